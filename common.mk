@@ -14,6 +14,11 @@ ifndef NODEBUG
 CFLAGS += -O0 -g3
 endif
 
+# per-stage stats of loading objects, see load_stats.h
+ifdef LOAD_STATS
+CPPFLAGS += -DLOAD_STATS
+endif
+
 # install variables
 INSTALL = install
 INSTALL_BIN = install -m755
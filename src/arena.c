@@ -0,0 +1,226 @@
+/*
+ * Copyright 2011-2014 hasufell
+ *
+ * This file is part of a hasufell project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation version 2 of the License only.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file arena.c
+ * A simple bump allocator. Every allocation is carved off the
+ * current block, a new block is only requested from the heap
+ * once the current one is full. Nothing is freed on its own,
+ * all blocks are released together.
+ * @brief arena allocator
+ */
+
+#include "arena.h"
+#include "err.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+
+/**
+ * Size of the header in front of the data of every block,
+ * so the data keeps the alignment of malloc().
+ */
+#define BLOCK_HEADER ARENA_SIZE(sizeof(arena_block))
+
+/**
+ * The data of a block.
+ */
+#define BLOCK_DATA(block) ((char*)(block) + BLOCK_HEADER)
+
+
+/**
+ * A block of memory of an arena, followed by its data.
+ */
+struct arena_block {
+	/**
+	 * The block which was in use before this one.
+	 */
+	arena_block *prev;
+	/**
+	 * Size of the data.
+	 */
+	size_t size;
+	/**
+	 * Used bytes of the data.
+	 */
+	size_t used;
+	/**
+	 * Length of the file mapping the block lives in,
+	 * 0 if it has been allocated from the heap.
+	 */
+	size_t map_len;
+};
+
+
+/**
+ * Initialize an empty arena. No memory is allocated
+ * until the first call of arena_alloc().
+ *
+ * @param mem the arena [out]
+ * @param block_size size of the blocks; to serve a known set of
+ * allocations with one block, pass the sum of their ARENA_SIZE()
+ */
+void arena_init(arena *mem, size_t block_size)
+{
+	if (!mem)
+		return;
+
+	mem->block = NULL;
+	mem->block_size = block_size;
+	mem->alloc_c = 0;
+	mem->block_c = 0;
+}
+
+/**
+ * Initialize an arena whose first block is a shared mapping
+ * of a file instead of heap memory. The kernel can write its
+ * pages back to the file and drop them under memory pressure,
+ * so the block may be bigger than the available memory.
+ * Further blocks come from the heap as usual.
+ *
+ * @param mem the arena [out]
+ * @param block_size size of the first block and of all
+ * further ones
+ * @param fd the file, which is truncated to the size of the
+ * block; it can be closed right after this call
+ * @return true/false for success/failure
+ */
+bool arena_init_file(arena *mem, size_t block_size, int fd)
+{
+	size_t const map_len = BLOCK_HEADER + block_size;
+	arena_block *block;
+
+	if (!mem || fd < 0)
+		return false;
+
+	arena_init(mem, block_size);
+
+	if (ftruncate(fd, map_len))
+		return false;
+	block = mmap(NULL, map_len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (block == MAP_FAILED)
+		return false;
+
+	block->prev = NULL;
+	block->size = block_size;
+	block->used = 0;
+	block->map_len = map_len;
+
+	mem->block = block;
+	mem->block_c = 1;
+
+	return true;
+}
+
+/**
+ * Allocate memory from an arena, aligned to ARENA_ALIGN.
+ * Allocations bigger than the block size get a block of
+ * their own, so the current block can still be used up.
+ * Aborts the program if no memory is left.
+ *
+ * @param mem the arena [mod]
+ * @param size size of the allocation
+ * @return the allocated memory, never NULL
+ */
+void *arena_alloc(arena *mem, size_t size)
+{
+	arena_block *block = mem->block;
+	void *ptr;
+
+	size = ARENA_SIZE(size);
+
+	if (!block || block->size - block->used < size) {
+		size_t const block_size =
+			(size > mem->block_size) ? size : mem->block_size;
+
+		block = malloc(BLOCK_HEADER + block_size);
+		CHECK_PTR_VAL(block);
+		block->size = block_size;
+		block->used = 0;
+		block->map_len = 0;
+
+		if (mem->block && size > mem->block_size) {
+			block->prev = mem->block->prev;
+			mem->block->prev = block;
+		} else {
+			block->prev = mem->block;
+			mem->block = block;
+		}
+
+		mem->block_c++;
+	}
+
+	ptr = BLOCK_DATA(block) + block->used;
+	block->used += size;
+	mem->alloc_c++;
+
+	return ptr;
+}
+
+/**
+ * Move all blocks of another arena into an arena, so
+ * they are released together. The other arena is
+ * left empty.
+ *
+ * @param mem the arena to move the blocks into [mod]
+ * @param other the arena the blocks are taken from [mod]
+ */
+void arena_merge(arena *mem, arena *other)
+{
+	arena_block *oldest = other->block;
+
+	if (!oldest)
+		return;
+
+	while (oldest->prev)
+		oldest = oldest->prev;
+
+	oldest->prev = mem->block;
+	mem->block = other->block;
+	mem->alloc_c += other->alloc_c;
+	mem->block_c += other->block_c;
+
+	arena_init(other, other->block_size);
+}
+
+/**
+ * Release all memory of an arena at once. The arena
+ * can be used again afterwards.
+ *
+ * @param mem the arena [mod]
+ */
+void arena_release(arena *mem)
+{
+	if (!mem)
+		return;
+
+	while (mem->block) {
+		arena_block *prev = mem->block->prev;
+
+		if (mem->block->map_len)
+			munmap(mem->block, mem->block->map_len);
+		else
+			free(mem->block);
+		mem->block = prev;
+	}
+
+	arena_init(mem, mem->block_size);
+}
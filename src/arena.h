@@ -0,0 +1,92 @@
+/*
+ * Copyright 2011-2014 hasufell
+ *
+ * This file is part of a hasufell project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation version 2 of the License only.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file arena.h
+ * Header for the arena allocator.
+ * @brief header of arena.c
+ */
+
+#ifndef _DROW_ENGINE_ARENA_H
+#define _DROW_ENGINE_ARENA_H
+
+
+#include <stdbool.h>
+#include <stddef.h>
+
+
+/**
+ * Default size of the blocks of an arena.
+ */
+#define ARENA_BLOCK_SIZE (64 * 1024)
+
+/**
+ * Alignment of all allocations from an arena, which is
+ * enough for every type used in this project.
+ */
+#define ARENA_ALIGN 16
+
+/**
+ * Space a single allocation of the given size takes up
+ * in an arena. Summing this up for all allocations gives
+ * the block size which serves all of them at once.
+ */
+#define ARENA_SIZE(size) \
+	(((size) + ARENA_ALIGN - 1) & ~((size_t)ARENA_ALIGN - 1))
+
+
+typedef struct arena arena;
+typedef struct arena_block arena_block;
+
+
+/**
+ * A bump allocator. Memory is handed out from big blocks
+ * and can only be released all at once, which makes both
+ * allocating and releasing a lot of small items cheap.
+ * An arena must not be used by multiple threads at once.
+ */
+struct arena {
+	/**
+	 * The block allocations are currently served from,
+	 * all older blocks are linked behind it.
+	 */
+	arena_block *block;
+	/**
+	 * Size of new blocks.
+	 */
+	size_t block_size;
+	/**
+	 * Count of allocations served so far.
+	 */
+	size_t alloc_c;
+	/**
+	 * Count of blocks, which is the count of allocations
+	 * from the heap (or of file mappings).
+	 */
+	size_t block_c;
+};
+
+
+void arena_init(arena *mem, size_t block_size);
+bool arena_init_file(arena *mem, size_t block_size, int fd);
+void *arena_alloc(arena *mem, size_t size);
+void arena_merge(arena *mem, arena *other);
+void arena_release(arena *mem);
+
+
+#endif /* _DROW_ENGINE_ARENA_H */
@@ -0,0 +1,93 @@
+/*
+ * Copyright 2011-2014 hasufell
+ *
+ * This file is part of a hasufell project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation version 2 of the License only.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file bench.c
+ * Main benchmark file, dispatching to the benchmark
+ * named on the command line.
+ * @brief benchmark entry point
+ */
+
+#include "bench.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+
+/**
+ * Program help text.
+ */
+char const * const helptext = "Usage: bench <benchmark> [args]\n"
+"\n"
+"benchmarks:\n"
+"  parse [file.obj...]     .obj tokenizer and parse_obj() throughput\n"
+"  parse-mt [file.obj...]  parse_obj_parallel() scaling over threads\n"
+"  walk [file.obj...]      face walks on HE_obj vs. compact HE_cobj\n"
+"  pairing [valence...]    edge pairing around a high-valence pole\n"
+"  normals [file.obj...]   vertex normals one by one vs. all at once\n"
+"  bounds [count...]       center and normalize in separate vs. fused passes\n"
+"  bezier [degree...]      bezier tessellation, allocating vs. batched\n"
+"  arc [count...]          placing things along a curve by arc length\n"
+"  suite [--grid faces] [file.obj...]\n"
+"                          all of the above on every mesh, as JSON lines\n";
+
+
+/**
+ * Get a monotonic timestamp.
+ *
+ * @return the time in seconds
+ */
+double bench_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char *argv[])
+{
+	if (argc < 2) {
+		printf("%s", helptext);
+		return 1;
+	}
+
+	if (!strcmp(argv[1], "parse"))
+		return bench_parse(argc - 2, argv + 2);
+	else if (!strcmp(argv[1], "parse-mt"))
+		return bench_parse_mt(argc - 2, argv + 2);
+	else if (!strcmp(argv[1], "walk"))
+		return bench_walk(argc - 2, argv + 2);
+	else if (!strcmp(argv[1], "pairing"))
+		return bench_pairing(argc - 2, argv + 2);
+	else if (!strcmp(argv[1], "normals"))
+		return bench_normals(argc - 2, argv + 2);
+	else if (!strcmp(argv[1], "bounds"))
+		return bench_bounds(argc - 2, argv + 2);
+	else if (!strcmp(argv[1], "bezier"))
+		return bench_bezier(argc - 2, argv + 2);
+	else if (!strcmp(argv[1], "arc"))
+		return bench_bezier_arc(argc - 2, argv + 2);
+	else if (!strcmp(argv[1], "suite"))
+		return bench_suite(argc - 2, argv + 2);
+
+	printf("%s", helptext);
+	return 1;
+}
@@ -0,0 +1,64 @@
+/*
+ * Copyright 2011-2014 hasufell
+ *
+ * This file is part of a hasufell project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation version 2 of the License only.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file bench.h
+ * Main benchmark header, containing the timing helpers
+ * and declarations of all benchmark functions.
+ * @brief benchmark declarations
+ */
+
+#ifndef _DROW_ENGINE_BENCH_H
+#define _DROW_ENGINE_BENCH_H
+
+
+#include <stdint.h>
+
+
+double bench_now(void);
+
+/*
+ * parser benchmarks
+ */
+int bench_parse(int argc, char *argv[]);
+int bench_parse_mt(int argc, char *argv[]);
+
+/*
+ * mesh benchmarks
+ */
+int bench_walk(int argc, char *argv[]);
+int bench_pairing(int argc, char *argv[]);
+int bench_normals(int argc, char *argv[]);
+int bench_bounds(int argc, char *argv[]);
+
+/*
+ * curve benchmarks
+ */
+int bench_bezier(int argc, char *argv[]);
+int bench_bezier_arc(int argc, char *argv[]);
+
+/*
+ * suite benchmarks
+ */
+int bench_suite(int argc, char *argv[]);
+void bench_alloc_reset(void);
+uint64_t bench_alloc_count(void);
+uint64_t bench_alloc_bytes(void);
+
+
+#endif /* _DROW_ENGINE_BENCH_H */
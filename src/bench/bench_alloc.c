@@ -0,0 +1,130 @@
+/*
+ * Copyright 2011-2014 hasufell
+ *
+ * This file is part of a hasufell project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation version 2 of the License only.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file bench_alloc.c
+ * Counts the calls to malloc(), calloc() and realloc() of
+ * the whole benchmark binary, which is linked with
+ * -Wl,--wrap for them. Memory the arena maps from files
+ * is not counted.
+ * @brief allocation counters
+ */
+
+#include "bench.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+/*
+ * globals
+ */
+static uint64_t alloc_count;
+static uint64_t alloc_bytes;
+
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t nmemb, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+void *__wrap_malloc(size_t size);
+void *__wrap_calloc(size_t nmemb, size_t size);
+void *__wrap_realloc(void *ptr, size_t size);
+
+
+/**
+ * Count an allocation. The counters are updated atomically,
+ * as the parallel parser allocates from several threads.
+ *
+ * @param size the requested size
+ */
+static void count_alloc(size_t size)
+{
+	__atomic_fetch_add(&alloc_count, 1, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&alloc_bytes, size, __ATOMIC_RELAXED);
+}
+
+/**
+ * Counting malloc().
+ *
+ * @param size the size
+ * @return the memory
+ */
+void *__wrap_malloc(size_t size)
+{
+	count_alloc(size);
+
+	return __real_malloc(size);
+}
+
+/**
+ * Counting calloc().
+ *
+ * @param nmemb count of members
+ * @param size size of a member
+ * @return the memory
+ */
+void *__wrap_calloc(size_t nmemb, size_t size)
+{
+	count_alloc(nmemb * size);
+
+	return __real_calloc(nmemb, size);
+}
+
+/**
+ * Counting realloc(), every call counts as an allocation
+ * of the new size.
+ *
+ * @param ptr the old memory
+ * @param size the new size
+ * @return the memory
+ */
+void *__wrap_realloc(void *ptr, size_t size)
+{
+	count_alloc(size);
+
+	return __real_realloc(ptr, size);
+}
+
+/**
+ * Reset the allocation counters.
+ */
+void bench_alloc_reset(void)
+{
+	__atomic_store_n(&alloc_count, 0, __ATOMIC_RELAXED);
+	__atomic_store_n(&alloc_bytes, 0, __ATOMIC_RELAXED);
+}
+
+/**
+ * Get the count of allocations since the last reset.
+ *
+ * @return the count
+ */
+uint64_t bench_alloc_count(void)
+{
+	return __atomic_load_n(&alloc_count, __ATOMIC_RELAXED);
+}
+
+/**
+ * Get the bytes allocated since the last reset.
+ *
+ * @return the bytes
+ */
+uint64_t bench_alloc_bytes(void)
+{
+	return __atomic_load_n(&alloc_bytes, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,420 @@
+/*
+ * Copyright 2011-2014 hasufell
+ *
+ * This file is part of a hasufell project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation version 2 of the License only.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file bench_bezier.c
+ * Benchmarks for the evaluation of bezier curves, comparing
+ * the recursive evaluation which allocated every reduced curve
+ * with the allocation-free single and batched evaluators and
+ * the adaptive, cached polylines, as well as placing things
+ * along curves by their arc length.
+ * @brief bezier curve benchmarks
+ */
+
+#include "bench.h"
+#include "bezier.h"
+#include "bezier_arc.h"
+#include "vector.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+/**
+ * Minimum time in seconds every measurement is repeated for.
+ */
+#define BENCH_MIN_TIME 0.5
+
+/**
+ * Count of curves tessellated per frame.
+ */
+#define BENCH_CURVE_C 1000
+
+/**
+ * Count of points per curve.
+ */
+#define BENCH_POINT_C 100
+
+/**
+ * Tolerance of the adaptive polylines.
+ */
+#define BENCH_TOLERANCE 0.001f
+
+
+/*
+ * The polylines of all curves.
+ */
+static bez_poly polys[BENCH_CURVE_C];
+
+/*
+ * static function declaration
+ */
+static vector *bezier_point_legacy(const bez_curv *bez,
+		const float section,
+		const uint32_t deg);
+static double tessellate_legacy(bez_curv const *curves, vector *points);
+static double tessellate_single(bez_curv const *curves, vector *points);
+static double tessellate_batch(bez_curv const *curves, vector *points);
+static double tessellate_adaptive(bez_curv const *curves, vector *points);
+static double tessellate_cached(bez_curv const *curves, vector *points);
+static double run_tessellate(double (*tessellate)(bez_curv const*, vector*),
+		bez_curv const *curves,
+		vector *points);
+
+
+/**
+ * Calculate a point on a curve the way calculate_bezier_point()
+ * used to: recursively, with a newly allocated reduced curve
+ * on every level and a newly allocated result.
+ *
+ * @param bez the bezier curve
+ * @param section the section
+ * @param deg the degree of the original curve
+ * @return the point, newly allocated
+ */
+static vector *bezier_point_legacy(const bez_curv *bez,
+		const float section,
+		const uint32_t deg)
+{
+	bez_curv new_bez = { NULL, 0 };
+
+	if (!get_reduced_bez_curv(bez, &new_bez, section))
+		return NULL;
+
+	if (bez->deg < deg)
+		free(bez->vec);
+
+	if (new_bez.deg > 0) {
+		return bezier_point_legacy(&new_bez, section, deg);
+	} else {
+		vector *result_vector = malloc(sizeof(*result_vector));
+		*result_vector = new_bez.vec[0];
+		free(new_bez.vec);
+
+		return result_vector;
+	}
+}
+
+/**
+ * Tessellate all curves with the legacy evaluation.
+ *
+ * @param curves the curves
+ * @param points the points of all curves [out]
+ * @return the time it took in seconds
+ */
+static double tessellate_legacy(bez_curv const *curves, vector *points)
+{
+	double t = bench_now();
+
+	for (uint32_t i = 0; i < BENCH_CURVE_C; i++) {
+		for (uint32_t j = 0; j < BENCH_POINT_C; j++) {
+			vector *point = bezier_point_legacy(&(curves[i]),
+					(float)j / (BENCH_POINT_C - 1), curves[i].deg);
+
+			points[i * BENCH_POINT_C + j] = *point;
+			free(point);
+		}
+	}
+
+	return bench_now() - t;
+}
+
+/**
+ * Tessellate all curves one point at a time with
+ * eval_bezier_point().
+ *
+ * @param curves the curves
+ * @param points the points of all curves [out]
+ * @return the time it took in seconds
+ */
+static double tessellate_single(bez_curv const *curves, vector *points)
+{
+	double t = bench_now();
+
+	for (uint32_t i = 0; i < BENCH_CURVE_C; i++)
+		for (uint32_t j = 0; j < BENCH_POINT_C; j++)
+			eval_bezier_point(&(curves[i]), (float)j / (BENCH_POINT_C - 1),
+					NULL, &(points[i * BENCH_POINT_C + j]));
+
+	return bench_now() - t;
+}
+
+/**
+ * Tessellate all curves one curve at a time with
+ * sample_bezier_curve().
+ *
+ * @param curves the curves
+ * @param points the points of all curves [out]
+ * @return the time it took in seconds
+ */
+static double tessellate_batch(bez_curv const *curves, vector *points)
+{
+	double t = bench_now();
+
+	for (uint32_t i = 0; i < BENCH_CURVE_C; i++)
+		sample_bezier_curve(&(curves[i]), BENCH_POINT_C,
+				&(points[i * BENCH_POINT_C]));
+
+	return bench_now() - t;
+}
+
+/**
+ * Tessellate all curves adaptively, with a tolerance that
+ * alternates between runs so that nothing is cached.
+ *
+ * @param curves the curves
+ * @param points unused
+ * @return the time it took in seconds
+ */
+static double tessellate_adaptive(bez_curv const *curves, vector *points)
+{
+	static bool odd = false;
+	float const tolerance = odd ? BENCH_TOLERANCE : BENCH_TOLERANCE * 1.1f;
+	double t = bench_now();
+
+	for (uint32_t i = 0; i < BENCH_CURVE_C; i++)
+		get_bez_poly(&(curves[i]), tolerance, &(polys[i]));
+	t = bench_now() - t;
+	odd = !odd;
+
+	return t;
+}
+
+/**
+ * Get the polylines of all curves again, which are all cached.
+ *
+ * @param curves the curves
+ * @param points unused
+ * @return the time it took in seconds
+ */
+static double tessellate_cached(bez_curv const *curves, vector *points)
+{
+	double t = bench_now();
+
+	for (uint32_t i = 0; i < BENCH_CURVE_C; i++)
+		get_bez_poly(&(curves[i]), BENCH_TOLERANCE, &(polys[i]));
+
+	return bench_now() - t;
+}
+
+/**
+ * Run a tessellation repeatedly for at least BENCH_MIN_TIME.
+ *
+ * @param tessellate the tessellation
+ * @param curves the curves
+ * @param points the points of all curves [out]
+ * @return the best time in seconds
+ */
+static double run_tessellate(double (*tessellate)(bez_curv const*, vector*),
+		bez_curv const *curves,
+		vector *points)
+{
+	double best = 0,
+		   start = bench_now();
+
+	do {
+		double t = tessellate(curves, points);
+
+		if (best == 0 || t < best)
+			best = t;
+	} while (bench_now() - start < BENCH_MIN_TIME);
+
+	return best;
+}
+
+/**
+ * Compare tessellating BENCH_CURVE_C curves into BENCH_POINT_C
+ * points each with the legacy, the single and the batched
+ * evaluation, and with adaptive polylines, tessellated from
+ * scratch and cached.
+ *
+ * @param argc count of degrees
+ * @param argv the degrees of the curves, 3, 10 and 30 if empty
+ * @return 0 on success, 1 on failure
+ */
+int bench_bezier(int argc, char *argv[])
+{
+	char *default_degs[] = { "3", "10", "30" };
+	vector *points = malloc(sizeof(*points) * BENCH_CURVE_C * BENCH_POINT_C);
+
+	if (!points) {
+		fprintf(stderr, "Out of memory!\n");
+		return 1;
+	}
+
+	if (!argc) {
+		argc = 3;
+		argv = default_degs;
+	}
+
+	printf("%d curves, %d points each\n", BENCH_CURVE_C, BENCH_POINT_C);
+	printf("%8s %12s %12s %12s %14s %12s %12s %10s\n", "degree",
+			"legacy ms", "single ms", "batch ms", "batch Mpts/s",
+			"adapt ms", "cached ms", "adapt pts");
+
+	for (int i = 0; i < argc; i++) {
+		uint32_t const deg = (uint32_t)strtoul(argv[i], NULL, 10);
+		bez_curv *curves = malloc(sizeof(*curves) * BENCH_CURVE_C);
+		vector *vec = malloc(sizeof(*vec) * BENCH_CURVE_C * (deg + 1));
+		double legacy,
+			   single,
+			   batch,
+			   adaptive,
+			   cached;
+		uint64_t poly_point_c = 0;
+
+		if (!deg || !curves || !vec) {
+			fprintf(stderr, "Invalid degree \"%s\"!\n", argv[i]);
+			free(curves);
+			free(vec);
+			free(points);
+			return 1;
+		}
+
+		srand(1);
+		for (uint32_t j = 0; j < BENCH_CURVE_C * (deg + 1); j++) {
+			vec[j].x = (float)rand() / RAND_MAX;
+			vec[j].y = (float)rand() / RAND_MAX;
+			vec[j].z = (float)rand() / RAND_MAX;
+		}
+		for (uint32_t j = 0; j < BENCH_CURVE_C; j++) {
+			curves[j].vec = vec + j * (deg + 1);
+			curves[j].deg = deg;
+		}
+
+		legacy = run_tessellate(tessellate_legacy, curves, points);
+		single = run_tessellate(tessellate_single, curves, points);
+		batch = run_tessellate(tessellate_batch, curves, points);
+		adaptive = run_tessellate(tessellate_adaptive, curves, points);
+		cached = run_tessellate(tessellate_cached, curves, points);
+
+		for (uint32_t j = 0; j < BENCH_CURVE_C; j++) {
+			poly_point_c += polys[j].point_c;
+			delete_bez_poly(&(polys[j]));
+		}
+
+		printf("%8u %12.3f %12.3f %12.3f %14.1f %12.3f %12.3f %10.1f\n",
+				deg, legacy * 1e3, single * 1e3, batch * 1e3,
+				BENCH_CURVE_C * BENCH_POINT_C / batch / 1e6,
+				adaptive * 1e3, cached * 1e3,
+				(double)poly_point_c / BENCH_CURVE_C);
+
+		free(curves);
+		free(vec);
+	}
+
+	free(points);
+
+	return 0;
+}
+
+/**
+ * Compare placing things along a cubic curve at raw sections, one
+ * at a time with calculate_bezier_point(), with placing them at
+ * distances along the curve with its arc length table, one at a
+ * time and all at once.
+ *
+ * @param argc count of counts
+ * @param argv the counts of things, 100, 10000 and 1000000
+ * if empty
+ * @return 0 on success, 1 on failure
+ */
+int bench_bezier_arc(int argc, char *argv[])
+{
+	char *default_counts[] = { "100", "10000", "1000000" };
+	vector vec[4] = { { 0, 0, 0 }, { 0, 1, 0 }, { 1, 1, 1 }, { 1, 0, 0 } };
+	bez_curv const bez = { vec, 3 };
+	bez_arc arc = { NULL, NULL, 0, NULL, 0, 0 };
+	double build = bench_now();
+
+	GET_BEZ_ARC(&bez, BEZ_ARC_SAMPLES, &arc);
+	build = bench_now() - build;
+
+	if (!argc) {
+		argc = 3;
+		argv = default_counts;
+	}
+
+	printf("table of %d samples built in %.3f ms\n", BEZ_ARC_SAMPLES,
+			build * 1e3);
+	printf("%10s %12s %12s %12s\n", "things", "section ms", "arc ms",
+			"arc batch ms");
+
+	for (int i = 0; i < argc; i++) {
+		uint32_t const n = (uint32_t)strtoul(argv[i], NULL, 10);
+		float *distances = malloc(sizeof(*distances) * n),
+			  *arc_distances = malloc(sizeof(*arc_distances) * n);
+		vector *points = malloc(sizeof(*points) * n);
+		double best[3] = { 0, 0, 0 };
+
+		if (!n || !distances || !arc_distances || !points) {
+			fprintf(stderr, "Invalid count \"%s\"!\n", argv[i]);
+			free(distances);
+			free(arc_distances);
+			free(points);
+			delete_bez_arc(&arc);
+			return 1;
+		}
+
+		for (uint32_t j = 0; j < n; j++) {
+			distances[j] = (float)j / n;
+			arc_distances[j] = distances[j] * arc.length;
+		}
+
+		for (int k = 0; k < 3; k++) {
+			double start = bench_now();
+
+			do {
+				double t = bench_now();
+
+				if (k == 0) {
+					for (uint32_t j = 0; j < n; j++) {
+						vector *point = calculate_bezier_point(&bez,
+								distances[j]);
+
+						points[j] = *point;
+						free(point);
+					}
+				} else if (k == 1) {
+					for (uint32_t j = 0; j < n; j++)
+						bez_arc_point(&arc, distances[j] * arc.length,
+								&(points[j]), NULL);
+				} else {
+					bez_arc_points(&arc, arc_distances, n, points);
+				}
+				t = bench_now() - t;
+
+				if (best[k] == 0 || t < best[k])
+					best[k] = t;
+			} while (bench_now() - start < BENCH_MIN_TIME);
+		}
+
+		printf("%10u %12.3f %12.3f %12.3f\n", n, best[0] * 1e3,
+				best[1] * 1e3, best[2] * 1e3);
+
+		free(distances);
+		free(arc_distances);
+		free(points);
+	}
+
+	delete_bez_arc(&arc);
+
+	return 0;
+}
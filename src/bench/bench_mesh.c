@@ -0,0 +1,690 @@
+/*
+ * Copyright 2011-2014 hasufell
+ *
+ * This file is part of a hasufell project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation version 2 of the License only.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file bench_mesh.c
+ * Benchmarks for topological walks over assembled
+ * half-edge meshes.
+ * @brief mesh benchmarks
+ */
+
+#include "bench.h"
+#include "filereader.h"
+#include "half_edge.h"
+#include "half_edge_compact.h"
+#include "half_edge_normals.h"
+#include "mesh_bounds.h"
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+/**
+ * Minimum time in seconds every measurement is repeated for.
+ */
+#define BENCH_MIN_TIME 0.5
+
+/**
+ * The quadratic legacy pairing is skipped above this valence.
+ */
+#define LEGACY_MAX_VALENCE 20000
+
+
+/*
+ * static function declaration
+ */
+static double walk_obj(HE_obj const * const obj);
+static double walk_cobj(HE_cobj const * const cobj);
+static double run_walk(void const *mesh,
+		double (*walk)(void const*),
+		double *sum);
+static double walk_obj_cb(void const *mesh);
+static double walk_cobj_cb(void const *mesh);
+static char *pole_obj(uint32_t valence, size_t *len);
+static void pair_edges_legacy(HE_obj *obj);
+static void normals_per_vertex(HE_obj *obj, unsigned threads);
+static void normals_area(HE_obj *obj, unsigned threads);
+static void normals_angle(HE_obj *obj, unsigned threads);
+static double run_normals(HE_obj *obj,
+		void (*normals)(HE_obj*, unsigned),
+		unsigned threads);
+static void fill_positions(vector *positions, uint32_t n);
+static void normalize_legacy(vector *positions,
+		uint32_t n,
+		vector *center);
+
+
+/**
+ * Walk around all faces and across all pairs of a HE_obj,
+ * summing up the coordinates of the visited vertices.
+ *
+ * @param obj the object
+ * @return the sum
+ */
+static double walk_obj(HE_obj const * const obj)
+{
+	double sum = 0;
+
+	for (uint32_t i = 0; i < obj->fc; i++) {
+		HE_edge const *edge = obj->faces[i].edge;
+
+		do {
+			sum += edge->pair->vert->vec->x;
+			edge = edge->next;
+		} while (edge != obj->faces[i].edge);
+	}
+
+	return sum;
+}
+
+/**
+ * The same walk as walk_obj(), on the compact representation.
+ *
+ * @param cobj the compact object
+ * @return the sum
+ */
+static double walk_cobj(HE_cobj const * const cobj)
+{
+	double sum = 0;
+
+	for (uint32_t i = 0; i < cobj->fc; i++) {
+		uint32_t edge = cobj->face_edges[i];
+
+		do {
+			sum += cobj->positions[cobj->edges[HE_C_PAIR(edge)].vert].x;
+			edge = cobj->edges[edge].next;
+		} while (edge != cobj->face_edges[i]);
+	}
+
+	return sum;
+}
+
+/**
+ * Wrapper of walk_obj() for run_walk().
+ *
+ * @param mesh the HE_obj
+ * @return the sum
+ */
+static double walk_obj_cb(void const *mesh)
+{
+	return walk_obj(mesh);
+}
+
+/**
+ * Wrapper of walk_cobj() for run_walk().
+ *
+ * @param mesh the HE_cobj
+ * @return the sum
+ */
+static double walk_cobj_cb(void const *mesh)
+{
+	return walk_cobj(mesh);
+}
+
+/**
+ * Run a walk repeatedly for at least BENCH_MIN_TIME.
+ *
+ * @param mesh the mesh to walk
+ * @param walk the walk
+ * @param sum the checksum of the last run [out]
+ * @return the best time in seconds
+ */
+static double run_walk(void const *mesh,
+		double (*walk)(void const*),
+		double *sum)
+{
+	double best = 0,
+		   start = bench_now();
+
+	do {
+		double t = bench_now();
+
+		*sum = walk(mesh);
+		t = bench_now() - t;
+
+		if (best == 0 || t < best)
+			best = t;
+	} while (bench_now() - start < BENCH_MIN_TIME);
+
+	return best;
+}
+
+/**
+ * Compare face walks and memory footprint of HE_obj and
+ * the compact HE_cobj for all given files.
+ *
+ * @param argc count of files
+ * @param argv the files, obj/bod_starter1-6.obj if empty
+ * @return 0 on success, 1 on failure
+ */
+int bench_walk(int argc, char *argv[])
+{
+	char *default_file[] = { "obj/bod_starter1-6.obj" };
+
+	if (!argc) {
+		argc = 1;
+		argv = default_file;
+	}
+
+	printf("%-32s %10s %12s %12s %10s %10s\n", "file", "half-edges",
+			"edges KiB", "cedges KiB", "ns/edge", "c ns/edge");
+
+	for (int i = 0; i < argc; i++) {
+		HE_obj *obj = read_obj_file(argv[i]);
+		HE_cobj *cobj;
+		double sum,
+			   csum,
+			   t,
+			   ct;
+		uint32_t ec;
+
+		if (!obj) {
+			fprintf(stderr, "Failed to parse \"%s\"!\n", argv[i]);
+			return 1;
+		}
+
+		cobj = compact_object(obj);
+		ec = obj->ec + obj->dec;
+
+		t = run_walk(obj, walk_obj_cb, &sum);
+		ct = run_walk(cobj, walk_cobj_cb, &csum);
+
+		if (sum != csum)
+			fprintf(stderr, "Checksum mismatch for \"%s\": %f vs %f\n",
+					argv[i], sum, csum);
+
+		printf("%-32s %10u %12.1f %12.1f %10.2f %10.2f\n", argv[i], ec,
+				sizeof(HE_edge) * ec / 1024.0,
+				sizeof(HE_cedge) * cobj->ec / 1024.0,
+				t / obj->ec * 1e9, ct / obj->ec * 1e9);
+
+		delete_compact_object(cobj);
+		free(cobj);
+		delete_object(obj);
+		free(obj);
+	}
+
+	return 0;
+}
+
+/**
+ * Create an .obj buffer with a triangle fan of the given
+ * valence around a pole, like the cap of a UV sphere, with
+ * a border around the fan.
+ *
+ * @param valence count of triangles around the pole
+ * @param len length of the buffer [out]
+ * @return the buffer, which has to be freed
+ */
+static char *pole_obj(uint32_t valence, size_t *len)
+{
+	size_t size = 64 + (size_t)valence * 96;
+	char *buf = malloc(size);
+	size_t pos = 0;
+
+	pos += sprintf(buf + pos, "v 0 0 1\n");
+	for (uint32_t i = 0; i < valence; i++) {
+		double const angle = 2 * M_PI * i / valence;
+
+		pos += sprintf(buf + pos, "v %f %f 0\n", cos(angle), sin(angle));
+	}
+	for (uint32_t i = 0; i < valence; i++)
+		pos += sprintf(buf + pos, "f 1 %u %u\n", i + 2,
+				(i + 1) % valence + 2);
+
+	*len = pos;
+
+	return buf;
+}
+
+/**
+ * Pair the edges the way assemble_HE_stage3() used to do it,
+ * by searching all edges which end at the start vertex of an edge
+ * for one coming from its end vertex and then searching all
+ * dummy edges starting at the end vertex of every dummy edge.
+ * Both go quadratic with the valence of a vertex.
+ *
+ * @param obj the object, whose pairs and dummy edges are
+ * recreated [mod]
+ */
+static void pair_edges_legacy(HE_obj *obj)
+{
+	HE_edge *edges = obj->edges;
+	uint32_t const ec = obj->ec,
+		  vc = obj->vc;
+	uint32_t *to_start = calloc(vc + 1, sizeof(*to_start)),
+			 *to_fill = calloc(vc + 1, sizeof(*to_fill)),
+			 *d_start = calloc(vc + 1, sizeof(*d_start)),
+			 *d_fill = calloc(vc + 1, sizeof(*d_fill));
+	HE_edge **to = malloc(sizeof(*to) * (ec + 1)),
+			**dummys = malloc(sizeof(*dummys) * (ec + 1));
+	uint32_t dec = 0;
+
+	/* edges by the vertex they point to, in the order of the edges */
+	for (uint32_t i = 0; i < ec; i++)
+		to_start[edges[i].next->vert - obj->vertices + 1]++;
+	for (uint32_t i = 0; i < vc; i++)
+		to_start[i + 1] += to_start[i];
+	for (uint32_t i = 0; i < ec; i++) {
+		uint32_t v = edges[i].next->vert - obj->vertices;
+
+		to[to_start[v] + to_fill[v]++] = &(edges[i]);
+	}
+
+	for (uint32_t i = 0; i < ec; i++) {
+		uint32_t v = edges[i].vert - obj->vertices;
+		bool pair_found = false;
+
+		for (uint32_t j = to_start[v]; j < to_start[v] + to_fill[v]; j++) {
+			if (to[j] && edges[i].next->vert == to[j]->vert) {
+				edges[i].pair = to[j];
+				to[j] = NULL;
+				pair_found = true;
+				break;
+			}
+		}
+
+		if (!pair_found) {
+			edges[ec + dec].face = NULL;
+			edges[ec + dec].next = NULL;
+			edges[ec + dec].pair = &(edges[i]);
+			edges[i].pair = &(edges[ec + dec]);
+			edges[ec + dec].vert = edges[i].next->vert;
+			d_start[edges[i].next->vert - obj->vertices + 1]++;
+			dec++;
+		}
+	}
+
+	/* dummy edges by their start vertex */
+	for (uint32_t i = 0; i < vc; i++)
+		d_start[i + 1] += d_start[i];
+	for (uint32_t i = 0; i < dec; i++) {
+		uint32_t v = edges[ec + i].vert - obj->vertices;
+
+		dummys[d_start[v] + d_fill[v]++] = &(edges[ec + i]);
+	}
+
+	for (uint32_t i = 0; i < dec; i++) {
+		HE_vert *vert = edges[ec + i].pair->vert;
+		uint32_t v = vert - obj->vertices;
+
+		for (uint32_t j = d_start[v]; j < d_start[v] + d_fill[v]; j++)
+			if (vert == dummys[j]->vert)
+				edges[ec + i].next = dummys[j];
+	}
+
+	obj->dec = dec;
+
+	free(to_start);
+	free(to_fill);
+	free(d_start);
+	free(d_fill);
+	free(to);
+	free(dummys);
+}
+
+/**
+ * Measure parsing of a triangle fan around a pole of increasing
+ * valence, compared to the pairing of the edges alone as
+ * assemble_HE_stage3() used to do it.
+ *
+ * @param argc count of valences
+ * @param argv the valences, 1000, 10000 and 100000 if empty
+ * @return 0 on success, 1 on failure
+ */
+int bench_pairing(int argc, char *argv[])
+{
+	char *default_valences[] = { "1000", "10000", "100000" };
+
+	if (!argc) {
+		argc = 3;
+		argv = default_valences;
+	}
+
+	printf("%10s %10s %14s %14s\n", "valence", "edges",
+			"parse ms", "legacy pair ms");
+
+	for (int i = 0; i < argc; i++) {
+		uint32_t valence = (uint32_t)strtoul(argv[i], NULL, 10);
+		size_t len;
+		char *buf;
+		HE_obj *obj = NULL;
+		double best = 0,
+			   start;
+
+		if (valence < 3) {
+			fprintf(stderr, "Invalid valence \"%s\"!\n", argv[i]);
+			return 1;
+		}
+
+		buf = pole_obj(valence, &len);
+
+		start = bench_now();
+		do {
+			double t = bench_now();
+
+			if (obj) {
+				delete_object(obj);
+				free(obj);
+			}
+			obj = parse_obj_buf(buf, len);
+			t = bench_now() - t;
+
+			if (best == 0 || t < best)
+				best = t;
+		} while (bench_now() - start < BENCH_MIN_TIME);
+
+		printf("%10u %10u %14.3f ", valence, obj->ec + obj->dec,
+				best * 1e3);
+
+		if (valence <= LEGACY_MAX_VALENCE) {
+			uint32_t const ec = obj->ec + obj->dec;
+			HE_edge *edges = malloc(sizeof(*edges) * ec);
+			double t;
+
+			memcpy(edges, obj->edges, sizeof(*edges) * ec);
+
+			t = bench_now();
+			pair_edges_legacy(obj);
+			t = bench_now() - t;
+
+			if (obj->ec + obj->dec != ec ||
+					memcmp(edges, obj->edges, sizeof(*edges) * ec))
+				fprintf(stderr, "Pairing mismatch for valence %u\n",
+						valence);
+
+			printf("%14.3f\n", t * 1e3);
+			free(edges);
+		} else {
+			printf("%14s\n", "-");
+		}
+
+		delete_object(obj);
+		free(obj);
+		free(buf);
+	}
+
+	return 0;
+}
+
+/**
+ * Compute the normals of all vertices one by one
+ * with vec_normal(), the way draw_normals() used to do it
+ * every frame.
+ *
+ * @param obj the object, with one normal per vertex [mod]
+ * @param threads unused
+ */
+static void normals_per_vertex(HE_obj *obj, unsigned threads)
+{
+	for (uint32_t i = 0; i < obj->vc; i++)
+		if (!vec_normal(obj, i, &(obj->vn[i])))
+			SET_NULL_VECTOR(&(obj->vn[i]));
+}
+
+/**
+ * Compute the area weighted normals of all vertices at once.
+ *
+ * @param obj the object [mod]
+ * @param threads count of threads
+ */
+static void normals_area(HE_obj *obj, unsigned threads)
+{
+	COMPUTE_VERTEX_NORMALS_PARALLEL(obj, NORMAL_WEIGHT_AREA, threads);
+}
+
+/**
+ * Compute the angle weighted normals of all vertices at once.
+ *
+ * @param obj the object [mod]
+ * @param threads count of threads
+ */
+static void normals_angle(HE_obj *obj, unsigned threads)
+{
+	COMPUTE_VERTEX_NORMALS_PARALLEL(obj, NORMAL_WEIGHT_ANGLE, threads);
+}
+
+/**
+ * Run a normals computation repeatedly for at least
+ * BENCH_MIN_TIME.
+ *
+ * @param obj the object [mod]
+ * @param normals the computation
+ * @param threads count of threads
+ * @return the best time in seconds
+ */
+static double run_normals(HE_obj *obj,
+		void (*normals)(HE_obj*, unsigned),
+		unsigned threads)
+{
+	double best = 0,
+		   start = bench_now();
+
+	do {
+		double t = bench_now();
+
+		normals(obj, threads);
+		t = bench_now() - t;
+
+		if (best == 0 || t < best)
+			best = t;
+	} while (bench_now() - start < BENCH_MIN_TIME);
+
+	return best;
+}
+
+/**
+ * Compare the vertex normals computed one by one with
+ * vec_normal() and all at once with compute_vertex_normals(),
+ * in one and in all threads, for all given files. The one-ring
+ * index is built before, so both only measure the normals.
+ *
+ * @param argc count of files
+ * @param argv the files, obj/teapot.obj and obj/bod_starter1-6.obj
+ * if empty
+ * @return 0 on success, 1 on failure
+ */
+int bench_normals(int argc, char *argv[])
+{
+	char *default_files[] = { "obj/teapot.obj", "obj/bod_starter1-6.obj" };
+
+	if (!argc) {
+		argc = 2;
+		argv = default_files;
+	}
+
+	printf("%-32s %10s %12s %10s %10s %10s %8s\n", "file", "vertices",
+			"vertex ms", "area ms", "angle ms", "mt ms", "speedup");
+
+	for (int i = 0; i < argc; i++) {
+		HE_obj *obj = read_obj_file(argv[i]);
+		double t,
+			   area,
+			   angle,
+			   mt;
+
+		if (!obj) {
+			fprintf(stderr, "Failed to parse \"%s\"!\n", argv[i]);
+			return 1;
+		}
+
+		/* the index and the array of the normals are shared by all */
+		COMPUTE_VERTEX_NORMALS(obj, NORMAL_WEIGHT_AREA);
+
+		t = run_normals(obj, normals_per_vertex, 1);
+		area = run_normals(obj, normals_area, 1);
+		angle = run_normals(obj, normals_angle, 1);
+		mt = run_normals(obj, normals_area, 0);
+
+		printf("%-32s %10u %12.3f %10.3f %10.3f %10.3f %7.1fx\n", argv[i],
+				obj->vc, t * 1e3, area * 1e3, angle * 1e3, mt * 1e3,
+				t / area);
+
+		delete_object(obj);
+		free(obj);
+	}
+
+	return 0;
+}
+
+/**
+ * Fill an array with the same pseudo-random positions every
+ * time, far away from the origin.
+ *
+ * @param positions the positions [out]
+ * @param n count of positions
+ */
+static void fill_positions(vector *positions, uint32_t n)
+{
+	srand(1);
+
+	for (uint32_t i = 0; i < n; i++) {
+		positions[i].x = 1000 + (float)rand() / RAND_MAX;
+		positions[i].y = (float)rand() / RAND_MAX;
+		positions[i].z = (float)rand() / RAND_MAX;
+	}
+}
+
+/**
+ * Find the center and normalize a set of positions the way
+ * find_center() and normalize_object() used to do it, in three
+ * passes with float sums and the range of x + y + z as size.
+ *
+ * @param positions the positions [mod]
+ * @param n count of positions
+ * @param center the center [out]
+ */
+static void normalize_legacy(vector *positions,
+		uint32_t n,
+		vector *center)
+{
+	float x = 0,
+		  y = 0,
+		  z = 0,
+		  max,
+		  min,
+		  scale_factor;
+
+	for (uint32_t i = 0; i < n; i++) {
+		x += positions[i].x;
+		y += positions[i].y;
+		z += positions[i].z;
+	}
+	center->x = x / n;
+	center->y = y / n;
+	center->z = z / n;
+
+	max = positions[0].x + positions[0].y + positions[0].z;
+	min = max;
+	for (uint32_t i = 0; i < n; i++) {
+		float sum = positions[i].x + positions[i].y + positions[i].z;
+
+		if (sum > max)
+			max = sum;
+		else if (sum < min)
+			min = sum;
+	}
+	scale_factor = 1 / (max - min);
+
+	for (uint32_t i = 0; i < n; i++) {
+		positions[i].x *= scale_factor;
+		positions[i].y *= scale_factor;
+		positions[i].z *= scale_factor;
+	}
+}
+
+/**
+ * Compare finding the bounds and normalizing a random set of
+ * positions in one fused pass plus a transform pass, in one and
+ * in all threads, with the old separate passes. The rate is the
+ * amount of positions read and written per second.
+ *
+ * @param argc count of sizes
+ * @param argv the counts of positions, 1000000 and 10000000
+ * if empty
+ * @return 0 on success, 1 on failure
+ */
+int bench_bounds(int argc, char *argv[])
+{
+	char *default_sizes[] = { "1000000", "10000000" };
+
+	if (!argc) {
+		argc = 2;
+		argv = default_sizes;
+	}
+
+	printf("%12s %12s %12s %12s %12s %10s\n", "positions", "legacy ms",
+			"fused ms", "mt ms", "mt GB/s", "center err");
+
+	for (int i = 0; i < argc; i++) {
+		uint32_t const n = (uint32_t)strtoul(argv[i], NULL, 10);
+		double const bytes = 3.0 * sizeof(vector) * n;
+		vector *positions;
+		vector center = { 0, 0, 0 };
+		mesh_bounds bounds;
+		double best[3] = { 0, 0, 0 };
+
+		if (!n) {
+			fprintf(stderr, "Invalid size \"%s\"!\n", argv[i]);
+			return 1;
+		}
+
+		positions = malloc(sizeof(*positions) * n);
+		if (!positions) {
+			fprintf(stderr, "Out of memory for %u positions!\n", n);
+			return 1;
+		}
+
+		/* scaling by 1 keeps the input the same for every run */
+		for (int k = 0; k < 3; k++) {
+			double start = bench_now();
+
+			do {
+				double t;
+
+				/* the legacy pass scales them by its own factor */
+				if (k < 2)
+					fill_positions(positions, n);
+
+				t = bench_now();
+				if (k == 0) {
+					normalize_legacy(positions, n, &center);
+				} else {
+					positions_bounds(positions, n, k == 1 ? 1 : 0, &bounds);
+					transform_positions(positions, n, NULL, 1,
+							k == 1 ? 1 : 0);
+				}
+				t = bench_now() - t;
+
+				if (best[k] == 0 || t < best[k])
+					best[k] = t;
+			} while (bench_now() - start < BENCH_MIN_TIME);
+		}
+
+		printf("%12u %12.3f %12.3f %12.3f %12.2f %10.4f\n", n,
+				best[0] * 1e3, best[1] * 1e3, best[2] * 1e3,
+				bytes / best[2] / 1e9, fabs(center.x - bounds.center.x));
+
+		free(positions);
+	}
+
+	return 0;
+}
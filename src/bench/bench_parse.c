@@ -0,0 +1,329 @@
+/*
+ * Copyright 2011-2014 hasufell
+ *
+ * This file is part of a hasufell project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation version 2 of the License only.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file bench_parse.c
+ * Benchmarks for the .obj scanner, comparing it with the
+ * strtok_r/strcmp/atof tokenizer it replaced, as well as
+ * the whole parse_obj() pipeline.
+ * @brief parser benchmarks
+ */
+
+#include "bench.h"
+#include "filereader.h"
+#include "half_edge.h"
+#include "obj_scan.h"
+
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+/**
+ * Minimum time in seconds every measurement is repeated for.
+ */
+#define BENCH_MIN_TIME 0.5
+
+
+/*
+ * static function declaration
+ */
+static double tokenize_legacy(char const *buf, size_t len);
+static double tokenize_scan(char const *buf, size_t len);
+static double run_tokenizer(double (*tokenizer)(char const*, size_t),
+		char const *buf,
+		size_t len,
+		double *sum);
+static double run_parse_obj(char const *buf,
+		size_t len,
+		unsigned threads);
+static void bench_parse_mt_file(char const *filename);
+
+
+/**
+ * The tokenizer as it used to be in assemble_obj_arrays():
+ * copy the string, split it with strtok_r, dispatch by strcmp
+ * and convert with atof/atoi. The numbers are only summed up,
+ * for faces only the vertex indices.
+ *
+ * @param buf the .obj buffer
+ * @param len length of buf
+ * @return the sum of all numbers
+ */
+static double tokenize_legacy(char const *buf, size_t len)
+{
+	char *string = malloc(len + 1),
+		 *str_ptr_space = NULL,
+		 *str_ptr_newline = NULL,
+		 *str_ptr_slash = NULL,
+		 *line;
+	double sum = 0;
+
+	memcpy(string, buf, len);
+	string[len] = '\0';
+
+	line = strtok_r(string, "\n", &str_ptr_newline);
+	while (line && *line) {
+		char *word = strtok_r(line, " ", &str_ptr_space);
+
+		if (!strcmp(word, "v") || !strcmp(word, "vn") ||
+				!strcmp(word, "vt")) {
+			while ((word = strtok_r(NULL, " ", &str_ptr_space)))
+				sum += atof(word);
+		} else if (!strcmp(word, "f") || !strcmp(word, "curv")) {
+			while ((word = strtok_r(NULL, " ", &str_ptr_space))) {
+				char *id = strtok_r(word, "/", &str_ptr_slash);
+
+				sum += atoi(id);
+			}
+		}
+
+		line = strtok_r(NULL, "\n", &str_ptr_newline);
+	}
+
+	free(string);
+
+	return sum;
+}
+
+/**
+ * The same work as tokenize_legacy(), done by the scanner
+ * from obj_scan.c directly on the buffer.
+ *
+ * @param buf the .obj buffer
+ * @param len length of buf
+ * @return the sum of all numbers
+ */
+static double tokenize_scan(char const *buf, size_t len)
+{
+	char const *pos = buf,
+		  *end = buf + len;
+	double sum = 0;
+
+	while (pos < end) {
+		char const *line_end = scan_line_end(pos, end);
+		double vals[4];
+		uint32_t v,
+				 vt;
+		uint8_t n;
+
+		switch (scan_keyword(&pos, line_end)) {
+		case OBJ_KW_V:
+		case OBJ_KW_VN:
+		case OBJ_KW_VT:
+			n = scan_doubles(&pos, line_end, vals, 4);
+			for (uint8_t i = 0; i < n && i < 4; i++)
+				sum += vals[i];
+			break;
+		case OBJ_KW_F:
+		case OBJ_KW_CURV:
+			while (scan_face_index(&pos, line_end, &v, &vt))
+				sum += v;
+			break;
+		default:
+			break;
+		}
+
+		pos = (line_end < end) ? line_end + 1 : end;
+	}
+
+	return sum;
+}
+
+/**
+ * Run a tokenizer repeatedly for at least BENCH_MIN_TIME.
+ *
+ * @param tokenizer the tokenizer to run
+ * @param buf the .obj buffer
+ * @param len length of buf
+ * @param sum the checksum of the last run [out]
+ * @return the best throughput in MB/s
+ */
+static double run_tokenizer(double (*tokenizer)(char const*, size_t),
+		char const *buf,
+		size_t len,
+		double *sum)
+{
+	double best = 0,
+		   start = bench_now();
+
+	do {
+		double t = bench_now();
+
+		*sum = tokenizer(buf, len);
+		t = bench_now() - t;
+
+		if (best == 0 || t < best)
+			best = t;
+	} while (bench_now() - start < BENCH_MIN_TIME);
+
+	return len / best / 1e6;
+}
+
+/**
+ * Run parse_obj_parallel() repeatedly for at least BENCH_MIN_TIME.
+ *
+ * @param buf the .obj buffer
+ * @param len length of buf
+ * @param threads count of parser threads
+ * @return the best throughput in MB/s
+ */
+static double run_parse_obj(char const *buf,
+		size_t len,
+		unsigned threads)
+{
+	double best = 0,
+		   start = bench_now();
+
+	do {
+		double t = bench_now();
+		HE_obj *obj = parse_obj_parallel(buf, len, threads);
+
+		t = bench_now() - t;
+		delete_object(obj);
+		free(obj);
+
+		if (best == 0 || t < best)
+			best = t;
+	} while (bench_now() - start < BENCH_MIN_TIME);
+
+	return len / best / 1e6;
+}
+
+/**
+ * Measure the tokenizer and parse_obj() throughput for
+ * all given files.
+ *
+ * @param argc count of files
+ * @param argv the files, obj/Spacestation_1.obj if empty
+ * @return 0 on success, 1 on failure
+ */
+int bench_parse(int argc, char *argv[])
+{
+	char *default_file[] = { "obj/Spacestation_1.obj" };
+
+	if (!argc) {
+		argc = 1;
+		argv = default_file;
+	}
+
+	printf("%-32s %10s %12s %12s %12s\n", "file", "size",
+			"legacy MB/s", "scan MB/s", "parse MB/s");
+
+	for (int i = 0; i < argc; i++) {
+		size_t len;
+		char const *buf = map_file(argv[i], &len);
+		double legacy_sum,
+			   scan_sum,
+			   legacy,
+			   scan;
+
+		if (!buf) {
+			fprintf(stderr, "Failed to map \"%s\"!\n", argv[i]);
+			return 1;
+		}
+
+		legacy = run_tokenizer(tokenize_legacy, buf, len, &legacy_sum);
+		scan = run_tokenizer(tokenize_scan, buf, len, &scan_sum);
+
+		if (legacy_sum != scan_sum)
+			fprintf(stderr, "Checksum mismatch for \"%s\": %f vs %f\n",
+					argv[i], legacy_sum, scan_sum);
+
+		printf("%-32s %10zu %12.1f %12.1f %12.1f\n", argv[i], len,
+				legacy, scan, run_parse_obj(buf, len, 1));
+
+		unmap_file(buf, len);
+	}
+
+	return 0;
+}
+
+/**
+ * Measure the parse_obj_parallel() throughput of a file for
+ * an increasing count of threads.
+ *
+ * @param filename the .obj file
+ */
+static void bench_parse_mt_file(char const *filename)
+{
+	size_t len;
+	char const *buf = map_file(filename, &len);
+	double serial = 0;
+
+	if (!buf) {
+		fprintf(stderr, "Failed to map \"%s\"!\n", filename);
+		return;
+	}
+
+	for (unsigned threads = 1; threads <= 8; threads *= 2) {
+		double mbs = run_parse_obj(buf, len, threads);
+
+		if (threads == 1)
+			serial = mbs;
+
+		printf("%-40s %10zu %8u %12.1f %8.2fx\n", filename, len,
+				threads, mbs, mbs / serial);
+	}
+
+	unmap_file(buf, len);
+}
+
+/**
+ * Measure how parse_obj_parallel() scales with the count of
+ * threads for all given files.
+ *
+ * @param argc count of files
+ * @param argv the files, all files in obj/ if empty
+ * @return 0 on success, 1 on failure
+ */
+int bench_parse_mt(int argc, char *argv[])
+{
+	printf("%-40s %10s %8s %12s %9s\n", "file", "size",
+			"threads", "parse MB/s", "speedup");
+
+	if (argc) {
+		for (int i = 0; i < argc; i++)
+			bench_parse_mt_file(argv[i]);
+	} else {
+		DIR *dir = opendir("obj");
+		struct dirent *entry;
+
+		if (!dir) {
+			fprintf(stderr, "Failed to open \"obj\"!\n");
+			return 1;
+		}
+
+		while ((entry = readdir(dir))) {
+			char path[512];
+
+			/* only .obj files, not their caches */
+			if (strlen(entry->d_name) < 4 || strcmp(entry->d_name +
+						strlen(entry->d_name) - 4, ".obj"))
+				continue;
+
+			snprintf(path, sizeof(path), "obj/%s", entry->d_name);
+			bench_parse_mt_file(path);
+		}
+
+		closedir(dir);
+	}
+
+	return 0;
+}
@@ -0,0 +1,611 @@
+/*
+ * Copyright 2011-2014 hasufell
+ *
+ * This file is part of a hasufell project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation version 2 of the License only.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file bench_suite.c
+ * Runs every hot function of the library on every mesh in
+ * obj/ and on synthetic grids, and prints one JSON object per
+ * function and mesh with the median and 99th percentile time,
+ * the throughput and the allocations of a run. The lines are
+ * in a fixed order, so the results of two commits can be
+ * compared with diff or jq.
+ * @brief benchmark suite
+ */
+
+#include "bench.h"
+#include "bezier.h"
+#include "filereader.h"
+#include "half_edge.h"
+#include "half_edge_normals.h"
+
+#include <dirent.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+/**
+ * Minimum time in seconds every function is repeated for.
+ */
+#define SUITE_MIN_TIME 0.3
+
+/**
+ * Minimum count of runs of every function.
+ */
+#define SUITE_MIN_RUNS 5
+
+/**
+ * Maximum count of runs of every function.
+ */
+#define SUITE_MAX_RUNS 1000
+
+/**
+ * Count of points every bezier curve is evaluated at.
+ */
+#define SUITE_BEZIER_POINTS 1000
+
+
+typedef struct suite_input suite_input;
+typedef struct suite_case suite_case;
+
+
+/**
+ * A mesh the functions run on.
+ */
+struct suite_input {
+	/**
+	 * The file name, or the name of the grid.
+	 */
+	char *name;
+	/**
+	 * The .obj text.
+	 */
+	char *buf;
+	/**
+	 * Length of the text.
+	 */
+	size_t len;
+	/**
+	 * Count of faces.
+	 */
+	uint32_t faces;
+	/**
+	 * The parsed object, for the functions which
+	 * don't parse.
+	 */
+	HE_obj *obj;
+};
+
+/**
+ * A function which is benchmarked.
+ */
+struct suite_case {
+	/**
+	 * Name of the function.
+	 */
+	char const *name;
+	/**
+	 * Whether it parses the text, so that its throughput
+	 * is measured in MB/s as well.
+	 */
+	bool parses;
+	/**
+	 * Run the function once.
+	 *
+	 * @param in the input
+	 * @return false if it does not apply to the input
+	 */
+	bool (*run)(suite_input *in);
+};
+
+
+/*
+ * static function declaration
+ */
+static bool run_parse_obj(suite_input *in);
+static bool run_parse_obj_parallel(suite_input *in);
+static bool run_vec_normal(suite_input *in);
+static bool run_vertex_normals(suite_input *in);
+static bool run_find_center(suite_input *in);
+static bool run_bezier_point(suite_input *in);
+static int cmp_double(void const *a, void const *b);
+static int cmp_string(void const *a, void const *b);
+static void print_json_string(char const *str);
+static void run_case(suite_case const *c, suite_input *in);
+static void run_input(suite_input *in);
+static char *grid_obj(uint32_t faces, size_t *len, uint32_t *side);
+static bool load_file_input(char const *filename, suite_input *in);
+static bool load_grid_input(uint32_t faces, suite_input *in);
+static char **default_files(uint32_t *count);
+
+
+/**
+ * The functions, in the order of the output.
+ */
+static suite_case const cases[] = {
+	{ "parse_obj", true, run_parse_obj },
+	{ "parse_obj_parallel", true, run_parse_obj_parallel },
+	{ "vec_normal", false, run_vec_normal },
+	{ "compute_vertex_normals", false, run_vertex_normals },
+	{ "find_center", false, run_find_center },
+	{ "calculate_bezier_point", false, run_bezier_point },
+};
+
+/**
+ * Keeps the results of the functions alive, so they
+ * are not optimized away.
+ */
+static volatile double sink;
+
+
+/**
+ * Parse the text with parse_obj_buf().
+ *
+ * @param in the input
+ * @return true
+ */
+static bool run_parse_obj(suite_input *in)
+{
+	HE_obj *obj = parse_obj_buf(in->buf, in->len);
+
+	if (!obj)
+		return false;
+
+	delete_object(obj);
+	free(obj);
+
+	return true;
+}
+
+/**
+ * Parse the text with parse_obj_parallel() on all CPUs.
+ *
+ * @param in the input
+ * @return true
+ */
+static bool run_parse_obj_parallel(suite_input *in)
+{
+	HE_obj *obj = parse_obj_parallel(in->buf, in->len, 0);
+
+	if (!obj)
+		return false;
+
+	delete_object(obj);
+	free(obj);
+
+	return true;
+}
+
+/**
+ * Compute the normal of every vertex with vec_normal().
+ *
+ * @param in the input
+ * @return true
+ */
+static bool run_vec_normal(suite_input *in)
+{
+	double sum = 0;
+
+	for (uint32_t i = 0; i < in->obj->vc; i++) {
+		vector vn;
+
+		if (vec_normal(in->obj, i, &vn))
+			sum += vn.x;
+	}
+	sink = sum;
+
+	return true;
+}
+
+/**
+ * Compute all vertex normals at once.
+ *
+ * @param in the input
+ * @return true/false for success/failure
+ */
+static bool run_vertex_normals(suite_input *in)
+{
+	return compute_vertex_normals(in->obj, NORMAL_WEIGHT_AREA);
+}
+
+/**
+ * Compute the center of the object.
+ *
+ * @param in the input
+ * @return true/false for success/failure
+ */
+static bool run_find_center(suite_input *in)
+{
+	vector center;
+
+	if (!find_center(in->obj, &center))
+		return false;
+	sink = center.x;
+
+	return true;
+}
+
+/**
+ * Evaluate every bezier curve of the object at
+ * SUITE_BEZIER_POINTS points, one allocation per point.
+ *
+ * @param in the input
+ * @return false if the object has no curves
+ */
+static bool run_bezier_point(suite_input *in)
+{
+	double sum = 0;
+
+	if (!in->obj->bzc)
+		return false;
+
+	for (uint32_t i = 0; i < in->obj->bzc; i++) {
+		for (uint32_t j = 0; j < SUITE_BEZIER_POINTS; j++) {
+			vector *point = calculate_bezier_point(&(in->obj->bez_curves[i]),
+					(float)j / (SUITE_BEZIER_POINTS - 1));
+
+			if (!point)
+				return false;
+			sum += point->x;
+			free(point);
+		}
+	}
+	sink = sum;
+
+	return true;
+}
+
+/**
+ * Compare two doubles for qsort().
+ *
+ * @param a the first double
+ * @param b the second double
+ * @return -1, 0 or 1
+ */
+static int cmp_double(void const *a, void const *b)
+{
+	double const x = *(double const*)a,
+		  y = *(double const*)b;
+
+	return (x > y) - (x < y);
+}
+
+/**
+ * Compare two strings for qsort().
+ *
+ * @param a pointer to the first string
+ * @param b pointer to the second string
+ * @return the result of strcmp()
+ */
+static int cmp_string(void const *a, void const *b)
+{
+	return strcmp(*(char * const*)a, *(char * const*)b);
+}
+
+/**
+ * Print a string as a JSON string.
+ *
+ * @param str the string
+ */
+static void print_json_string(char const *str)
+{
+	putchar('"');
+	for (; *str; str++) {
+		if (*str == '"' || *str == '\\')
+			printf("\\%c", *str);
+		else if ((unsigned char)*str < 0x20)
+			printf("\\u%04x", (unsigned)*str);
+		else
+			putchar(*str);
+	}
+	putchar('"');
+}
+
+/**
+ * Run a function on an input until it ran for SUITE_MIN_TIME
+ * and SUITE_MIN_RUNS times, and print its line. The
+ * allocations are the ones of the last run, after the caches
+ * of the object are built. Nothing is printed if the
+ * function does not apply to the input.
+ *
+ * @param c the function
+ * @param in the input
+ */
+static void run_case(suite_case const *c, suite_input *in)
+{
+	double *times = malloc(sizeof(*times) * SUITE_MAX_RUNS);
+	double const start = bench_now();
+	uint32_t runs = 0;
+	uint64_t allocs = 0,
+			 alloc_bytes = 0;
+	double median,
+		   p99;
+
+	if (!times)
+		return;
+
+	while (runs < SUITE_MAX_RUNS && (runs < SUITE_MIN_RUNS ||
+				bench_now() - start < SUITE_MIN_TIME)) {
+		double t;
+
+		bench_alloc_reset();
+		t = bench_now();
+		if (!c->run(in)) {
+			free(times);
+			return;
+		}
+		times[runs++] = bench_now() - t;
+		allocs = bench_alloc_count();
+		alloc_bytes = bench_alloc_bytes();
+	}
+
+	qsort(times, runs, sizeof(*times), cmp_double);
+	median = runs % 2 ? times[runs / 2] :
+		(times[runs / 2 - 1] + times[runs / 2]) / 2;
+	/* nearest rank */
+	p99 = times[(runs * 99 + 99) / 100 - 1];
+
+	printf("{\"bench\": \"%s\", \"input\": ", c->name);
+	print_json_string(in->name);
+	printf(", \"bytes\": %zu, \"faces\": %u, \"runs\": %u, "
+			"\"median_ms\": %.6f, \"p99_ms\": %.6f, ",
+			in->len, in->faces, runs, median * 1e3, p99 * 1e3);
+	if (c->parses)
+		printf("\"mb_s\": %.2f, ", in->len / median / 1e6);
+	else
+		printf("\"mb_s\": null, ");
+	printf("\"faces_s\": %.0f, \"allocs\": %llu, \"alloc_bytes\": %llu}\n",
+			in->faces / median, (unsigned long long)allocs,
+			(unsigned long long)alloc_bytes);
+	fflush(stdout);
+
+	free(times);
+}
+
+/**
+ * Run all functions on an input. The parsers run first, then
+ * the text is freed and parsed once for the others, so that
+ * only one parsed object is alive at a time.
+ *
+ * @param in the input, its text is freed [mod]
+ */
+static void run_input(suite_input *in)
+{
+	uint32_t const case_c = sizeof(cases) / sizeof(*cases);
+	HE_obj *obj;
+
+	if (!(obj = parse_obj_buf(in->buf, in->len))) {
+		fprintf(stderr, "Failed to parse \"%s\"!\n", in->name);
+		return;
+	}
+	in->faces = obj->fc;
+	delete_object(obj);
+	free(obj);
+
+	for (uint32_t i = 0; i < case_c; i++)
+		if (cases[i].parses)
+			run_case(&(cases[i]), in);
+
+	in->obj = parse_obj_buf(in->buf, in->len);
+	free(in->buf);
+	in->buf = NULL;
+	if (!in->obj)
+		return;
+
+	for (uint32_t i = 0; i < case_c; i++)
+		if (!cases[i].parses)
+			run_case(&(cases[i]), in);
+
+	delete_object(in->obj);
+	free(in->obj);
+	in->obj = NULL;
+}
+
+/**
+ * Create the .obj text of a flat grid of quads.
+ *
+ * @param faces the wanted count of faces, which is rounded
+ * to the nearest square
+ * @param len the length of the text [out]
+ * @param side count of quads along a side [out]
+ * @return the newly allocated text
+ */
+static char *grid_obj(uint32_t faces, size_t *len, uint32_t *side)
+{
+	uint32_t const n = faces > 1 ? (uint32_t)lround(sqrt(faces)) : 1;
+	/* "v %u %u 0\n" and "f %u %u %u %u\n" with 10 digit numbers */
+	size_t const size = (size_t)(n + 1) * (n + 1) * 26 +
+		(size_t)n * n * 46 + 1;
+	char *buf = malloc(size),
+		 *pos = buf;
+
+	if (!buf)
+		return NULL;
+
+	for (uint32_t y = 0; y <= n; y++)
+		for (uint32_t x = 0; x <= n; x++)
+			pos += sprintf(pos, "v %u %u 0\n", x, y);
+
+	for (uint32_t y = 0; y < n; y++) {
+		for (uint32_t x = 0; x < n; x++) {
+			uint32_t const v = y * (n + 1) + x + 1;
+
+			pos += sprintf(pos, "f %u %u %u %u\n", v, v + 1,
+					v + n + 2, v + n + 1);
+		}
+	}
+
+	*len = (size_t)(pos - buf);
+	*side = n;
+
+	return buf;
+}
+
+/**
+ * Read a .obj file as input.
+ *
+ * @param filename the file
+ * @param in the input [out]
+ * @return true/false for success/failure
+ */
+static bool load_file_input(char const *filename, suite_input *in)
+{
+	memset(in, 0, sizeof(*in));
+
+	if (!(in->buf = read_file(filename)))
+		return false;
+	in->len = strlen(in->buf);
+	in->name = strdup(filename);
+
+	return in->name != NULL;
+}
+
+/**
+ * Create a grid as input.
+ *
+ * @param faces the wanted count of faces
+ * @param in the input [out]
+ * @return true/false for success/failure
+ */
+static bool load_grid_input(uint32_t faces, suite_input *in)
+{
+	uint32_t side;
+
+	memset(in, 0, sizeof(*in));
+
+	if (!(in->buf = grid_obj(faces, &(in->len), &side)))
+		return false;
+	in->name = malloc(32);
+	if (!in->name)
+		return false;
+	sprintf(in->name, "grid-%ux%u", side, side);
+
+	return true;
+}
+
+/**
+ * Get all .obj files in obj/, sorted by name.
+ *
+ * @param count count of files [out]
+ * @return the newly allocated paths
+ */
+static char **default_files(uint32_t *count)
+{
+	DIR *dir = opendir("obj");
+	struct dirent *entry;
+	char **files = NULL;
+	uint32_t file_c = 0;
+
+	*count = 0;
+	if (!dir)
+		return NULL;
+
+	while ((entry = readdir(dir))) {
+		size_t const name_len = strlen(entry->d_name);
+		char **tmp;
+
+		/* only .obj files, not their caches */
+		if (name_len < 4 || strcmp(entry->d_name + name_len - 4, ".obj"))
+			continue;
+
+		if (!(tmp = realloc(files, sizeof(*files) * (file_c + 1))))
+			break;
+		files = tmp;
+		if (!(files[file_c] = malloc(name_len + 5)))
+			break;
+		sprintf(files[file_c++], "obj/%s", entry->d_name);
+	}
+	closedir(dir);
+
+	qsort(files, file_c, sizeof(*files), cmp_string);
+	*count = file_c;
+
+	return files;
+}
+
+/**
+ * Run the suite on the given files and grids, or on every
+ * .obj file in obj/ and grids of 1M and 10M faces.
+ *
+ * @param argc count of arguments
+ * @param argv "--grid <faces>" or .obj files
+ * @return 0 on success, 1 on failure
+ */
+int bench_suite(int argc, char *argv[])
+{
+	char **files = NULL;
+	uint32_t file_c = 0,
+			 grids[] = { 1000000, 10000000 },
+			 grid_c = 2;
+	uint32_t *arg_grids = NULL;
+	int ret = 0;
+
+	if (argc) {
+		files = malloc(sizeof(*files) * argc);
+		arg_grids = malloc(sizeof(*arg_grids) * argc);
+		if (!files || !arg_grids)
+			return 1;
+
+		grid_c = 0;
+		for (int i = 0; i < argc; i++) {
+			if (!strcmp(argv[i], "--grid") && i + 1 < argc) {
+				arg_grids[grid_c++] = (uint32_t)strtoul(argv[++i], NULL, 10);
+			} else {
+				files[file_c] = strdup(argv[i]);
+				if (!files[file_c++])
+					return 1;
+			}
+		}
+	} else {
+		files = default_files(&file_c);
+	}
+
+	for (uint32_t i = 0; i < file_c; i++) {
+		suite_input in;
+
+		if (!load_file_input(files[i], &in)) {
+			fprintf(stderr, "Failed to read \"%s\"!\n", files[i]);
+			ret = 1;
+		} else {
+			run_input(&in);
+		}
+		free(in.buf);
+		free(in.name);
+		free(files[i]);
+	}
+	free(files);
+
+	for (uint32_t i = 0; i < grid_c; i++) {
+		suite_input in;
+
+		if (!load_grid_input(arg_grids ? arg_grids[i] : grids[i], &in)) {
+			fprintf(stderr, "Failed to create a grid!\n");
+			ret = 1;
+		} else {
+			run_input(&in);
+		}
+		free(in.buf);
+		free(in.name);
+	}
+	free(arg_grids);
+
+	return ret;
+}
@@ -20,59 +20,107 @@
  * @file bezier.c
  * This file provides operations and informational functions
  * on the bezier data type which is defined in bezier.h.
+ * Points are evaluated either one at a time with the de
+ * Casteljau algorithm in a scratch buffer or many at a time
+ * in the Bernstein form, neither of which allocates.
+ * For drawing, curves are tessellated adaptively into polylines
+ * which are kept until the curve changes.
  * @brief operations on bezier curves
  */
 
 #include "bezier.h"
 #include "vector.h"
+#include "vector_simd.h"
 
+#include <stdbool.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
+
+
+/**
+ * Count of points eval_bezier_points() works on at once,
+ * in arrays on the stack.
+ */
+#define BEZIER_BLOCK 64
 
 
 /*
  * static function declaration
  */
-static bool get_section_vec(const vector *a,
-		const vector *b,
-		vector *c,
-		const float section);
-static vector *calculate_bezier_point_rec(const bez_curv *bez,
-		const float section,
-		const uint32_t deg);
+static void bernstein_block(const bez_curv *bez,
+		float const *sections,
+		uint32_t n,
+		vector *points);
+static bool is_flat(vector const *ctrl, uint32_t deg, float tol2);
+static void split_bez(vector const *ctrl,
+		uint32_t deg,
+		vector *left,
+		vector *right);
+static bool append_poly_point(bez_poly *poly, vector point);
+static bool subdivide_bez(vector const *ctrl,
+		uint32_t deg,
+		float tol2,
+		uint32_t depth,
+		vector *scratch,
+		bez_poly *poly);
 
 
 /**
- * Get the vector that is in between the to control
- * points a and b and in the specified section from 0 to 1.
+ * Evaluate a block of points of a curve in the Bernstein form,
+ * with a Horner-like scheme which needs no scratch space.
+ * The loops run over all points of the block for every control
+ * point, so the compiler can vectorize them.
  *
- * @param a first control point
- * @param b second control point
- * @param c store the result here [out]
- * @param section the section between 0 and 1
- * @return true/false for success/failure
+ * @param bez the bezier curve, of degree 1 or higher
+ * @param sections the sections of the points
+ * @param n count of points, at most BEZIER_BLOCK
+ * @param points the points [out]
  */
-static bool get_section_vec(const vector *a,
-		const vector *b,
-		vector *c,
-		const float section)
+static void bernstein_block(const bez_curv *bez,
+		float const *sections,
+		uint32_t n,
+		vector *points)
 {
-	vector a_tmp,
-		   b_tmp;
+	uint32_t const deg = bez->deg;
+	vector const *vec = bez->vec;
+	float s[BEZIER_BLOCK],
+		  tn[BEZIER_BLOCK],
+		  x[BEZIER_BLOCK],
+		  y[BEZIER_BLOCK],
+		  z[BEZIER_BLOCK];
+	float binom = 1;
 
-	if (!a || !b || !c)
-		return false;
+	for (uint32_t j = 0; j < n; j++) {
+		s[j] = 1 - sections[j];
+		tn[j] = 1;
+		x[j] = vec[0].x * s[j];
+		y[j] = vec[0].y * s[j];
+		z[j] = vec[0].z * s[j];
+	}
 
-	copy_vector(a, &a_tmp);
-	copy_vector(b, &b_tmp);
+	/* sum up binom(deg, i) * t^i * (1 - t)^(deg - i) * vec[i] */
+	for (uint32_t i = 1; i < deg; i++) {
+		binom = binom * (deg - i + 1) / i;
 
-	set_null_vector(c);
+		for (uint32_t j = 0; j < n; j++) {
+			float f;
 
-	SUB_VECTORS(&a_tmp, &b_tmp, c);
-	VECTOR_LEN_SCAL_MUL(c, section, c);
-	ADD_VECTORS(c, b, c);
+			tn[j] *= sections[j];
+			f = tn[j] * binom;
+			x[j] = (x[j] + f * vec[i].x) * s[j];
+			y[j] = (y[j] + f * vec[i].y) * s[j];
+			z[j] = (z[j] + f * vec[i].z) * s[j];
+		}
+	}
 
-	return true;
+	for (uint32_t j = 0; j < n; j++) {
+		float const f = tn[j] * sections[j];
+
+		points[j].x = x[j] + f * vec[deg].x;
+		points[j].y = y[j] + f * vec[deg].y;
+		points[j].z = z[j] + f * vec[deg].z;
+	}
 }
 
 /**
@@ -83,47 +131,126 @@ static bool get_section_vec(const vector *a,
  * @param bez the bezier curve to calcluate the point from
  * @param section the section which will be applied to all
  * lines between the bezier vertices
- * @param deg the degree of the bezier curve, this needs to be passed
- * because the function is recursive
- * @return the vector to the calculated point, newly allocated
+ * @return the vector to the calculated point, newly allocated,
+ * NULL on failure
  */
-static vector *calculate_bezier_point_rec(const bez_curv *bez,
-		const float section,
-		const uint32_t deg)
+vector *calculate_bezier_point(const bez_curv *bez,
+		const float section)
 {
-	bez_curv new_bez = { NULL, 0 };
+	vector *point = malloc(sizeof(*point));
 
-	if (!get_reduced_bez_curv(bez, &new_bez, section))
+	if (!point)
 		return NULL;
 
-	if (bez->deg < deg)
-		free(bez->vec);
-
-	if (new_bez.deg > 0) {
-		return calculate_bezier_point_rec(&new_bez, section, deg);
-	} else {
-		vector *result_vector = malloc(sizeof(*result_vector));
-		*result_vector = new_bez.vec[0];
-		free(new_bez.vec);
-
-		return result_vector;
+	if (!eval_bezier_point(bez, section, NULL, point)) {
+		free(point);
+		return NULL;
 	}
+
+	return point;
 }
 
 /**
- * Calculate a point on the bezier curve according to the
- * bezier vertices. If section is set to 0.5 then it will
- * return the vector to the point in the middle of the curve.
+ * Calculate a point on the bezier curve with the de Casteljau
+ * algorithm, reducing the curve in place in a scratch buffer
+ * instead of allocating every reduced curve.
  *
  * @param bez the bezier curve to calcluate the point from
  * @param section the section which will be applied to all
  * lines between the bezier vertices
- * @return the vector to the calculated point, newly allocated
+ * @param scratch room for deg + 1 vectors, or NULL to use
+ * one on the stack up to BEZIER_STACK_DEG and the Bernstein
+ * form above that [mod]
+ * @param point the calculated point [out]
+ * @return true/false for success/failure
  */
-vector *calculate_bezier_point(const bez_curv *bez,
-		const float section)
+bool eval_bezier_point(const bez_curv *bez,
+		const float section,
+		vector *scratch,
+		vector *point)
 {
-	return calculate_bezier_point_rec(bez, section, bez->deg);
+	vector stack_scratch[BEZIER_STACK_DEG + 1];
+
+	if (!bez || !bez->vec || !point)
+		return false;
+
+	if (!scratch) {
+		if (bez->deg > BEZIER_STACK_DEG)
+			return eval_bezier_points(bez, &section, 1, point);
+		scratch = stack_scratch;
+	}
+
+	for (uint32_t i = 0; i <= bez->deg; i++)
+		scratch[i] = bez->vec[i];
+
+	/* every new point is in the section between two old ones */
+	for (uint32_t deg = bez->deg; deg > 0; deg--)
+		for (uint32_t i = 0; i < deg; i++)
+			scratch[i] = vec_lerp(scratch[i], scratch[i + 1], section);
+
+	*point = scratch[0];
+
+	return true;
+}
+
+/**
+ * Calculate many points on the bezier curve at once.
+ *
+ * @param bez the bezier curve to calcluate the points from
+ * @param sections the sections of the points
+ * @param n count of points
+ * @param points the calculated points [out]
+ * @return true/false for success/failure
+ */
+bool eval_bezier_points(const bez_curv *bez,
+		float const *sections,
+		uint32_t n,
+		vector *points)
+{
+	if (!bez || !bez->vec || (n && (!sections || !points)))
+		return false;
+
+	if (!bez->deg) {
+		for (uint32_t i = 0; i < n; i++)
+			points[i] = bez->vec[0];
+		return true;
+	}
+
+	for (uint32_t i = 0; i < n; i += BEZIER_BLOCK)
+		bernstein_block(bez, sections + i,
+				n - i < BEZIER_BLOCK ? n - i : BEZIER_BLOCK,
+				points + i);
+
+	return true;
+}
+
+/**
+ * Calculate n points on the bezier curve, evenly spread over
+ * the sections from 0 to 1, both ends included.
+ *
+ * @param bez the bezier curve to calcluate the points from
+ * @param n count of points, at least 2
+ * @param points the calculated points [out]
+ * @return true/false for success/failure
+ */
+bool sample_bezier_curve(const bez_curv *bez,
+		uint32_t n,
+		vector *points)
+{
+	float sections[BEZIER_BLOCK];
+
+	if (n < 2 || !bez || !bez->vec || !points)
+		return false;
+
+	for (uint32_t i = 0; i < n; i += BEZIER_BLOCK) {
+		uint32_t const m = n - i < BEZIER_BLOCK ? n - i : BEZIER_BLOCK;
+
+		for (uint32_t j = 0; j < m; j++)
+			sections[j] = (float)(i + j) / (n - 1);
+		eval_bezier_points(bez, sections, m, points + i);
+	}
+
+	return true;
 }
 
 /**
@@ -147,19 +274,200 @@ bool get_reduced_bez_curv(const bez_curv *bez,
 		return false;
 
 	vec_arr = malloc(sizeof(*vec_arr) * bez->deg);
-	for (uint32_t i = 0; i < bez->deg; i++) {
-		vector new_vec;
 
-		get_section_vec(&(bez->vec[i + 1]),
-				&(bez->vec[i]),
-				&new_vec,
-				section);
-
-		vec_arr[i] = new_vec;
-	}
+	/* every new point is in the section between two old ones */
+	vec_batch_lerp(bez->vec, bez->vec + 1, vec_arr, bez->deg, section);
 
 	new_bez->vec = vec_arr;
 	new_bez->deg = bez->deg - 1;
 
 	return true;
 }
+
+/**
+ * Check whether all inner control points are close enough to
+ * the line segment between the end points. The curve is in their
+ * convex hull, so it is then as close to the segment, too.
+ *
+ * @param ctrl the control points
+ * @param deg the degree of the curve
+ * @param tol2 the squared tolerance
+ * @return true if the segment is close enough to the curve
+ */
+static bool is_flat(vector const *ctrl, uint32_t deg, float tol2)
+{
+	vector const chord = vec_sub(ctrl[deg], ctrl[0]);
+	float const len2 = vec_dot(chord, chord);
+
+	for (uint32_t i = 1; i < deg; i++) {
+		vector diff = vec_sub(ctrl[i], ctrl[0]);
+
+		if (len2 > 0) {
+			float t = vec_dot(diff, chord) / len2;
+
+			t = t < 0 ? 0 : (t > 1 ? 1 : t);
+			diff = vec_sub(diff, vec_scale(chord, t));
+		}
+
+		if (vec_dot(diff, diff) > tol2)
+			return false;
+	}
+
+	return true;
+}
+
+/**
+ * Split a curve in the middle into two curves of the same
+ * degree with the de Casteljau algorithm. The reduction runs
+ * in place in the right half, whose last points are left
+ * alone by every level after theirs.
+ *
+ * @param ctrl the control points
+ * @param deg the degree of the curve
+ * @param left the control points of the first half [out]
+ * @param right the control points of the second half [out]
+ */
+static void split_bez(vector const *ctrl,
+		uint32_t deg,
+		vector *left,
+		vector *right)
+{
+	for (uint32_t i = 0; i <= deg; i++)
+		right[i] = ctrl[i];
+
+	for (uint32_t k = 0; k <= deg; k++) {
+		left[k] = right[0];
+		for (uint32_t i = 0; i < deg - k; i++)
+			right[i] = vec_lerp(right[i], right[i + 1], 0.5f);
+	}
+}
+
+/**
+ * Append a point to a polyline, growing it if necessary.
+ *
+ * @param poly the polyline [mod]
+ * @param point the point
+ * @return true/false for success/failure
+ */
+static bool append_poly_point(bez_poly *poly, vector point)
+{
+	if (poly->point_c == poly->point_cap) {
+		uint32_t const cap = poly->point_cap ? poly->point_cap * 2 : 64;
+		vector *points = realloc(poly->points, sizeof(*points) * cap);
+
+		if (!points)
+			return false;
+		poly->points = points;
+		poly->point_cap = cap;
+	}
+
+	poly->points[poly->point_c++] = point;
+
+	return true;
+}
+
+/**
+ * Halve a curve until its parts are flat and append their
+ * end points to the polyline.
+ *
+ * @param ctrl the control points
+ * @param deg the degree of the curve
+ * @param tol2 the squared tolerance
+ * @param depth how often the curve was halved already
+ * @param scratch room for 2 * (deg + 1) vectors for every
+ * level below depth up to BEZIER_MAX_DEPTH [mod]
+ * @param poly the polyline [mod]
+ * @return true/false for success/failure
+ */
+static bool subdivide_bez(vector const *ctrl,
+		uint32_t deg,
+		float tol2,
+		uint32_t depth,
+		vector *scratch,
+		bez_poly *poly)
+{
+	vector *left = scratch,
+		   *right = scratch + deg + 1;
+
+	if (depth == BEZIER_MAX_DEPTH || is_flat(ctrl, deg, tol2))
+		return append_poly_point(poly, ctrl[deg]);
+
+	split_bez(ctrl, deg, left, right);
+
+	return subdivide_bez(left, deg, tol2, depth + 1,
+				scratch + 2 * (deg + 1), poly) &&
+		subdivide_bez(right, deg, tol2, depth + 1,
+				scratch + 2 * (deg + 1), poly);
+}
+
+/**
+ * Get the polyline of a bezier curve which is nowhere further
+ * away from the curve than the tolerance. The curve is halved
+ * until every part is flat, so flat stretches get few segments
+ * and tight bends many. If the polyline is of the same control
+ * points and tolerance already, it is left as it is.
+ *
+ * @param bez the bezier curve
+ * @param tolerance the largest distance between the curve and
+ * the polyline, greater than 0
+ * @param poly the polyline, zeroed or from an earlier call [mod]
+ * @return true/false for success/failure
+ */
+bool get_bez_poly(const bez_curv *bez,
+		float tolerance,
+		bez_poly *poly)
+{
+	size_t const ctrl_size = sizeof(vector) * (bez ? bez->deg + 1 : 0);
+	vector *scratch;
+	bool success;
+
+	if (!bez || !bez->vec || !poly || !(tolerance > 0))
+		return false;
+
+	if (poly->ctrl && poly->deg == bez->deg &&
+			poly->tolerance == tolerance &&
+			!memcmp(poly->ctrl, bez->vec, ctrl_size))
+		return true;
+
+	if (!poly->ctrl || poly->deg != bez->deg) {
+		free(poly->ctrl);
+		poly->ctrl = malloc(ctrl_size);
+	}
+	scratch = malloc(ctrl_size * 2 * BEZIER_MAX_DEPTH);
+
+	poly->point_c = 0;
+	success = poly->ctrl && scratch &&
+		append_poly_point(poly, bez->vec[0]) &&
+		subdivide_bez(bez->vec, bez->deg, tolerance * tolerance, 0,
+				scratch, poly);
+	free(scratch);
+
+	if (!success) {
+		free(poly->ctrl);
+		poly->ctrl = NULL;
+		poly->point_c = 0;
+		return false;
+	}
+
+	memcpy(poly->ctrl, bez->vec, ctrl_size);
+	poly->deg = bez->deg;
+	poly->tolerance = tolerance;
+	poly->version++;
+
+	return true;
+}
+
+/**
+ * Free the polyline of a bezier curve and zero it.
+ *
+ * @param poly the polyline [mod]
+ */
+void delete_bez_poly(bez_poly *poly)
+{
+	if (!poly)
+		return;
+
+	free(poly->points);
+	free(poly->ctrl);
+	memset(poly, 0, sizeof(*poly));
+}
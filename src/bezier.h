@@ -28,10 +28,61 @@
 
 #include "vector.h"
 
+#include <stdbool.h>
 #include <stdint.h>
 
 
+/**
+ * Fault intolerant macro. Will abort the program if the called
+ * function failed.
+ */
+#define EVAL_BEZIER_POINT(...) \
+{ \
+	if (!eval_bezier_point(__VA_ARGS__)) { \
+		fprintf(stderr, "Failure in eval_bezier_point()!\n"); \
+		abort(); \
+	} \
+}
+
+/**
+ * Fault intolerant macro. Will abort the program if the called
+ * function failed.
+ */
+#define SAMPLE_BEZIER_CURVE(...) \
+{ \
+	if (!sample_bezier_curve(__VA_ARGS__)) { \
+		fprintf(stderr, "Failure in sample_bezier_curve()!\n"); \
+		abort(); \
+	} \
+}
+
+/**
+ * Fault intolerant macro. Will abort the program if the called
+ * function failed.
+ */
+#define GET_BEZ_POLY(...) \
+{ \
+	if (!get_bez_poly(__VA_ARGS__)) { \
+		fprintf(stderr, "Failure in get_bez_poly()!\n"); \
+		abort(); \
+	} \
+}
+
+/**
+ * Highest degree eval_bezier_point() handles in a scratch
+ * buffer on the stack if the caller passes none.
+ */
+#define BEZIER_STACK_DEG 31
+
+/**
+ * How often get_bez_poly() halves a curve at most, so
+ * a polyline has at most 2^BEZIER_MAX_DEPTH segments.
+ */
+#define BEZIER_MAX_DEPTH 16
+
+
 typedef struct bez_curv bez_curv;
+typedef struct bez_poly bez_poly;
 
 
 /**
@@ -48,11 +99,64 @@ struct bez_curv {
 	uint32_t deg;
 };
 
+/**
+ * Polyline of a bezier curve, tessellated by get_bez_poly()
+ * and kept until the curve or the tolerance changes.
+ * A zeroed one is empty.
+ */
+struct bez_poly {
+	/**
+	 * Points of the polyline, starting with the first
+	 * and ending with the last control point.
+	 */
+	vector *points;
+	/**
+	 * Count of points.
+	 */
+	uint32_t point_c;
+	/**
+	 * Count of points there is room for.
+	 */
+	uint32_t point_cap;
+	/**
+	 * Copy of the control points the polyline is of.
+	 */
+	vector *ctrl;
+	/**
+	 * Degree of the curve the polyline is of.
+	 */
+	uint32_t deg;
+	/**
+	 * Largest distance between the curve and the polyline.
+	 */
+	float tolerance;
+	/**
+	 * Incremented on every tessellation, so users of the
+	 * points know when they changed.
+	 */
+	uint32_t version;
+};
+
 
 bool get_reduced_bez_curv(const bez_curv *bez,
 		bez_curv *new_bez,
 		const float section);
 vector *calculate_bezier_point(const bez_curv *bez,
 		const float section);
+bool eval_bezier_point(const bez_curv *bez,
+		const float section,
+		vector *scratch,
+		vector *point);
+bool eval_bezier_points(const bez_curv *bez,
+		float const *sections,
+		uint32_t n,
+		vector *points);
+bool sample_bezier_curve(const bez_curv *bez,
+		uint32_t n,
+		vector *points);
+bool get_bez_poly(const bez_curv *bez,
+		float tolerance,
+		bez_poly *poly);
+void delete_bez_poly(bez_poly *poly);
 
 #endif /* _DROW_ENGINE_BEZIER_H */
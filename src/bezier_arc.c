@@ -0,0 +1,333 @@
+/*
+ * Copyright 2011-2014 hasufell
+ *
+ * This file is part of a hasufell project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation version 2 of the License only.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file bezier_arc.c
+ * Arc length tables of bezier curves, which map a distance
+ * along a curve to its section, so that things can move along
+ * the curve at a constant speed. The table is built once from
+ * a polyline through evenly spread sections and looked up by
+ * binary search.
+ * @brief arc length of bezier curves
+ */
+
+#include "bezier.h"
+#include "bezier_arc.h"
+#include "vector.h"
+#include "vector_simd.h"
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+/**
+ * Count of distances bez_arc_points() looks up at once,
+ * in an array on the stack.
+ */
+#define BEZ_ARC_BLOCK 64
+
+
+/*
+ * static function declaration
+ */
+static bool build_bez_arc(const bez_curv *bez,
+		uint32_t sample_c,
+		bez_arc *arc);
+
+
+/**
+ * Build the table of an arc, whose buffers are allocated
+ * for the degree and count of samples already.
+ *
+ * @param bez the bezier curve
+ * @param sample_c count of samples
+ * @param arc the arc [mod]
+ * @return true/false for success/failure
+ */
+static bool build_bez_arc(const bez_curv *bez,
+		uint32_t sample_c,
+		bez_arc *arc)
+{
+	vector *points = malloc(sizeof(*points) * sample_c);
+	float length = 0;
+
+	if (!points || !sample_bezier_curve(bez, sample_c, points)) {
+		free(points);
+		return false;
+	}
+
+	arc->lengths[0] = 0;
+	for (uint32_t i = 1; i < sample_c; i++) {
+		vector const d = vec_sub(points[i], points[i - 1]);
+
+		length += sqrtf(vec_dot(d, d));
+		arc->lengths[i] = length;
+	}
+	free(points);
+
+	memcpy(arc->ctrl, bez->vec, sizeof(vector) * (bez->deg + 1));
+	for (uint32_t i = 0; i < bez->deg; i++)
+		arc->deriv[i] = vec_scale(vec_sub(bez->vec[i + 1], bez->vec[i]),
+				(float)bez->deg);
+	arc->deg = bez->deg;
+	arc->sample_c = sample_c;
+	arc->length = length;
+
+	return true;
+}
+
+/**
+ * Get the arc length table of a bezier curve. If the table is
+ * of the same control points and count of samples already,
+ * it is left as it is.
+ *
+ * @param bez the bezier curve
+ * @param sample_c count of samples, at least 2, more make the
+ * distances more exact, BEZ_ARC_SAMPLES is a good default
+ * @param arc the arc, zeroed or from an earlier call [mod]
+ * @return true/false for success/failure
+ */
+bool get_bez_arc(const bez_curv *bez,
+		uint32_t sample_c,
+		bez_arc *arc)
+{
+	if (!bez || !bez->vec || !arc || sample_c < 2)
+		return false;
+
+	if (arc->ctrl && arc->deg == bez->deg && arc->sample_c == sample_c &&
+			!memcmp(arc->ctrl, bez->vec, sizeof(vector) * (bez->deg + 1)))
+		return true;
+
+	if (!arc->ctrl || arc->deg != bez->deg || arc->sample_c != sample_c) {
+		delete_bez_arc(arc);
+		arc->ctrl = malloc(sizeof(*arc->ctrl) * (bez->deg + 1));
+		/* at least one, so a curve of degree 0 has one, too */
+		arc->deriv = malloc(sizeof(*arc->deriv) * (bez->deg + 1));
+		arc->lengths = malloc(sizeof(*arc->lengths) * sample_c);
+	}
+
+	if (!arc->ctrl || !arc->deriv || !arc->lengths ||
+			!build_bez_arc(bez, sample_c, arc)) {
+		delete_bez_arc(arc);
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * Free the arc length table of a bezier curve and zero it.
+ *
+ * @param arc the arc [mod]
+ */
+void delete_bez_arc(bez_arc *arc)
+{
+	if (!arc)
+		return;
+
+	free(arc->ctrl);
+	free(arc->deriv);
+	free(arc->lengths);
+	memset(arc, 0, sizeof(*arc));
+}
+
+/**
+ * Get the section of the point at a distance along the curve,
+ * with a binary search through the table.
+ *
+ * @param arc the arc
+ * @param distance the distance from the start of the curve,
+ * clamped to the length of the curve
+ * @return the section between 0 and 1
+ */
+float bez_arc_section(bez_arc const *arc,
+		float distance)
+{
+	uint32_t lo = 0,
+			 hi = arc->sample_c - 1;
+	float seg;
+
+	if (!(distance > 0) || !(arc->length > 0))
+		return 0;
+	if (distance >= arc->length)
+		return 1;
+
+	/* lengths[lo] <= distance < lengths[hi] */
+	while (hi - lo > 1) {
+		uint32_t const mid = lo + (hi - lo) / 2;
+
+		if (arc->lengths[mid] <= distance)
+			lo = mid;
+		else
+			hi = mid;
+	}
+
+	seg = arc->lengths[hi] - arc->lengths[lo];
+
+	return (lo + (seg > 0 ? (distance - arc->lengths[lo]) / seg : 0)) /
+		(arc->sample_c - 1);
+}
+
+/**
+ * Get the point at a distance along the curve and the
+ * direction of the curve there.
+ *
+ * @param arc the arc
+ * @param distance the distance from the start of the curve,
+ * clamped to the length of the curve
+ * @param point the point [out]
+ * @param tangent the normalized direction of the curve, a null
+ * vector if it has none, or NULL if not needed [out]
+ * @return true/false for success/failure
+ */
+bool bez_arc_point(bez_arc const *arc,
+		float distance,
+		vector *point,
+		vector *tangent)
+{
+	float section;
+	bez_curv bez;
+
+	if (!arc || !arc->ctrl || !point)
+		return false;
+
+	section = bez_arc_section(arc, distance);
+	bez.vec = arc->ctrl;
+	bez.deg = arc->deg;
+	if (!eval_bezier_point(&bez, section, NULL, point))
+		return false;
+
+	if (tangent) {
+		if (!arc->deg) {
+			SET_NULL_VECTOR(tangent);
+			return true;
+		}
+
+		bez.vec = arc->deriv;
+		bez.deg = arc->deg - 1;
+		if (!eval_bezier_point(&bez, section, NULL, tangent))
+			return false;
+		*tangent = vec_normalize(*tangent);
+	}
+
+	return true;
+}
+
+/**
+ * Get the points at many distances along the curve at once.
+ *
+ * @param arc the arc
+ * @param distances the distances from the start of the curve,
+ * clamped to the length of the curve
+ * @param n count of distances
+ * @param points the points [out]
+ * @return true/false for success/failure
+ */
+bool bez_arc_points(bez_arc const *arc,
+		float const *distances,
+		uint32_t n,
+		vector *points)
+{
+	float sections[BEZ_ARC_BLOCK];
+	bez_curv bez;
+
+	if (!arc || !arc->ctrl || (n && (!distances || !points)))
+		return false;
+
+	bez.vec = arc->ctrl;
+	bez.deg = arc->deg;
+
+	for (uint32_t i = 0; i < n; i += BEZ_ARC_BLOCK) {
+		uint32_t const m = n - i < BEZ_ARC_BLOCK ? n - i : BEZ_ARC_BLOCK;
+
+		for (uint32_t j = 0; j < m; j++)
+			sections[j] = bez_arc_section(arc, distances[i + j]);
+		if (!eval_bezier_points(&bez, sections, m, points + i))
+			return false;
+	}
+
+	return true;
+}
+
+/**
+ * Get the frame at a distance along the curve as a 4x4 matrix
+ * in the column-major order of OpenGL, which can be passed to
+ * glMultMatrixf(). Its x axis is the direction of the curve,
+ * its z axis is perpendicular to that and to the up vector,
+ * its y axis is perpendicular to both and its origin is the
+ * point on the curve.
+ *
+ * @param arc the arc
+ * @param distance the distance from the start of the curve,
+ * clamped to the length of the curve
+ * @param up the up vector, must not be a null vector
+ * @param m the matrix [out]
+ * @return true/false for success/failure
+ */
+bool bez_arc_frame(bez_arc const *arc,
+		float distance,
+		vector const *up,
+		float m[16])
+{
+	vector point,
+		   tangent,
+		   normal,
+		   binormal;
+
+	if (!up || !m || !bez_arc_point(arc, distance, &point, &tangent))
+		return false;
+
+	if (is_null_vector(&tangent))
+		tangent.x = 1;
+
+	binormal = vec_normalize(vec_cross(tangent, *up));
+	/* the curve runs along the up vector, take any other one */
+	if (is_null_vector(&binormal)) {
+		vector const other = { up->y, up->z, up->x };
+
+		binormal = vec_normalize(vec_cross(tangent, other));
+		if (is_null_vector(&binormal)) {
+			vector const axis = { 0, 0, 1 };
+
+			binormal = vec_normalize(vec_cross(tangent, axis));
+		}
+	}
+	normal = vec_cross(binormal, tangent);
+
+	m[0] = tangent.x;
+	m[1] = tangent.y;
+	m[2] = tangent.z;
+	m[3] = 0;
+	m[4] = normal.x;
+	m[5] = normal.y;
+	m[6] = normal.z;
+	m[7] = 0;
+	m[8] = binormal.x;
+	m[9] = binormal.y;
+	m[10] = binormal.z;
+	m[11] = 0;
+	m[12] = point.x;
+	m[13] = point.y;
+	m[14] = point.z;
+	m[15] = 1;
+
+	return true;
+}
@@ -0,0 +1,113 @@
+/*
+ * Copyright 2011-2014 hasufell
+ *
+ * This file is part of a hasufell project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation version 2 of the License only.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file bezier_arc.h
+ * Header for the arc length tables of bezier curves.
+ * @brief header of bezier_arc.c
+ */
+
+#ifndef _DROW_ENGINE_BEZIER_ARC_H
+#define _DROW_ENGINE_BEZIER_ARC_H
+
+
+#include "bezier.h"
+#include "vector.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+
+/**
+ * Fault intolerant macro. Will abort the program if the called
+ * function failed.
+ */
+#define GET_BEZ_ARC(...) \
+{ \
+	if (!get_bez_arc(__VA_ARGS__)) { \
+		fprintf(stderr, "Failure in get_bez_arc()!\n"); \
+		abort(); \
+	} \
+}
+
+/**
+ * Count of samples of an arc length table that is good
+ * enough for moving things along a curve on the screen.
+ */
+#define BEZ_ARC_SAMPLES 256
+
+
+typedef struct bez_arc bez_arc;
+
+
+/**
+ * Arc length table of a bezier curve, built by get_bez_arc()
+ * and kept until the curve or the count of samples changes.
+ * A zeroed one is empty.
+ */
+struct bez_arc {
+	/**
+	 * Copy of the control points.
+	 */
+	vector *ctrl;
+	/**
+	 * Control points of the derivative of the curve,
+	 * deg of them.
+	 */
+	vector *deriv;
+	/**
+	 * Degree of the curve.
+	 */
+	uint32_t deg;
+	/**
+	 * Arc length from the start of the curve up to the
+	 * sections i / (sample_c - 1), rising.
+	 */
+	float *lengths;
+	/**
+	 * Count of samples.
+	 */
+	uint32_t sample_c;
+	/**
+	 * Length of the whole curve.
+	 */
+	float length;
+};
+
+
+bool get_bez_arc(const bez_curv *bez,
+		uint32_t sample_c,
+		bez_arc *arc);
+void delete_bez_arc(bez_arc *arc);
+float bez_arc_section(bez_arc const *arc,
+		float distance);
+bool bez_arc_point(bez_arc const *arc,
+		float distance,
+		vector *point,
+		vector *tangent);
+bool bez_arc_points(bez_arc const *arc,
+		float const *distances,
+		uint32_t n,
+		vector *points);
+bool bez_arc_frame(bez_arc const *arc,
+		float distance,
+		vector const *up,
+		float m[16]);
+
+
+#endif /* _DROW_ENGINE_BEZIER_ARC_H */
@@ -27,41 +27,219 @@
 #include "err.h"
 #include "filereader.h"
 #include "half_edge.h"
+#include "half_edge_cache.h"
+#include "load_stats.h"
 
 #include <fcntl.h>
+#include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
 
 
+/*
+ * static function declaration
+ */
+static bool cache_is_newer(char const * const filename,
+		char const * const cache);
+
+
 /**
  * Read an obj file and return a HE_obj
- * if parsing worked.
+ * if parsing worked. The file is mapped read-only
+ * and parsed directly from the mapping, so no
+ * copy of the file content is ever made.
+ *
+ * If there is a cache file next to the obj file (its name
+ * with HE_CACHE_SUFFIX appended) which is newer than the
+ * obj file, the object is loaded from there instead. Otherwise
+ * the cache is (re)written after parsing, if possible.
  *
  * @param filename file to open
  * @return the HE_obj or NULL for failure
  */
 HE_obj *read_obj_file(char const * const filename)
 {
-	char *string = NULL; /* file content */
+	return read_obj_file_stats(filename, NULL);
+}
+
+/**
+ * Read an obj file like read_obj_file() and add what every
+ * stage took to the stats. They are only recorded when built
+ * with -DLOAD_STATS, otherwise they stay untouched.
+ *
+ * @param filename file to open
+ * @param stats the stats, NULL for none [mod]
+ * @return the HE_obj or NULL for failure
+ */
+HE_obj *read_obj_file_stats(char const * const filename,
+		load_stats *stats)
+{
+	char const *map = NULL; /* file content */
+	char *cache;
+	size_t len = 0;
 	HE_obj *obj = NULL;
+	load_sample sample;
+	bool cached;
 
 	if (!filename || !*filename)
 		return NULL;
 
-	/* read the whole file into string */
-	string = read_file(filename);
+	cache = malloc(strlen(filename) + sizeof(HE_CACHE_SUFFIX));
+	CHECK_PTR_VAL(cache);
+	strcpy(cache, filename);
+	strcat(cache, HE_CACHE_SUFFIX);
 
-	if (!string)
-		return NULL;
+	LOAD_SAMPLE(stats, &sample);
+	cached = cache_is_newer(filename, cache);
+	LOAD_STAGE_DONE(stats, LOAD_STAGE_READ, &sample, 0);
+
+	LOAD_SAMPLE(stats, &sample);
+	if (cached && (obj = load_obj_cache(cache))) {
+		LOAD_STAGE_DONE(stats, LOAD_STAGE_CACHE, &sample, obj->fc);
+		free(cache);
+		return obj;
+	}
+
+	/* map the whole file */
+	LOAD_SAMPLE(stats, &sample);
+	map = map_file(filename, &len);
+	LOAD_STAGE_DONE(stats, LOAD_STAGE_READ, &sample, len);
+
+	if (map) {
+		obj = parse_obj_stats(map, len, 1, stats);
+		unmap_file(map, len);
 
-	obj = parse_obj(string);
-	free(string);
+		/* without a cache we are just slower next time */
+		if (obj) {
+			LOAD_SAMPLE(stats, &sample);
+			write_obj_cache(obj, cache);
+			LOAD_STAGE_DONE(stats, LOAD_STAGE_CACHE, &sample, obj->fc);
+		}
+	}
+
+	free(cache);
 	return obj;
 }
 
+/**
+ * Check if a cache file was modified after the file
+ * it has been created from.
+ *
+ * @param filename the original file
+ * @param cache the cache file
+ * @return true if the cache exists and is newer, false otherwise
+ */
+static bool cache_is_newer(char const * const filename,
+		char const * const cache)
+{
+	struct stat st,
+				cache_st;
+
+	if (stat(filename, &st) || stat(cache, &cache_st))
+		return false;
+
+	if (cache_st.st_mtim.tv_sec != st.st_mtim.tv_sec)
+		return cache_st.st_mtim.tv_sec > st.st_mtim.tv_sec;
+
+	return cache_st.st_mtim.tv_nsec > st.st_mtim.tv_nsec;
+}
+
+/**
+ * Maps a whole file read-only into memory. The mapping
+ * is not NULL-terminated.
+ *
+ * @param filename file to open
+ * @param len the length of the mapping [out]
+ * @return the mapping which must be released with unmap_file()
+ * by the caller or NULL on failure (including empty files)
+ */
+char const *map_file(char const * const filename, size_t *len)
+{
+	struct stat st;
+	void *map;
+	int fd;
+
+	if (!filename || !len)
+		return NULL;
+
+	if ((fd = open(filename, O_RDONLY)) == -1)
+		return NULL;
+
+	if (fstat(fd, &st) || st.st_size <= 0) {
+		close(fd);
+		return NULL;
+	}
+
+	map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+	/* the mapping stays valid after closing */
+	if (close(fd))
+		ABORT("Failed to close file descripter %d\n", fd);
+
+	if (map == MAP_FAILED)
+		return NULL;
+
+	/* we walk the file strictly front to back */
+	madvise(map, (size_t)st.st_size, MADV_SEQUENTIAL);
+
+	*len = (size_t)st.st_size;
+
+	return map;
+}
+
+/**
+ * Release a mapping created by map_file().
+ *
+ * @param map the mapping
+ * @param len the length of the mapping
+ */
+void unmap_file(char const *map, size_t len)
+{
+	if (!map)
+		return;
+
+	munmap((void*)map, len);
+}
+
+/**
+ * Create an anonymous temporary file, e.g. to back memory
+ * mappings which may be bigger than the available memory.
+ * The file is unlinked right away, so it vanishes as soon
+ * as it is closed and all mappings of it are gone.
+ *
+ * @param dir the directory to create the file in, NULL
+ * for $TMPDIR or /tmp
+ * @return the file descriptor or -1 on failure
+ */
+int open_temp_file(char const * const dir)
+{
+	char const *tmp_dir = dir;
+	char *path;
+	int fd;
+
+	if (!tmp_dir)
+		tmp_dir = getenv("TMPDIR");
+	if (!tmp_dir || !*tmp_dir)
+		tmp_dir = "/tmp";
+
+	path = malloc(strlen(tmp_dir) + sizeof("/drow-engine.XXXXXX"));
+	CHECK_PTR_VAL(path);
+	strcpy(path, tmp_dir);
+	strcat(path, "/drow-engine.XXXXXX");
+
+	fd = mkstemp(path);
+	if (fd != -1)
+		unlink(path);
+
+	free(path);
+
+	return fd;
+}
+
 /**
  * Reads a file and returns a newly allocated string.
  *
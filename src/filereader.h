@@ -28,9 +28,16 @@
 
 #include "half_edge.h"
 
+#include <stddef.h>
+
 
 HE_obj *read_obj_file(char const * const filename);
+HE_obj *read_obj_file_stats(char const * const filename,
+		load_stats *stats);
 char *read_file(char const * const filename);
+char const *map_file(char const * const filename, size_t *len);
+void unmap_file(char const *map, size_t len);
+int open_temp_file(char const * const dir);
 
 
 #endif /* _DROW_ENGINE_FILEREADER_H */
@@ -0,0 +1,405 @@
+/*
+ * Copyright 2011-2014 hasufell
+ *
+ * This file is part of a hasufell project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation version 2 of the License only.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file gl_bench.c
+ * Renders the scene of init_object() into an offscreen EGL
+ * pbuffer instead of a window, without vsync, and reports the
+ * time, the draw calls and the vertices of every frame as JSON.
+ * This needs no window system, so it also runs on servers and
+ * in CI, e.g. on Mesa's llvmpipe.
+ * @brief headless render benchmark
+ */
+
+/* the query functions are OpenGL 1.5 */
+#define GL_GLEXT_PROTOTYPES
+
+#include "gl_bench.h"
+#include "gl_draw.h"
+#include "gl_setup.h"
+#include "render.h"
+#include "sim.h"
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GL/gl.h>
+#include <GL/glext.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+
+typedef struct offscreen offscreen;
+typedef struct bench_frame bench_frame;
+
+
+/**
+ * An offscreen OpenGL context.
+ */
+struct offscreen {
+	/**
+	 * The EGL display.
+	 */
+	EGLDisplay display;
+	/**
+	 * The pbuffer which is rendered into.
+	 */
+	EGLSurface surface;
+	/**
+	 * The OpenGL context.
+	 */
+	EGLContext context;
+};
+
+/**
+ * The measurements of one frame.
+ */
+struct bench_frame {
+	/**
+	 * CPU time of the rendering thread in milliseconds.
+	 */
+	double cpu_ms;
+	/**
+	 * Time until the frame was finished in milliseconds.
+	 */
+	double wall_ms;
+	/**
+	 * Count of draw calls, see render_stats.
+	 */
+	uint32_t draw_calls;
+	/**
+	 * Count of vertices submitted.
+	 */
+	uint64_t vertices;
+};
+
+
+/*
+ * static function declaration
+ */
+static double clock_ms(clockid_t clock);
+static EGLDisplay get_display(void);
+static bool create_offscreen(uint32_t width,
+		uint32_t height,
+		offscreen *off);
+static void destroy_offscreen(offscreen *off);
+static bool has_gl_extension(char const * const name);
+static void print_json_string(FILE *out, char const *str);
+static void print_bench_json(FILE *out,
+		bench_frame const *frames,
+		uint32_t frame_c,
+		bool gl_vertices);
+
+
+/**
+ * Read a clock.
+ *
+ * @param clock the clock
+ * @return the time in milliseconds
+ */
+static double clock_ms(clockid_t clock)
+{
+	struct timespec ts;
+
+	clock_gettime(clock, &ts);
+
+	return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+/**
+ * Get an initialized EGL display which needs no window
+ * system. Mesa's surfaceless platform is preferred, the
+ * default display is the fallback.
+ *
+ * @return the display, EGL_NO_DISPLAY on failure
+ */
+static EGLDisplay get_display(void)
+{
+	char const *exts = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+	EGLDisplay display;
+
+	if (exts && strstr(exts, "EGL_MESA_platform_surfaceless")) {
+		PFNEGLGETPLATFORMDISPLAYEXTPROC get_platform_display =
+			(PFNEGLGETPLATFORMDISPLAYEXTPROC)
+			eglGetProcAddress("eglGetPlatformDisplayEXT");
+
+		if (get_platform_display) {
+			display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA,
+					EGL_DEFAULT_DISPLAY, NULL);
+			if (display != EGL_NO_DISPLAY &&
+					eglInitialize(display, NULL, NULL))
+				return display;
+		}
+	}
+
+	display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+	if (display != EGL_NO_DISPLAY && eglInitialize(display, NULL, NULL))
+		return display;
+
+	return EGL_NO_DISPLAY;
+}
+
+/**
+ * Create a desktop OpenGL context with a pbuffer of the
+ * given size and make it current.
+ *
+ * @param width width of the pbuffer
+ * @param height height of the pbuffer
+ * @param off the context [out]
+ * @return true/false for success/failure
+ */
+static bool create_offscreen(uint32_t width,
+		uint32_t height,
+		offscreen *off)
+{
+	EGLint const config_attribs[] = {
+		EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+		EGL_RED_SIZE, 8,
+		EGL_GREEN_SIZE, 8,
+		EGL_BLUE_SIZE, 8,
+		EGL_DEPTH_SIZE, 24,
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+		EGL_NONE,
+	};
+	EGLint const surface_attribs[] = {
+		EGL_WIDTH, (EGLint)width,
+		EGL_HEIGHT, (EGLint)height,
+		EGL_NONE,
+	};
+	EGLConfig config;
+	EGLint config_c = 0;
+
+	off->surface = EGL_NO_SURFACE;
+	off->context = EGL_NO_CONTEXT;
+
+	if ((off->display = get_display()) == EGL_NO_DISPLAY) {
+		fprintf(stderr, "Failed initializing EGL!\n");
+		return false;
+	}
+
+	if (!eglBindAPI(EGL_OPENGL_API) ||
+			!eglChooseConfig(off->display, config_attribs, &config, 1,
+				&config_c) || !config_c) {
+		fprintf(stderr, "No EGL config for desktop OpenGL!\n");
+		destroy_offscreen(off);
+		return false;
+	}
+
+	off->surface = eglCreatePbufferSurface(off->display, config,
+			surface_attribs);
+	off->context = eglCreateContext(off->display, config,
+			EGL_NO_CONTEXT, NULL);
+	if (off->surface == EGL_NO_SURFACE || off->context == EGL_NO_CONTEXT ||
+			!eglMakeCurrent(off->display, off->surface, off->surface,
+				off->context)) {
+		fprintf(stderr, "Failed creating offscreen OpenGL context!\n");
+		destroy_offscreen(off);
+		return false;
+	}
+
+	/* no vsync, a pbuffer has none anyway */
+	eglSwapInterval(off->display, 0);
+
+	return true;
+}
+
+/**
+ * Release an offscreen context and its display.
+ *
+ * @param off the context [mod]
+ */
+static void destroy_offscreen(offscreen *off)
+{
+	eglMakeCurrent(off->display, EGL_NO_SURFACE, EGL_NO_SURFACE,
+			EGL_NO_CONTEXT);
+	if (off->context != EGL_NO_CONTEXT)
+		eglDestroyContext(off->display, off->context);
+	if (off->surface != EGL_NO_SURFACE)
+		eglDestroySurface(off->display, off->surface);
+	eglTerminate(off->display);
+}
+
+/**
+ * Check whether the current OpenGL context has an extension.
+ *
+ * @param name the name of the extension
+ * @return true if it has
+ */
+static bool has_gl_extension(char const * const name)
+{
+	char const *exts = (char const*)glGetString(GL_EXTENSIONS);
+	size_t const len = strlen(name);
+
+	while (exts && (exts = strstr(exts, name))) {
+		if (exts[len] == ' ' || exts[len] == '\0')
+			return true;
+		exts += len;
+	}
+
+	return false;
+}
+
+/**
+ * Print a string as a JSON string.
+ *
+ * @param out the stream
+ * @param str the string
+ */
+static void print_json_string(FILE *out, char const *str)
+{
+	fputc('"', out);
+	for (; str && *str; str++) {
+		if (*str == '"' || *str == '\\')
+			fprintf(out, "\\%c", *str);
+		else if ((unsigned char)*str < 0x20)
+			fprintf(out, "\\u%04x", (unsigned)*str);
+		else
+			fputc(*str, out);
+	}
+	fputc('"', out);
+}
+
+/**
+ * Print the results as a JSON object with the context, the
+ * means and every single frame.
+ *
+ * @param out the stream
+ * @param frames the measurements
+ * @param frame_c count of frames
+ * @param gl_vertices whether the vertices were counted by
+ * the GL, not by the draw code
+ */
+static void print_bench_json(FILE *out,
+		bench_frame const *frames,
+		uint32_t frame_c,
+		bool gl_vertices)
+{
+	double cpu_ms = 0,
+		   wall_ms = 0;
+
+	for (uint32_t i = 0; i < frame_c; i++) {
+		cpu_ms += frames[i].cpu_ms;
+		wall_ms += frames[i].wall_ms;
+	}
+
+	fprintf(out, "{\n  \"renderer\": ");
+	print_json_string(out, (char const*)glGetString(GL_RENDERER));
+	fprintf(out, ",\n  \"version\": ");
+	print_json_string(out, (char const*)glGetString(GL_VERSION));
+	fprintf(out, ",\n  \"width\": %d,\n  \"height\": %d,\n"
+			"  \"frame_count\": %u,\n  \"vertices_source\": \"%s\",\n"
+			"  \"mean_cpu_ms\": %.4f,\n  \"mean_wall_ms\": %.4f,\n"
+			"  \"frames\": [\n",
+			BENCH_WIDTH, BENCH_HEIGHT, frame_c,
+			gl_vertices ? "pipeline_statistics" : "draw_stats",
+			frame_c ? cpu_ms / frame_c : 0,
+			frame_c ? wall_ms / frame_c : 0);
+	for (uint32_t i = 0; i < frame_c; i++)
+		fprintf(out, "    {\"cpu_ms\": %.4f, \"wall_ms\": %.4f, "
+				"\"draw_calls\": %u, \"vertices\": %llu}%s\n",
+				frames[i].cpu_ms, frames[i].wall_ms, frames[i].draw_calls,
+				(unsigned long long)frames[i].vertices,
+				i + 1 < frame_c ? "," : "");
+	fprintf(out, "  ]\n}\n");
+}
+
+/**
+ * Render the scene of init_object() for a count of frames
+ * into an offscreen framebuffer and print the measurements
+ * as JSON. Every frame is waited for with glFinish(), so the
+ * wall time includes the rendering itself. The vertices are
+ * counted by the GL if it has ARB_pipeline_statistics_query,
+ * otherwise by the draw code, see render_stats. The profiler
+ * overlay is turned off, so only the scene is measured, and
+ * the simulation advances by one tick per frame, so every run
+ * draws the same frames.
+ *
+ * @param frames count of frames
+ * @param out the stream for the JSON
+ * @return true/false for success/failure
+ */
+bool run_render_bench(uint32_t frames, FILE *out)
+{
+	offscreen off;
+	bench_frame *results;
+	GLuint query = 0;
+	bool gl_vertices;
+	sim_params params;
+
+	if (!out || !create_offscreen(BENCH_WIDTH, BENCH_HEIGHT, &off))
+		return false;
+
+	results = calloc((size_t)frames + 1, sizeof(*results));
+	if (!results) {
+		destroy_offscreen(&off);
+		return false;
+	}
+
+	init_opengl();
+	show_profiler = false;
+
+	gl_vertices = has_gl_extension("GL_ARB_pipeline_statistics_query");
+	if (gl_vertices)
+		glGenQueries(1, &query);
+
+	get_scene_params(&params);
+	for (uint32_t i = 0; i < frames; i++) {
+		double cpu,
+			   wall;
+
+		sim_tick(&scene, &params);
+
+		cpu = clock_ms(CLOCK_THREAD_CPUTIME_ID);
+		wall = clock_ms(CLOCK_MONOTONIC);
+
+		reset_render_stats();
+		if (gl_vertices)
+			glBeginQuery(GL_VERTICES_SUBMITTED_ARB, query);
+
+		draw_scene();
+
+		if (gl_vertices)
+			glEndQuery(GL_VERTICES_SUBMITTED_ARB);
+		glFinish();
+
+		results[i].cpu_ms = clock_ms(CLOCK_THREAD_CPUTIME_ID) - cpu;
+		results[i].wall_ms = clock_ms(CLOCK_MONOTONIC) - wall;
+		results[i].draw_calls = draw_stats.draw_calls;
+		results[i].vertices = draw_stats.vertices;
+		if (gl_vertices) {
+			GLuint64 vertices = 0;
+
+			glGetQueryObjectui64v(query, GL_QUERY_RESULT, &vertices);
+			results[i].vertices = vertices;
+		}
+	}
+
+	print_bench_json(out, results, frames, gl_vertices);
+
+	if (gl_vertices)
+		glDeleteQueries(1, &query);
+	free(results);
+	delete_scene();
+	destroy_offscreen(&off);
+
+	return true;
+}
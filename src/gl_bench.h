@@ -0,0 +1,54 @@
+/*
+ * Copyright 2011-2014 hasufell
+ *
+ * This file is part of a hasufell project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation version 2 of the License only.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file gl_bench.h
+ * Header for the headless render benchmark.
+ * @brief header of gl_bench.c
+ */
+
+#ifndef _DROW_ENGINE_GL_BENCH_H
+#define _DROW_ENGINE_GL_BENCH_H
+
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+
+/**
+ * Width of the offscreen framebuffer, the same as the one
+ * of the window.
+ */
+#define BENCH_WIDTH 640
+
+/**
+ * Height of the offscreen framebuffer.
+ */
+#define BENCH_HEIGHT 480
+
+/**
+ * Count of frames rendered if none is given.
+ */
+#define BENCH_DEFAULT_FRAMES 300
+
+
+bool run_render_bench(uint32_t frames, FILE *out);
+
+
+#endif /* _DROW_ENGINE_GL_BENCH_H */
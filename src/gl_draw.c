@@ -18,27 +18,31 @@
 
 /**
  * @file gl_draw.c
- * This file does the actual OpenGL and GLUT logic,
- * drawing the objects, handling keyboard input and
- * various GLUT-related callback functions.
+ * This file does the actual OpenGL and GLU logic,
+ * drawing the objects and the scene into the SDL window
+ * which gl_setup.c creates and handles the input of.
  * @brief OpenGL drawing
  */
 
 #include "bezier.h"
+#include "bezier_arc.h"
 #include "err.h"
 #include "filereader.h"
 #include "gl_draw.h"
+#include "gl_overlay.h"
 #include "half_edge.h"
+#include "half_edge_normals.h"
 #include "print.h"
+#include "profiler.h"
+#include "render.h"
+#include "sim.h"
 
-#include <GL/glut.h>
 #include <GL/gl.h>
 #include <GL/glu.h>
 
 #include <SDL.h>
 
 #include <math.h>
-#include <limits.h>
 #include <unistd.h>
 
 #include <stdbool.h>
@@ -49,115 +53,89 @@
 /*
  * globals
  */
-int year = 0;
 int yearabs = 365;
-int day = 0;
 int dayabs = 30;
+sim_state scene;
 HE_obj *obj;
 HE_obj *float_obj;
 HE_obj *bez_obj;
+render_mesh obj_mesh;
+render_mesh float_obj_mesh;
+render_lines obj_normals;
+render_curve *bez_obj_curves;
 bool show_normals = false;
+float normals_scale = 0.1f;
 bool shademodel = true;
 bool draw_bezier = true;
 bool draw_frame = false;
 float ball_speed = 0.2f;
+profiler frame_profiler;
+bool show_profiler = true;
 
 
-
-/**
- * Draws the vertex normals of the object.
- *
- * @param obj the object to draw the vertex normals of
- * @param scale_inc the incrementor for scaling the normals
+/*
+ * static function declaration
  */
-void draw_normals(HE_obj const * const obj,
-		float const scale_inc)
-{
-	static float normals_scale_factor = 0.1f;
-	static float line_width = 2;
-	vector vec;
-
-	normals_scale_factor += scale_inc;
+static void color_vertices(HE_obj const * const obj,
+		bool disco);
+static float bez_tolerance(const bez_curv *bez, float pixels);
+static GLUquadric *get_quadric(GLenum draw_style);
+static void draw_wire_sphere(GLdouble radius,
+		GLint slices,
+		GLint stacks);
+static void draw_disk(GLdouble inner,
+		GLdouble outer,
+		GLint slices);
 
-	glPushMatrix();
-
-	glLineWidth(line_width);
-	glColor3f(1.0, 0.0, 0.0);
-
-	glBegin(GL_LINES);
-	for (uint32_t i = 0; i < obj->vc; i++) {
-		/* be fault tolerant here, so we don't just
-		 * kill the whole thing, because the normals failed to draw */
-		if (!vec_normal(&(obj->vertices[i]), &vec))
-			break;
-
-		glVertex3f(obj->vertices[i].vec->x,
-				obj->vertices[i].vec->y,
-				obj->vertices[i].vec->z);
-		glVertex3f(obj->vertices[i].vec->x + (vec.x * normals_scale_factor),
-				obj->vertices[i].vec->y + (vec.y * normals_scale_factor),
-				obj->vertices[i].vec->z + (vec.z * normals_scale_factor));
-	}
-	glEnd();
-	glPopMatrix();
-}
 
 /**
- * Draws the vertex normals of the object, using
- * the information given by the .obj file.
+ * Draws the vertex normals of the object as lines of the
+ * length normals_scale. They are computed into obj->vn once,
+ * unless the .obj file already gave one normal per vertex,
+ * and the lines are only uploaded again when the object or
+ * the length changes.
  *
- * @param obj the object to draw the vertex normals of
- * @param scale_inc the incrementor for scaling the normals
+ * @param obj the object to draw the vertex normals of [mod]
+ * @param lines the buffer of the lines [mod]
  */
-void draw_given_normals(HE_obj const * const obj,
-		float const scale_inc)
+void draw_normals(HE_obj * const obj,
+		render_lines *lines)
 {
-	static float normals_scale_factor = 0.1f;
 	static float line_width = 2;
 
-	normals_scale_factor += scale_inc;
+	/* be fault tolerant here, so we don't just
+	 * kill the whole thing, because the normals failed to draw */
+	if (obj->vnc != obj->vc &&
+			!compute_vertex_normals(obj, NORMAL_WEIGHT_AREA))
+		return;
+	if (!upload_render_normals(obj, normals_scale, lines))
+		return;
 
 	glPushMatrix();
 
 	glLineWidth(line_width);
 	glColor3f(1.0, 0.0, 0.0);
 
-	glBegin(GL_LINES);
-	for (uint32_t i = 0; i < obj->vc; i++) {
-		glVertex3f(obj->vertices[i].vec->x,
-				obj->vertices[i].vec->y,
-				obj->vertices[i].vec->z);
-		glVertex3f(obj->vertices[i].vec->x +
-				(obj->vn[i].x * normals_scale_factor),
-				obj->vertices[i].vec->y +
-				(obj->vn[i].y * normals_scale_factor),
-				obj->vertices[i].vec->z +
-				(obj->vn[i].z * normals_scale_factor));
-	}
-	glEnd();
+	draw_render_lines(lines);
+
 	glPopMatrix();
 }
 
 /**
- * Draws all vertices of the object by
- * assembling a polygon for each face.
+ * Assign colors to the vertices of an object. The first vertex
+ * of every face gets a random one if it has none yet, or in disco
+ * mode a new one anyway.
  *
- * @param obj the object of which we will draw the vertices
- * @param disco_set determines whether we are in disco mode
+ * @param obj the object to color
+ * @param disco whether we are in disco mode
  */
-void draw_vertices(HE_obj const * const obj,
-		bool disco_set)
+static void color_vertices(HE_obj const * const obj,
+		bool disco)
 {
 	/* color */
 	static float red = 90,
 				 blue = 90,
 				 green = 90;
-	static bool disco = false;
-
-	if (disco_set)
-		disco = !disco;
-
-	glPushMatrix();
 
 	for (uint32_t i = 0; i < obj->fc; i++) { /* for all faces */
 		HE_edge *tmp_edge = obj->faces[i].edge;
@@ -192,39 +170,170 @@ void draw_vertices(HE_obj const * const obj,
 				tmp_edge->vert->col->blue =
 					(sin(blue * i * (M_PI / 180)) / 2) + 0.5;
 		}
+	}
+}
 
-		glBegin(GL_POLYGON);
-		do { /* for all edges of the face */
-			glColor3f(tmp_edge->vert->col->red,
-					tmp_edge->vert->col->green,
-					tmp_edge->vert->col->blue);
+/**
+ * Get a GLU quadric of the given draw style. There is one per
+ * style, created on first use and kept for the whole program.
+ *
+ * @param draw_style GLU_FILL or GLU_LINE
+ * @return the quadric
+ */
+static GLUquadric *get_quadric(GLenum draw_style)
+{
+	static GLUquadric *fill,
+					  *line;
+	GLUquadric **quadric = draw_style == GLU_LINE ? &line : &fill;
+
+	if (!*quadric) {
+		*quadric = gluNewQuadric();
+		CHECK_PTR_VAL(*quadric);
+		gluQuadricDrawStyle(*quadric, draw_style);
+	}
 
-			glVertex3f(tmp_edge->vert->vec->x,
-					tmp_edge->vert->vec->y,
-					tmp_edge->vert->vec->z);
+	return *quadric;
+}
 
-		} while ((tmp_edge = tmp_edge->next) != obj->faces[i].edge);
-		glEnd();
+/**
+ * Draws a wireframe sphere around the origin. This is GLU
+ * instead of glutWireSphere(), which needs a window system
+ * and so does not work in offscreen contexts.
+ *
+ * @param radius the radius
+ * @param slices count of subdivisions around the z-axis
+ * @param stacks count of subdivisions along the z-axis
+ */
+static void draw_wire_sphere(GLdouble radius,
+		GLint slices,
+		GLint stacks)
+{
+	gluSphere(get_quadric(GLU_LINE), radius, slices, stacks);
+	count_draw_call(0);
+}
+
+/**
+ * Draws a filled disk with a hole around the origin.
+ *
+ * @param inner radius of the hole
+ * @param outer radius of the disk
+ * @param slices count of subdivisions around the z-axis
+ */
+static void draw_disk(GLdouble inner,
+		GLdouble outer,
+		GLint slices)
+{
+	gluDisk(get_quadric(GLU_FILL), inner, outer, slices, 1);
+	count_draw_call(0);
+}
+
+/**
+ * Draws all faces of the object from its vertex buffers. They
+ * are filled once, when the object is first drawn or has changed,
+ * and only the colors are uploaded again in every frame of
+ * disco mode. If the upload fails, the object is left out and
+ * it is tried again in the next frame.
+ *
+ * @param obj the object of which we will draw the vertices [mod]
+ * @param mesh the vertex buffers of the object [mod]
+ * @param disco_set determines whether we are in disco mode
+ */
+void draw_vertices(HE_obj * const obj,
+		render_mesh *mesh,
+		bool disco_set)
+{
+	static bool disco = false;
+
+	if (disco_set)
+		disco = !disco;
+
+	if (!render_mesh_is_current(mesh, obj)) {
+		color_vertices(obj, false);
+		/* be fault tolerant here, so we don't just
+		 * kill the whole thing, because the upload failed */
+		if (!upload_render_mesh(obj, mesh))
+			return;
+	}
+
+	if (disco) {
+		color_vertices(obj, true);
+		/* be fault tolerant here, the old colors will do */
+		upload_render_mesh_colors(obj, mesh);
 	}
 
+	glPushMatrix();
+	draw_render_mesh(mesh);
 	glPopMatrix();
 }
 
 /**
- * Draw the bezier curve.
+ * Convert a tolerance in pixels into one in the coordinates of
+ * a bezier curve, at the depth of its control point closest to
+ * the camera. It is rounded down to a power of two, so that
+ * small moves of the camera don't change it.
+ *
+ * @param bez the bezier curve
+ * @param pixels the tolerance in pixels
+ * @return the tolerance in object coordinates
+ */
+static float bez_tolerance(const bez_curv *bez, float pixels)
+{
+	GLfloat mv[16],
+			proj[16];
+	GLint viewport[4];
+	float depth = 0,
+		  scale,
+		  tolerance;
+
+	glGetFloatv(GL_MODELVIEW_MATRIX, mv);
+	glGetFloatv(GL_PROJECTION_MATRIX, proj);
+	glGetIntegerv(GL_VIEWPORT, viewport);
+
+	for (uint32_t j = 0; j <= bez->deg; j++) {
+		float const d = -(mv[2] * bez->vec[j].x + mv[6] * bez->vec[j].y +
+				mv[10] * bez->vec[j].z + mv[14]);
+
+		if (j == 0 || d < depth)
+			depth = d;
+	}
+	if (depth < 0.01f)
+		depth = 0.01f;
+
+	/* from object to eye coordinates */
+	scale = sqrtf(mv[0] * mv[0] + mv[1] * mv[1] + mv[2] * mv[2]);
+
+	tolerance = pixels * 2 * depth / (proj[5] * viewport[3] * scale);
+	if (!(tolerance > 0) || isinf(tolerance))
+		return 0.001f;
+
+	return exp2f(floorf(log2f(tolerance)));
+}
+
+/**
+ * Draw the bezier curve. Its polyline is only tessellated
+ * and uploaded again when the curve or the tolerance changes.
  *
  * @param bez the bezier curve to draw
- * @param step_factor_inc the step factor between calculated control points
+ * @param curve the buffer of the polyline of this curve [mod]
+ * @param tolerance_inc the increment of the tolerance
+ * in pixels, divided by 10
  */
-void draw_bez(const bez_curv *bez, float step_factor_inc)
+void draw_bez(const bez_curv *bez,
+		render_curve *curve,
+		float tolerance_inc)
 {
 	static float line_width = 2;
 	static float point_size = 10;
-	static float step_factor = 0.1;
+	static float pixel_tolerance = 0.5f;
+
+	if ((pixel_tolerance + tolerance_inc * 10) > 0.05f &&
+			(pixel_tolerance + tolerance_inc * 10) < 5)
+		pixel_tolerance += tolerance_inc * 10;
 
-	if ((step_factor + step_factor_inc) > 0.002 &&
-			(step_factor + step_factor_inc) < 0.50)
-		step_factor += step_factor_inc;
+	/* be fault tolerant here, a curve is not worth dying for */
+	if (!upload_render_curve(bez, bez_tolerance(bez, pixel_tolerance),
+				curve))
+		return;
 
 	glPushMatrix();
 
@@ -232,9 +341,6 @@ void draw_bez(const bez_curv *bez, float step_factor_inc)
 	glPointSize(point_size);
 	glColor3f(1.0, 0.0, 0.0);
 
-	vector *v1 = NULL,
-		   *v2 = NULL;
-
 	/*
 	 * draw frame
 	 */
@@ -245,6 +351,7 @@ void draw_bez(const bez_curv *bez, float step_factor_inc)
 			bez->vec[j].z);
 	}
 	glEnd();
+	count_draw_call(bez->deg + 1);
 
 	/*
 	 * draw control points
@@ -256,55 +363,12 @@ void draw_bez(const bez_curv *bez, float step_factor_inc)
 			bez->vec[j].z);
 	}
 	glEnd();
-
-	glBegin(GL_LINES);
-
-	/*
-	 * line segments: first line
-	 */
-	v1 = calculate_bezier_point(bez, step_factor);
-	glVertex3f(bez->vec[0].x,
-			bez->vec[0].y,
-			bez->vec[0].z);
-	glVertex3f(v1->x,
-			v1->y,
-			v1->z);
-
-	for (float k = step_factor; k < 1 - step_factor; k += step_factor) {
-		free(v1);
-		free(v2);
-
-		v1 = calculate_bezier_point(bez, k);
-		v2 = calculate_bezier_point(bez, k +
-				step_factor);
-
-		/*
-		 * line segments: middle lines
-		 */
-		glVertex3f(v1->x,
-				v1->y,
-				v1->z);
-		glVertex3f(v2->x,
-				v2->y,
-				v2->z);
-
-	}
+	count_draw_call(bez->deg + 1);
 
 	/*
-	 * line segments: last line
+	 * line segments
 	 */
-	glVertex3f(v2->x,
-			v2->y,
-			v2->z);
-	glVertex3f(bez->vec[bez->deg].x,
-			bez->vec[bez->deg].y,
-			bez->vec[bez->deg].z);
-
-		free(v1);
-		free(v2);
-
-		glEnd();
-
+	draw_render_curve(curve);
 
 	glPopMatrix();
 }
@@ -314,11 +378,11 @@ void draw_bez(const bez_curv *bez, float step_factor_inc)
  * which will cut the curve at the given position.
  *
  * @param bez the bezier curve to draw the frame of
- * @param pos the position where the curve and the frame
- * will cut
+ * @param section the section where the curve and the frame
+ * will cut, see bez_arc_section()
  */
 void draw_bez_frame(const bez_curv *bez,
-		float pos)
+		float section)
 {
 	bez_curv cur_bez = *bez;
 	bez_curv next_bez = { NULL, 0 };
@@ -326,7 +390,7 @@ void draw_bez_frame(const bez_curv *bez,
 	glPushMatrix();
 	glColor3f(0.0, 1.0, 0.0);
 
-	while ((get_reduced_bez_curv(&cur_bez, &next_bez, pos))) {
+	while ((get_reduced_bez_curv(&cur_bez, &next_bez, section))) {
 
 		glBegin(GL_LINES);
 
@@ -345,6 +409,7 @@ void draw_bez_frame(const bez_curv *bez,
 		cur_bez = next_bez;
 
 		glEnd();
+		count_draw_call(2 * next_bez.deg);
 	}
 	free(cur_bez.vec);
 
@@ -355,54 +420,53 @@ void draw_bez_frame(const bez_curv *bez,
  * Draws a ball on the bezier curve at the given position.
  *
  * @param bez the bezier curve to draw the ball on
- * @param pos the position of the ball
+ * @param section the section of the curve where the ball is,
+ * the same the frame is drawn at, see draw_bez_frame()
  */
 void draw_ball(const bez_curv *bez,
-		const float pos)
+		const float section)
 {
-	const float ball_pos = pos;
-	vector *point;
+	vector point;
+
+	if (!eval_bezier_point(bez, section, NULL, &point))
+		return;
 
 	glPushMatrix();
 	glColor3f(0.0, 1.0, 0.0);
-	point = calculate_bezier_point(bez,
-			ball_pos);
-	glTranslatef(point->x, point->y, point->z);
-	glutWireSphere(0.02f, 100, 100);
+	glTranslatef(point.x, point.y, point.z);
+	draw_wire_sphere(0.02f, 100, 100);
 	glPopMatrix();
-
-	free(point);
 }
 
 /**
  * Draws a ship on the bezier curve at the given position.
  *
  * @param bez the bezier curve to draw the ship on
- * @param pos the position of the ship
+ * @param section the section of the curve where the ship is,
+ * the same the frame is drawn at, see draw_bez_frame()
  * @param scale_fac the scale factor
  */
 void draw_ship(const bez_curv *bez,
-		const float pos,
+		const float section,
 		const float scale_fac)
 {
-	const float ship_pos = pos;
-	vector *point;
+	vector point;
 
+	if (!eval_bezier_point(bez, section, NULL, &point))
+		return;
 
 	glPushMatrix();
 
 	glColor3f(0.0, 1.0, 0.0);
-	point = calculate_bezier_point(bez,
-			ship_pos);
-	glTranslatef(point->x, point->y, point->z);
+	glTranslatef(point.x, point.y, point.z);
 	glScalef(VISIBILITY_FACTOR * scale_fac,
 			VISIBILITY_FACTOR * scale_fac,
 			VISIBILITY_FACTOR * scale_fac);
-	draw_vertices(float_obj, false);
+	profiler_push(&frame_profiler, PROFILE_DRAW_VERTICES);
+	draw_vertices(float_obj, &float_obj_mesh, false);
+	profiler_pop(&frame_profiler);
 
 	glPopMatrix();
-
-	free(point);
 }
 
 
@@ -412,8 +476,8 @@ void draw_ship(const bez_curv *bez,
  * @param myxrot rotation increment around x-axis
  * @param myyrot rotation increment around x-axis
  * @param myzrot rotation increment around x-axis
- * @param bez_inc the step factor between calculated control points
- * for the bezier curve
+ * @param bez_inc the increment of the tolerance of the bezier
+ * curve, see draw_bez()
  */
 void draw_obj(int32_t const myxrot,
 		int32_t const myyrot,
@@ -424,19 +488,6 @@ void draw_obj(int32_t const myxrot,
 	static int32_t xrot = 0,
 					yrot = 0,
 					zrot = 0;
-	static float ball_inc = 0;
-	static bool ball_to_right = true;
-
-	if (ball_inc > 0.98)
-		ball_to_right = false;
-	else if (ball_inc < 0.02)
-		ball_to_right = true;
-
-	if (ball_to_right)
-		ball_inc += 0.01f * ball_speed;
-	else
-		ball_inc -= 0.01f * ball_speed;
-
 	vector center_vert;
 
 	FIND_CENTER(obj, &center_vert);
@@ -464,10 +515,15 @@ void draw_obj(int32_t const myxrot,
 			-center_vert.z + SYSTEM_POS_Z);
 
 	if (obj->ec != 0) {
-		if (show_normals)
-			draw_given_normals(obj, 0);
+		if (show_normals) {
+			profiler_push(&frame_profiler, PROFILE_DRAW_NORMALS);
+			draw_normals(obj, &obj_normals);
+			profiler_pop(&frame_profiler);
+		}
 
-		draw_vertices(obj, false);
+		profiler_push(&frame_profiler, PROFILE_DRAW_VERTICES);
+		draw_vertices(obj, &obj_mesh, false);
+		profiler_pop(&frame_profiler);
 	}
 
 	glPopMatrix();
@@ -492,12 +548,29 @@ void draw_obj(int32_t const myxrot,
 			-center_vert.z + SYSTEM_POS_Z);
 
 	if (bez_obj->bzc != 0) {
-		if(draw_bezier)
-			draw_bez(&(bez_obj->bez_curves[0]), bez_inc);
-		if(draw_frame)
-			draw_bez_frame(&(bez_obj->bez_curves[0]), ball_inc);
+		bez_arc *arc = &(bez_obj_curves[0].arc);
+		float section;
+
+		/* the ship moves at a constant speed, the frame has to
+		 * cut the curve at the very same section */
+		GET_BEZ_ARC(&(bez_obj->bez_curves[0]), BEZ_ARC_SAMPLES, arc);
+		section = bez_arc_section(arc, scene.ball_pos * arc->length);
+
+		if(draw_bezier) {
+			profiler_push(&frame_profiler, PROFILE_DRAW_BEZ);
+			draw_bez(&(bez_obj->bez_curves[0]), &(bez_obj_curves[0]),
+					bez_inc);
+			profiler_pop(&frame_profiler);
+		}
+		if(draw_frame) {
+			profiler_push(&frame_profiler, PROFILE_DRAW_BEZ_FRAME);
+			draw_bez_frame(&(bez_obj->bez_curves[0]), section);
+			profiler_pop(&frame_profiler);
+		}
 
-		draw_ship(&(bez_obj->bez_curves[0]), ball_inc, 0.03);
+		profiler_push(&frame_profiler, PROFILE_DRAW_SHIP);
+		draw_ship(&(bez_obj->bez_curves[0]), section, 0.03);
+		profiler_pop(&frame_profiler);
 	}
 
 	glPopMatrix();
@@ -510,8 +583,6 @@ void draw_obj(int32_t const myxrot,
  */
 void draw_Planet_1(void)
 {
-	GLUquadric* quadric = NULL;
-	quadric = gluNewQuadric();
 	const int rot_fac_day = 15;
 
 	glPushMatrix();
@@ -519,18 +590,18 @@ void draw_Planet_1(void)
 	/* Rotate around the sun */
 	glTranslatef(0.0f, 0.0f, SYSTEM_POS_Z);
 	glRotatef(90, 1.0f, 0.0f, 0.0f);
-	glRotatef((ROT_FACTOR_PLANET_SUN * day), 0.0f, 0.0f, 1.0f);
+	glRotatef((ROT_FACTOR_PLANET_SUN * scene.day), 0.0f, 0.0f, 1.0f);
 	glTranslatef(0.0f, 4.0f, 0.0f);
-	glRotatef((ROT_FACTOR_PLANET_SUN * day), 0.0f, 0.0f, -1.0f);
+	glRotatef((ROT_FACTOR_PLANET_SUN * scene.day), 0.0f, 0.0f, -1.0f);
 	glRotatef(315, 0.0f, 1.0f, 0.0f);
 
 	glColor3f(1.0f, 0.0f, 0.0f);
 
 	/* A rotation (full 360°) once a day is much
 	 * too fast you wouldn't see a thing */
-	glRotatef((ROT_FACTOR_PLANET * day) / rot_fac_day, 0.0f, 0.0f, 1.0f);
-	glutWireSphere(1.0f, XY_WIRE_COUNT, XY_WIRE_COUNT);
-	glRotatef((ROT_FACTOR_PLANET * day) / rot_fac_day, 0.0f, 0.0f, -1.0f);
+	glRotatef((ROT_FACTOR_PLANET * scene.day) / rot_fac_day, 0.0f, 0.0f, 1.0f);
+	draw_wire_sphere(1.0f, XY_WIRE_COUNT, XY_WIRE_COUNT);
+	glRotatef((ROT_FACTOR_PLANET * scene.day) / rot_fac_day, 0.0f, 0.0f, -1.0f);
 
 	/* Center axis */
 	glPushMatrix();
@@ -540,38 +611,39 @@ void draw_Planet_1(void)
 	glVertex3f(0, 0, -5);
 	glVertex3f(0, 0, 5);
 	glEnd();
+	count_draw_call(2);
 	glPopMatrix();
 
 	/* circle1 */
 	glPushMatrix();
 	glColor3f(0.8f, 0.0f, 0.2f);
 	/* glRotatef(90, 0.0f, 1.0f, 0.0f); [> "senkrecht zur Planetenachse" <] */
-	gluDisk(quadric, 1.2f, 1.3f, 32, 1);
+	draw_disk(1.2f, 1.3f, 32);
 	glPopMatrix();
 
 	/* circle2 */
 	glPushMatrix();
 	glColor3f(0.0f, 1.0f, 0.0f);
 	/* glRotatef(90, 0.0f, 1.0f, 0.0f); [> "senkrecht zur Planetenachse" <] */
-	gluDisk(quadric, 1.4f, 1.7f, 32, 1);
+	draw_disk(1.4f, 1.7f, 32);
 	glPopMatrix();
 
 	/* Moon1 */
 	glPushMatrix();
 	glColor3f(0.0f, 0.0f, 1.0f);
-	/* glRotatef((ROT_FACTOR_MOON * day), 1.0f, 0.0f, 0.0f); [> "senkrecht zur Planetenachse" <] */
-	glRotatef((ROT_FACTOR_MOON * day), 0.0f, 0.0f, 1.0f);
+	/* glRotatef((ROT_FACTOR_MOON * scene.day), 1.0f, 0.0f, 0.0f); [> "senkrecht zur Planetenachse" <] */
+	glRotatef((ROT_FACTOR_MOON * scene.day), 0.0f, 0.0f, 1.0f);
 	glTranslatef(0.0f, 2.0f, 0.0f);
-	glutWireSphere(0.1f, XY_WIRE_COUNT, XY_WIRE_COUNT);
+	draw_wire_sphere(0.1f, XY_WIRE_COUNT, XY_WIRE_COUNT);
 	glPopMatrix();
 
 	/* Moon2 */
 	glPushMatrix();
 	glColor3f(0.0f, 1.0f, 1.0f);
-	/* glRotatef((ROT_FACTOR_MOON * day), 1.0f, 0.0f, 0.0f); [> "senkrecht zur Planetenachse" <] */
-	glRotatef((ROT_FACTOR_MOON * day), 0.0f, 0.0f, 1.0f);
+	/* glRotatef((ROT_FACTOR_MOON * scene.day), 1.0f, 0.0f, 0.0f); [> "senkrecht zur Planetenachse" <] */
+	glRotatef((ROT_FACTOR_MOON * scene.day), 0.0f, 0.0f, 1.0f);
 	glTranslatef(0.0f, -2.0f, 0.0f);
-	glutWireSphere(0.1f, XY_WIRE_COUNT, XY_WIRE_COUNT);
+	draw_wire_sphere(0.1f, XY_WIRE_COUNT, XY_WIRE_COUNT);
 	glPopMatrix();
 
 	glPopMatrix();
@@ -591,7 +663,7 @@ void draw_Planet_2(void)
 	/* Rotate around the sun */
 	glTranslatef(0.0f, 0.0f, SYSTEM_POS_Z);
 	glRotatef(90, 1.0f, 0.0f, 0.0f);
-	glRotatef((ROT_FACTOR_PLANET_SUN * day), 0.0f, 0.0f, 1.0f);
+	glRotatef((ROT_FACTOR_PLANET_SUN * scene.day), 0.0f, 0.0f, 1.0f);
 	glTranslatef(-2.0f, -8.0f, 0.0f);
 
 	glColor3f(0.0f, 0.0f, 1.0f);
@@ -599,35 +671,35 @@ void draw_Planet_2(void)
 	/* A rotation (full 360°) once a day is much
 	 * too fast you woulden'd see a thing */
 	const int rot_fac_day = 15;
-	glRotatef((ROT_FACTOR_PLANET * day) / rot_fac_day, 0.0f, 0.0f, 1.0f);
-	glutWireSphere(1.3f, XY_WIRE_COUNT, XY_WIRE_COUNT);
-	glRotatef((ROT_FACTOR_PLANET * day) / rot_fac_day, 0.0f, 0.0f, -1.0f);
+	glRotatef((ROT_FACTOR_PLANET * scene.day) / rot_fac_day, 0.0f, 0.0f, 1.0f);
+	draw_wire_sphere(1.3f, XY_WIRE_COUNT, XY_WIRE_COUNT);
+	glRotatef((ROT_FACTOR_PLANET * scene.day) / rot_fac_day, 0.0f, 0.0f, -1.0f);
 
 	/* Moon3 */
 	glPushMatrix();
 	glColor3f(1.0f, 1.0f, 1.0f);
-	glRotatef((ROT_FACTOR_MOON * day), 0.0f, 0.0f, 1.0f);
+	glRotatef((ROT_FACTOR_MOON * scene.day), 0.0f, 0.0f, 1.0f);
 	glTranslatef(cos(0 * (M_PI / 180)) * moon_pos_fac,
 			sin(0 * (M_PI / 180)) * moon_pos_fac, 0.0f);
-	glutWireSphere(0.1f, XY_WIRE_COUNT, XY_WIRE_COUNT);
+	draw_wire_sphere(0.1f, XY_WIRE_COUNT, XY_WIRE_COUNT);
 	glPopMatrix();
 
 	/* Moon4 */
 	glPushMatrix();
 	glColor3f(1.0f, 0.0f, 1.0f);
-	glRotatef((ROT_FACTOR_MOON * day), 0.0f, 0.0f, 1.0f);
+	glRotatef((ROT_FACTOR_MOON * scene.day), 0.0f, 0.0f, 1.0f);
 	glTranslatef(cos(120 * (M_PI / 180)) * moon_pos_fac,
 			sin(120 * (M_PI / 180)) * moon_pos_fac, 0.0f);
-	glutWireSphere(0.1f, XY_WIRE_COUNT, XY_WIRE_COUNT);
+	draw_wire_sphere(0.1f, XY_WIRE_COUNT, XY_WIRE_COUNT);
 	glPopMatrix();
 
 	/* Moon5 */
 	glPushMatrix();
 	glColor3f(1.0f, 0.0f, 0.0f);
-	glRotatef((ROT_FACTOR_MOON * day), 0.0f, 0.0f, 1.0f);
+	glRotatef((ROT_FACTOR_MOON * scene.day), 0.0f, 0.0f, 1.0f);
 	glTranslatef(cos(240 * (M_PI / 180)) * moon_pos_fac,
 			sin(240 * (M_PI / 180)) * moon_pos_fac, 0.0f);
-	glutWireSphere(0.1f, XY_WIRE_COUNT, XY_WIRE_COUNT);
+	draw_wire_sphere(0.1f, XY_WIRE_COUNT, XY_WIRE_COUNT);
 	glPopMatrix();
 
 	glPopMatrix();
@@ -635,28 +707,26 @@ void draw_Planet_2(void)
 
 /**
  * Displays the whole setup with the sun, planet one,
- * planet two and the frame rate
+ * planet two and the frame rate, as the simulation state
+ * scene has them. Every frame and its draw_* calls are timed
+ * by frame_profiler.
  */
 void draw_scene(void)
 {
-	day++;
-	if (day >= yearabs) {
-		day = 0;
-		year++;
-	}
-	if (year >= (INT_MAX - 1000) || year < 0) {
-		year = 0;
-	}
-	if (day < 0) {
-		day = 0;
-	}
+	profiler_begin_frame(&frame_profiler);
 
 	glClear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
 	glMatrixMode(GL_MODELVIEW);
 
+	profiler_push(&frame_profiler, PROFILE_DRAW_OBJ);
 	draw_obj(0, 0, 0, 0);
+	profiler_pop(&frame_profiler);
+	profiler_push(&frame_profiler, PROFILE_DRAW_PLANET_1);
 	draw_Planet_1();
+	profiler_pop(&frame_profiler);
+	profiler_push(&frame_profiler, PROFILE_DRAW_PLANET_2);
 	draw_Planet_2();
+	profiler_pop(&frame_profiler);
 
 	glMatrixMode(GL_PROJECTION);
 	glPushMatrix();
@@ -667,12 +737,29 @@ void draw_scene(void)
 	glPushMatrix();
 	glLoadIdentity();
 	glColor3f(1.0f, 1.0f, 1.0f);
-	glRasterPos2i(5, 10);
+	if (show_profiler) {
+		profiler_push(&frame_profiler, PROFILE_DRAW_OVERLAY);
+		draw_profiler_overlay(&frame_profiler);
+		profiler_pop(&frame_profiler);
+	}
 
 	glMatrixMode(GL_MODELVIEW);
 	glPopMatrix();
 	glMatrixMode(GL_PROJECTION);
 	glPopMatrix();
 	glEnable(GL_TEXTURE_2D);
+
+	profiler_end_frame(&frame_profiler);
 }
 
+/**
+ * Get the settings of the simulation from the ones the
+ * keys change.
+ *
+ * @param params the settings [out]
+ */
+void get_scene_params(sim_params *params)
+{
+	params->ball_speed = ball_speed;
+	params->yearabs = yearabs;
+}
@@ -28,8 +28,10 @@
 
 #include "bezier.h"
 #include "half_edge.h"
+#include "profiler.h"
+#include "render.h"
+#include "sim.h"
 
-#include <GL/glut.h>
 #include <GL/gl.h>
 #include <GL/glu.h>
 
@@ -44,7 +46,6 @@
 #define TIMERMSECS 25
 
 #define XY_WIRE_COUNT 10.0f
-#define FPS_OUT_SIZE 17
 #define ROT_FACTOR_PLANET_SUN (360.0 / yearabs)
 #define ROT_FACTOR_PLANET (360.0 / 1.0)
 #define ROT_FACTOR_MOON (360.0 / dayabs)
@@ -58,25 +59,36 @@
 
 extern int yearabs;
 extern int dayabs;
+extern sim_state scene;
 extern HE_obj *obj;
 extern HE_obj *float_obj;
 extern HE_obj *bez_obj;
+extern render_mesh obj_mesh;
+extern render_mesh float_obj_mesh;
+extern render_lines obj_normals;
+extern render_curve *bez_obj_curves;
 extern bool show_normals;
+extern float normals_scale;
 extern bool shademodel;
 extern bool draw_frame;
 extern bool draw_bezier;
 extern float ball_speed;
+extern profiler frame_profiler;
+extern bool show_profiler;
 
 
-void draw_normals(HE_obj const * const obj,
-		float const scale_inc);
-void draw_vertices(HE_obj const * const obj,
+void draw_normals(HE_obj * const obj,
+		render_lines *lines);
+void draw_vertices(HE_obj * const obj,
+		render_mesh *mesh,
 		bool disco_set);
-void draw_bez(const bez_curv *bez, float step_factor_inc);
+void draw_bez(const bez_curv *bez,
+		render_curve *curve,
+		float tolerance_inc);
 void draw_bez_frame(const bez_curv *bez,
-		float pos);
+		float section);
 void draw_ball(const bez_curv *bez,
-		const float pos);
+		const float section);
 void draw_obj(int32_t const myxrot,
 		int32_t const myyrot,
 		int32_t const myzrot,
@@ -84,6 +96,7 @@ void draw_obj(int32_t const myxrot,
 void draw_Planet_1(void);
 void draw_Planet_2(void);
 void draw_scene(void);
+void get_scene_params(sim_params *params);
 
 
 #endif /* _DROW_ENGINE_DRAW_H */
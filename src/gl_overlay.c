@@ -0,0 +1,199 @@
+/*
+ * Copyright 2011-2014 hasufell
+ *
+ * This file is part of a hasufell project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation version 2 of the License only.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file gl_overlay.c
+ * Draws text on top of the scene with glBitmap() and a built-in
+ * 5x7 font, since the bitmap fonts of GLUT need glutInit() and
+ * so a window system. Used for the frame profiler overlay.
+ * @brief text overlay
+ */
+
+#include "gl_overlay.h"
+#include "profiler.h"
+
+#include <GL/gl.h>
+
+#include <ctype.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+
+/**
+ * Width of a glyph in pixels.
+ */
+#define GLYPH_WIDTH 5
+
+/**
+ * Height of a glyph in pixels.
+ */
+#define GLYPH_HEIGHT 7
+
+/**
+ * Horizontal distance of two glyphs in pixels.
+ */
+#define GLYPH_ADVANCE 6
+
+/**
+ * Vertical distance of two lines in the coordinates of
+ * draw_scene()'s overlay projection.
+ */
+#define LINE_HEIGHT 12
+
+
+/**
+ * The font, rows from top to bottom, with the leftmost pixel
+ * in bit 4. Lower case letters are drawn as upper case ones,
+ * characters without a glyph as spaces.
+ */
+static unsigned char const font[128][GLYPH_HEIGHT] = {
+	['0'] = { 0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E },
+	['1'] = { 0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E },
+	['2'] = { 0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F },
+	['3'] = { 0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E },
+	['4'] = { 0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02 },
+	['5'] = { 0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E },
+	['6'] = { 0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E },
+	['7'] = { 0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08 },
+	['8'] = { 0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E },
+	['9'] = { 0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C },
+	['A'] = { 0x0E, 0x11, 0x11, 0x11, 0x1F, 0x11, 0x11 },
+	['B'] = { 0x1E, 0x11, 0x11, 0x1E, 0x11, 0x11, 0x1E },
+	['C'] = { 0x0E, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0E },
+	['D'] = { 0x1C, 0x12, 0x11, 0x11, 0x11, 0x12, 0x1C },
+	['E'] = { 0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x1F },
+	['F'] = { 0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x10 },
+	['G'] = { 0x0E, 0x11, 0x10, 0x17, 0x11, 0x11, 0x0F },
+	['H'] = { 0x11, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11 },
+	['I'] = { 0x0E, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E },
+	['J'] = { 0x07, 0x02, 0x02, 0x02, 0x02, 0x12, 0x0C },
+	['K'] = { 0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11 },
+	['L'] = { 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1F },
+	['M'] = { 0x11, 0x1B, 0x15, 0x15, 0x11, 0x11, 0x11 },
+	['N'] = { 0x11, 0x11, 0x19, 0x15, 0x13, 0x11, 0x11 },
+	['O'] = { 0x0E, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E },
+	['P'] = { 0x1E, 0x11, 0x11, 0x1E, 0x10, 0x10, 0x10 },
+	['Q'] = { 0x0E, 0x11, 0x11, 0x11, 0x15, 0x12, 0x0D },
+	['R'] = { 0x1E, 0x11, 0x11, 0x1E, 0x14, 0x12, 0x11 },
+	['S'] = { 0x0F, 0x10, 0x10, 0x0E, 0x01, 0x01, 0x1E },
+	['T'] = { 0x1F, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04 },
+	['U'] = { 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E },
+	['V'] = { 0x11, 0x11, 0x11, 0x11, 0x11, 0x0A, 0x04 },
+	['W'] = { 0x11, 0x11, 0x11, 0x15, 0x15, 0x15, 0x0A },
+	['X'] = { 0x11, 0x11, 0x0A, 0x04, 0x0A, 0x11, 0x11 },
+	['Y'] = { 0x11, 0x11, 0x11, 0x0A, 0x04, 0x04, 0x04 },
+	['Z'] = { 0x1F, 0x01, 0x02, 0x04, 0x08, 0x10, 0x1F },
+	['.'] = { 0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C },
+	[':'] = { 0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x0C, 0x00 },
+	['-'] = { 0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00 },
+	['_'] = { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1F },
+	['/'] = { 0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x00 },
+	['%'] = { 0x18, 0x19, 0x02, 0x04, 0x08, 0x13, 0x03 },
+};
+
+
+/**
+ * Draw a line of ASCII text with the current color, with its
+ * lower left corner at a position of the current projection.
+ * The line is put together in one bitmap and drawn with a single
+ * glBitmap() call, since every call is a draw of its own. Text
+ * longer than OVERLAY_LINE_SIZE - 1 characters is cut off.
+ *
+ * @param x the x coordinate
+ * @param y the y coordinate
+ * @param text the text
+ */
+void draw_text(int x, int y, char const * const text)
+{
+	GLubyte bitmap[GLYPH_HEIGHT][(OVERLAY_LINE_SIZE * GLYPH_ADVANCE + 7) / 8];
+	size_t len = strlen(text);
+	GLsizei width;
+
+	if (len > OVERLAY_LINE_SIZE - 1)
+		len = OVERLAY_LINE_SIZE - 1;
+	width = (GLsizei)(len * GLYPH_ADVANCE);
+
+	/* glBitmap() wants the rows from bottom to top,
+	 * with the leftmost pixel in the highest bit */
+	memset(bitmap, 0, sizeof(bitmap));
+	for (size_t i = 0; i < len; i++) {
+		uint32_t const glyph =
+			(uint32_t)toupper((unsigned char)text[i]) & 127;
+
+		for (uint32_t row = 0; row < GLYPH_HEIGHT; row++) {
+			uint8_t const bits = font[glyph][GLYPH_HEIGHT - 1 - row];
+
+			for (uint32_t col = 0; col < GLYPH_WIDTH; col++) {
+				size_t const px = i * GLYPH_ADVANCE + col;
+
+				if (bits & (1 << (GLYPH_WIDTH - 1 - col)))
+					bitmap[row][px / 8] |= (GLubyte)(0x80 >> (px % 8));
+			}
+		}
+	}
+
+	glRasterPos2i(x, y);
+
+	glPushClientAttrib(GL_CLIENT_PIXEL_STORE_BIT);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, sizeof(bitmap[0]) * 8);
+	glBitmap(width, GLYPH_HEIGHT, 0, 0, (GLfloat)width, 0, bitmap[0]);
+	glPopClientAttrib();
+}
+
+/**
+ * Draw the frame rate, the time of a frame and of every zone,
+ * averaged over the last OVERLAY_FRAMES frames, in the lower
+ * left corner. Needs the projection draw_scene() sets up for it.
+ *
+ * @param prof the profiler
+ */
+void draw_profiler_overlay(profiler const *prof)
+{
+	profile_summary sum;
+	char line[OVERLAY_LINE_SIZE];
+	int y = 5;
+
+	if (!profiler_summary(prof, OVERLAY_FRAMES, &sum))
+		return;
+
+	glPushAttrib(GL_ENABLE_BIT | GL_CURRENT_BIT);
+	glDisable(GL_LIGHTING);
+	glDisable(GL_DEPTH_TEST);
+	glDisable(GL_TEXTURE_2D);
+	glColor3f(1.0f, 1.0f, 1.0f);
+
+	/* the zones from the bottom up, the totals on top */
+	for (uint32_t i = PROFILE_ZONE_C; i-- > 0;) {
+		if (!sum.zone_ran[i])
+			continue;
+
+		snprintf(line, sizeof(line), "%-14s %7.3f ms",
+				profile_zone_name(i), sum.zone_ms[i]);
+		draw_text(5, y, line);
+		y += LINE_HEIGHT;
+	}
+
+	snprintf(line, sizeof(line), "%5.1f fps %6.2f ms cpu %6.2f ms",
+			sum.fps, sum.frame_ms, sum.cpu_ms);
+	draw_text(5, y, line);
+
+	glPopAttrib();
+}
@@ -0,0 +1,47 @@
+/*
+ * Copyright 2011-2014 hasufell
+ *
+ * This file is part of a hasufell project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation version 2 of the License only.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file gl_overlay.h
+ * Header for the text overlay on top of the scene.
+ * @brief header of gl_overlay.c
+ */
+
+#ifndef _DROW_ENGINE_GL_OVERLAY_H
+#define _DROW_ENGINE_GL_OVERLAY_H
+
+
+#include "profiler.h"
+
+
+/**
+ * Count of frames the overlay averages over.
+ */
+#define OVERLAY_FRAMES 60
+
+/**
+ * Maximum length of a line of the overlay.
+ */
+#define OVERLAY_LINE_SIZE 64
+
+
+void draw_text(int x, int y, char const * const text);
+void draw_profiler_overlay(profiler const *prof);
+
+
+#endif /* _DROW_ENGINE_GL_OVERLAY_H */
@@ -27,8 +27,12 @@
 #include "gl_draw.h"
 #include "gl_setup.h"
 #include "half_edge.h"
+#include "half_edge_normals.h"
+#include "profiler.h"
+#include "render.h"
+#include "sim.h"
+#include "sim_loop.h"
 
-#include <GL/glut.h>
 #include <GL/gl.h>
 
 #include <SDL.h>
@@ -37,7 +41,6 @@
 /*
  * static function declaration
  */
-static void init_opengl(void);
 static bool process_events(SDL_Window *win, SDL_GLContext glctx);
 static void reshape(SDL_Window *win);
 static bool process_window_events(SDL_Window *win,
@@ -50,7 +53,7 @@ static void gl_destroy(SDL_Window *win, SDL_GLContext glctx);
 /**
  * Sets the initial values to start the program.
  */
-static void init_opengl(void)
+void init_opengl(void)
 {
 	glClearColor(0.0, 0.0, 0.0, 0.0);
 	glEnable(GL_DEPTH_TEST);
@@ -161,7 +164,11 @@ static bool process_window_events(SDL_Window *win,
  *
  * press n to toggle normals
  *
- * press k to increase length of normals
+ * press p to toggle the profiler overlay
+ *
+ * press P to write the profiled frames to PROFILER_TRACE_FILE
+ *
+ * press L to increase length of normals
  *
  * press l to decrease length of normals
  *
@@ -241,7 +248,7 @@ static bool process_keypress(SDL_KeyboardEvent *key_event)
 		break;
 	case 'd':
 		if (mod & KMOD_SHIFT) {
-			draw_vertices(obj, true);
+			draw_vertices(obj, &obj_mesh, true);
 		} else {
 			glTranslatef(1.0f, 0.0f, 0.0f);
 		}
@@ -283,9 +290,9 @@ static bool process_keypress(SDL_KeyboardEvent *key_event)
 		break;
 	case 'l':
 		if (mod & KMOD_SHIFT) {
-			draw_normals(obj, 0.01f);
+			normals_scale += 0.01f;
 		} else {
-			draw_normals(obj, -0.01f);
+			normals_scale -= 0.01f;
 		}
 		break;
 	case 'w':
@@ -297,6 +304,17 @@ static bool process_keypress(SDL_KeyboardEvent *key_event)
 	case 'n':
 		show_normals = !show_normals;
 		break;
+	case 'p':
+		if (mod & KMOD_SHIFT) {
+			if (save_profiler_trace(&frame_profiler, PROFILER_TRACE_FILE))
+				printf("Wrote trace to \"%s\"\n", PROFILER_TRACE_FILE);
+			else
+				fprintf(stderr, "Failed to write trace to \"%s\"!\n",
+						PROFILER_TRACE_FILE);
+		} else {
+			show_profiler = !show_profiler;
+		}
+		break;
 	case '+':
 		glTranslatef(0.0f, 0.0f, 1.0f);
 		break;
@@ -316,8 +334,7 @@ static bool process_keypress(SDL_KeyboardEvent *key_event)
  */
 static void gl_destroy(SDL_Window *win, SDL_GLContext glctx)
 {
-	delete_object(obj);
-	free(obj);
+	delete_scene();
 
 	SDL_GL_DeleteContext(glctx);
 	SDL_DestroyWindow(win);
@@ -333,14 +350,21 @@ static void gl_destroy(SDL_Window *win, SDL_GLContext glctx)
  * will float around the sun
  * @param bez the file to parse and build the object from which
  * will define on which curve the object floats around the sun
+ * @param stats the load stats of the three objects, in the order
+ * of the files, NULL for none [out]
  */
 void init_object(char const * const sun,
 		char const * const object,
-		char const * const bez)
+		char const * const bez,
+		load_stats *stats)
 {
-	obj = read_obj_file(sun);
-	float_obj = read_obj_file(object);
-	bez_obj	= read_obj_file(bez);
+	if (stats)
+		for (uint32_t i = 0; i < 3; i++)
+			init_load_stats(&(stats[i]));
+
+	obj = read_obj_file_stats(sun, stats);
+	float_obj = read_obj_file_stats(object, stats ? &(stats[1]) : NULL);
+	bez_obj	= read_obj_file_stats(bez, stats ? &(stats[2]) : NULL);
 
 	if (!obj) {
 		ABORT("Failed to read object file \"%s\"!", sun);
@@ -353,17 +377,62 @@ void init_object(char const * const sun,
 	NORMALIZE_OBJECT(obj);
 	NORMALIZE_OBJECT(float_obj);
 	NORMALIZE_OBJECT(bez_obj);
+
+	/* one polyline buffer per curve, uploaded on first draw */
+	if (bez_obj->bzc) {
+		bez_obj_curves = calloc(bez_obj->bzc, sizeof(*bez_obj_curves));
+		CHECK_PTR_VAL(bez_obj_curves);
+	}
+
+	/* the normal lines of upload_render_normals() and
+	 * build_normal_lines() and the vertex buffers of
+	 * build_mesh_batch() need one normal per vertex */
+	if (obj->vnc != obj->vc)
+		COMPUTE_VERTEX_NORMALS(obj, NORMAL_WEIGHT_AREA);
+	if (float_obj->vnc != float_obj->vc)
+		COMPUTE_VERTEX_NORMALS(float_obj, NORMAL_WEIGHT_AREA);
+}
+
+/**
+ * Free the objects of the scene and their buffers. Needs the
+ * OpenGL context the buffers were created in.
+ */
+void delete_scene(void)
+{
+	delete_render_mesh(&obj_mesh);
+	delete_render_mesh(&float_obj_mesh);
+	delete_render_lines(&obj_normals);
+	for (uint32_t i = 0; bez_obj_curves && i < bez_obj->bzc; i++)
+		delete_render_curve(&(bez_obj_curves[i]));
+	free(bez_obj_curves);
+	delete_object(obj);
+	free(obj);
+	delete_object(float_obj);
+	free(float_obj);
+	delete_object(bez_obj);
+	free(bez_obj);
+	obj = NULL;
+	float_obj = NULL;
+	bez_obj = NULL;
+	bez_obj_curves = NULL;
 }
 
 /**
  * Starts the main SDL loop which runs until the user
- * ends the program.
+ * ends the program. The scene is simulated at a fixed rate
+ * of SIM_TICKS_PER_SEC, independent of the frame rate, and
+ * every frame draws it interpolated between the last two ticks.
+ *
+ * @param sim_thread whether to simulate in a worker thread,
+ * which keeps ticking while a frame is slow
  */
-void init_sdl_loop(void)
+void init_sdl_loop(bool sim_thread)
 {
 	SDL_Window *win;
 	SDL_GLContext glctx;
 	const int window_flags = SDL_WINDOW_OPENGL | SDL_WINDOW_SHOWN;
+	sim_loop sim;
+	sim_params params;
 
 	if (SDL_Init(SDL_INIT_VIDEO)) {
 		fprintf(stderr, "Failed initalizing SDL!\n");
@@ -385,15 +454,25 @@ void init_sdl_loop(void)
 
 	init_opengl();
 
+	get_scene_params(&params);
+	if (!start_sim_loop(&sim, &params, sim_thread))
+		/* fall back to ticking in this thread */
+		start_sim_loop(&sim, &params, false);
+
 	while (1) {
 		bool running = process_events(win, glctx);
 
 		if (!running)
 			break;
 
+		get_scene_params(&params);
+		set_sim_loop_params(&sim, &params);
+		get_sim_loop_state(&sim, &scene);
+
 		draw_scene();
 		SDL_GL_SwapWindow(win);
 	}
 
+	stop_sim_loop(&sim);
 	gl_destroy(win, glctx);
 }
@@ -26,10 +26,18 @@
 #define _DROW_ENGINE_SETUP_H
 
 
+#include "load_stats.h"
+
+#include <stdbool.h>
+
+
 void init_object(char const * const sun,
 		char const * const object,
-		char const * const bez);
-void init_sdl_loop(void);
+		char const * const bez,
+		load_stats *stats);
+void init_opengl(void);
+void delete_scene(void);
+void init_sdl_loop(bool sim_thread);
 
 
 #endif /* _DROW_ENGINE_SETUP_H */
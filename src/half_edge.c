@@ -24,11 +24,15 @@
  * @brief operations on half-edge data structs
  */
 
-#include "common.h"
+#include "arena.h"
 #include "err.h"
 #include "filereader.h"
 #include "half_edge.h"
+#include "half_edge_ring.h"
+#include "half_edge_tris.h"
+#include "mesh_bounds.h"
 #include "vector.h"
+#include "vector_simd.h"
 
 #include <stdbool.h>
 #include <stdint.h>
@@ -36,77 +40,6 @@
 #include <stdlib.h>
 
 
-/**
- * Fault intolerant macro. Will abort the program if the called
- * function failed.
- */
-#define GET_ALL_EMANATING_EDGES(...) \
-{ \
-	if (!get_all_emanating_edges(__VA_ARGS__)) { \
-		fprintf(stderr, "Failure in get_all_emanating_edges()!\n"); \
-		abort(); \
-	} \
-}
-
-
-/*
- * static declarations
- */
-static bool get_all_emanating_edges(HE_vert const * const vert,
-		HE_edge ***edge_array_out,
-		uint32_t *ec_out);
-
-
-/**
- * Get all edges that emanate from vertice and return a pointer
- * to that array with the size of ec_out.
- *
- * @param vert the vertice to get the emanating edges of
- * @param edge_array_out address of the 2d edge array to save
- * the result in [out]
- * @param ec_out the edge counter is saved here [out]
- * @return true/false for success/failure
- */
-static bool get_all_emanating_edges(HE_vert const * const vert,
-		HE_edge ***edge_array_out,
-		uint32_t *ec_out)
-{
-	uint32_t ec = 0; /* edge count */
-	uint32_t max_edges = 500; /* good guess to avoid infinite loop */
-	HE_edge **edge_array = NULL;
-
-	if (!edge_array_out || !vert || !ec_out)
-		return false;
-
-	HE_edge *edge = vert->edge;
-
-	/* build an array of emanating edges */
-	do {
-		REALLOC(edge_array,
-				sizeof(HE_edge*) * (ec + 1));
-
-		edge_array[ec] = edge;
-
-		edge = edge->pair->next;
-		ec++;
-
-		/* sanity check */
-		if (ec > max_edges)
-			goto loop_fail_cleanup;
-	} while (edge && edge != vert->edge);
-
-	/* set out-pointers */
-	*edge_array_out = edge_array;
-	*ec_out = ec; /* this is the real size, not the x[ec] value */
-
-	return true;
-
-loop_fail_cleanup:
-	free(edge_array);
-	return false;
-}
-
-
 /**
  * Calculate the normal of a face that corresponds
  * to edge.
@@ -118,57 +51,55 @@ loop_fail_cleanup:
 bool face_normal(HE_edge const * const edge,
 		vector *vec)
 {
-	vector he_vec1,
-		   he_vec2,
-		   he_base;
+	vector he_base;
 
 	if (!edge || !vec)
 		return false;
 
-	COPY_VECTOR(edge->next->vert->vec, &he_base);
+	he_base = *(edge->next->vert->vec);
 
 	/* calculate vectors between the vertices */
-	SUB_VECTORS(edge->next->next->vert->vec, &he_base, &he_vec1);
-	SUB_VECTORS(edge->vert->vec, &he_base, &he_vec2);
-
-	VECTOR_PRODUCT(&he_vec1, &he_vec2, vec);
-
-	NORMALIZE_VECTOR(vec, vec);
+	*vec = vec_normalize(vec_cross(
+				vec_sub(*(edge->next->next->vert->vec), he_base),
+				vec_sub(*(edge->vert->vec), he_base)));
 
 	return true;
 }
 
 /**
- * Calculate the approximated normal of a vertex.
+ * Calculate the approximated normal of a vertex, by summing
+ * up the normals of all incident faces. The faces are taken
+ * from the one-ring index, so no memory is allocated once
+ * that has been built.
  *
- * @param vert the vertex
+ * @param obj the object, its one-ring index is built if
+ * needed [mod]
+ * @param vert index of the vertex
  * @param vec the vector to store the result in [out]
  * @return true/false for success/failure
  */
-bool vec_normal(HE_vert const * const vert, vector *vec)
+bool vec_normal(HE_obj *obj, uint32_t vert, vector *vec)
 {
-	HE_edge **edge_array = NULL;
-	uint32_t ec;
-	vector he_base;
+	HE_ring_iter it;
+	HE_edge *edge;
 
-	if (!vert || !vec)
+	if (!obj || !vec)
 		return false;
 
 	/* fault tolerance if we didn't get any
 	 * normal */
-	if (!get_all_emanating_edges(vert, &edge_array, &ec))
+	if (!ring_iter_init(&it, obj, vert))
 		return false;
 
-	COPY_VECTOR(edge_array[0]->vert->vec, &he_base);
 	SET_NULL_VECTOR(vec); /* set to null for later summation */
 
 	/* iterate over all edges, get the normalized
 	 * face vector and add those up */
-	for (uint32_t i = 0; i < ec; i++) {
+	while ((edge = ring_next_edge(&it))) {
 		vector new_vec;
 
-		if (edge_array[i]->face) {
-			FACE_NORMAL(edge_array[i], &new_vec);
+		if (edge->face) {
+			FACE_NORMAL(edge, &new_vec);
 			ADD_VECTORS(vec, &new_vec, vec);
 		}
 	}
@@ -176,13 +107,12 @@ bool vec_normal(HE_vert const * const vert, vector *vec)
 	/* normalize the result */
 	NORMALIZE_VECTOR(vec, vec);
 
-	free(edge_array);
 	return true;
 }
 
 /**
- * Find the center of an object and store the coordinates
- * in a HE_vert struct.
+ * Find the center of an object, which is the mean of all
+ * vertices, and store the coordinates in a HE_vert struct.
  *
  * @param obj the object we want to find the center of
  * @param vec the vector to store the result in [out]
@@ -190,65 +120,32 @@ bool vec_normal(HE_vert const * const vert, vector *vec)
  */
 bool find_center(HE_obj const * const obj, vector *vec)
 {
-	float x = 0,
-		  y = 0,
-		  z = 0;
-	uint32_t i;
+	mesh_bounds bounds;
 
-	if (!obj || !vec)
+	if (!obj || !vec || !get_mesh_bounds(obj, 0, &bounds))
 		return false;
 
-
-	for (i = 0; i < obj->vc; i++) {
-		x += obj->vertices[i].vec->x;
-		y += obj->vertices[i].vec->y;
-		z += obj->vertices[i].vec->z;
-	}
-
-	vec->x = x / i;
-	vec->y = y / i;
-	vec->z = z / i;
+	*vec = bounds.center;
 
 	return true;
 }
 
 /**
  * Calculates the factor that can be used to scale down the object
- * to the size of 1.
+ * to the size of 1, which scales the longest side of its
+ * bounding box to 1.
  *
  * @param obj the object we want to scale
  * @return the corresponding scale factor, -1 on error
  */
 float get_normalized_scale_factor(HE_obj const * const obj)
 {
-	float max;
-	float min;
-	uint32_t i;
+	mesh_bounds bounds;
 
-	if (!obj)
+	if (!obj || !get_mesh_bounds(obj, 0, &bounds))
 		return -1;
 
-	max = obj->vertices[0].vec->x +
-		obj->vertices[0].vec->y + obj->vertices[0].vec->z;
-	min = obj->vertices[0].vec->x +
-		obj->vertices[0].vec->y + obj->vertices[0].vec->z;
-
-	for (i = 0; i < obj->vc; i++) {
-		if ((obj->vertices[i].vec->x +
-				obj->vertices[i].vec->y +
-				obj->vertices[i].vec->z) > max)
-			max = obj->vertices[i].vec->x +
-				obj->vertices[i].vec->y +
-				obj->vertices[i].vec->z;
-		else if ((obj->vertices[i].vec->x +
-				obj->vertices[i].vec->y +
-				obj->vertices[i].vec->z) < min)
-			min = obj->vertices[i].vec->x +
-				obj->vertices[i].vec->y +
-				obj->vertices[i].vec->z;
-	}
-
-	return 1 / (max - min);
+	return bounds.scale;
 }
 
 /**
@@ -260,33 +157,26 @@ float get_normalized_scale_factor(HE_obj const * const obj)
  */
 bool normalize_object(HE_obj *obj)
 {
-	float scale_factor;
+	mesh_bounds bounds;
 
-	if (!obj)
+	if (!obj || !get_mesh_bounds(obj, 0, &bounds))
 		return false;
 
-	scale_factor = get_normalized_scale_factor(obj);
-
-	for (uint32_t i = 0; i < obj->vc; i++) {
-		obj->vertices[i].vec->x *= scale_factor;
-		obj->vertices[i].vec->y *= scale_factor;
-		obj->vertices[i].vec->z *= scale_factor;
-	}
+	if (!transform_positions(obj->positions, obj->vc, NULL,
+				bounds.scale, 0))
+		return false;
 
-	for (uint32_t i = 0; i < obj->bzc; i++) {
-		for (uint32_t j = 0; j <= obj->bez_curves[i].deg; j++) {
-			obj->bez_curves[i].vec[j].x *= scale_factor;
-			obj->bez_curves[i].vec[j].y *= scale_factor;
-			obj->bez_curves[i].vec[j].z *= scale_factor;
-		}
-		i++;
-	}
+	for (uint32_t i = 0; i < obj->bzc; i++)
+		vec_batch_scale(obj->bez_curves[i].vec, obj->bez_curves[i].vec,
+				obj->bez_curves[i].deg + 1, bounds.scale);
+	obj->version++;
 
 	return true;
 }
 
 /**
- * Free the inner structures of an object.
+ * Free the inner structures of an object. If the object
+ * is owned by an arena, this releases the arena at once.
  *
  * @param obj the object to free
  */
@@ -295,15 +185,23 @@ void delete_object(HE_obj *obj)
 	if (!obj)
 		return;
 
-	for (uint32_t i = 0; i < obj->vc; i++) {
-		free(obj->vertices[i].vec);
-		free(obj->vertices[i].col);
+	delete_vertex_rings(obj);
+	delete_face_triangles(obj);
+
+	if (obj->mem) {
+		arena_release(obj->mem);
+		free(obj->mem);
+		obj->mem = NULL;
+		return;
 	}
+
 	for (uint32_t i = 0; i < obj->bzc; i++)
 		free(obj->bez_curves[i].vec);
 
 	free(obj->edges);
 	free(obj->vertices);
+	free(obj->positions);
+	free(obj->colors);
 	free(obj->faces);
 	free(obj->bez_curves);
 	free(obj->vn);
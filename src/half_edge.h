@@ -29,10 +29,13 @@
 #define _DROW_ENGINE_HE_OPERATIONS_H
 
 
+#include "arena.h"
 #include "bezier.h"
+#include "load_stats.h"
 #include "vector.h"
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 
@@ -110,9 +113,10 @@ typedef double** V_NORMALS;
 typedef struct FACES FACES;
 typedef struct HE_edge HE_edge;
 typedef struct HE_vert HE_vert;
-typedef struct HE_vert_acc HE_vert_acc;
 typedef struct HE_face HE_face;
 typedef struct HE_obj HE_obj;
+typedef struct HE_ring HE_ring;
+typedef struct HE_tris HE_tris;
 typedef struct color color;
 
 
@@ -143,6 +147,11 @@ struct obj_items {
 	 * Vertices normals
 	 */
 	V_NORMALS vn;
+	/**
+	 * Owns all rows of the raw arrays, the arrays of
+	 * row pointers are allocated on their own.
+	 */
+	arena mem;
 };
 
 /**
@@ -193,7 +202,8 @@ struct HE_edge {
 struct HE_vert {
 	/**
 	 * A vector pointing
-	 * to the coordinates of the vertex.
+	 * to the coordinates of the vertex. This points into
+	 * the positions array of the HE_obj.
 	 */
 	vector *vec;
 	/**
@@ -203,54 +213,10 @@ struct HE_vert {
 	 */
 	HE_edge *edge;
 	/**
-	 * Color of the vertex.
+	 * Color of the vertex. This points into
+	 * the colors array of the HE_obj.
 	 */
 	color *col;
-	/**
-	 * The acceleration structure, used to speed up
-	 * assembling the half-edge structures.
-	 */
-	HE_vert_acc *acc;
-};
-
-/**
- * Structure only needed for various
- * acceleration techniques during assembling of the
- * half-edge.
- */
-struct HE_vert_acc {
-	/**
-	 * Array that saves all potential
-	 * pair edges that point TO this vertex. It is used
-	 * for finding the pairs when assembling
-	 * the HE_edge struct. Note that this does not reliably
-	 * save all border edges (which is a non-issue for the
-	 * specific purpose of this struct since border-edges
-	 * don't qualify for pairs anyway).
-	 */
-	HE_edge **edge_array;
-	/**
-	 * Similar as the edge_array acceleration structure,
-	 * except that it is used for connecting the
-	 * dummy edges.
-	 */
-	HE_edge **dummys;
-	/**
-	 * Element count of the edge_array.
-	 */
-	uint32_t eac;
-	/**
-	 * Amount of allocations for edge_array.
-	 */
-	int32_t eac_alloc;
-	/**
-	 * Element count of dummys.
-	 */
-	uint32_t dc;
-	/**
-	 * Amount of allocations for dummy edges array.
-	 */
-	int32_t dc_alloc;
 };
 
 /**
@@ -277,6 +243,17 @@ struct HE_obj {
 	 * Array of vertices.
 	 */
 	HE_vert *vertices;
+	/**
+	 * Coordinates of all vertices, in the same order
+	 * as the vertices array. Loops over all coordinates
+	 * should use this instead of going through the vertices.
+	 */
+	vector *positions;
+	/**
+	 * Colors of all vertices, in the same order
+	 * as the vertices array.
+	 */
+	color *colors;
 	/**
 	 * Array of faces.
 	 */
@@ -317,6 +294,29 @@ struct HE_obj {
 	 * Count of vertice normals.
 	 */
 	uint32_t vnc;
+	/**
+	 * Owns all arrays of the object if set, in which case
+	 * delete_object() releases them at once. NULL if every
+	 * array has been allocated on its own.
+	 */
+	arena *mem;
+	/**
+	 * One-ring index of all vertices, see half_edge_ring.h.
+	 * NULL until it is first used.
+	 */
+	HE_ring *ring;
+	/**
+	 * Triangles of all faces, see half_edge_tris.h.
+	 * NULL until they are first used.
+	 */
+	HE_tris *tris;
+	/**
+	 * Incremented whenever the positions, normals or colors
+	 * change, so that copies of them, like vertex buffers,
+	 * know when to update. Code which changes them directly
+	 * has to increment it, too.
+	 */
+	uint32_t version;
 };
 
 /**
@@ -331,11 +331,24 @@ struct color {
 
 bool face_normal(HE_edge const * const edge,
 		vector *vec);
-bool vec_normal(HE_vert const * const vert, vector *vec);
+bool vec_normal(HE_obj *obj, uint32_t vert, vector *vec);
 bool find_center(HE_obj const * const obj, vector *vec);
 float get_normalized_scale_factor(HE_obj const * const obj);
 bool normalize_object(HE_obj *obj);
 HE_obj *parse_obj(char const * const filename);
+HE_obj *parse_obj_buf(char const * const obj_buf, size_t len);
+HE_obj *parse_obj_parallel(char const * const obj_buf,
+		size_t len,
+		unsigned threads);
+HE_obj *parse_obj_stats(char const * const obj_buf,
+		size_t len,
+		unsigned threads,
+		load_stats *stats);
+size_t obj_items_arena_size(obj_items const * const raw_obj,
+		HE_obj const * const he_obj);
+void assemble_obj_items(obj_items const * const raw_obj,
+		HE_obj *he_obj,
+		unsigned threads);
 void delete_object(HE_obj *obj);
 
 
@@ -23,21 +23,169 @@
  * @brief Half-edge assembler
  */
 
+#include "arena.h"
 #include "common.h"
 #include "err.h"
 #include "filereader.h"
+#include "load_stats.h"
+#include "obj_scan.h"
 
+#include <pthread.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
+
+
+/**
+ * Files smaller than this per thread are not worth
+ * being parsed in parallel.
+ */
+#define MIN_CHUNK_SIZE (256 * 1024)
+
+
+/**
+ * Sort key of an edge within its bucket when pairing edges:
+ * the other vertex, whether the edge runs towards the vertex
+ * of the bucket and the index of the edge. Vertex indices
+ * must fit into 31 bit.
+ */
+#define PAIR_KEY(other, towards, edge) \
+	(((uint64_t)(other) << 33) | ((uint64_t)(towards) << 32) | (edge))
+
+/**
+ * Bits per pass of the radix sort in assemble_HE_parallel().
+ */
+#define RADIX_BITS 8
+
+/**
+ * Count of digits per pass of the radix sort.
+ */
+#define RADIX_SIZE (1 << RADIX_BITS)
+
+/**
+ * Buckets up to this size are sorted by insertion sort
+ * when pairing edges.
+ */
+#define INSERTION_SORT_MAX 16
+
+
+typedef struct obj_chunk obj_chunk;
+typedef struct assembly_part assembly_part;
+
+/**
+ * A part of the obj buffer which is parsed on its own,
+ * possibly in its own thread, along with the raw arrays
+ * parsed from it. All indices stay as they are in the file,
+ * so chunks only need to be concatenated in order.
+ */
+struct obj_chunk {
+	/**
+	 * Start of the part, always at the beginning of a line.
+	 */
+	char const *start;
+	/**
+	 * End of the part (exclusive).
+	 */
+	char const *end;
+	/**
+	 * Raw vertices array.
+	 */
+	VERTICES v;
+	/**
+	 * Raw vertices normals array.
+	 */
+	V_NORMALS vn;
+	/**
+	 * Raw texture coordinates array.
+	 */
+	V_TEXTURES vt;
+	/**
+	 * Vertex references of the raw faces.
+	 */
+	uint32_t **f_v;
+	/**
+	 * Texture coordinate references of the raw faces.
+	 */
+	uint32_t **f_vt;
+	/**
+	 * Raw bezier curves array.
+	 */
+	BEZIER_CURV bez;
+	/**
+	 * Owns the rows of all raw arrays.
+	 */
+	arena mem;
+	uint32_t vc, vnc, vtc, fc, ec, bzc;
+};
+
+/**
+ * The part of the work one thread does in every step
+ * of assemble_HE_parallel().
+ */
+struct assembly_part {
+	/**
+	 * The raw object.
+	 */
+	obj_items const *raw_obj;
+	/**
+	 * The object which is assembled.
+	 */
+	HE_obj *he_obj;
+	/**
+	 * First face of the part.
+	 */
+	uint32_t face_start;
+	/**
+	 * End of the faces of the part (exclusive).
+	 */
+	uint32_t face_end;
+	/**
+	 * First edge or key of the part.
+	 */
+	uint32_t edge_start;
+	/**
+	 * End of the edges or keys of the part (exclusive).
+	 */
+	uint32_t edge_end;
+	/**
+	 * Sort keys of all edges.
+	 */
+	uint64_t *keys;
+	/**
+	 * Scratch space of the same size as keys.
+	 */
+	uint64_t *tmp;
+	/**
+	 * Digit counts or target indices of the current
+	 * radix sort pass.
+	 */
+	uint32_t hist[RADIX_SIZE];
+	/**
+	 * Shift of the digit of the current radix sort pass.
+	 */
+	uint32_t shift;
+	/**
+	 * Result or input of the current step, such as the count
+	 * of edges of the part.
+	 */
+	uint32_t count;
+};
 
 
 /*
  * static function declaration
  */
-static bool assemble_obj_arrays(char const * const obj_string,
+static void *parse_obj_chunk(void *arg);
+static void merge_obj_chunks(obj_chunk *chunks,
+		uint32_t chunk_c,
+		obj_items *raw_obj,
+		HE_obj *he_obj);
+static bool assemble_obj_arrays(char const * const obj_buf,
+		size_t len,
+		uint32_t threads,
 		obj_items *raw_obj,
 		HE_obj *he_obj);
 static void assemble_HE_stage1(obj_items const * const raw_obj,
@@ -45,55 +193,78 @@ static void assemble_HE_stage1(obj_items const * const raw_obj,
 static void assemble_HE_stage2(obj_items const * const raw_obj,
 		HE_obj *he_obj);
 static void assemble_HE_stage3(HE_obj *he_obj);
-static void delete_accel_struct(HE_obj *he_obj);
-static void delete_raw_object(obj_items *raw_obj,
-		uint32_t fc,
-		uint32_t vc,
-		uint32_t vtc,
-		uint32_t bzc,
-		uint32_t vnc);
+static void assemble_faces(obj_items const * const raw_obj,
+		HE_obj *he_obj,
+		uint32_t face_start,
+		uint32_t face_end,
+		uint32_t ec);
+static void assemble_vertex_edges(HE_obj *he_obj);
+static void pair_bucket(HE_edge *edges,
+		uint64_t *bucket,
+		uint32_t n);
+static uint32_t create_dummy_edges(HE_obj *he_obj,
+		uint32_t start,
+		uint32_t end,
+		uint32_t dec);
+static void link_dummy_edges(HE_obj *he_obj);
+static void run_assembly_parts(void *(*fn)(void*),
+		assembly_part *parts,
+		uint32_t part_c);
+static void *count_part_edges(void *arg);
+static void *assemble_part_faces(void *arg);
+static void *key_part_edges(void *arg);
+static void *radix_part_count(void *arg);
+static void *radix_part_scatter(void *arg);
+static int cmp_uint64(void const *a, void const *b);
+static void *pair_part_edges(void *arg);
+static void *count_part_borders(void *arg);
+static void *dummy_part_edges(void *arg);
+static void assemble_HE_parallel(obj_items const * const raw_obj,
+		HE_obj *he_obj,
+		uint32_t threads,
+		load_stats *stats);
+static void assemble_HE(obj_items const * const raw_obj,
+		HE_obj *he_obj,
+		unsigned threads,
+		load_stats *stats);
+static void delete_raw_object(obj_items *raw_obj);
 
 
 /**
- * Parse the obj_string for obj related arrays such as
+ * Parse a part of the obj buffer for obj related arrays such as
  * "f 1 4 3 2" or "v 0.3 0.2 -1.2" and fill the related
- * raw obj_* structures which are not yet HE_* structures.
- * This function is a blob to take advantage of subsequent
- * strtok_r calls which allow us to parse the whole string only
- * once.
- *
- * NOTE: This function can be buggy for trailing whitespaces on
- * the end of lines or dos line endings.
+ * raw arrays of the chunk, which are not yet HE_* structures.
+ * The part is walked line by line only once by the
+ * scanner in obj_scan.c and is never modified or copied,
+ * so it can directly point into a read-only file mapping.
+ * Dos line endings and trailing whitespace are handled.
+ * Every row is allocated with its exact size from the arena
+ * of the chunk instead of growing it on the heap.
+ * The signature allows running this as a thread.
  *
- * @param obj_string the string that is in obj format
- * @param raw_obj contains arrays of the items as they are in the .obj
- * file; members v, f and vt are set [out]
- * @param he_obj the half-edge object containing array-pointers
- * to all the HE_* structures; members ec, fc, vc and vtc are set [out]
- * @return true/false for success/failure
+ * @param arg the obj_chunk to parse, with start and end set
+ * and all other members zeroed [mod]
+ * @return NULL
  */
-static bool assemble_obj_arrays(char const * const obj_string,
-		obj_items *raw_obj,
-		HE_obj *he_obj)
+static void *parse_obj_chunk(void *arg)
 {
-	char *string;
-
-	/* for strtok_r */
-	char *str_ptr_space = NULL,
-		 *str_ptr_newline = NULL,
-		 *str_ptr_slash = NULL,
-		 *str_tmp_ptr = NULL;
+	obj_chunk *chunk = arg;
+	char const *pos = chunk->start,
+		  *end = chunk->end;
+	arena *mem = &(chunk->mem);
 
-	/* these will be assigned later to the out structs */
 	uint32_t vc = 0, fc = 0, ec = 0, vtc = 0, bzc = 0, vnc = 0;
 	VERTICES obj_v = NULL;
-	FACES *obj_f = malloc(sizeof(*obj_f));
-	uint32_t **obj_f_v = NULL; /* tmp v member of obj_f */
-	uint32_t **obj_f_vt = NULL; /* tmp vt member of obj_f */
+	uint32_t **obj_f_v = NULL;
+	uint32_t **obj_f_vt = NULL;
 	V_TEXTURES obj_vt = NULL;
 	BEZIER_CURV bez = NULL;
 	V_NORMALS obj_vn = NULL;
 
+	/* the indices of the current line, before they go into a row */
+	uint32_t *row_v = NULL;
+	uint32_t *row_vt = NULL;
+
 	/* allocator chunks/counts */
 	const int32_t obj_v_alloc_chunk = 200;
 	int32_t obj_v_alloc_c = 0;
@@ -107,109 +278,84 @@ static bool assemble_obj_arrays(char const * const obj_string,
 	int32_t obj_f_vt_alloc_c = 0;
 	const int32_t bez_alloc_chunk = 3;
 	int32_t bez_alloc_c = 0;
+	const int32_t row_v_alloc_chunk = 16;
+	int32_t row_v_alloc_c = 0;
+	const int32_t row_vt_alloc_chunk = 16;
+	int32_t row_vt_alloc_c = 0;
 
+	arena_init(mem, ARENA_BLOCK_SIZE);
 
-	if (!obj_string || !raw_obj)
-		return false;
-
-	/* avoid side effects */
-	string = malloc(sizeof(char) * strlen(obj_string) + 1);
-	strcpy(string, obj_string);
+	/* start parsing the buffer line by line */
+	while (pos < end) {
+		char const *line_end = scan_line_end(pos, end);
 
-	/* start parsing the string line by line */
-	str_tmp_ptr = strtok_r(string, "\n", &str_ptr_newline);
-
-	while (str_tmp_ptr && *str_tmp_ptr) {
-
-		/* parse word by word */
-		str_tmp_ptr = strtok_r(str_tmp_ptr, " ", &str_ptr_space);
+		switch (scan_keyword(&pos, line_end)) {
 
 		/*
 		 * VERTICES
 		 */
-		if (!strcmp(str_tmp_ptr, "v")) {
-			char *myint = NULL;
-			uint8_t i = 0;
-
+		case OBJ_KW_V:
 			MAYBE_REALLOC(obj_v,
 					sizeof(*obj_v),
 					(int32_t)vc > (obj_v_alloc_c - 2),
 					obj_v_alloc_c,
 					obj_v_alloc_chunk);
 
-			obj_v[vc] = malloc(sizeof(**obj_v) * 4);
+			obj_v[vc] = arena_alloc(mem, sizeof(**obj_v) * 4);
 
-			while ((myint = strtok_r(NULL, " ", &str_ptr_space))) {
-				obj_v[vc][i] = atof(myint);
-				i++;
+			if (scan_doubles(&pos, line_end, obj_v[vc], 4) > 3)
+				ABORT("Malformed vertice exceeds 3 dimensions!\n");
 
-				if (i > 3)
-					ABORT("Malformed vertice exceeds 3 dimensions!\n");
-			}
 			vc++;
 			obj_v[vc] = NULL; /* trailing NULL pointer */
+			break;
 
 		/*
 		 * VERTICES NORMALS
 		 */
-		} else if (!strcmp(str_tmp_ptr, "vn")) {
-			char *myint = NULL;
-			uint8_t i = 0;
-
+		case OBJ_KW_VN:
 			MAYBE_REALLOC(obj_vn,
 					sizeof(*obj_vn),
 					(int32_t)vnc > (obj_vn_alloc_c - 2),
 					obj_vn_alloc_c,
 					obj_vn_alloc_chunk);
 
-			obj_vn[vnc] = malloc(sizeof(**obj_vn) * 4);
+			obj_vn[vnc] = arena_alloc(mem, sizeof(**obj_vn) * 4);
 
-			while ((myint = strtok_r(NULL, " ", &str_ptr_space))) {
-				obj_vn[vnc][i] = atof(myint);
-				i++;
+			if (scan_doubles(&pos, line_end, obj_vn[vnc], 4) > 3)
+				ABORT("Malformed vertice exceeds 3 dimensions!\n");
 
-				if (i > 3)
-					ABORT("Malformed vertice exceeds 3 dimensions!\n");
-			}
 			vnc++;
 			obj_vn[vnc] = NULL; /* trailing NULL pointer */
+			break;
 
 		/*
 		 * VERTEX TEXTURES
 		 */
-		} else if (!strcmp(str_tmp_ptr, "vt")) {
-			char *myint = NULL;
-			uint8_t i = 0;
-
+		case OBJ_KW_VT:
 			MAYBE_REALLOC(obj_vt,
 					sizeof(*obj_vt),
 					(int32_t)vtc > (obj_vt_alloc_c - 2),
 					obj_vt_alloc_c,
 					obj_vt_alloc_chunk);
 
-			obj_vt[vtc] = malloc(sizeof(**obj_vt) * 4);
+			obj_vt[vtc] = arena_alloc(mem, sizeof(**obj_vt) * 4);
 
-			while ((myint = strtok_r(NULL, " ", &str_ptr_space))) {
-				obj_vt[vtc][i] = atof(myint);
-				i++;
+			if (scan_doubles(&pos, line_end, obj_vt[vtc], 4) > 3)
+				ABORT("Malformed vertice texture exceeds 3 dimensions!\n");
 
-				if (i > 3)
-					ABORT("Malformed vertice texture exceeds 3 dimensions!\n");
-			}
 			vtc++;
 			obj_vt[vtc] = NULL; /* trailing NULL pointer */
+			break;
 
 		/*
 		 * FACES
 		 */
-		} else if (!strcmp(str_tmp_ptr, "f")) {
-			char *myint_v = NULL,
-				 *myint_vt = NULL;
-			uint8_t i = 0;
-			const int32_t obj_f_v_arr_chunk = 5;
-			int32_t obj_f_v_arr_c = 0;
-			const int32_t obj_f_vt_arr_chunk = 5;
-			int32_t obj_f_vt_arr_c = 0;
+		case OBJ_KW_F: {
+			uint32_t v_id,
+					 vt_id;
+			uint32_t i = 0;
+			bool has_vt = false;
 
 			MAYBE_REALLOC(obj_f_v,
 					sizeof(*obj_f_v),
@@ -217,63 +363,58 @@ static bool assemble_obj_arrays(char const * const obj_string,
 					obj_f_v_alloc_c,
 					obj_f_v_alloc_chunk);
 
-			obj_f_v[fc] = NULL;
-
 			MAYBE_REALLOC(obj_f_vt,
 					sizeof(*obj_f_vt),
 					(int32_t)fc > (obj_f_vt_alloc_c - 2),
 					obj_f_vt_alloc_c,
 					obj_f_vt_alloc_chunk);
 
-			obj_f_vt[fc] = NULL;
-
-			while ((myint_v = strtok_r(NULL, " ", &str_ptr_space))) {
-				/* is there a slash? */
-				if ((myint_vt = strtok_r(myint_v, "/", &str_ptr_slash)))
-					myint_v = myint_vt;
-				else
-					free(obj_f_vt); /* seems there is no vt, free the array */
-
-				ec++;
-
-				MAYBE_REALLOC(obj_f_v[fc],
-						sizeof(**obj_f_v),
-						(int32_t)i > obj_f_v_arr_c - 2,
-						obj_f_v_arr_c,
-						obj_f_v_arr_chunk);
-
-				obj_f_v[fc][i] = atoi(myint_v);
+			while (scan_face_index(&pos, line_end, &v_id, &vt_id)) {
+				MAYBE_REALLOC(row_v,
+						sizeof(*row_v),
+						(int32_t)i > row_v_alloc_c - 1,
+						row_v_alloc_c,
+						row_v_alloc_chunk);
+				MAYBE_REALLOC(row_vt,
+						sizeof(*row_vt),
+						(int32_t)i > row_vt_alloc_c - 1,
+						row_vt_alloc_c,
+						row_vt_alloc_chunk);
+
+				row_v[i] = v_id;
+				/* x from "3/x" */
+				row_vt[i] = vt_id;
+				if (vt_id)
+					has_vt = true;
 
 				i++;
+			}
+			ec += i;
 
-				/* so we can iterate over it more easily */
-				obj_f_v[fc][i] = 0;
-
-				/* parse x from "0.3/x" */
-				if ((myint_vt = strtok_r(NULL, "/", &str_ptr_slash))) {
-
-					MAYBE_REALLOC(obj_f_vt[fc],
-							sizeof(**obj_f_vt),
-							(int32_t)i > obj_f_vt_arr_c - 2,
-							obj_f_vt_arr_c,
-							obj_f_vt_arr_chunk);
+			/* rows are terminated by 0, so we can iterate over them */
+			obj_f_v[fc] = arena_alloc(mem, sizeof(**obj_f_v) * (i + 1));
+			memcpy(obj_f_v[fc], row_v, sizeof(*row_v) * i);
+			obj_f_v[fc][i] = 0;
 
-					obj_f_vt[fc][i - 1] = atoi(myint_vt);
-					/* so we can iterate over it more easily */
-					obj_f_vt[fc][i] = 0;
-				}
+			obj_f_vt[fc] = NULL;
+			if (has_vt) {
+				obj_f_vt[fc] = arena_alloc(mem, sizeof(**obj_f_vt) * (i + 1));
+				memcpy(obj_f_vt[fc], row_vt, sizeof(*row_vt) * i);
+				obj_f_vt[fc][i] = 0;
 			}
+
 			fc++;
 			obj_f_v[fc] = NULL; /* trailing NULL pointer */
+			break;
+		}
 
 		/*
 		 * Bezier Curve
 		 */
-		} else if (!strcmp(str_tmp_ptr, "curv")) {
-			char *myint = NULL;
-			uint8_t i = 0;
-			const int32_t bez_arr_alloc_chunk = 5;
-			int32_t bez_arr_alloc_c = 0;
+		case OBJ_KW_CURV: {
+			uint32_t v_id,
+					 vt_id;
+			uint32_t i = 0;
 
 			MAYBE_REALLOC(bez,
 					sizeof(*bez),
@@ -281,24 +422,160 @@ static bool assemble_obj_arrays(char const * const obj_string,
 					bez_alloc_c,
 					bez_alloc_chunk);
 
-			bez[bzc] = NULL;
-			while ((myint = strtok_r(NULL, " ", &str_ptr_space))) {
-
-				MAYBE_REALLOC(bez[bzc],
-						sizeof(**bez),
-						(int32_t)i > bez_arr_alloc_c - 2,
-						bez_arr_alloc_c,
-						bez_arr_alloc_chunk);
+			while (scan_face_index(&pos, line_end, &v_id, &vt_id)) {
+				MAYBE_REALLOC(row_v,
+						sizeof(*row_v),
+						(int32_t)i > row_v_alloc_c - 1,
+						row_v_alloc_c,
+						row_v_alloc_chunk);
 
-				bez[bzc][i] = atoi(myint);
+				row_v[i] = v_id;
 				i++;
+			}
+
+			bez[bzc] = NULL;
+			if (i) {
+				bez[bzc] = arena_alloc(mem, sizeof(**bez) * (i + 1));
+				for (uint32_t j = 0; j < i; j++)
+					bez[bzc][j] = row_v[j];
 				bez[bzc][i] = 0;
 			}
+
 			bzc++;
 			bez[bzc] = NULL; /* trailing NULL pointer */
+			break;
 		}
 
-		str_tmp_ptr = strtok_r(NULL, "\n", &str_ptr_newline);
+		default:
+			break;
+		}
+
+		pos = (line_end < end) ? line_end + 1 : end;
+	}
+
+	free(row_v);
+	free(row_vt);
+
+	chunk->v = obj_v;
+	chunk->vn = obj_vn;
+	chunk->vt = obj_vt;
+	chunk->f_v = obj_f_v;
+	chunk->f_vt = obj_f_vt;
+	chunk->bez = bez;
+	chunk->vc = vc;
+	chunk->vnc = vnc;
+	chunk->vtc = vtc;
+	chunk->fc = fc;
+	chunk->ec = ec;
+	chunk->bzc = bzc;
+
+	return NULL;
+}
+
+/**
+ * Concatenate the raw arrays of all chunks in order. The
+ * element offsets of every chunk are the prefix sums over the
+ * counts of the chunks before it, so the result is exactly
+ * the same as if the whole buffer was parsed as one chunk.
+ * Only the row pointers are moved, the rows themselves are
+ * handed over to raw_obj along with the arenas they live in.
+ *
+ * @param chunks the parsed chunks, their arrays are freed [mod]
+ * @param chunk_c count of chunks
+ * @param raw_obj contains arrays of the items as they are in the .obj
+ * file; all members are set [out]
+ * @param he_obj the half-edge object containing array-pointers
+ * to all the HE_* structures; members ec, fc, vc, vtc and vnc are set [out]
+ */
+static void merge_obj_chunks(obj_chunk *chunks,
+		uint32_t chunk_c,
+		obj_items *raw_obj,
+		HE_obj *he_obj)
+{
+	uint32_t vc = 0, fc = 0, ec = 0, vtc = 0, bzc = 0, vnc = 0;
+	FACES *obj_f = malloc(sizeof(*obj_f));
+
+	CHECK_PTR_VAL(obj_f);
+
+	arena_init(&(raw_obj->mem), ARENA_BLOCK_SIZE);
+	for (uint32_t i = 0; i < chunk_c; i++)
+		arena_merge(&(raw_obj->mem), &(chunks[i].mem));
+
+	/* a single chunk can be handed over as is */
+	if (chunk_c == 1) {
+		vc = chunks[0].vc;
+		vnc = chunks[0].vnc;
+		vtc = chunks[0].vtc;
+		fc = chunks[0].fc;
+		ec = chunks[0].ec;
+		raw_obj->v = chunks[0].v;
+		raw_obj->vn = chunks[0].vn;
+		raw_obj->vt = chunks[0].vt;
+		raw_obj->bez = chunks[0].bez;
+		obj_f->v = chunks[0].f_v;
+		obj_f->vt = chunks[0].f_vt;
+	} else {
+		for (uint32_t i = 0; i < chunk_c; i++) {
+			vc += chunks[i].vc;
+			vnc += chunks[i].vnc;
+			vtc += chunks[i].vtc;
+			fc += chunks[i].fc;
+			ec += chunks[i].ec;
+			bzc += chunks[i].bzc;
+		}
+
+		/* keep the NULL-ness of empty arrays as in the serial case */
+		raw_obj->v = vc ? malloc(sizeof(*raw_obj->v) * (vc + 1)) : NULL;
+		raw_obj->vn = vnc ? malloc(sizeof(*raw_obj->vn) * (vnc + 1)) : NULL;
+		raw_obj->vt = vtc ? malloc(sizeof(*raw_obj->vt) * (vtc + 1)) : NULL;
+		raw_obj->bez = bzc ? malloc(sizeof(*raw_obj->bez) * (bzc + 1)) : NULL;
+		obj_f->v = fc ? malloc(sizeof(*obj_f->v) * (fc + 1)) : NULL;
+		obj_f->vt = fc ? malloc(sizeof(*obj_f->vt) * (fc + 1)) : NULL;
+
+		vc = vnc = vtc = fc = bzc = 0;
+		for (uint32_t i = 0; i < chunk_c; i++) {
+			obj_chunk *c = &(chunks[i]);
+
+			if (c->vc)
+				memcpy(raw_obj->v + vc, c->v, sizeof(*c->v) * c->vc);
+			if (c->vnc)
+				memcpy(raw_obj->vn + vnc, c->vn, sizeof(*c->vn) * c->vnc);
+			if (c->vtc)
+				memcpy(raw_obj->vt + vtc, c->vt, sizeof(*c->vt) * c->vtc);
+			if (c->bzc)
+				memcpy(raw_obj->bez + bzc, c->bez, sizeof(*c->bez) * c->bzc);
+			if (c->fc) {
+				memcpy(obj_f->v + fc, c->f_v, sizeof(*c->f_v) * c->fc);
+				memcpy(obj_f->vt + fc, c->f_vt, sizeof(*c->f_vt) * c->fc);
+			}
+
+			vc += c->vc;
+			vnc += c->vnc;
+			vtc += c->vtc;
+			bzc += c->bzc;
+			fc += c->fc;
+
+			free(c->v);
+			free(c->vn);
+			free(c->vt);
+			free(c->bez);
+			free(c->f_v);
+			free(c->f_vt);
+		}
+
+		/* trailing NULL pointers */
+		if (vc)
+			raw_obj->v[vc] = NULL;
+		if (vnc)
+			raw_obj->vn[vnc] = NULL;
+		if (vtc)
+			raw_obj->vt[vtc] = NULL;
+		if (bzc)
+			raw_obj->bez[bzc] = NULL;
+		if (fc) {
+			obj_f->v[fc] = NULL;
+			obj_f->vt[fc] = NULL;
+		}
 	}
 
 	/* assign the out variables */
@@ -306,18 +583,81 @@ static bool assemble_obj_arrays(char const * const obj_string,
 	he_obj->fc = fc;
 	he_obj->vc = vc;
 	he_obj->vtc = vtc;
-	raw_obj->v = obj_v;
-	obj_f->v = obj_f_v;
-	obj_f->vt = obj_f_vt;
 	raw_obj->f = obj_f;
-	raw_obj->vt = obj_vt;
-	raw_obj->bez = bez;
-	raw_obj->vn = obj_vn;
 	he_obj->vn = NULL; /* will be filled in assemble_HE_stage1() */
 	he_obj->vnc = vnc;
+}
 
-	/* cleanup */
-	free(string);
+/**
+ * Parse the obj buffer for obj related arrays and fill the
+ * raw obj_* structures. The buffer is split at line boundaries
+ * into one chunk per thread, the chunks are parsed in parallel
+ * by parse_obj_chunk() and then merged by merge_obj_chunks().
+ *
+ * @param obj_buf the buffer that is in obj format, it does not
+ * need to be NULL-terminated
+ * @param len the length of obj_buf
+ * @param threads the maximum count of threads to use, small
+ * buffers are parsed with less threads
+ * @param raw_obj contains arrays of the items as they are in the .obj
+ * file; all members are set [out]
+ * @param he_obj the half-edge object containing array-pointers
+ * to all the HE_* structures; members ec, fc, vc, vtc and vnc are set [out]
+ * @return true/false for success/failure
+ */
+static bool assemble_obj_arrays(char const * const obj_buf,
+		size_t len,
+		uint32_t threads,
+		obj_items *raw_obj,
+		HE_obj *he_obj)
+{
+	char const *end = obj_buf + len;
+	obj_chunk *chunks;
+	pthread_t *tids;
+	uint32_t chunk_c = threads;
+
+	if (!obj_buf || !raw_obj || !threads)
+		return false;
+
+	if (len / MIN_CHUNK_SIZE < chunk_c)
+		chunk_c = len / MIN_CHUNK_SIZE;
+	if (chunk_c < 1)
+		chunk_c = 1;
+
+	chunks = calloc(chunk_c, sizeof(*chunks));
+	CHECK_PTR_VAL(chunks);
+	tids = malloc(sizeof(*tids) * chunk_c);
+	CHECK_PTR_VAL(tids);
+
+	/* split at the first line start behind every n-th part */
+	chunks[0].start = obj_buf;
+	for (uint32_t i = 1; i < chunk_c; i++) {
+		char const *split = obj_buf + (len / chunk_c) * i;
+
+		if (split < chunks[i - 1].start)
+			split = chunks[i - 1].start;
+		split = scan_line_end(split, end);
+		if (split < end)
+			split++;
+
+		chunks[i - 1].end = split;
+		chunks[i].start = split;
+	}
+	chunks[chunk_c - 1].end = end;
+
+	/* the first chunk is parsed by the calling thread */
+	for (uint32_t i = 1; i < chunk_c; i++)
+		if (pthread_create(&(tids[i]), NULL, parse_obj_chunk, &(chunks[i])))
+			ABORT("Failed to create parser thread!\n");
+	parse_obj_chunk(&(chunks[0]));
+	for (uint32_t i = 1; i < chunk_c; i++)
+		if (pthread_join(tids[i], NULL))
+			ABORT("Failed to join parser thread!\n");
+
+	merge_obj_chunks(chunks, chunk_c, raw_obj, he_obj);
+
+	free(tids);
+	free(chunks);
 
 	return true;
 }
@@ -334,7 +674,8 @@ static bool assemble_obj_arrays(char const * const obj_string,
  * @param raw_obj contains arrays of the items as they are in the .obj
  * file
  * @param he_obj the half-edge object containing array-pointers
- * to all the HE_* structures; member vertices is set [out]
+ * to all the HE_* structures; the arrays it gets are allocated
+ * from its arena [out]
  */
 static void assemble_HE_stage1(obj_items const * const raw_obj,
 		HE_obj *he_obj)
@@ -346,121 +687,130 @@ static void assemble_HE_stage1(obj_items const * const raw_obj,
 	uint8_t	const zpos = 2;
 	int8_t default_color = -1;
 	HE_vert *vertices = he_obj->vertices;
+	vector *positions = NULL;
+	color *colors = NULL;
 	vector *v_normals = NULL;
 	bez_curv *bez_curves = NULL;
 
-	/* allocator chunks/counts */
-	const int32_t bez_curves_alloc_chunk = 3;
-	int32_t bez_curves_alloc_c = 0;
-	const int32_t v_normals_alloc_chunk = 200;
-	int32_t v_normals_alloc_c = 0;
+	/* one contiguous array per vertex attribute */
+	positions = arena_alloc(he_obj->mem,
+			sizeof(*positions) * (he_obj->vc + 1));
+	colors = arena_alloc(he_obj->mem, sizeof(*colors) * (he_obj->vc + 1));
 
 	while (raw_obj->v[vc]) {
-		vector *tmp_vec;
-
-		tmp_vec = malloc(sizeof(vector));
-		CHECK_PTR_VAL(tmp_vec);
+		positions[vc].x = raw_obj->v[vc][xpos];
+		positions[vc].y = raw_obj->v[vc][ypos];
+		positions[vc].z = raw_obj->v[vc][zpos];
 
-		tmp_vec->x = raw_obj->v[vc][xpos];
-		tmp_vec->y = raw_obj->v[vc][ypos];
-		tmp_vec->z = raw_obj->v[vc][zpos];
-
-		vertices[vc].vec = tmp_vec;
+		vertices[vc].vec = &(positions[vc]);
 
 		/* set unused/unknown values to NULL */
 		vertices[vc].edge = NULL;
 
-		vertices[vc].col = malloc(sizeof(color));
-		vertices[vc].col->red = default_color;
-		vertices[vc].col->green = default_color;
-		vertices[vc].col->blue = default_color;
-
-		/* set acc structure */
-		vertices[vc].acc = malloc(sizeof(HE_vert_acc));
-		vertices[vc].acc->edge_array = NULL;
-		vertices[vc].acc->eac_alloc = 0;
-		vertices[vc].acc->eac = 0;
-		vertices[vc].acc->dc_alloc = 0;
-		vertices[vc].acc->dc = 0;
+		colors[vc].red = default_color;
+		colors[vc].green = default_color;
+		colors[vc].blue = default_color;
+		vertices[vc].col = &(colors[vc]);
 
 		vc++;
 	}
 
+	if (he_obj->vnc)
+		v_normals = arena_alloc(he_obj->mem,
+				sizeof(*v_normals) * he_obj->vnc);
 	for (uint32_t i = 0; i < he_obj->vnc; i++) {
-		MAYBE_REALLOC(v_normals,
-				sizeof(*v_normals),
-				(int32_t)i > v_normals_alloc_c - 2,
-				v_normals_alloc_c,
-				v_normals_alloc_chunk);
-
 		v_normals[i].x = raw_obj->vn[i][xpos];
 		v_normals[i].y = raw_obj->vn[i][ypos];
 		v_normals[i].z = raw_obj->vn[i][zpos];
 	}
 
-	while (raw_obj->bez && raw_obj->bez[bzc]) {
+	while (raw_obj->bez && raw_obj->bez[bzc])
+		bzc++;
+	if (bzc)
+		bez_curves = arena_alloc(he_obj->mem, sizeof(*bez_curves) * bzc);
+
+	for (uint32_t j = 0; j < bzc; j++) {
 		uint32_t i = 0;
-		const int32_t bez_vec_alloc_chunk = 5;
-		int32_t bez_vec_alloc_c = 0;
-		vector *bez_vec = NULL;
-
-		MAYBE_REALLOC(bez_curves,
-				sizeof(*bez_curves),
-				(int32_t)bzc > bez_curves_alloc_c - 2,
-				bez_curves_alloc_c,
-				bez_curves_alloc_chunk);
-
-		while (raw_obj->bez[bzc][i]) {
-			MAYBE_REALLOC(bez_vec,
-					sizeof(vector),
-					(int32_t)i > bez_vec_alloc_c - 1,
-					bez_vec_alloc_c,
-					bez_vec_alloc_chunk);
-
-			bez_vec[i] = *(vertices[raw_obj->bez[bzc][i] - 1].vec);
+		vector *bez_vec;
+
+		while (raw_obj->bez[j][i])
 			i++;
-		}
+		bez_vec = arena_alloc(he_obj->mem, sizeof(*bez_vec) * i);
 
-		bez_curves[bzc].vec = bez_vec;
-		bez_curves[bzc].deg = i - 1; /* i is length */
-		bzc++;
+		for (uint32_t k = 0; k < i; k++)
+			bez_vec[k] = positions[raw_obj->bez[j][k] - 1];
+
+		bez_curves[j].vec = bez_vec;
+		bez_curves[j].deg = i - 1; /* i is length */
 	}
 
 	he_obj->bez_curves = bez_curves;
 	he_obj->bzc = bzc;
 	he_obj->vertices = vertices;
+	he_obj->positions = positions;
+	he_obj->colors = colors;
 	he_obj->vn = v_normals;
 }
 
 /**
- * Second stage of assembling the half-edge data structure.
- * Here we start creating the HE_edges and HE_faces and also
- * fill some missing information to the HE_verts along with it.
- * The edge pairs are still unknown, as well as some other
- * acceleration-structure related members like vertice->dummys.
- * This function isn't really modular, but makes
- * reading parse_obj() a bit less painful.
+ * Size of the arena which owns all arrays of the assembled
+ * object, so that a single block serves all of them.
+ * The assembly itself needs hardly any memory on top, since
+ * the space reserved for dummy edges serves as scratch space.
  *
  * @param raw_obj contains arrays of the items as they are in the .obj
  * file
- * @param he_obj the half-edge object containing array-pointers
- * to all the HE_* structures; member vertices, edges
- * and faces are modified [out]
+ * @param he_obj the half-edge object, with the counts set
+ * @return the size
  */
-static void assemble_HE_stage2(obj_items const * const raw_obj,
-		HE_obj *he_obj)
+size_t obj_items_arena_size(obj_items const * const raw_obj,
+		HE_obj const * const he_obj)
+{
+	size_t size = ARENA_SIZE(sizeof(HE_vert) * (he_obj->vc + 1)) +
+		ARENA_SIZE(sizeof(HE_face) * he_obj->fc) +
+		ARENA_SIZE(sizeof(HE_edge) * he_obj->ec * 2) +
+		ARENA_SIZE(sizeof(vector) * (he_obj->vc + 1)) +
+		ARENA_SIZE(sizeof(color) * (he_obj->vc + 1)) +
+		ARENA_SIZE(sizeof(vector) * he_obj->vnc);
+	uint32_t bzc = 0;
+
+	while (raw_obj->bez && raw_obj->bez[bzc]) {
+		uint32_t i = 0;
+
+		while (raw_obj->bez[bzc][i])
+			i++;
+		size += ARENA_SIZE(sizeof(vector) * i);
+		bzc++;
+	}
+
+	return size + ARENA_SIZE(sizeof(bez_curv) * bzc);
+}
+
+/**
+ * Create the HE_edges of a range of faces and connect them
+ * around every face, as well as the HE_faces themselves.
+ * The edge pairs are still unknown.
+ *
+ * @param raw_obj contains arrays of the items as they are in the .obj
+ * file
+ * @param he_obj the half-edge object; members edges and
+ * faces are modified [mod]
+ * @param face_start the first face
+ * @param face_end the end of the face range (exclusive)
+ * @param ec index of the first edge of face_start
+ */
+static void assemble_faces(obj_items const * const raw_obj,
+		HE_obj *he_obj,
+		uint32_t face_start,
+		uint32_t face_end,
+		uint32_t ec)
 {
 	HE_vert *vertices = he_obj->vertices;
 	HE_edge *edges = he_obj->edges;
 	HE_face *faces = he_obj->faces;
 	FACES *obj_f = raw_obj->f;
 
-	uint32_t ec = 0,
-			 fc = he_obj->fc;
-	const int32_t edge_array_alloc_chunk = 5;
-
-	/* create HE_edges and real HE_faces */
-	for (uint32_t i = 0; i < fc; i++) { /* for all faces */
+	for (uint32_t i = face_start; i < face_end; i++) { /* for all faces */
 		uint32_t j = 0;
 
 		/* for all vertices of the face */
@@ -471,50 +821,14 @@ static void assemble_HE_stage2(obj_items const * const raw_obj,
 			edges[ec].vert = &(vertices[fv_arr_id]);
 			edges[ec].face = &(faces[i]);
 			edges[ec].pair = NULL; /* preliminary */
-			vertices[fv_arr_id].edge = &(edges[ec]); /* last one wins */
-			vertices[fv_arr_id].acc->dummys = NULL; /* preliminary */
-
-			/* Skip j == 0 here, so we don't underrun the arrays,
-			 * since we always look one edge back. The first edge
-			 * element is taken care of below as well. */
-			if (j > 0) {
-				uint32_t *eac = &(edges[ec].vert->acc->eac);
-				int32_t *edge_array_alloc_c = &(edges[ec].vert->acc->eac_alloc);
 
-				/* connect previous edge to current edge */
+			/* connect previous edge to current edge */
+			if (j > 0)
 				edges[ec - 1].next = &(edges[ec]);
 
-				/* Acceleration struct:
-				 * add previous edge to edge_array of current vertice */
-				MAYBE_REALLOC(edges[ec].vert->acc->edge_array,
-						sizeof(HE_edge*),
-						(int32_t)(*eac) > (*edge_array_alloc_c) - 1,
-						(*edge_array_alloc_c),
-						(*eac) + edge_array_alloc_chunk);
-
-				edges[ec].vert->acc->edge_array[*eac] = &(edges[ec - 1]);
-				(*eac)++;
-
-				if (!obj_f->v[i][j + 1]) { /* no vertice left */
-					uint32_t *eac;
-					int32_t *edge_array_alloc_c;
-
-					/* connect last edge to first edge */
-					edges[ec].next = &(edges[ec - j]);
-					eac = &(edges[ec].next->vert->acc->eac);
-					edge_array_alloc_c = &(edges[ec].next->vert->acc->eac_alloc);
-
-					/* Acceleration struct:
-					 * add last edge to edge_array element of first vertice */
-					MAYBE_REALLOC(edges[ec].next->vert->acc->edge_array,
-							sizeof(HE_edge*),
-							(int32_t)(*eac) > (*edge_array_alloc_c) - 1,
-							(*edge_array_alloc_c),
-							(*eac) + edge_array_alloc_chunk);
-					edges[ec].next->vert->acc->edge_array[*eac] = &(edges[ec]);
-					(*eac)++;
-				}
-			}
+			/* connect last edge to first edge */
+			if (!obj_f->v[i][j + 1])
+				edges[ec].next = &(edges[ec - j]);
 
 			ec++;
 			j++;
@@ -522,10 +836,174 @@ static void assemble_HE_stage2(obj_items const * const raw_obj,
 
 		faces[i].edge = &(edges[ec - 1]); /* "last" edge */
 	}
+}
 
-	he_obj->vertices = vertices;
-	he_obj->edges = edges;
-	he_obj->faces = faces;
+/**
+ * Attach an emanating edge to every vertex. If there
+ * are multiple ones, the last one wins.
+ *
+ * @param he_obj the half-edge object; member vertices is
+ * modified [mod]
+ */
+static void assemble_vertex_edges(HE_obj *he_obj)
+{
+	HE_edge *edges = he_obj->edges;
+
+	for (uint32_t i = 0; i < he_obj->ec; i++)
+		edges[i].vert->edge = &(edges[i]);
+}
+
+/**
+ * Second stage of assembling the half-edge data structure.
+ * Here we start creating the HE_edges and HE_faces and also
+ * fill some missing information to the HE_verts along with it.
+ * The edge pairs are still unknown.
+ * This function isn't really modular, but makes
+ * reading parse_obj() a bit less painful.
+ *
+ * @param raw_obj contains arrays of the items as they are in the .obj
+ * file
+ * @param he_obj the half-edge object containing array-pointers
+ * to all the HE_* structures; member vertices, edges
+ * and faces are modified [out]
+ */
+static void assemble_HE_stage2(obj_items const * const raw_obj,
+		HE_obj *he_obj)
+{
+	assemble_faces(raw_obj, he_obj, 0, he_obj->fc, 0);
+	assemble_vertex_edges(he_obj);
+}
+
+/**
+ * Create dummy pair edges for all border edges in a range
+ * of edges, which are the ones without a pair.
+ *
+ * @param he_obj the half-edge object; member edges is
+ * modified [mod]
+ * @param start the first edge
+ * @param end the end of the edge range (exclusive)
+ * @param dec count of dummy edges created before this range
+ * @return dec plus the count of dummy edges created
+ */
+static uint32_t create_dummy_edges(HE_obj *he_obj,
+		uint32_t start,
+		uint32_t end,
+		uint32_t dec)
+{
+	HE_edge *edges = he_obj->edges;
+	uint32_t const ec = he_obj->ec;
+
+	for (uint32_t i = start; i < end; i++) {
+		if (edges[i].pair)
+			continue;
+
+		/* NULL-face indicates border-edge */
+		edges[ec + dec].face = NULL;
+		/* we don't know this one yet */
+		edges[ec + dec].next = NULL;
+		/* set both pairs */
+		edges[ec + dec].pair = &(edges[i]);
+		edges[i].pair = &(edges[ec + dec]);
+		/* set vertex */
+		edges[ec + dec].vert = edges[i].next->vert;
+
+		dec++;
+	}
+
+	return dec;
+}
+
+/**
+ * Connect the dummy edges together. The next edge of a dummy
+ * edge is the last dummy edge starting at the vertex it
+ * points to, if any.
+ *
+ * @param he_obj the half-edge object with dec set; member
+ * edges is modified [mod]
+ */
+static void link_dummy_edges(HE_obj *he_obj)
+{
+	HE_edge *edges = he_obj->edges;
+	HE_vert *vertices = he_obj->vertices;
+	uint32_t const ec = he_obj->ec;
+	HE_edge **last_dummy;
+
+	if (!he_obj->dec)
+		return;
+
+	last_dummy = malloc(sizeof(*last_dummy) * (he_obj->vc + 1));
+	CHECK_PTR_VAL(last_dummy);
+	for (uint32_t i = 0; i < he_obj->vc; i++)
+		last_dummy[i] = NULL;
+
+	/* remember the last dummy edge starting at every vertex */
+	for (uint32_t i = 0; i < he_obj->dec; i++)
+		last_dummy[edges[ec + i].vert - vertices] = &(edges[ec + i]);
+
+	for (uint32_t i = 0; i < he_obj->dec; i++) /* for all dummy edges */
+		edges[ec + i].next =
+			last_dummy[edges[ec + i].pair->vert - vertices];
+
+	free(last_dummy);
+}
+
+/**
+ * Pair the edges of a bucket, which holds all edges between one
+ * vertex and any vertex with a bigger index. Every entry is
+ * a key as made by PAIR_KEY(), so once the bucket is sorted, the
+ * edges between the same two vertices are grouped by direction
+ * and each direction is in the order of the edges. The k-th edge
+ * running one way is then paired with the k-th edge running
+ * the other way.
+ *
+ * @param edges the edges array [mod]
+ * @param bucket the keys of all edges of the bucket [mod]
+ * @param n size of the bucket
+ */
+static void pair_bucket(HE_edge *edges,
+		uint64_t *bucket,
+		uint32_t n)
+{
+	if (n <= INSERTION_SORT_MAX) {
+		for (uint32_t j = 1; j < n; j++) {
+			uint64_t key = bucket[j];
+			uint32_t k = j;
+
+			while (k > 0 && bucket[k - 1] > key) {
+				bucket[k] = bucket[k - 1];
+				k--;
+			}
+			bucket[k] = key;
+		}
+	} else {
+		qsort(bucket, n, sizeof(*bucket), cmp_uint64);
+	}
+
+	for (uint32_t g = 0; g < n; ) {
+		uint64_t const other = bucket[g] >> 33;
+		uint32_t from_end = g,
+				 g_end;
+
+		/* edges running away from the bucket vertex come first */
+		while (from_end < n && !((bucket[from_end] >> 32) & 1) &&
+				(bucket[from_end] >> 33) == other)
+			from_end++;
+		g_end = from_end;
+		while (g_end < n && (bucket[g_end] >> 33) == other)
+			g_end++;
+
+		for (uint32_t from_u = g, to_u = from_end;
+				from_u < from_end && to_u < g_end;
+				from_u++, to_u++) {
+			uint32_t const i = (uint32_t)bucket[from_u],
+					 j = (uint32_t)bucket[to_u];
+
+			edges[i].pair = &(edges[j]);
+			edges[j].pair = &(edges[i]);
+		}
+
+		g = g_end;
+	}
 }
 
 /**
@@ -534,75 +1012,475 @@ static void assemble_HE_stage2(obj_items const * const raw_obj,
  * possibility of border-edges, where we have to set up
  * dummy edges and connect them properly.
  *
+ * The edges are bucketed by the smaller index of their two
+ * vertices with a counting sort and then paired bucket by bucket,
+ * see pair_bucket(). So the k-th edge from v to w always pairs
+ * with the k-th edge from w to v, and edges from a vertex to itself
+ * are their own pair. Whatever is left is a border edge and gets
+ * a dummy pair. All of this is linear in the count of edges and
+ * vertices, no matter how high the valence of the vertices is.
+ *
  * @param he_obj the half-edge object containing array-pointers;
  * member dec is set and edges is modified [out]
  */
 static void assemble_HE_stage3(HE_obj *he_obj)
 {
 	HE_edge *edges = he_obj->edges;
-	uint32_t ec = he_obj->ec;
-	uint32_t dec = 0;
-	const int32_t edge_array_alloc_chunk = 5;
-
-	/* find pairs */
-	for (uint32_t i = 0; i < ec; i++) { /* for all edges */
-		uint32_t eac = edges[i].vert->acc->eac;
-		bool pair_found = false;
-
-		for (uint32_t j = 0; j < eac; j++) { /* for all potential pairs */
-			if (edges[i].vert->acc->edge_array[j] &&
-					(edges[i].next->vert ==
-					 edges[i].vert->acc->edge_array[j]->vert)) {
-				edges[i].pair = edges[i].vert->acc->edge_array[j];
-				edges[i].vert->acc->edge_array[j] = NULL;
-
-				pair_found = true;
-				break;
-			}
+	HE_vert *vertices = he_obj->vertices;
+	uint32_t ec = he_obj->ec,
+			 vc = he_obj->vc;
+	uint32_t *bucket_end;
+	uint64_t *bucket;
+
+	if (ec == 0) {
+		he_obj->dec = 0;
+		return;
+	}
+
+	/*
+	 * The space for the dummy edges is not used until the pairs
+	 * are known, which is enough for the buckets and in most
+	 * cases also for their bounds.
+	 */
+	bucket = (uint64_t*)(edges + ec);
+	if (sizeof(*bucket) * ec + sizeof(*bucket_end) * (vc + 1) <=
+			sizeof(*edges) * ec) {
+		bucket_end = (uint32_t*)(bucket + ec);
+		memset(bucket_end, 0, sizeof(*bucket_end) * (vc + 1));
+	} else {
+		bucket_end = calloc(vc + 1, sizeof(*bucket_end));
+		CHECK_PTR_VAL(bucket_end);
+	}
+
+	/* bucket the edges by their smaller vertex */
+	for (uint32_t i = 0; i < ec; i++) {
+		uint32_t from = edges[i].vert - vertices,
+				 to = edges[i].next->vert - vertices;
+
+		if (from == to) /* pairs with itself */
+			edges[i].pair = &(edges[i]);
+		else
+			bucket_end[(from < to ? from : to) + 1]++;
+	}
+	for (uint32_t i = 0; i < vc; i++)
+		bucket_end[i + 1] += bucket_end[i];
+	for (uint32_t i = 0; i < ec; i++) {
+		uint32_t from = edges[i].vert - vertices,
+				 to = edges[i].next->vert - vertices;
+
+		if (from < to)
+			bucket[bucket_end[from]++] = PAIR_KEY(to, 0, i);
+		else if (from > to)
+			bucket[bucket_end[to]++] = PAIR_KEY(from, 1, i);
+	}
+
+	/* bucket_end[u] is now where bucket u + 1 starts */
+	for (uint32_t u = 0; u < vc; u++) {
+		uint32_t const start = u ? bucket_end[u - 1] : 0;
+
+		pair_bucket(edges, bucket + start, bucket_end[u] - start);
+	}
+
+	if (bucket_end != (uint32_t*)(bucket + ec))
+		free(bucket_end);
+
+	/* create dummy pair edges for all border edges */
+	he_obj->dec = create_dummy_edges(he_obj, 0, ec, 0);
+	link_dummy_edges(he_obj);
+}
+
+/**
+ * Run a function on all parts, each in its own thread.
+ * The first part runs in the calling thread.
+ *
+ * @param fn the function
+ * @param parts the parts
+ * @param part_c count of parts
+ */
+static void run_assembly_parts(void *(*fn)(void*),
+		assembly_part *parts,
+		uint32_t part_c)
+{
+	pthread_t *tids = malloc(sizeof(*tids) * part_c);
+
+	CHECK_PTR_VAL(tids);
+
+	for (uint32_t i = 1; i < part_c; i++)
+		if (pthread_create(&(tids[i]), NULL, fn, &(parts[i])))
+			ABORT("Failed to create assembler thread!\n");
+	fn(&(parts[0]));
+	for (uint32_t i = 1; i < part_c; i++)
+		if (pthread_join(tids[i], NULL))
+			ABORT("Failed to join assembler thread!\n");
+
+	free(tids);
+}
+
+/**
+ * Count the edges of the faces of a part.
+ *
+ * @param arg the assembly_part, with the face range set;
+ * member count is set [mod]
+ * @return NULL
+ */
+static void *count_part_edges(void *arg)
+{
+	assembly_part *part = arg;
+	uint32_t **f_v = part->raw_obj->f->v;
+	uint32_t ec = 0;
+
+	for (uint32_t i = part->face_start; i < part->face_end; i++)
+		for (uint32_t j = 0; f_v[i][j]; j++)
+			ec++;
+
+	part->count = ec;
+
+	return NULL;
+}
+
+/**
+ * Create the edges and faces of a part.
+ *
+ * @param arg the assembly_part, with the face range and
+ * edge_start set [mod]
+ * @return NULL
+ */
+static void *assemble_part_faces(void *arg)
+{
+	assembly_part *part = arg;
+
+	assemble_faces(part->raw_obj, part->he_obj, part->face_start,
+			part->face_end, part->edge_start);
+
+	return NULL;
+}
+
+/**
+ * Compute the sort keys of the edges of a part, which
+ * are the smaller vertex index in the upper and the edge index
+ * in the lower 32 bit. Edges from a vertex to itself are their
+ * own pair and get the vertex count as key, which sorts them
+ * behind all others.
+ *
+ * @param arg the assembly_part, with the edge range set [mod]
+ * @return NULL
+ */
+static void *key_part_edges(void *arg)
+{
+	assembly_part *part = arg;
+	HE_edge *edges = part->he_obj->edges;
+	HE_vert *vertices = part->he_obj->vertices;
+
+	for (uint32_t i = part->edge_start; i < part->edge_end; i++) {
+		uint64_t v = edges[i].vert - vertices,
+				 w = edges[i].next->vert - vertices;
+
+		if (v == w) {
+			edges[i].pair = &(edges[i]);
+			part->keys[i] = ((uint64_t)part->he_obj->vc << 32) | i;
+		} else {
+			part->keys[i] = ((v < w ? v : w) << 32) | i;
 		}
+	}
 
-		/* create dummy pair edge if we have a border edge */
-		if (!pair_found) {
-			uint32_t *vert_dc = &(edges[i].next->vert->acc->dc);
-			int32_t *dumme_array_alloc_c = &(edges[i].next->vert->acc->dc_alloc);
-
-			MAYBE_REALLOC(edges[i].next->vert->acc->dummys,
-					sizeof(HE_edge*),
-					(int32_t)(*vert_dc) > (*dumme_array_alloc_c) - 1,
-					(*dumme_array_alloc_c),
-					(*vert_dc) + edge_array_alloc_chunk);
-
-			/* NULL-face indicates border-edge */
-			edges[ec + dec].face = NULL;
-			/* we don't know this one yet */
-			edges[ec + dec].next = NULL;
-			/* set both pairs */
-			edges[ec + dec].pair = &(edges[i]);
-			edges[i].pair = &(edges[ec + dec]);
-			/* set vertex */
-			edges[ec + dec].vert = edges[i].next->vert;
-			/* add the dummy edge to the dummys array of the vertex */
-			edges[ec + dec].vert->acc->dummys[*vert_dc] = &(edges[ec + dec]);
-			(*vert_dc)++;
+	return NULL;
+}
 
-			dec++;
+/**
+ * Count the radix digits of the keys of a part for one
+ * pass of the radix sort.
+ *
+ * @param arg the assembly_part, with the edge range and shift
+ * set; member hist is filled [mod]
+ * @return NULL
+ */
+static void *radix_part_count(void *arg)
+{
+	assembly_part *part = arg;
+
+	memset(part->hist, 0, sizeof(*part->hist) * RADIX_SIZE);
+	for (uint32_t i = part->edge_start; i < part->edge_end; i++)
+		part->hist[(part->keys[i] >> part->shift) & (RADIX_SIZE - 1)]++;
+
+	return NULL;
+}
+
+/**
+ * Move the keys of a part to their place in the sorted order
+ * for one pass of the radix sort. This keeps the order of equal
+ * digits.
+ *
+ * @param arg the assembly_part, with member hist holding the
+ * first target index for every digit [mod]
+ * @return NULL
+ */
+static void *radix_part_scatter(void *arg)
+{
+	assembly_part *part = arg;
+
+	for (uint32_t i = part->edge_start; i < part->edge_end; i++) {
+		uint64_t key = part->keys[i];
+
+		part->tmp[part->hist[(key >> part->shift) & (RADIX_SIZE - 1)]++] = key;
+	}
+
+	return NULL;
+}
+
+/**
+ * Compare two uint64_t for qsort().
+ *
+ * @param a the first number
+ * @param b the second number
+ * @return -1, 0 or 1 if a is lower, equal or greater than b
+ */
+static int cmp_uint64(void const *a, void const *b)
+{
+	uint64_t const x = *(uint64_t const*)a,
+		  y = *(uint64_t const*)b;
+
+	return (x > y) - (x < y);
+}
+
+/**
+ * Pair all edges of the buckets of a part. The keys are sorted
+ * by the smaller vertex of the edges, so every bucket holds all
+ * edges between its vertex and any bigger one, in the order of
+ * the edges. Every bucket is keyed in the scratch space and
+ * paired by pair_bucket(), like the serial assemble_HE_stage3()
+ * does.
+ *
+ * @param arg the assembly_part, with the range of sorted keys
+ * in edge_start/edge_end, always starting at a bucket [mod]
+ * @return NULL
+ */
+static void *pair_part_edges(void *arg)
+{
+	assembly_part *part = arg;
+	HE_edge *edges = part->he_obj->edges;
+	HE_vert *vertices = part->he_obj->vertices;
+	uint64_t const *keys = part->keys;
+	uint64_t *bucket = part->tmp;
+	uint32_t start = part->edge_start;
+
+	while (start < part->edge_end) {
+		uint32_t const u = keys[start] >> 32;
+		uint32_t end = start;
+
+		/* self-loops are already paired */
+		if (u == part->he_obj->vc)
+			break;
+
+		while (end < part->edge_end && (keys[end] >> 32) == u) {
+			uint32_t i = (uint32_t)keys[end];
+			uint32_t from = edges[i].vert - vertices,
+					 to = edges[i].next->vert - vertices;
+
+			bucket[end] = (from == u) ? PAIR_KEY(to, 0, i) :
+				PAIR_KEY(from, 1, i);
+			end++;
 		}
+
+		pair_bucket(edges, bucket + start, end - start);
+
+		start = end;
 	}
 
-	/* now we have to connect the dummy edges together */
-	for (uint32_t i = 0; i < dec; i++) { /* for all dummy edges */
-		/* vertex the dummy edge points to */
-		HE_vert *vert = edges[ec + i].pair->vert;
+	return NULL;
+}
+
+/**
+ * Count the border edges of a part.
+ *
+ * @param arg the assembly_part, with the edge range set;
+ * member count is set [mod]
+ * @return NULL
+ */
+static void *count_part_borders(void *arg)
+{
+	assembly_part *part = arg;
+	HE_edge const *edges = part->he_obj->edges;
+	uint32_t dec = 0;
 
-		/* iterate over the dummy array */
-		for (uint32_t j = 0; j < vert->acc->dc; j++) {
-			if (vert == vert->acc->dummys[j]->vert)
-				edges[ec + i].next = vert->acc->dummys[j];
+	for (uint32_t i = part->edge_start; i < part->edge_end; i++)
+		if (!edges[i].pair)
+			dec++;
+
+	part->count = dec;
+
+	return NULL;
+}
+
+/**
+ * Create the dummy edges of a part.
+ *
+ * @param arg the assembly_part, with the edge range set and
+ * member count holding the count of dummy edges of all previous
+ * parts [mod]
+ * @return NULL
+ */
+static void *dummy_part_edges(void *arg)
+{
+	assembly_part *part = arg;
+
+	create_dummy_edges(part->he_obj, part->edge_start, part->edge_end,
+			part->count);
+
+	return NULL;
+}
+
+/**
+ * Run the second and third stage of assembling the half-edge
+ * data structure with multiple threads. The result is exactly the
+ * same as with assemble_HE_stage2() and assemble_HE_stage3().
+ *
+ * The edge offsets of the faces are computed with a prefix
+ * sum over the face sizes of every part, then all parts create
+ * their edges and faces concurrently. The edges are sorted by
+ * their smaller vertex with a parallel radix sort, which keeps
+ * their order, so the buckets of one vertex can be paired
+ * independently of all others. Border edges get their dummy edges
+ * at offsets computed by another prefix sum.
+ *
+ * @param raw_obj contains arrays of the items as they are in the .obj
+ * file
+ * @param he_obj the half-edge object containing array-pointers
+ * to all the HE_* structures; member dec is set and vertices,
+ * edges and faces are modified [out]
+ * @param threads count of threads to use
+ * @param stats the stats of stage 2 and 3, NULL for none [mod]
+ */
+static void assemble_HE_parallel(obj_items const * const raw_obj,
+		HE_obj *he_obj,
+		uint32_t threads,
+		load_stats *stats)
+{
+	uint32_t const ec = he_obj->ec,
+		  fc = he_obj->fc;
+	uint32_t part_c = threads,
+			 offset = 0;
+	assembly_part *parts;
+	uint64_t *keys,
+			 *tmp,
+			 *swap;
+	load_sample sample;
+
+	if (fc < part_c)
+		part_c = fc;
+	if (ec == 0 || part_c < 2) {
+		LOAD_SAMPLE(stats, &sample);
+		assemble_HE_stage2(raw_obj, he_obj);
+		LOAD_STAGE_DONE(stats, LOAD_STAGE_STAGE2, &sample, ec);
+		LOAD_SAMPLE(stats, &sample);
+		assemble_HE_stage3(he_obj);
+		LOAD_STAGE_DONE(stats, LOAD_STAGE_STAGE3, &sample, he_obj->dec);
+		return;
+	}
+
+	LOAD_SAMPLE(stats, &sample);
+
+	parts = calloc(part_c, sizeof(*parts));
+	CHECK_PTR_VAL(parts);
+	/* the space for the dummy edges is unused until the pairs are known */
+	keys = (uint64_t*)(he_obj->edges + ec);
+	tmp = keys + ec;
+
+	for (uint32_t i = 0; i < part_c; i++) {
+		parts[i].raw_obj = raw_obj;
+		parts[i].he_obj = he_obj;
+		parts[i].face_start = (uint64_t)fc * i / part_c;
+		parts[i].face_end = (uint64_t)fc * (i + 1) / part_c;
+		parts[i].keys = keys;
+		parts[i].tmp = tmp;
+	}
+
+	/*
+	 * stage 2: edges and faces
+	 */
+	run_assembly_parts(count_part_edges, parts, part_c);
+	for (uint32_t i = 0; i < part_c; i++) {
+		parts[i].edge_start = offset;
+		offset += parts[i].count;
+	}
+	run_assembly_parts(assemble_part_faces, parts, part_c);
+	assemble_vertex_edges(he_obj);
+	LOAD_STAGE_DONE(stats, LOAD_STAGE_STAGE2, &sample, ec);
+	LOAD_SAMPLE(stats, &sample);
+
+	/*
+	 * stage 3: sort the edges by their smaller vertex
+	 */
+	for (uint32_t i = 0; i < part_c; i++) {
+		parts[i].edge_start = (uint64_t)ec * i / part_c;
+		parts[i].edge_end = (uint64_t)ec * (i + 1) / part_c;
+	}
+	run_assembly_parts(key_part_edges, parts, part_c);
+
+	/* only the upper 32 bit are sorted, up to the vertex count */
+	for (uint32_t shift = 32;
+			shift < 64 && (he_obj->vc >> (shift - 32));
+			shift += RADIX_BITS) {
+		uint32_t pos = 0;
+
+		for (uint32_t i = 0; i < part_c; i++) {
+			parts[i].shift = shift;
+			parts[i].keys = keys;
+			parts[i].tmp = tmp;
 		}
+		run_assembly_parts(radix_part_count, parts, part_c);
+
+		/* first target index of every digit of every part */
+		for (uint32_t d = 0; d < RADIX_SIZE; d++) {
+			for (uint32_t i = 0; i < part_c; i++) {
+				uint32_t c = parts[i].hist[d];
+
+				parts[i].hist[d] = pos;
+				pos += c;
+			}
+		}
+		run_assembly_parts(radix_part_scatter, parts, part_c);
+
+		swap = keys;
+		keys = tmp;
+		tmp = swap;
+	}
+
+	/* pair, with every part starting at a bucket */
+	for (uint32_t i = 0; i < part_c; i++) {
+		uint32_t start = (uint64_t)ec * i / part_c;
+
+		while (start > 0 && start < ec &&
+				(keys[start] >> 32) == (keys[start - 1] >> 32))
+			start++;
+
+		parts[i].edge_start = start;
+		parts[i].keys = keys;
+		parts[i].tmp = tmp;
+		if (i > 0)
+			parts[i - 1].edge_end = start;
+	}
+	parts[part_c - 1].edge_end = ec;
+	run_assembly_parts(pair_part_edges, parts, part_c);
+
+	/* dummy edges in the order of their pairs */
+	for (uint32_t i = 0; i < part_c; i++) {
+		parts[i].edge_start = (uint64_t)ec * i / part_c;
+		parts[i].edge_end = (uint64_t)ec * (i + 1) / part_c;
+	}
+	run_assembly_parts(count_part_borders, parts, part_c);
+	offset = 0;
+	for (uint32_t i = 0; i < part_c; i++) {
+		uint32_t c = parts[i].count;
+
+		parts[i].count = offset;
+		offset += c;
 	}
+	run_assembly_parts(dummy_part_edges, parts, part_c);
+	he_obj->dec = offset;
+	link_dummy_edges(he_obj);
 
-	he_obj->edges = edges;
-	he_obj->dec = dec;
+	free(parts);
+	LOAD_STAGE_DONE(stats, LOAD_STAGE_STAGE3, &sample, he_obj->dec);
 }
 
 /**
@@ -615,17 +1493,78 @@ static void assemble_HE_stage3(HE_obj *he_obj)
  */
 HE_obj *parse_obj(char const * const obj_string)
 {
-	char *string = NULL,
-		 *str_ptr;
+	if (!obj_string)
+		return NULL;
+
+	return parse_obj_buf(obj_string, strlen(obj_string));
+}
+
+/**
+ * Parse an .obj buffer and return a HE_obj
+ * that represents the whole object. The buffer is
+ * neither copied nor modified and does not need to be
+ * NULL-terminated, so it may be a read-only file mapping.
+ *
+ * @param obj_buf the whole content of the .obj file
+ * @param len the length of obj_buf
+ * @return the HE_face array that represents the object, NULL
+ * on failure
+ */
+HE_obj *parse_obj_buf(char const * const obj_buf, size_t len)
+{
+	return parse_obj_parallel(obj_buf, len, 1);
+}
+
+/**
+ * Parse an .obj buffer with multiple threads and return a HE_obj
+ * that represents the whole object. Both the parsing and
+ * the assembly of the half-edge structures run in parallel.
+ * The result is exactly the same as the one of parse_obj_buf().
+ *
+ * @param obj_buf the whole content of the .obj file
+ * @param len the length of obj_buf
+ * @param threads the maximum count of threads, 0 to use
+ * one per online CPU
+ * @return the HE_face array that represents the object, NULL
+ * on failure
+ */
+HE_obj *parse_obj_parallel(char const * const obj_buf,
+		size_t len,
+		unsigned threads)
+{
+	return parse_obj_stats(obj_buf, len, threads, NULL);
+}
+
+/**
+ * Parse an .obj buffer like parse_obj_parallel() and add
+ * what every stage took to the stats. They are only recorded
+ * when built with -DLOAD_STATS, otherwise they stay untouched.
+ *
+ * @param obj_buf the whole content of the .obj file
+ * @param len the length of obj_buf
+ * @param threads the maximum count of threads, 0 to use
+ * one per online CPU
+ * @param stats the stats, NULL for none [mod]
+ * @return the HE_face array that represents the object, NULL
+ * on failure
+ */
+HE_obj *parse_obj_stats(char const * const obj_buf,
+		size_t len,
+		unsigned threads,
+		load_stats *stats)
+{
 	HE_obj *he_obj = NULL;
 	obj_items raw_obj;
+	load_sample sample;
 
-	if (!obj_string || !*obj_string)
+	if (!obj_buf || !len)
 		return NULL;
 
-	string = malloc(sizeof(char) * strlen(obj_string) + 1);
-	strcpy(string, obj_string);
-	str_ptr = string;
+	if (!threads) {
+		long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+		threads = cpus > 0 ? (unsigned)cpus : 1;
+	}
 
 	/*
 	 * allocation for he_obj
@@ -636,49 +1575,92 @@ HE_obj *parse_obj(char const * const obj_string)
 	/*
 	 * assemble pseudo-object, also sets vc, fc, ec
 	 */
-	if (!assemble_obj_arrays(string, &raw_obj, he_obj))
+	LOAD_SAMPLE(stats, &sample);
+	if (!assemble_obj_arrays(obj_buf, len, threads, &raw_obj, he_obj))
 		return NULL;
+	LOAD_STAGE_DONE(stats, LOAD_STAGE_PARSE, &sample, (uint64_t)he_obj->vc +
+			he_obj->vnc + he_obj->vtc + he_obj->fc);
 
 	/*
-	 * he_obj member allocation
+	 * he_obj member allocation, all from one arena
 	 */
-	he_obj->vertices = malloc(sizeof(HE_vert) *
-			(he_obj->vc + 1));
-	CHECK_PTR_VAL(he_obj->vertices);
-	he_obj->faces = (HE_face*) malloc(sizeof(HE_face) * he_obj->fc);
-	CHECK_PTR_VAL(he_obj->faces);
-	/* hold enough space for possible dummy edges */
-	he_obj->edges = (HE_edge*) malloc(sizeof(HE_edge) * he_obj->ec * 2);
-	CHECK_PTR_VAL(he_obj->edges);
+	he_obj->mem = malloc(sizeof(*he_obj->mem));
+	CHECK_PTR_VAL(he_obj->mem);
+	arena_init(he_obj->mem, obj_items_arena_size(&raw_obj, he_obj));
 
-	/*
-	 * run the stages of assemblance
-	 */
-	assemble_HE_stage1(&raw_obj, he_obj);
-	assemble_HE_stage2(&raw_obj, he_obj);
-	assemble_HE_stage3(he_obj);
+	assemble_HE(&raw_obj, he_obj, threads, stats);
 
 	/* cleanup */
-	delete_raw_object(&raw_obj, he_obj->fc,
-			he_obj->vc, he_obj->vtc, he_obj->bzc, he_obj->vnc);
-	delete_accel_struct(he_obj);
-	free(string);
+	LOAD_SAMPLE(stats, &sample);
+	delete_raw_object(&raw_obj);
+	LOAD_STAGE_DONE(stats, LOAD_STAGE_CLEANUP, &sample, he_obj->fc);
 
 	return he_obj;
 }
 
 /**
- * Delete the acceleration structure of
- * HE_vert.
+ * Assemble the half-edge structures of an object from the
+ * raw items of its obj file. This allows building objects
+ * from raw items which don't come from parse_obj_chunk(),
+ * e.g. from the streaming parser.
+ *
+ * @param raw_obj contains arrays of the items as they are in the .obj
+ * file
+ * @param he_obj the half-edge object, with the counts ec, fc, vc, vtc
+ * and vnc set and its arena initialized, ideally with the size from
+ * obj_items_arena_size(); all arrays are allocated from it [mod]
+ * @param threads the maximum count of threads to use
  */
-static void delete_accel_struct(HE_obj *he_obj)
+void assemble_obj_items(obj_items const * const raw_obj,
+		HE_obj *he_obj,
+		unsigned threads)
 {
-	for (uint32_t i = 0; i < he_obj->vc; i++) {
-		if (he_obj->ec != 0) { /* not filles if we have only a bezier curve */
-			free(he_obj->vertices[i].acc->dummys);
-			free(he_obj->vertices[i].acc->edge_array);
-		}
-		free(he_obj->vertices[i].acc);
+	assemble_HE(raw_obj, he_obj, threads, NULL);
+}
+
+/**
+ * Assemble the half-edge structures like assemble_obj_items()
+ * and add what every stage took to the stats.
+ *
+ * @param raw_obj contains arrays of the items as they are in the .obj
+ * file
+ * @param he_obj the half-edge object, see assemble_obj_items() [mod]
+ * @param threads the maximum count of threads to use
+ * @param stats the stats, NULL for none [mod]
+ */
+static void assemble_HE(obj_items const * const raw_obj,
+		HE_obj *he_obj,
+		unsigned threads,
+		load_stats *stats)
+{
+	load_sample sample;
+
+	/* allocating the arrays is part of stage 1 */
+	LOAD_SAMPLE(stats, &sample);
+	he_obj->ring = NULL;
+	he_obj->tris = NULL;
+	he_obj->version = 0;
+	he_obj->vertices = arena_alloc(he_obj->mem, sizeof(HE_vert) *
+			(he_obj->vc + 1));
+	he_obj->faces = arena_alloc(he_obj->mem, sizeof(HE_face) * he_obj->fc);
+	/* hold enough space for possible dummy edges */
+	he_obj->edges = arena_alloc(he_obj->mem,
+			sizeof(HE_edge) * he_obj->ec * 2);
+
+	/*
+	 * run the stages of assemblance
+	 */
+	assemble_HE_stage1(raw_obj, he_obj);
+	LOAD_STAGE_DONE(stats, LOAD_STAGE_STAGE1, &sample, he_obj->vc);
+	if (threads > 1) {
+		assemble_HE_parallel(raw_obj, he_obj, threads, stats);
+	} else {
+		LOAD_SAMPLE(stats, &sample);
+		assemble_HE_stage2(raw_obj, he_obj);
+		LOAD_STAGE_DONE(stats, LOAD_STAGE_STAGE2, &sample, he_obj->ec);
+		LOAD_SAMPLE(stats, &sample);
+		assemble_HE_stage3(he_obj);
+		LOAD_STAGE_DONE(stats, LOAD_STAGE_STAGE3, &sample, he_obj->dec);
 	}
 }
 
@@ -686,28 +1668,12 @@ static void delete_accel_struct(HE_obj *he_obj)
  * Delete the raw obj pseudo struct which is only
  * used for assembling the HE_obj.
  */
-static void delete_raw_object(obj_items *raw_obj,
-		uint32_t fc,
-		uint32_t vc,
-		uint32_t vtc,
-		uint32_t bzc,
-		uint32_t vnc)
+static void delete_raw_object(obj_items *raw_obj)
 {
 	if (!raw_obj)
 		return;
 
-	for (uint32_t i = 0; i < vnc; i++)
-		free(raw_obj->vn[i]);
-	for (uint32_t i = 0; i < bzc; i++)
-		free(raw_obj->bez[i]);
-	for (uint32_t i = 0; i < vtc; i++)
-		free(raw_obj->vt[i]);
-	for (uint32_t i = 0; i < vc; i++)
-		free(raw_obj->v[i]);
-	for (uint32_t i = 0; i < fc; i++) {
-		free(raw_obj->f->v[i]);
-		free(raw_obj->f->vt[i]);
-	}
+	arena_release(&(raw_obj->mem));
 	free(raw_obj->bez);
 	free(raw_obj->f->v);
 	free(raw_obj->f->vt);
@@ -0,0 +1,455 @@
+/*
+ * Copyright 2011-2014 hasufell
+ *
+ * This file is part of a hasufell project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation version 2 of the License only.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file half_edge_cache.c
+ * Writing and loading of the binary cache of assembled
+ * HE_obj structures. All references are stored as indices,
+ * so loading a cache only needs to check it and to turn the
+ * indices back into pointers, instead of parsing the .obj file
+ * and pairing all edges again.
+ * @brief binary half-edge cache
+ */
+
+#include "arena.h"
+#include "err.h"
+#include "filereader.h"
+#include "half_edge.h"
+#include "half_edge_cache.h"
+#include "vector.h"
+
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+
+/**
+ * Index of an element a pointer refers to, HE_CACHE_NONE
+ * for NULL pointers.
+ */
+#define PTR_INDEX(ptr, base) \
+	((ptr) ? (uint32_t)((ptr) - (base)) : HE_CACHE_NONE)
+
+
+/*
+ * static function declaration
+ */
+static size_t cache_size(HE_cache_header const * const header);
+static uint64_t cache_checksum(char const *data, size_t len);
+static bool write_all(int fd, char const *buf, size_t len);
+static HE_obj *expand_cache(HE_cache_header const * const header,
+		char const *data);
+
+
+/**
+ * Size of a cache file with the counts of the header.
+ *
+ * @param header the header
+ * @return the size in bytes
+ */
+static size_t cache_size(HE_cache_header const * const header)
+{
+	return sizeof(*header) +
+		sizeof(vector) *
+		((size_t)header->vc + header->vnc + header->bez_vec_c) +
+		sizeof(HE_cache_edge) * ((size_t)header->ec + header->dec) +
+		sizeof(uint32_t) *
+		((size_t)header->vc + header->fc + header->bzc);
+}
+
+/**
+ * Checksum of a buffer, FNV-1a over 64 bit words with an
+ * additional shift to mix the upper bits into the lower ones.
+ * Every step is reversible, so any change of a single word
+ * changes the checksum.
+ *
+ * @param data the buffer
+ * @param len length of the buffer
+ * @return the checksum
+ */
+static uint64_t cache_checksum(char const *data, size_t len)
+{
+	uint64_t hash = 0xcbf29ce484222325ULL;
+	size_t i = 0;
+
+	for (; i + sizeof(uint64_t) <= len; i += sizeof(uint64_t)) {
+		uint64_t word;
+
+		memcpy(&word, data + i, sizeof(word));
+		hash = (hash ^ word) * 0x100000001b3ULL;
+		hash ^= hash >> 29;
+	}
+	for (; i < len; i++) {
+		hash = (hash ^ (unsigned char)data[i]) * 0x100000001b3ULL;
+		hash ^= hash >> 29;
+	}
+
+	return hash;
+}
+
+/**
+ * Write a whole buffer into a file descriptor.
+ *
+ * @param fd the file descriptor
+ * @param buf the buffer
+ * @param len length of the buffer
+ * @return true/false for success/failure
+ */
+static bool write_all(int fd, char const *buf, size_t len)
+{
+	while (len) {
+		ssize_t n = write(fd, buf, len);
+
+		if (n <= 0)
+			return false;
+
+		buf += n;
+		len -= (size_t)n;
+	}
+
+	return true;
+}
+
+/**
+ * Write an object into a cache file. The file is written
+ * under a temporary name first and then renamed, so
+ * nobody ever sees a partly written cache.
+ *
+ * @param obj the object
+ * @param filename the cache file
+ * @return true/false for success/failure
+ */
+bool write_obj_cache(HE_obj const * const obj,
+		char const * const filename)
+{
+	HE_cache_header header;
+	char *buf,
+		 *pos,
+		 *tmp_name;
+	size_t size;
+	int fd;
+	bool ret;
+
+	if (!obj || !filename || !*filename)
+		return false;
+
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, HE_CACHE_MAGIC, sizeof(HE_CACHE_MAGIC));
+	header.byte_order = HE_CACHE_BYTE_ORDER;
+	header.version = HE_CACHE_VERSION;
+	header.vc = obj->vc;
+	header.ec = obj->ec;
+	header.dec = obj->dec;
+	header.fc = obj->fc;
+	header.vnc = obj->vnc;
+	header.vtc = obj->vtc;
+	header.bzc = obj->bzc;
+	for (uint32_t i = 0; i < obj->bzc; i++)
+		header.bez_vec_c += obj->bez_curves[i].deg + 1;
+
+	size = cache_size(&header);
+	buf = malloc(size);
+	CHECK_PTR_VAL(buf);
+	pos = buf + sizeof(header);
+
+	if (obj->vc)
+		memcpy(pos, obj->positions, sizeof(vector) * obj->vc);
+	pos += sizeof(vector) * obj->vc;
+	if (obj->vnc)
+		memcpy(pos, obj->vn, sizeof(vector) * obj->vnc);
+	pos += sizeof(vector) * obj->vnc;
+	for (uint32_t i = 0; i < obj->bzc; i++) {
+		size_t const len =
+			sizeof(vector) * (obj->bez_curves[i].deg + 1);
+
+		memcpy(pos, obj->bez_curves[i].vec, len);
+		pos += len;
+	}
+
+	for (uint32_t i = 0; i < obj->ec + obj->dec; i++) {
+		HE_edge const *edge = &(obj->edges[i]);
+		HE_cache_edge cedge;
+
+		cedge.vert = PTR_INDEX(edge->vert, obj->vertices);
+		cedge.pair = PTR_INDEX(edge->pair, obj->edges);
+		cedge.face = PTR_INDEX(edge->face, obj->faces);
+		cedge.next = PTR_INDEX(edge->next, obj->edges);
+
+		memcpy(pos, &cedge, sizeof(cedge));
+		pos += sizeof(cedge);
+	}
+
+	for (uint32_t i = 0; i < obj->vc; i++) {
+		uint32_t edge = PTR_INDEX(obj->vertices[i].edge, obj->edges);
+
+		memcpy(pos, &edge, sizeof(edge));
+		pos += sizeof(edge);
+	}
+	for (uint32_t i = 0; i < obj->fc; i++) {
+		uint32_t edge = PTR_INDEX(obj->faces[i].edge, obj->edges);
+
+		memcpy(pos, &edge, sizeof(edge));
+		pos += sizeof(edge);
+	}
+	for (uint32_t i = 0; i < obj->bzc; i++) {
+		memcpy(pos, &(obj->bez_curves[i].deg), sizeof(uint32_t));
+		pos += sizeof(uint32_t);
+	}
+
+	header.checksum = cache_checksum(buf + sizeof(header),
+			size - sizeof(header));
+	memcpy(buf, &header, sizeof(header));
+
+	tmp_name = malloc(strlen(filename) + 32);
+	CHECK_PTR_VAL(tmp_name);
+	sprintf(tmp_name, "%s.%ld.tmp", filename, (long)getpid());
+
+	fd = open(tmp_name, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	ret = (fd != -1) && write_all(fd, buf, size);
+	if (fd != -1 && close(fd))
+		ret = false;
+	if (ret && rename(tmp_name, filename))
+		ret = false;
+	if (!ret && fd != -1)
+		unlink(tmp_name);
+
+	free(tmp_name);
+	free(buf);
+
+	return ret;
+}
+
+/**
+ * Build the HE_obj from the sections of a cache, turning
+ * all indices into pointers. Like the parser does, the object
+ * is owned by an arena which is served by a single block.
+ * All vertices get the default color.
+ *
+ * @param header the header, which has already been checked
+ * @param data the sections behind the header
+ * @return the object, NULL if the cache references
+ * something which does not exist
+ */
+static HE_obj *expand_cache(HE_cache_header const * const header,
+		char const *data)
+{
+	uint32_t const total = header->ec + header->dec;
+	char const *positions = data,
+		  *vn = positions + sizeof(vector) * header->vc,
+		  *bez_vec = vn + sizeof(vector) * header->vnc,
+		  *edges = bez_vec + sizeof(vector) * header->bez_vec_c,
+		  *vert_edges = edges + sizeof(HE_cache_edge) * total,
+		  *face_edges = vert_edges + sizeof(uint32_t) * header->vc,
+		  *bez_deg = face_edges + sizeof(uint32_t) * header->fc;
+	size_t size = ARENA_SIZE(sizeof(HE_vert) * (header->vc + 1)) +
+		ARENA_SIZE(sizeof(HE_face) * header->fc) +
+		ARENA_SIZE(sizeof(HE_edge) * total) +
+		ARENA_SIZE(sizeof(vector) * (header->vc + 1)) +
+		ARENA_SIZE(sizeof(color) * (header->vc + 1)) +
+		ARENA_SIZE(sizeof(vector) * header->vnc) +
+		ARENA_SIZE(sizeof(bez_curv) * header->bzc);
+	uint32_t bez_vec_c = 0;
+	bool valid = true;
+	HE_obj *obj;
+
+	/* the control points have to add up */
+	for (uint32_t i = 0; i < header->bzc; i++) {
+		uint32_t deg;
+
+		memcpy(&deg, bez_deg + sizeof(deg) * i, sizeof(deg));
+		if (deg >= header->bez_vec_c - bez_vec_c)
+			return NULL;
+
+		bez_vec_c += deg + 1;
+		size += ARENA_SIZE(sizeof(vector) * (deg + 1));
+	}
+	if (bez_vec_c != header->bez_vec_c)
+		return NULL;
+
+	obj = malloc(sizeof(*obj));
+	CHECK_PTR_VAL(obj);
+	obj->mem = malloc(sizeof(*obj->mem));
+	CHECK_PTR_VAL(obj->mem);
+	arena_init(obj->mem, size);
+	obj->ring = NULL;
+	obj->tris = NULL;
+	obj->version = 0;
+
+	obj->ec = header->ec;
+	obj->dec = header->dec;
+	obj->vc = header->vc;
+	obj->fc = header->fc;
+	obj->vnc = header->vnc;
+	obj->vtc = header->vtc;
+	obj->bzc = header->bzc;
+
+	obj->vertices = arena_alloc(obj->mem,
+			sizeof(*obj->vertices) * (obj->vc + 1));
+	obj->faces = arena_alloc(obj->mem, sizeof(*obj->faces) * obj->fc);
+	obj->edges = arena_alloc(obj->mem, sizeof(*obj->edges) * total);
+	obj->positions = arena_alloc(obj->mem,
+			sizeof(*obj->positions) * (obj->vc + 1));
+	obj->colors = arena_alloc(obj->mem,
+			sizeof(*obj->colors) * (obj->vc + 1));
+	obj->vn = NULL;
+	obj->bez_curves = NULL;
+
+	if (obj->vc)
+		memcpy(obj->positions, positions, sizeof(vector) * obj->vc);
+
+	if (obj->vnc) {
+		obj->vn = arena_alloc(obj->mem, sizeof(*obj->vn) * obj->vnc);
+		memcpy(obj->vn, vn, sizeof(vector) * obj->vnc);
+	}
+
+	if (obj->bzc)
+		obj->bez_curves = arena_alloc(obj->mem,
+				sizeof(*obj->bez_curves) * obj->bzc);
+	for (uint32_t i = 0; i < obj->bzc; i++) {
+		bez_curv *bez = &(obj->bez_curves[i]);
+
+		memcpy(&(bez->deg), bez_deg + sizeof(uint32_t) * i,
+				sizeof(uint32_t));
+		bez->vec = arena_alloc(obj->mem, sizeof(vector) * (bez->deg + 1));
+		memcpy(bez->vec, bez_vec, sizeof(vector) * (bez->deg + 1));
+		bez_vec += sizeof(vector) * (bez->deg + 1);
+	}
+
+	for (uint32_t i = 0; i < total; i++) {
+		HE_edge *edge = &(obj->edges[i]);
+		HE_cache_edge cedge;
+
+		memcpy(&cedge, edges + sizeof(cedge) * i, sizeof(cedge));
+
+		if (cedge.vert >= obj->vc || cedge.pair >= total ||
+				(cedge.face >= obj->fc && cedge.face != HE_CACHE_NONE) ||
+				(cedge.next >= total && cedge.next != HE_CACHE_NONE)) {
+			valid = false;
+			break;
+		}
+
+		edge->vert = &(obj->vertices[cedge.vert]);
+		edge->pair = &(obj->edges[cedge.pair]);
+		edge->face = (cedge.face != HE_CACHE_NONE) ?
+			&(obj->faces[cedge.face]) : NULL;
+		edge->next = (cedge.next != HE_CACHE_NONE) ?
+			&(obj->edges[cedge.next]) : NULL;
+	}
+
+	for (uint32_t i = 0; valid && i < obj->vc; i++) {
+		uint32_t edge;
+
+		memcpy(&edge, vert_edges + sizeof(edge) * i, sizeof(edge));
+		if (edge >= total && edge != HE_CACHE_NONE) {
+			valid = false;
+			break;
+		}
+
+		obj->colors[i].red = -1;
+		obj->colors[i].green = -1;
+		obj->colors[i].blue = -1;
+
+		obj->vertices[i].vec = &(obj->positions[i]);
+		obj->vertices[i].col = &(obj->colors[i]);
+		obj->vertices[i].edge = (edge != HE_CACHE_NONE) ?
+			&(obj->edges[edge]) : NULL;
+	}
+
+	for (uint32_t i = 0; valid && i < obj->fc; i++) {
+		uint32_t edge;
+
+		memcpy(&edge, face_edges + sizeof(edge) * i, sizeof(edge));
+		if (edge >= total) {
+			valid = false;
+			break;
+		}
+
+		obj->faces[i].edge = &(obj->edges[edge]);
+	}
+
+	if (!valid) {
+		delete_object(obj);
+		free(obj);
+		return NULL;
+	}
+
+	return obj;
+}
+
+/**
+ * Load an object from a cache in memory. The cache is
+ * rejected if it has another version or byte order, if its
+ * size does not match the header or if the checksum fails.
+ *
+ * @param buf the cache, it is not modified
+ * @param len length of buf
+ * @return the object, NULL on failure
+ */
+HE_obj *load_obj_cache_buf(char const * const buf, size_t len)
+{
+	HE_cache_header header;
+
+	if (!buf || len < sizeof(header))
+		return NULL;
+
+	memcpy(&header, buf, sizeof(header));
+
+	if (memcmp(header.magic, HE_CACHE_MAGIC, sizeof(HE_CACHE_MAGIC)) ||
+			header.byte_order != HE_CACHE_BYTE_ORDER ||
+			header.version != HE_CACHE_VERSION ||
+			header.dec > header.ec ||
+			cache_size(&header) != len)
+		return NULL;
+
+	if (cache_checksum(buf + sizeof(header), len - sizeof(header)) !=
+			header.checksum)
+		return NULL;
+
+	return expand_cache(&header, buf + sizeof(header));
+}
+
+/**
+ * Load an object from a cache file, which is mapped
+ * read-only for that.
+ *
+ * @param filename the cache file
+ * @return the object, NULL on failure
+ */
+HE_obj *load_obj_cache(char const * const filename)
+{
+	char const *map;
+	size_t len = 0;
+	HE_obj *obj;
+
+	if (!filename || !*filename)
+		return NULL;
+
+	map = map_file(filename, &len);
+	if (!map)
+		return NULL;
+
+	obj = load_obj_cache_buf(map, len);
+	unmap_file(map, len);
+
+	return obj;
+}
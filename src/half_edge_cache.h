@@ -0,0 +1,135 @@
+/*
+ * Copyright 2011-2014 hasufell
+ *
+ * This file is part of a hasufell project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation version 2 of the License only.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file half_edge_cache.h
+ * Header for the binary cache of assembled half-edge objects.
+ * @brief header of half_edge_cache.c
+ */
+
+#ifndef _DROW_ENGINE_HE_CACHE_H
+#define _DROW_ENGINE_HE_CACHE_H
+
+
+#include "half_edge.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+
+/**
+ * First bytes of every cache file.
+ */
+#define HE_CACHE_MAGIC "HECACHE"
+
+/**
+ * Version of the cache format. This must be increased whenever
+ * the format or the result of the parser changes, so old
+ * caches are rebuilt.
+ */
+#define HE_CACHE_VERSION 1
+
+/**
+ * Written in native byte order, so caches of machines
+ * with another byte order are recognized.
+ */
+#define HE_CACHE_BYTE_ORDER 0x01020304
+
+/**
+ * Appended to the name of an .obj file to get
+ * the name of its cache.
+ */
+#define HE_CACHE_SUFFIX ".hecache"
+
+/**
+ * Index used for references which don't exist, such as
+ * the face of a border edge.
+ */
+#define HE_CACHE_NONE UINT32_MAX
+
+
+typedef struct HE_cache_header HE_cache_header;
+typedef struct HE_cache_edge HE_cache_edge;
+
+
+/**
+ * Header of a cache file. It is followed by these
+ * sections, in this order and without any padding:
+ * positions (vc vectors), vertex normals (vnc vectors),
+ * bezier control points (bez_vec_c vectors), edges (ec + dec
+ * HE_cache_edge), the edge of every vertex (vc uint32_t), the
+ * edge of every face (fc uint32_t) and the degree of every
+ * bezier curve (bzc uint32_t). All numbers are in the byte order
+ * of the machine which wrote the cache.
+ */
+struct HE_cache_header {
+	/**
+	 * HE_CACHE_MAGIC, including the terminating NULL byte.
+	 */
+	char magic[8];
+	/**
+	 * HE_CACHE_BYTE_ORDER.
+	 */
+	uint32_t byte_order;
+	/**
+	 * HE_CACHE_VERSION.
+	 */
+	uint32_t version;
+	/**
+	 * Checksum of everything behind the header.
+	 */
+	uint64_t checksum;
+	uint32_t vc, ec, dec, fc, vnc, vtc, bzc;
+	/**
+	 * Count of bezier control points of all curves.
+	 */
+	uint32_t bez_vec_c;
+};
+
+/**
+ * A half-edge with indices instead of pointers, in the
+ * order of the edges array of the HE_obj.
+ */
+struct HE_cache_edge {
+	/**
+	 * Index of the start-vertex.
+	 */
+	uint32_t vert;
+	/**
+	 * Index of the pair.
+	 */
+	uint32_t pair;
+	/**
+	 * Index of the face, HE_CACHE_NONE for dummy edges.
+	 */
+	uint32_t face;
+	/**
+	 * Index of the next half-edge, HE_CACHE_NONE if unknown.
+	 */
+	uint32_t next;
+};
+
+
+bool write_obj_cache(HE_obj const * const obj,
+		char const * const filename);
+HE_obj *load_obj_cache(char const * const filename);
+HE_obj *load_obj_cache_buf(char const * const buf, size_t len);
+
+
+#endif /* _DROW_ENGINE_HE_CACHE_H */
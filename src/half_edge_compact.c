@@ -0,0 +1,298 @@
+/*
+ * Copyright 2011-2014 hasufell
+ *
+ * This file is part of a hasufell project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation version 2 of the License only.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file half_edge_compact.c
+ * Conversion between HE_obj and the compact, index based
+ * HE_cobj. The compact representation uses 32 bit indices
+ * instead of pointers and stores pairs next to each other,
+ * so a half-edge only needs 12 bytes and walks over big
+ * meshes touch far less memory.
+ * @brief compact half-edge representation
+ */
+
+#include "err.h"
+#include "half_edge.h"
+#include "half_edge_compact.h"
+#include "vector.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+/**
+ * Index of an element a pointer refers to, HE_C_NONE
+ * for NULL pointers.
+ */
+#define PTR_INDEX(ptr, base) \
+	((ptr) ? (uint32_t)((ptr) - (base)) : HE_C_NONE)
+
+
+/*
+ * static function declaration
+ */
+static uint32_t *pair_edge_ids(HE_obj const * const obj,
+		uint32_t *cec_out);
+
+
+/**
+ * Assign every half-edge of the object its index in the
+ * compact representation, so that pairs end up at 2i and
+ * 2i + 1. The edges are visited in their original order.
+ * Half-edges without a mutual pair (which only happens for
+ * degenerated faces) get a new border edge as pair, which
+ * is why the count of compact half-edges is returned separately.
+ *
+ * @param obj the object
+ * @param cec_out the count of compact half-edges [out]
+ * @return the compact index for every half-edge
+ */
+static uint32_t *pair_edge_ids(HE_obj const * const obj,
+		uint32_t *cec_out)
+{
+	uint32_t const ec = obj->ec + obj->dec;
+	uint32_t *ids = malloc(sizeof(*ids) * (ec + 1));
+	uint32_t cec = 0;
+
+	CHECK_PTR_VAL(ids);
+
+	for (uint32_t i = 0; i < ec; i++)
+		ids[i] = HE_C_NONE;
+
+	for (uint32_t i = 0; i < ec; i++) {
+		HE_edge const *edge = &(obj->edges[i]);
+		uint32_t pair = PTR_INDEX(edge->pair, obj->edges);
+
+		if (ids[i] != HE_C_NONE)
+			continue;
+
+		ids[i] = cec;
+		if (pair != HE_C_NONE && pair != i && ids[pair] == HE_C_NONE &&
+				obj->edges[pair].pair == edge)
+			ids[pair] = cec + 1;
+
+		cec += 2;
+	}
+
+	*cec_out = cec;
+
+	return ids;
+}
+
+/**
+ * Convert a HE_obj into the compact representation.
+ * The coordinates and vertex normals are copied, so
+ * both objects can be deleted independently.
+ *
+ * @param obj the object to convert
+ * @return the compact object, NULL on failure
+ */
+HE_cobj *compact_object(HE_obj const * const obj)
+{
+	HE_cobj *cobj;
+	uint32_t *ids;
+	uint32_t cec;
+
+	if (!obj)
+		return NULL;
+
+	cobj = malloc(sizeof(*cobj));
+	CHECK_PTR_VAL(cobj);
+
+	ids = pair_edge_ids(obj, &cec);
+
+	cobj->ec = cec;
+	cobj->vc = obj->vc;
+	cobj->fc = obj->fc;
+	cobj->vnc = obj->vnc;
+
+	cobj->edges = malloc(sizeof(*cobj->edges) * (cec + 1));
+	CHECK_PTR_VAL(cobj->edges);
+
+	/* border edges without an original half-edge */
+	for (uint32_t i = 1; i < cec; i += 2) {
+		cobj->edges[i].vert = HE_C_NONE;
+		cobj->edges[i].face = HE_C_NONE;
+		cobj->edges[i].next = HE_C_NONE;
+	}
+
+	for (uint32_t i = 0; i < obj->ec + obj->dec; i++) {
+		HE_edge const *edge = &(obj->edges[i]);
+		HE_cedge *cedge = &(cobj->edges[ids[i]]);
+		uint32_t next = PTR_INDEX(edge->next, obj->edges);
+
+		cedge->vert = PTR_INDEX(edge->vert, obj->vertices);
+		cedge->face = PTR_INDEX(edge->face, obj->faces);
+		cedge->next = (next != HE_C_NONE) ? ids[next] : HE_C_NONE;
+
+		/* the new pair of an unpaired edge starts where it ends */
+		if (edge->next && cobj->edges[HE_C_PAIR(ids[i])].vert == HE_C_NONE)
+			cobj->edges[HE_C_PAIR(ids[i])].vert =
+				PTR_INDEX(edge->next->vert, obj->vertices);
+	}
+
+	cobj->vert_edges = malloc(sizeof(*cobj->vert_edges) * (obj->vc + 1));
+	CHECK_PTR_VAL(cobj->vert_edges);
+	for (uint32_t i = 0; i < obj->vc; i++) {
+		uint32_t edge = PTR_INDEX(obj->vertices[i].edge, obj->edges);
+
+		cobj->vert_edges[i] = (edge != HE_C_NONE) ? ids[edge] : HE_C_NONE;
+	}
+
+	cobj->face_edges = malloc(sizeof(*cobj->face_edges) * (obj->fc + 1));
+	CHECK_PTR_VAL(cobj->face_edges);
+	for (uint32_t i = 0; i < obj->fc; i++)
+		cobj->face_edges[i] = ids[PTR_INDEX(obj->faces[i].edge, obj->edges)];
+
+	cobj->positions = malloc(sizeof(*cobj->positions) * (obj->vc + 1));
+	CHECK_PTR_VAL(cobj->positions);
+	if (obj->vc)
+		memcpy(cobj->positions, obj->positions,
+				sizeof(*cobj->positions) * obj->vc);
+
+	cobj->vn = NULL;
+	if (obj->vnc) {
+		cobj->vn = malloc(sizeof(*cobj->vn) * obj->vnc);
+		CHECK_PTR_VAL(cobj->vn);
+		memcpy(cobj->vn, obj->vn, sizeof(*cobj->vn) * obj->vnc);
+	}
+
+	free(ids);
+
+	return cobj;
+}
+
+/**
+ * Convert a compact object back into a HE_obj. As in
+ * the parser, all half-edges bordering a face come first
+ * and are followed by the dummy border edges. All vertices
+ * get the default color.
+ *
+ * @param cobj the compact object to convert
+ * @return the object, NULL on failure
+ */
+HE_obj *expand_object(HE_cobj const * const cobj)
+{
+	HE_obj *obj;
+	uint32_t *ids;
+	uint32_t ec = 0,
+			 dec = 0;
+
+	if (!cobj)
+		return NULL;
+
+	obj = malloc(sizeof(*obj));
+	CHECK_PTR_VAL(obj);
+
+	/* faces first, border edges last */
+	for (uint32_t i = 0; i < cobj->ec; i++)
+		if (cobj->edges[i].face != HE_C_NONE)
+			ec++;
+
+	ids = malloc(sizeof(*ids) * (cobj->ec + 1));
+	CHECK_PTR_VAL(ids);
+	for (uint32_t i = 0, j = 0; i < cobj->ec; i++) {
+		if (cobj->edges[i].face != HE_C_NONE)
+			ids[i] = j++;
+		else
+			ids[i] = ec + dec++;
+	}
+
+	obj->ec = ec;
+	obj->dec = dec;
+	obj->vc = cobj->vc;
+	obj->fc = cobj->fc;
+	obj->vnc = cobj->vnc;
+	obj->vtc = 0;
+	obj->bzc = 0;
+	obj->bez_curves = NULL;
+	obj->mem = NULL;
+	obj->ring = NULL;
+	obj->tris = NULL;
+	obj->version = 0;
+
+	obj->edges = malloc(sizeof(*obj->edges) * (cobj->ec + 1));
+	CHECK_PTR_VAL(obj->edges);
+	obj->vertices = malloc(sizeof(*obj->vertices) * (cobj->vc + 1));
+	CHECK_PTR_VAL(obj->vertices);
+	obj->positions = malloc(sizeof(*obj->positions) * (cobj->vc + 1));
+	CHECK_PTR_VAL(obj->positions);
+	obj->colors = malloc(sizeof(*obj->colors) * (cobj->vc + 1));
+	CHECK_PTR_VAL(obj->colors);
+	obj->faces = malloc(sizeof(*obj->faces) * (cobj->fc + 1));
+	CHECK_PTR_VAL(obj->faces);
+
+	for (uint32_t i = 0; i < cobj->ec; i++) {
+		HE_cedge const *cedge = &(cobj->edges[i]);
+		HE_edge *edge = &(obj->edges[ids[i]]);
+
+		edge->vert = &(obj->vertices[cedge->vert]);
+		edge->pair = &(obj->edges[ids[HE_C_PAIR(i)]]);
+		edge->face = (cedge->face != HE_C_NONE) ?
+			&(obj->faces[cedge->face]) : NULL;
+		edge->next = (cedge->next != HE_C_NONE) ?
+			&(obj->edges[ids[cedge->next]]) : NULL;
+	}
+
+	if (cobj->vc)
+		memcpy(obj->positions, cobj->positions,
+				sizeof(*obj->positions) * cobj->vc);
+
+	for (uint32_t i = 0; i < cobj->vc; i++) {
+		obj->colors[i].red = -1;
+		obj->colors[i].green = -1;
+		obj->colors[i].blue = -1;
+
+		obj->vertices[i].vec = &(obj->positions[i]);
+		obj->vertices[i].col = &(obj->colors[i]);
+		obj->vertices[i].edge = (cobj->vert_edges[i] != HE_C_NONE) ?
+			&(obj->edges[ids[cobj->vert_edges[i]]]) : NULL;
+	}
+
+	for (uint32_t i = 0; i < cobj->fc; i++)
+		obj->faces[i].edge = &(obj->edges[ids[cobj->face_edges[i]]]);
+
+	obj->vn = NULL;
+	if (cobj->vnc) {
+		obj->vn = malloc(sizeof(*obj->vn) * cobj->vnc);
+		CHECK_PTR_VAL(obj->vn);
+		memcpy(obj->vn, cobj->vn, sizeof(*obj->vn) * cobj->vnc);
+	}
+
+	free(ids);
+
+	return obj;
+}
+
+/**
+ * Free the inner structures of a compact object.
+ *
+ * @param cobj the compact object to free
+ */
+void delete_compact_object(HE_cobj *cobj)
+{
+	if (!cobj)
+		return;
+
+	free(cobj->edges);
+	free(cobj->vert_edges);
+	free(cobj->face_edges);
+	free(cobj->positions);
+	free(cobj->vn);
+}
@@ -0,0 +1,128 @@
+/*
+ * Copyright 2011-2014 hasufell
+ *
+ * This file is part of a hasufell project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation version 2 of the License only.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file half_edge_compact.h
+ * Header for the compact, index based half-edge representation
+ * and its conversion from/to HE_obj.
+ * @brief header of half_edge_compact.c
+ */
+
+#ifndef _DROW_ENGINE_HE_COMPACT_H
+#define _DROW_ENGINE_HE_COMPACT_H
+
+
+#include "half_edge.h"
+#include "vector.h"
+
+#include <stdint.h>
+
+
+/**
+ * Index used for references which don't exist, such as
+ * the face of a border edge.
+ */
+#define HE_C_NONE UINT32_MAX
+
+/**
+ * The pair of a compact half-edge. Pairs are always stored
+ * next to each other at 2i and 2i + 1.
+ */
+#define HE_C_PAIR(edge) ((edge) ^ 1)
+
+
+typedef struct HE_cedge HE_cedge;
+typedef struct HE_cobj HE_cobj;
+
+
+/**
+ * Represents a half-edge by indices instead of pointers,
+ * which makes it 12 bytes instead of 32. The pair is
+ * implicit, see HE_C_PAIR().
+ */
+struct HE_cedge {
+	/**
+	 * Index of the start-vertex of the half-edge.
+	 */
+	uint32_t vert;
+	/**
+	 * Index of the face the half-edge borders,
+	 * HE_C_NONE for border edges.
+	 */
+	uint32_t face;
+	/**
+	 * Index of the next half-edge around the face,
+	 * HE_C_NONE if unknown.
+	 */
+	uint32_t next;
+};
+
+/**
+ * The compact counterpart of HE_obj. Vertices and faces
+ * only consist of the index of one of their half-edges, so they
+ * are stored as plain arrays. Bezier curves and colors
+ * are not part of the topology and are left out.
+ */
+struct HE_cobj {
+	/**
+	 * Array of half-edges, ordered by pairs.
+	 */
+	HE_cedge *edges;
+	/**
+	 * One of the half-edges emanating from each vertex,
+	 * HE_C_NONE for isolated vertices.
+	 */
+	uint32_t *vert_edges;
+	/**
+	 * One of the half-edges bordering each face.
+	 */
+	uint32_t *face_edges;
+	/**
+	 * Coordinates of all vertices.
+	 */
+	vector *positions;
+	/**
+	 * Vertices normals.
+	 */
+	vector *vn;
+	/**
+	 * Count of half-edges, including border edges.
+	 * This is always even.
+	 */
+	uint32_t ec;
+	/**
+	 * Count of vertices.
+	 */
+	uint32_t vc;
+	/**
+	 * Count of faces.
+	 */
+	uint32_t fc;
+	/**
+	 * Count of vertice normals.
+	 */
+	uint32_t vnc;
+};
+
+
+HE_cobj *compact_object(HE_obj const * const obj);
+HE_obj *expand_object(HE_cobj const * const cobj);
+void delete_compact_object(HE_cobj *cobj);
+
+
+#endif /* _DROW_ENGINE_HE_COMPACT_H */
@@ -0,0 +1,381 @@
+/*
+ * Copyright 2011-2014 hasufell
+ *
+ * This file is part of a hasufell project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation version 2 of the License only.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file half_edge_normals.c
+ * Computes the normals of all vertices of a HE_obj at once.
+ * Every face normal is computed a single time into a flat
+ * array, then every vertex sums up the weighted normals of its
+ * faces from its slice of the one-ring index. Both passes
+ * only write to their own face or vertex, so they are split
+ * over threads without any locking and the result does not
+ * depend on the count of threads.
+ * @brief batch computation of vertex normals
+ */
+
+#include "err.h"
+#include "half_edge.h"
+#include "half_edge_normals.h"
+#include "half_edge_ring.h"
+#include "vector.h"
+
+#include <math.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+
+typedef struct normal_part normal_part;
+
+
+/**
+ * The part of the work one thread does in every
+ * pass of compute_vertex_normals_parallel().
+ */
+struct normal_part {
+	/**
+	 * The object.
+	 */
+	HE_obj *obj;
+	/**
+	 * The weighting of the face normals.
+	 */
+	normal_weight weight;
+	/**
+	 * Normals of all faces, of the length of the area
+	 * for NORMAL_WEIGHT_AREA, of length 1 otherwise.
+	 */
+	vector *face_normals;
+	/**
+	 * Angle of the face at the start vertex of every edge,
+	 * only for NORMAL_WEIGHT_ANGLE.
+	 */
+	float *angles;
+	/**
+	 * First face or vertex of the part.
+	 */
+	uint32_t start;
+	/**
+	 * End of the faces or vertices of the part (exclusive).
+	 */
+	uint32_t end;
+};
+
+
+/*
+ * static function declaration
+ */
+static float corner_angle(vector const * const prev,
+		vector const * const vert,
+		vector const * const next);
+static void *face_part_normals(void *arg);
+static void *vertex_part_normals(void *arg);
+static void run_normal_parts(void *(*fn)(void*),
+		normal_part *parts,
+		uint32_t part_c);
+static vector *vertex_normals_array(HE_obj *obj);
+
+
+/**
+ * Calculate the angle at a corner of a face.
+ *
+ * @param prev the previous vertex of the face
+ * @param vert the vertex of the corner
+ * @param next the next vertex of the face
+ * @return the angle in radians, 0 if the corner is degenerated
+ */
+static float corner_angle(vector const * const prev,
+		vector const * const vert,
+		vector const * const next)
+{
+	float const ax = prev->x - vert->x,
+		  ay = prev->y - vert->y,
+		  az = prev->z - vert->z,
+		  bx = next->x - vert->x,
+		  by = next->y - vert->y,
+		  bz = next->z - vert->z;
+	float const cx = ay * bz - az * by,
+		  cy = az * bx - ax * bz,
+		  cz = ax * by - ay * bx;
+
+	/* atan2 stays accurate for very small and very flat angles */
+	return atan2f(sqrtf(cx * cx + cy * cy + cz * cz),
+			ax * bx + ay * by + az * bz);
+}
+
+/**
+ * Compute the normals of the faces of a part with Newell's
+ * method, which also works for non-planar polygons and gives
+ * a vector of twice the area of the face. For
+ * NORMAL_WEIGHT_ANGLE the normals are normalized and the angles
+ * of the face at its vertices are stored as well.
+ *
+ * @param arg the normal_part, with the face range set [mod]
+ * @return NULL
+ */
+static void *face_part_normals(void *arg)
+{
+	normal_part *part = arg;
+	HE_obj const *obj = part->obj;
+
+	for (uint32_t i = part->start; i < part->end; i++) {
+		HE_edge const * const start = obj->faces[i].edge;
+		HE_edge const *edge = start;
+		double x = 0,
+			   y = 0,
+			   z = 0;
+
+		do {
+			vector const *cur = edge->vert->vec,
+				  *next = edge->next->vert->vec;
+
+			x += (double)(cur->y - next->y) * (cur->z + next->z);
+			y += (double)(cur->z - next->z) * (cur->x + next->x);
+			z += (double)(cur->x - next->x) * (cur->y + next->y);
+			edge = edge->next;
+		} while (edge != start);
+
+		if (part->weight == NORMAL_WEIGHT_ANGLE) {
+			double const len = sqrt(x * x + y * y + z * z);
+			HE_edge const *prev = start;
+
+			if (len > 0) {
+				x /= len;
+				y /= len;
+				z /= len;
+			}
+
+			while (prev->next != start)
+				prev = prev->next;
+			do {
+				part->angles[edge - obj->edges] =
+					corner_angle(prev->vert->vec, edge->vert->vec,
+							edge->next->vert->vec);
+				prev = edge;
+				edge = edge->next;
+			} while (edge != start);
+		} else {
+			/* half of Newell's vector is the area */
+			x /= 2;
+			y /= 2;
+			z /= 2;
+		}
+
+		part->face_normals[i].x = (float)x;
+		part->face_normals[i].y = (float)y;
+		part->face_normals[i].z = (float)z;
+	}
+
+	return NULL;
+}
+
+/**
+ * Sum up the weighted face normals around the vertices of
+ * a part, in the order of the one-ring index, and normalize
+ * them into obj->vn. Vertices without a face get a null
+ * vector.
+ *
+ * @param arg the normal_part, with the vertex range set [mod]
+ * @return NULL
+ */
+static void *vertex_part_normals(void *arg)
+{
+	normal_part *part = arg;
+	HE_obj const *obj = part->obj;
+	HE_ring const *ring = obj->ring;
+
+	for (uint32_t i = part->start; i < part->end; i++) {
+		double x = 0,
+			   y = 0,
+			   z = 0,
+			   len;
+
+		for (uint32_t j = ring->offsets[i]; j < ring->offsets[i + 1]; j++) {
+			uint32_t const e = ring->edges[j];
+			HE_face const *face = obj->edges[e].face;
+			vector const *normal;
+			double w = 1;
+
+			if (!face)
+				continue;
+
+			normal = &(part->face_normals[face - obj->faces]);
+			if (part->weight == NORMAL_WEIGHT_ANGLE)
+				w = part->angles[e];
+
+			x += w * normal->x;
+			y += w * normal->y;
+			z += w * normal->z;
+		}
+
+		len = sqrt(x * x + y * y + z * z);
+		if (len > 0) {
+			x /= len;
+			y /= len;
+			z /= len;
+		}
+
+		obj->vn[i].x = (float)x;
+		obj->vn[i].y = (float)y;
+		obj->vn[i].z = (float)z;
+	}
+
+	return NULL;
+}
+
+/**
+ * Run a function on all parts, the first one in
+ * the calling thread.
+ *
+ * @param fn the function
+ * @param parts the parts
+ * @param part_c count of parts
+ */
+static void run_normal_parts(void *(*fn)(void*),
+		normal_part *parts,
+		uint32_t part_c)
+{
+	pthread_t *tids = malloc(sizeof(*tids) * part_c);
+
+	CHECK_PTR_VAL(tids);
+
+	for (uint32_t i = 1; i < part_c; i++)
+		if (pthread_create(&(tids[i]), NULL, fn, &(parts[i])))
+			ABORT("Failed to create normals thread!\n");
+	fn(&(parts[0]));
+	for (uint32_t i = 1; i < part_c; i++)
+		if (pthread_join(tids[i], NULL))
+			ABORT("Failed to join normals thread!\n");
+
+	free(tids);
+}
+
+/**
+ * Make obj->vn hold one normal per vertex. The array is
+ * reused if it already has that size, otherwise a new one
+ * is allocated, from the arena of the object if it has one.
+ *
+ * @param obj the object [mod]
+ * @return obj->vn
+ */
+static vector *vertex_normals_array(HE_obj *obj)
+{
+	if (obj->vn && obj->vnc == obj->vc)
+		return obj->vn;
+
+	if (obj->mem) {
+		obj->vn = arena_alloc(obj->mem, sizeof(*obj->vn) * obj->vc);
+	} else {
+		obj->vn = realloc(obj->vn, sizeof(*obj->vn) * obj->vc);
+		CHECK_PTR_VAL(obj->vn);
+	}
+	obj->vnc = obj->vc;
+
+	return obj->vn;
+}
+
+/**
+ * Compute the normals of all vertices of an object and store
+ * them in obj->vn, so that obj->vn[i] belongs to
+ * obj->vertices[i] and obj->vnc equals obj->vc afterwards. Any
+ * normals from the .obj file are replaced. The result is
+ * exactly the same as the one of compute_vertex_normals(),
+ * for any count of threads.
+ *
+ * @param obj the object, its one-ring index is built if
+ * needed [mod]
+ * @param weight how the face normals are weighted
+ * @param threads the maximum count of threads, 0 to use
+ * one per online CPU
+ * @return true/false for success/failure
+ */
+bool compute_vertex_normals_parallel(HE_obj *obj,
+		normal_weight weight,
+		unsigned threads)
+{
+	normal_part *parts;
+	vector *face_normals;
+	float *angles = NULL;
+	uint32_t part_c;
+
+	if (!obj || (obj->vc && !obj->vertices) || (obj->fc && !obj->faces))
+		return false;
+
+	if (!threads) {
+		long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+		threads = cpus > 0 ? (unsigned)cpus : 1;
+	}
+	if (!obj->vc)
+		return true;
+	part_c = obj->vc < threads ? obj->vc : threads;
+
+	/* built up front, the threads only read it */
+	get_vertex_rings(obj);
+	vertex_normals_array(obj);
+
+	face_normals = malloc(sizeof(*face_normals) * (obj->fc + 1));
+	CHECK_PTR_VAL(face_normals);
+	if (weight == NORMAL_WEIGHT_ANGLE) {
+		angles = malloc(sizeof(*angles) * (obj->ec + 1));
+		CHECK_PTR_VAL(angles);
+	}
+	parts = calloc(part_c, sizeof(*parts));
+	CHECK_PTR_VAL(parts);
+
+	for (uint32_t i = 0; i < part_c; i++) {
+		parts[i].obj = obj;
+		parts[i].weight = weight;
+		parts[i].face_normals = face_normals;
+		parts[i].angles = angles;
+		parts[i].start = (uint64_t)obj->fc * i / part_c;
+		parts[i].end = (uint64_t)obj->fc * (i + 1) / part_c;
+	}
+	run_normal_parts(face_part_normals, parts, part_c);
+
+	for (uint32_t i = 0; i < part_c; i++) {
+		parts[i].start = (uint64_t)obj->vc * i / part_c;
+		parts[i].end = (uint64_t)obj->vc * (i + 1) / part_c;
+	}
+	run_normal_parts(vertex_part_normals, parts, part_c);
+
+	free(parts);
+	free(angles);
+	free(face_normals);
+	obj->version++;
+
+	return true;
+}
+
+/**
+ * Compute the normals of all vertices of an object in
+ * the calling thread and store them in obj->vn. See
+ * compute_vertex_normals_parallel().
+ *
+ * @param obj the object, its one-ring index is built if
+ * needed [mod]
+ * @param weight how the face normals are weighted
+ * @return true/false for success/failure
+ */
+bool compute_vertex_normals(HE_obj *obj,
+		normal_weight weight)
+{
+	return compute_vertex_normals_parallel(obj, weight, 1);
+}
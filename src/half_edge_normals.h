@@ -0,0 +1,84 @@
+/*
+ * Copyright 2011-2014 hasufell
+ *
+ * This file is part of a hasufell project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation version 2 of the License only.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file half_edge_normals.h
+ * Header for the batch computation of vertex normals.
+ * @brief header of half_edge_normals.c
+ */
+
+#ifndef _DROW_ENGINE_HE_NORMALS_H
+#define _DROW_ENGINE_HE_NORMALS_H
+
+
+#include "half_edge.h"
+
+#include <stdbool.h>
+
+
+/**
+ * Fault intolerant macro. Will abort the program if the called
+ * function failed.
+ */
+#define COMPUTE_VERTEX_NORMALS(...) \
+{ \
+	if (!compute_vertex_normals(__VA_ARGS__)) { \
+		fprintf(stderr, "Failure in compute_vertex_normals()!\n"); \
+		abort(); \
+	} \
+}
+
+/**
+ * Fault intolerant macro. Will abort the program if the called
+ * function failed.
+ */
+#define COMPUTE_VERTEX_NORMALS_PARALLEL(...) \
+{ \
+	if (!compute_vertex_normals_parallel(__VA_ARGS__)) { \
+		fprintf(stderr, "Failure in compute_vertex_normals_parallel()!\n"); \
+		abort(); \
+	} \
+}
+
+
+/**
+ * How the normals of the incident faces are
+ * weighted in the normal of a vertex.
+ */
+enum normal_weight {
+	/**
+	 * By the area of the face.
+	 */
+	NORMAL_WEIGHT_AREA,
+	/**
+	 * By the angle of the face at the vertex.
+	 */
+	NORMAL_WEIGHT_ANGLE,
+};
+
+typedef enum normal_weight normal_weight;
+
+
+bool compute_vertex_normals(HE_obj *obj,
+		normal_weight weight);
+bool compute_vertex_normals_parallel(HE_obj *obj,
+		normal_weight weight,
+		unsigned threads);
+
+
+#endif /* _DROW_ENGINE_HE_NORMALS_H */
@@ -0,0 +1,249 @@
+/*
+ * Copyright 2011-2014 hasufell
+ *
+ * This file is part of a hasufell project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation version 2 of the License only.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file half_edge_ring.c
+ * The one-ring index of the vertices of a HE_obj. It is
+ * built once per object on first use, after that the
+ * emanating edges and incident faces of a vertex are a
+ * contiguous slice which is walked without any heap traffic
+ * and without a limit on the valence.
+ * @brief one-ring index of half-edge vertices
+ */
+
+#include "err.h"
+#include "half_edge.h"
+#include "half_edge_ring.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+
+/*
+ * static function declaration
+ */
+static bool walk_vertex_ring(HE_obj const * const obj,
+		uint32_t vert,
+		uint32_t *ring_edges,
+		uint32_t count);
+static HE_ring *build_vertex_rings(HE_obj const * const obj);
+
+
+/**
+ * Collect the emanating edges of a vertex by walking
+ * edge->pair->next around it. This only succeeds if the walk
+ * comes back to the start after visiting exactly all edges of
+ * the vertex, so it never runs away on broken topology.
+ *
+ * @param obj the object
+ * @param vert index of the vertex
+ * @param ring_edges the slice of the vertex [out]
+ * @param count count of edges starting at the vertex
+ * @return true if the walk found all edges, false otherwise
+ */
+static bool walk_vertex_ring(HE_obj const * const obj,
+		uint32_t vert,
+		uint32_t *ring_edges,
+		uint32_t count)
+{
+	HE_vert const *v = &(obj->vertices[vert]);
+	HE_edge const *edge = v->edge;
+	uint32_t i = 0;
+
+	do {
+		if (!edge || edge->vert != v || i == count)
+			return false;
+
+		ring_edges[i++] = edge - obj->edges;
+		edge = edge->pair ? edge->pair->next : NULL;
+	} while (edge != v->edge);
+
+	return i == count;
+}
+
+/**
+ * Build the one-ring index of all vertices. The edges are
+ * counted per vertex first, so every slice has its exact size.
+ *
+ * @param obj the object
+ * @return the newly allocated index
+ */
+static HE_ring *build_vertex_rings(HE_obj const * const obj)
+{
+	uint32_t const vc = obj->vc,
+		  ec = obj->ec + obj->dec;
+	uint32_t *fill;
+	bool unordered = false;
+	HE_ring *ring = malloc(sizeof(*ring));
+
+	CHECK_PTR_VAL(ring);
+	ring->offsets = calloc(vc + 1, sizeof(*ring->offsets));
+	CHECK_PTR_VAL(ring->offsets);
+	ring->edges = malloc(sizeof(*ring->edges) * (ec + 1));
+	CHECK_PTR_VAL(ring->edges);
+
+	for (uint32_t i = 0; i < ec; i++)
+		ring->offsets[obj->edges[i].vert - obj->vertices + 1]++;
+	for (uint32_t i = 0; i < vc; i++)
+		ring->offsets[i + 1] += ring->offsets[i];
+
+	/* where the next edge of every vertex goes that can't be walked */
+	fill = malloc(sizeof(*fill) * (vc + 1));
+	CHECK_PTR_VAL(fill);
+	for (uint32_t i = 0; i < vc; i++) {
+		uint32_t const start = ring->offsets[i],
+			  count = ring->offsets[i + 1] - start;
+
+		fill[i] = UINT32_MAX;
+		if (count && !walk_vertex_ring(obj, i, ring->edges + start, count)) {
+			fill[i] = start;
+			unordered = true;
+		}
+	}
+
+	/* non-manifold vertices get their edges in index order */
+	for (uint32_t i = 0; unordered && i < ec; i++) {
+		uint32_t const v = obj->edges[i].vert - obj->vertices;
+
+		if (fill[v] != UINT32_MAX)
+			ring->edges[fill[v]++] = i;
+	}
+
+	free(fill);
+
+	return ring;
+}
+
+/**
+ * Get the one-ring index of an object, which is built
+ * on first use and then kept until delete_vertex_rings()
+ * or delete_object(). It must be deleted whenever the
+ * topology of the object changes.
+ *
+ * @param obj the object [mod]
+ * @return the index, NULL if obj is NULL
+ */
+HE_ring const *get_vertex_rings(HE_obj *obj)
+{
+	if (!obj)
+		return NULL;
+
+	if (!obj->ring)
+		obj->ring = build_vertex_rings(obj);
+
+	return obj->ring;
+}
+
+/**
+ * Delete the one-ring index of an object, if any.
+ *
+ * @param obj the object [mod]
+ */
+void delete_vertex_rings(HE_obj *obj)
+{
+	if (!obj || !obj->ring)
+		return;
+
+	free(obj->ring->offsets);
+	free(obj->ring->edges);
+	free(obj->ring);
+	obj->ring = NULL;
+}
+
+/**
+ * Get the emanating edges of a vertex as a slice
+ * of the one-ring index.
+ *
+ * @param obj the object [mod]
+ * @param vert index of the vertex
+ * @param count the count of edges [out]
+ * @return the indices of the edges into obj->edges, NULL if
+ * vert is out of range
+ */
+uint32_t const *vertex_ring(HE_obj *obj,
+		uint32_t vert,
+		uint32_t *count)
+{
+	HE_ring const *ring;
+
+	if (!obj || !count || vert >= obj->vc)
+		return NULL;
+
+	ring = get_vertex_rings(obj);
+	*count = ring->offsets[vert + 1] - ring->offsets[vert];
+
+	return ring->edges + ring->offsets[vert];
+}
+
+/**
+ * Start iterating over the one-ring of a vertex.
+ *
+ * @param it the iterator [out]
+ * @param obj the object [mod]
+ * @param vert index of the vertex
+ * @return true if the vertex has emanating edges, false otherwise
+ */
+bool ring_iter_init(HE_ring_iter *it,
+		HE_obj *obj,
+		uint32_t vert)
+{
+	uint32_t count = 0;
+
+	if (!it)
+		return false;
+
+	it->edges = obj ? obj->edges : NULL;
+	it->pos = vertex_ring(obj, vert, &count);
+	it->end = it->pos ? it->pos + count : NULL;
+
+	return count > 0;
+}
+
+/**
+ * Get the next emanating edge of the vertex,
+ * including dummy edges.
+ *
+ * @param it the iterator [mod]
+ * @return the edge or NULL at the end
+ */
+HE_edge *ring_next_edge(HE_ring_iter *it)
+{
+	if (it->pos == it->end)
+		return NULL;
+
+	return &(it->edges[*(it->pos++)]);
+}
+
+/**
+ * Get the next incident face of the vertex, which
+ * skips the dummy edges.
+ *
+ * @param it the iterator [mod]
+ * @return the face or NULL at the end
+ */
+HE_face *ring_next_face(HE_ring_iter *it)
+{
+	HE_edge *edge;
+
+	while ((edge = ring_next_edge(it)))
+		if (edge->face)
+			return edge->face;
+
+	return NULL;
+}
@@ -0,0 +1,90 @@
+/*
+ * Copyright 2011-2014 hasufell
+ *
+ * This file is part of a hasufell project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation version 2 of the License only.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file half_edge_ring.h
+ * Header for the one-ring index of the vertices of a HE_obj.
+ * @brief header of half_edge_ring.c
+ */
+
+#ifndef _DROW_ENGINE_HE_RING_H
+#define _DROW_ENGINE_HE_RING_H
+
+
+#include "half_edge.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+
+typedef struct HE_ring_iter HE_ring_iter;
+
+
+/**
+ * The emanating half-edges of all vertices, including
+ * dummy edges, in compressed sparse row layout: the edges of
+ * vertex v are the indices edges[offsets[v]] up to
+ * edges[offsets[v + 1]] (exclusive) into the edges array
+ * of the object. Around manifold vertices they are in the
+ * order of walking edge->pair->next, starting at vert->edge,
+ * otherwise in the order of the edges array.
+ */
+struct HE_ring {
+	/**
+	 * Start of the edges of every vertex, vc + 1 entries.
+	 */
+	uint32_t *offsets;
+	/**
+	 * Indices of the emanating edges, ec + dec entries.
+	 */
+	uint32_t *edges;
+};
+
+/**
+ * Iterator over the one-ring of a vertex, which is
+ * just a position in the slice of the vertex.
+ */
+struct HE_ring_iter {
+	/**
+	 * The edges array of the object.
+	 */
+	HE_edge *edges;
+	/**
+	 * The next index to return.
+	 */
+	uint32_t const *pos;
+	/**
+	 * The end of the slice.
+	 */
+	uint32_t const *end;
+};
+
+
+HE_ring const *get_vertex_rings(HE_obj *obj);
+void delete_vertex_rings(HE_obj *obj);
+uint32_t const *vertex_ring(HE_obj *obj,
+		uint32_t vert,
+		uint32_t *count);
+bool ring_iter_init(HE_ring_iter *it,
+		HE_obj *obj,
+		uint32_t vert);
+HE_edge *ring_next_edge(HE_ring_iter *it);
+HE_face *ring_next_face(HE_ring_iter *it);
+
+
+#endif /* _DROW_ENGINE_HE_RING_H */
@@ -0,0 +1,390 @@
+/*
+ * Copyright 2011-2014 hasufell
+ *
+ * This file is part of a hasufell project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation version 2 of the License only.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file half_edge_tris.c
+ * The triangulation of the faces of a HE_obj. Convex faces
+ * become fans around their first corner, concave ones are
+ * split by ear clipping in the plane of their normal, so the
+ * triangles cover exactly the face, unlike GL_POLYGON. All
+ * faces are triangulated once per object on first use into a
+ * flat index array, which is then shared by everything that
+ * needs triangles, and faces which change can be triangulated
+ * again on their own.
+ * @brief triangulation of half-edge faces
+ */
+
+#include "err.h"
+#include "half_edge.h"
+#include "half_edge_tris.h"
+#include "vector.h"
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+/*
+ * static function declaration
+ */
+static uint32_t face_corner_c(HE_face const * const face);
+static float corner_turn(float const * const a,
+		float const * const b,
+		float const * const c);
+static bool is_ear(float const (*uv)[2],
+		uint32_t corner_c,
+		uint32_t corner);
+static void clip_ears(uint32_t *ids,
+		float (*uv)[2],
+		uint32_t corner_c,
+		uint32_t *indices);
+static HE_tris *build_face_triangles(HE_obj const * const obj);
+
+
+/**
+ * Count the corners of a face.
+ *
+ * @param face the face
+ * @return count of corners, 0 for a broken face
+ */
+static uint32_t face_corner_c(HE_face const * const face)
+{
+	HE_edge const *edge = face->edge;
+	uint32_t corner_c = 0;
+
+	if (!edge)
+		return 0;
+
+	do {
+		corner_c++;
+	} while ((edge = edge->next) && edge != face->edge);
+
+	return edge ? corner_c : 0;
+}
+
+/**
+ * Calculate how much the path a, b, c turns left at b
+ * in the plane.
+ *
+ * @param a first point
+ * @param b second point
+ * @param c third point
+ * @return twice the signed area of the triangle, positive
+ * for a left turn
+ */
+static float corner_turn(float const * const a,
+		float const * const b,
+		float const * const c)
+{
+	return (b[0] - a[0]) * (c[1] - a[1]) - (b[1] - a[1]) * (c[0] - a[0]);
+}
+
+/**
+ * Check whether a corner of a counter-clockwise polygon is an
+ * ear, that is it is convex and no other corner lies in the
+ * triangle of it and its neighbours. Corners at the same
+ * place as the ones of the triangle don't count, so faces
+ * which touch themselves can be clipped.
+ *
+ * @param uv the corners in the plane
+ * @param corner_c count of corners
+ * @param corner the corner
+ * @return true if the corner is an ear
+ */
+static bool is_ear(float const (*uv)[2],
+		uint32_t corner_c,
+		uint32_t corner)
+{
+	float const *prev = uv[(corner + corner_c - 1) % corner_c],
+		  *cur = uv[corner],
+		  *next = uv[(corner + 1) % corner_c];
+
+	if (corner_turn(prev, cur, next) <= 0)
+		return false;
+
+	for (uint32_t i = 0; i < corner_c; i++) {
+		float const *q = uv[i];
+
+		if ((q[0] == prev[0] && q[1] == prev[1]) ||
+				(q[0] == cur[0] && q[1] == cur[1]) ||
+				(q[0] == next[0] && q[1] == next[1]))
+			continue;
+
+		if (corner_turn(prev, cur, q) >= 0 &&
+				corner_turn(cur, next, q) >= 0 &&
+				corner_turn(next, prev, q) >= 0)
+			return false;
+	}
+
+	return true;
+}
+
+/**
+ * Split a counter-clockwise polygon into triangles by
+ * cutting off one ear after the other. If no ear is left,
+ * because the polygon is degenerated or crosses itself, the
+ * next corner is cut off anyway, so there are always
+ * corner_c - 2 triangles.
+ *
+ * @param ids the vertex indices of the corners [mod]
+ * @param uv the corners in the plane [mod]
+ * @param corner_c count of corners, at least 3
+ * @param indices the triangles, 3 * (corner_c - 2) indices [out]
+ */
+static void clip_ears(uint32_t *ids,
+		float (*uv)[2],
+		uint32_t corner_c,
+		uint32_t *indices)
+{
+	uint32_t pos = 0,
+			 corner = 0;
+
+	while (corner_c > 3) {
+		uint32_t tries;
+
+		for (tries = 0; tries < corner_c; tries++) {
+			if (is_ear((float const (*)[2])uv, corner_c, corner))
+				break;
+			corner = (corner + 1) % corner_c;
+		}
+
+		indices[pos++] = ids[(corner + corner_c - 1) % corner_c];
+		indices[pos++] = ids[corner];
+		indices[pos++] = ids[(corner + 1) % corner_c];
+
+		memmove(ids + corner, ids + corner + 1,
+				sizeof(*ids) * (corner_c - corner - 1));
+		memmove(uv + corner, uv + corner + 1,
+				sizeof(*uv) * (corner_c - corner - 1));
+		corner_c--;
+		if (corner == corner_c)
+			corner = 0;
+	}
+
+	indices[pos++] = ids[0];
+	indices[pos++] = ids[1];
+	indices[pos++] = ids[2];
+}
+
+/**
+ * Triangulate a face. Convex faces become a fan around the
+ * corner of face->edge. Concave faces are projected onto the
+ * plane their Newell normal is most perpendicular to and
+ * split by ear clipping.
+ *
+ * @param obj the object of the face
+ * @param face the face
+ * @param indices the triangles as indices into obj->vertices,
+ * room for 3 * (corners - 2) of them [out]
+ * @return count of indices written, 0 for faces with less
+ * than three corners
+ */
+uint32_t triangulate_face(HE_obj const * const obj,
+		HE_face const * const face,
+		uint32_t *indices)
+{
+	uint32_t const corner_c = face_corner_c(face);
+	uint32_t stack_ids[HE_TRIS_STACK_CORNERS];
+	float stack_uv[HE_TRIS_STACK_CORNERS][2];
+	uint32_t *ids = stack_ids;
+	float (*uv)[2] = stack_uv;
+	HE_edge const *edge = face->edge;
+	double normal[3] = { 0, 0, 0 };
+	uint32_t axis,
+			 pos = 0;
+	bool convex = true;
+
+	if (corner_c < 3)
+		return 0;
+
+	if (corner_c > HE_TRIS_STACK_CORNERS) {
+		ids = malloc(sizeof(*ids) * corner_c);
+		CHECK_PTR_VAL(ids);
+		uv = malloc(sizeof(*uv) * corner_c);
+		CHECK_PTR_VAL(uv);
+	}
+
+	/* Newell's normal, as in half_edge_normals.c */
+	for (uint32_t i = 0; i < corner_c; i++, edge = edge->next) {
+		vector const *cur = edge->vert->vec,
+			  *next = edge->next->vert->vec;
+
+		ids[i] = (uint32_t)(edge->vert - obj->vertices);
+		normal[0] += (double)(cur->y - next->y) * (cur->z + next->z);
+		normal[1] += (double)(cur->z - next->z) * (cur->x + next->x);
+		normal[2] += (double)(cur->x - next->x) * (cur->y + next->y);
+	}
+
+	/* drop the coordinate the normal points along the most,
+	 * and mirror the plane so the face is counter-clockwise */
+	axis = fabs(normal[0]) > fabs(normal[1]) ? 0 : 1;
+	axis = fabs(normal[2]) > fabs(normal[axis]) ? 2 : axis;
+	for (uint32_t i = 0; i < corner_c; i++, edge = edge->next) {
+		float const coords[3] = { edge->vert->vec->x,
+			edge->vert->vec->y, edge->vert->vec->z };
+
+		uv[i][0] = coords[(axis + 1) % 3];
+		uv[i][1] = normal[axis] < 0 ? -coords[(axis + 2) % 3] :
+			coords[(axis + 2) % 3];
+	}
+
+	for (uint32_t i = 0; i < corner_c && convex; i++)
+		convex = corner_turn(uv[(i + corner_c - 1) % corner_c], uv[i],
+				uv[(i + 1) % corner_c]) >= 0;
+
+	if (convex) {
+		for (uint32_t i = 1; i + 1 < corner_c; i++) {
+			indices[pos++] = ids[0];
+			indices[pos++] = ids[i];
+			indices[pos++] = ids[i + 1];
+		}
+	} else {
+		clip_ears(ids, uv, corner_c, indices);
+	}
+
+	if (ids != stack_ids) {
+		free(ids);
+		free(uv);
+	}
+
+	return 3 * (corner_c - 2);
+}
+
+/**
+ * Triangulate all faces of an object. The corners are
+ * counted per face first, so every face has its exact slice.
+ *
+ * @param obj the object
+ * @return the newly allocated triangles
+ */
+static HE_tris *build_face_triangles(HE_obj const * const obj)
+{
+	HE_tris *tris = malloc(sizeof(*tris));
+
+	CHECK_PTR_VAL(tris);
+	tris->offsets = calloc(obj->fc + 1, sizeof(*tris->offsets));
+	CHECK_PTR_VAL(tris->offsets);
+
+	for (uint32_t i = 0; i < obj->fc; i++) {
+		uint32_t const corner_c = face_corner_c(&(obj->faces[i]));
+
+		tris->offsets[i + 1] = tris->offsets[i] +
+			(corner_c >= 3 ? 3 * (corner_c - 2) : 0);
+	}
+	tris->index_c = tris->offsets[obj->fc];
+
+	tris->indices = malloc(sizeof(*tris->indices) * (tris->index_c + 1));
+	CHECK_PTR_VAL(tris->indices);
+	for (uint32_t i = 0; i < obj->fc; i++)
+		triangulate_face(obj, &(obj->faces[i]),
+				tris->indices + tris->offsets[i]);
+
+	return tris;
+}
+
+/**
+ * Get the triangles of all faces of an object, which are
+ * built on first use and then kept until
+ * delete_face_triangles() or delete_object(). They must be
+ * deleted whenever the topology of the object changes, faces
+ * whose vertices move are updated by update_face_triangles().
+ * Moving and scaling the whole object keeps them valid.
+ *
+ * @param obj the object [mod]
+ * @return the triangles, NULL if obj is NULL
+ */
+HE_tris const *get_face_triangles(HE_obj *obj)
+{
+	if (!obj)
+		return NULL;
+
+	if (!obj->tris)
+		obj->tris = build_face_triangles(obj);
+
+	return obj->tris;
+}
+
+/**
+ * Triangulate some faces again, after their vertices moved,
+ * and leave all others alone. The faces must have the same
+ * count of corners as before. All of them are checked before
+ * any is changed, so on failure the triangles are untouched.
+ * If the triangles are not built yet, they are built for all
+ * faces. Bumps the version of the object, so that the buffers
+ * of render.c are uploaded again.
+ *
+ * @param obj the object [mod]
+ * @param faces indices of the faces which changed
+ * @param n count of faces
+ * @return true/false for success/failure
+ */
+bool update_face_triangles(HE_obj *obj,
+		uint32_t const *faces,
+		uint32_t n)
+{
+	HE_tris *tris;
+
+	if (!obj || (n && !faces))
+		return false;
+
+	if (!obj->tris) {
+		get_face_triangles(obj);
+		obj->version++;
+		return true;
+	}
+
+	tris = obj->tris;
+	for (uint32_t i = 0; i < n; i++) {
+		uint32_t const f = faces[i];
+		uint32_t corner_c;
+
+		if (f >= obj->fc)
+			return false;
+
+		corner_c = face_corner_c(&(obj->faces[f]));
+		if ((corner_c >= 3 ? 3 * (corner_c - 2) : 0) !=
+				tris->offsets[f + 1] - tris->offsets[f])
+			return false;
+	}
+
+	for (uint32_t i = 0; i < n; i++)
+		triangulate_face(obj, &(obj->faces[faces[i]]),
+				tris->indices + tris->offsets[faces[i]]);
+	if (n)
+		obj->version++;
+
+	return true;
+}
+
+/**
+ * Delete the triangles of an object, if any.
+ *
+ * @param obj the object [mod]
+ */
+void delete_face_triangles(HE_obj *obj)
+{
+	if (!obj || !obj->tris)
+		return;
+
+	free(obj->tris->offsets);
+	free(obj->tris->indices);
+	free(obj->tris);
+	obj->tris = NULL;
+}
@@ -0,0 +1,76 @@
+/*
+ * Copyright 2011-2014 hasufell
+ *
+ * This file is part of a hasufell project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation version 2 of the License only.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file half_edge_tris.h
+ * Header for the triangulation of the faces of a HE_obj.
+ * @brief header of half_edge_tris.c
+ */
+
+#ifndef _DROW_ENGINE_HE_TRIS_H
+#define _DROW_ENGINE_HE_TRIS_H
+
+
+#include "half_edge.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+
+/**
+ * Corners of a face up to which the triangulation works
+ * on the stack, bigger faces need a heap buffer.
+ */
+#define HE_TRIS_STACK_CORNERS 64
+
+
+/**
+ * The triangles of all faces as indices into the vertices
+ * array of the object, three per triangle and in the
+ * orientation of the face. A face with n corners has n - 2
+ * triangles, which are the indices indices[offsets[f]] up to
+ * indices[offsets[f + 1]] (exclusive). Faces with less than
+ * three corners have none.
+ */
+struct HE_tris {
+	/**
+	 * Start of the triangles of every face, fc + 1 entries.
+	 */
+	uint32_t *offsets;
+	/**
+	 * Indices of the corners of all triangles.
+	 */
+	uint32_t *indices;
+	/**
+	 * Count of indices.
+	 */
+	uint32_t index_c;
+};
+
+
+uint32_t triangulate_face(HE_obj const * const obj,
+		HE_face const * const face,
+		uint32_t *indices);
+HE_tris const *get_face_triangles(HE_obj *obj);
+bool update_face_triangles(HE_obj *obj,
+		uint32_t const *faces,
+		uint32_t n);
+void delete_face_triangles(HE_obj *obj);
+
+
+#endif /* _DROW_ENGINE_HE_TRIS_H */
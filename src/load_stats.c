@@ -0,0 +1,166 @@
+/*
+ * Copyright 2011-2014 hasufell
+ *
+ * This file is part of a hasufell project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation version 2 of the License only.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file load_stats.c
+ * Records what every stage of loading an object takes: the
+ * wall time, the change of the heap, the growth of the peak
+ * resident set size and the count of items. The parser only
+ * records them when built with -DLOAD_STATS, see load_stats.h.
+ * @brief statistics of loading an object
+ */
+
+#include "load_stats.h"
+
+#include <malloc.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <time.h>
+
+
+/**
+ * Names of the stages, indexed by load_stage.
+ */
+static char const * const stage_names[LOAD_STAGE_C] = {
+	"read",
+	"parse",
+	"stage1",
+	"stage2",
+	"stage3",
+	"cleanup",
+	"cache",
+};
+
+
+/**
+ * Reset all stages.
+ *
+ * @param stats the stats [out]
+ */
+void init_load_stats(load_stats *stats)
+{
+	if (stats)
+		memset(stats, 0, sizeof(*stats));
+}
+
+/**
+ * Sample the time, the heap and the peak resident set size.
+ * The heap includes the blocks malloc() maps on its own, but
+ * not the mappings of the arenas in files.
+ *
+ * @param sample the sample [out]
+ */
+void take_load_sample(load_sample *sample)
+{
+	struct timespec ts;
+	struct mallinfo2 mi = mallinfo2();
+	struct rusage ru;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	getrusage(RUSAGE_SELF, &ru);
+
+	sample->time = ts.tv_sec + ts.tv_nsec / 1e9;
+	sample->heap = (int64_t)(mi.uordblks + mi.hblkhd);
+	sample->peak_rss = ru.ru_maxrss;
+}
+
+/**
+ * Add what a stage took from its start up to now. A stage which
+ * runs several times, e.g. once per object, adds up.
+ *
+ * @param stats the stats [mod]
+ * @param stage the stage
+ * @param start the sample taken at the start of the stage
+ * @param items count of items, see load_stage
+ */
+void add_load_stage(load_stats *stats,
+		load_stage stage,
+		load_sample const *start,
+		uint64_t items)
+{
+	load_sample now;
+	load_stage_stats *st;
+
+	if (!stats || !start || stage >= LOAD_STAGE_C)
+		return;
+
+	take_load_sample(&now);
+	st = &(stats->stages[stage]);
+	st->seconds += now.time - start->time;
+	st->bytes += now.heap - start->heap;
+	st->peak_rss += now.peak_rss - start->peak_rss;
+	st->items += items;
+	st->ran = true;
+}
+
+/**
+ * Get the name of a stage.
+ *
+ * @param stage the stage
+ * @return the name, "unknown" for invalid stages
+ */
+char const *load_stage_name(load_stage stage)
+{
+	if (stage >= LOAD_STAGE_C)
+		return "unknown";
+
+	return stage_names[stage];
+}
+
+/**
+ * Print the stages which ran as a table, along with
+ * their sum.
+ *
+ * @param out the stream
+ * @param name what was loaded, e.g. the file name
+ * @param stats the stats
+ */
+void print_load_stats(FILE *out,
+		char const * const name,
+		load_stats const *stats)
+{
+	load_stage_stats total;
+
+	if (!out || !stats)
+		return;
+
+	memset(&total, 0, sizeof(total));
+
+	fprintf(out, "%s:\n", name ? name : "(unnamed)");
+	fprintf(out, "  %-8s %10s %12s %12s %12s\n",
+			"stage", "ms", "heap KiB", "peak KiB", "items");
+	for (uint32_t i = 0; i < LOAD_STAGE_C; i++) {
+		load_stage_stats const *st = &(stats->stages[i]);
+
+		if (!st->ran)
+			continue;
+
+		fprintf(out, "  %-8s %10.3f %12.1f %12lld %12llu\n",
+				stage_names[i], st->seconds * 1e3, st->bytes / 1024.0,
+				(long long)st->peak_rss, (unsigned long long)st->items);
+		total.seconds += st->seconds;
+		total.bytes += st->bytes;
+		total.peak_rss += st->peak_rss;
+	}
+	fprintf(out, "  %-8s %10.3f %12.1f %12lld\n",
+			"total", total.seconds * 1e3, total.bytes / 1024.0,
+			(long long)total.peak_rss);
+}
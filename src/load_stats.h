@@ -0,0 +1,197 @@
+/*
+ * Copyright 2011-2014 hasufell
+ *
+ * This file is part of a hasufell project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation version 2 of the License only.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file load_stats.h
+ * Header for the statistics of loading an object.
+ * @brief header of load_stats.c
+ */
+
+#ifndef _DROW_ENGINE_LOAD_STATS_H
+#define _DROW_ENGINE_LOAD_STATS_H
+
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+
+/**
+ * Whether the stats are recorded at all. They are only
+ * compiled in with -DLOAD_STATS (make LOAD_STATS=1), since
+ * taking a sample locks the allocator.
+ */
+#ifdef LOAD_STATS
+#define LOAD_STATS_ENABLED true
+#else
+#define LOAD_STATS_ENABLED false
+#endif
+
+/**
+ * Take a sample at the start of a stage, if the
+ * stats are compiled in and wanted.
+ */
+#ifdef LOAD_STATS
+#define LOAD_SAMPLE(stats, sample) \
+{ \
+	if (stats) \
+		take_load_sample(sample); \
+}
+#else
+#define LOAD_SAMPLE(stats, sample)
+#endif
+
+/**
+ * Add a stage to the stats, from a sample taken at its start
+ * up to now, if the stats are compiled in and wanted.
+ */
+#ifdef LOAD_STATS
+#define LOAD_STAGE_DONE(stats, stage, sample, items) \
+{ \
+	if (stats) \
+		add_load_stage(stats, stage, sample, items); \
+}
+#else
+#define LOAD_STAGE_DONE(stats, stage, sample, items)
+#endif
+
+
+typedef struct load_sample load_sample;
+typedef struct load_stage_stats load_stage_stats;
+typedef struct load_stats load_stats;
+
+
+/**
+ * The stages of loading an object, in the order they run.
+ * Items are what the stage produced or, for the cleanup,
+ * freed.
+ */
+enum load_stage {
+	/**
+	 * Checking the cache and mapping the file, items are
+	 * the bytes of the file.
+	 */
+	LOAD_STAGE_READ,
+	/**
+	 * Parsing the text into raw arrays in
+	 * assemble_obj_arrays(), items are the raw vertices,
+	 * normals, texture coordinates, faces and curves.
+	 */
+	LOAD_STAGE_PARSE,
+	/**
+	 * Vertices, normals and curves in assemble_HE_stage1(),
+	 * items are the vertices.
+	 */
+	LOAD_STAGE_STAGE1,
+	/**
+	 * Edges and faces in assemble_HE_stage2(), items are
+	 * the edges.
+	 */
+	LOAD_STAGE_STAGE2,
+	/**
+	 * Pairing the edges in assemble_HE_stage3(), items are
+	 * the dummy edges.
+	 */
+	LOAD_STAGE_STAGE3,
+	/**
+	 * Freeing the raw arrays in delete_raw_object(), items
+	 * are the raw faces.
+	 */
+	LOAD_STAGE_CLEANUP,
+	/**
+	 * Loading the object from its cache or writing the
+	 * cache, items are the faces.
+	 */
+	LOAD_STAGE_CACHE,
+	/**
+	 * Count of stages.
+	 */
+	LOAD_STAGE_C,
+};
+
+typedef enum load_stage load_stage;
+
+/**
+ * The state of the process at the start of a stage.
+ */
+struct load_sample {
+	/**
+	 * Monotonic time in seconds.
+	 */
+	double time;
+	/**
+	 * Bytes in use by malloc().
+	 */
+	int64_t heap;
+	/**
+	 * Peak resident set size in KiB.
+	 */
+	int64_t peak_rss;
+};
+
+/**
+ * What one stage took.
+ */
+struct load_stage_stats {
+	/**
+	 * Wall time in seconds.
+	 */
+	double seconds;
+	/**
+	 * Change of the bytes in use by malloc(), negative
+	 * if the stage freed more than it allocated.
+	 */
+	int64_t bytes;
+	/**
+	 * Growth of the peak resident set size in KiB.
+	 */
+	int64_t peak_rss;
+	/**
+	 * Count of items, see load_stage.
+	 */
+	uint64_t items;
+	/**
+	 * Whether the stage ran.
+	 */
+	bool ran;
+};
+
+/**
+ * What loading an object took, per stage.
+ */
+struct load_stats {
+	/**
+	 * The stages, indexed by load_stage.
+	 */
+	load_stage_stats stages[LOAD_STAGE_C];
+};
+
+
+void init_load_stats(load_stats *stats);
+void take_load_sample(load_sample *sample);
+void add_load_stage(load_stats *stats,
+		load_stage stage,
+		load_sample const *start,
+		uint64_t items);
+char const *load_stage_name(load_stage stage);
+void print_load_stats(FILE *out,
+		char const * const name,
+		load_stats const *stats);
+
+
+#endif /* _DROW_ENGINE_LOAD_STATS_H */
@@ -18,21 +18,30 @@
 
 /**
  * @file main.c
- * Takes argv[1] as parameter and passes
- * it to the glut functions for drawing the file
- * in a predefined scene.
+ * Takes the three .obj files from the command line and
+ * draws them in a predefined scene, in a window or, with
+ * --bench, offscreen for a count of frames. With --stats, what
+ * loading them took is printed, with --trace the profiled frames
+ * are written as a Chrome trace at the end. --sim-thread moves
+ * the simulation of the scene out of the rendering thread.
  * @brief program entry point
  */
 
+#include "gl_bench.h"
+#include "gl_draw.h"
 #include "gl_setup.h"
 #include "half_edge.h"
+#include "load_stats.h"
 #include "print.h"
+#include "profiler.h"
 #include "vector.h"
 
-#include <GL/glut.h>
 #include <GL/gl.h>
 #include <GL/glu.h>
+#include <stdbool.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include <SDL.h>
 
@@ -40,21 +49,88 @@
 /**
  * Program help text.
  */
-char const * const helptext = "Usage: drow-engine <center.obj>"
-" <float.obj> <bez.obj>\n";
+char const * const helptext = "Usage: drow-engine [--bench [frames]]"
+" [--stats]\n"
+"                   [--trace file] [--sim-thread]\n"
+"                   <center.obj> <float.obj> <bez.obj>\n"
+"\n"
+"  --bench [frames]  render the frames offscreen without a window\n"
+"                    and print their timings as JSON\n"
+"  --stats           print the time and memory every stage of\n"
+"                    loading the objects took to stderr, needs\n"
+"                    a build with LOAD_STATS=1\n"
+"  --trace file      write the last frames as a Chrome trace to\n"
+"                    the file at the end\n"
+"  --sim-thread      simulate the scene in a thread of its own\n";
 
 
 int main(int argc, char *argv[])
 {
-	if (argc != 4) {
+	bool bench = false,
+		 stats = false,
+		 sim_thread = false;
+	unsigned long frames = BENCH_DEFAULT_FRAMES;
+	load_stats obj_stats[3];
+	char const *trace = NULL;
+	int arg = 1;
+
+	while (arg < argc && !strncmp(argv[arg], "--", 2)) {
+		if (!strcmp(argv[arg], "--bench")) {
+			bench = true;
+			arg++;
+			/* the frame count is optional, the three files are not */
+			if (argc - arg >= 4 && strncmp(argv[arg], "--", 2)) {
+				char *end;
+
+				frames = strtoul(argv[arg], &end, 10);
+				if (*end || !frames || frames > UINT32_MAX) {
+					printf("%s", helptext);
+					return 1;
+				}
+				arg++;
+			}
+		} else if (!strcmp(argv[arg], "--stats")) {
+			stats = true;
+			arg++;
+		} else if (!strcmp(argv[arg], "--sim-thread")) {
+			sim_thread = true;
+			arg++;
+		} else if (!strcmp(argv[arg], "--trace") && arg + 1 < argc) {
+			trace = argv[arg + 1];
+			arg += 2;
+		} else {
+			printf("%s", helptext);
+			return 1;
+		}
+	}
+
+	if (argc - arg != 3) {
 		printf("%s", helptext);
 		return 1;
 	}
 
-	glutInit(&argc, argv);
+	if (stats && !LOAD_STATS_ENABLED)
+		fprintf(stderr, "Built without LOAD_STATS=1, "
+				"no load stats are recorded!\n");
+
+	init_object(argv[arg], argv[arg + 1], argv[arg + 2],
+			stats ? obj_stats : NULL);
 
-	init_object(argv[1], argv[2], argv[3]);
-	init_sdl_loop();
+	if (stats && LOAD_STATS_ENABLED)
+		for (uint32_t i = 0; i < 3; i++)
+			print_load_stats(stderr, argv[arg + i], &(obj_stats[i]));
+
+	if (bench) {
+		if (!run_render_bench((uint32_t)frames, stdout))
+			return 1;
+	} else {
+		init_sdl_loop(sim_thread);
+	}
+
+	if (trace && !save_profiler_trace(&frame_profiler, trace)) {
+		fprintf(stderr, "Failed to write trace to \"%s\"!\n", trace);
+		return 1;
+	}
 
 	return 0;
 }
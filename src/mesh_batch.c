@@ -0,0 +1,192 @@
+/*
+ * Copyright 2011-2014 hasufell
+ *
+ * This file is part of a hasufell project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation version 2 of the License only.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file mesh_batch.c
+ * Puts the vertices of an object once into an interleaved
+ * vertex array and its triangles into an index array, so that
+ * it can be drawn from vertex buffers with a single
+ * glDrawElements() instead of walking the half-edges of every
+ * face in every frame.
+ * The vertex normals are turned into lines the same way.
+ * @brief triangulated vertex arrays of objects
+ */
+
+#include "err.h"
+#include "half_edge.h"
+#include "half_edge_tris.h"
+#include "mesh_batch.h"
+#include "vector.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+/**
+ * Build the vertices and triangles of an object. The triangles
+ * are the ones of get_face_triangles(). The arrays of the batch
+ * are reused if they are big enough.
+ *
+ * @param obj the object, its triangles are built if
+ * necessary [mod]
+ * @param batch the batch, zeroed or from an earlier call [mod]
+ * @return true/false for success/failure
+ */
+bool build_mesh_batch(HE_obj * const obj,
+		mesh_batch *batch)
+{
+	HE_tris const *tris;
+	uint32_t index_c;
+	mesh_vertex *vertices;
+	uint32_t *indices;
+
+	if (!obj || !batch || (obj->fc && !obj->faces))
+		return false;
+
+	tris = get_face_triangles(obj);
+	index_c = tris->index_c;
+
+	vertices = realloc(batch->vertices, sizeof(*vertices) * (obj->vc + 1));
+	CHECK_PTR_VAL(vertices);
+	batch->vertices = vertices;
+	indices = realloc(batch->indices, sizeof(*indices) * (index_c + 1));
+	CHECK_PTR_VAL(indices);
+	batch->indices = indices;
+
+	for (uint32_t i = 0; i < obj->vc; i++) {
+		mesh_vertex *vert = &(vertices[i]);
+
+		vert->pos[0] = obj->positions[i].x;
+		vert->pos[1] = obj->positions[i].y;
+		vert->pos[2] = obj->positions[i].z;
+		if (obj->vn && obj->vnc == obj->vc) {
+			vert->normal[0] = obj->vn[i].x;
+			vert->normal[1] = obj->vn[i].y;
+			vert->normal[2] = obj->vn[i].z;
+		} else {
+			memset(vert->normal, 0, sizeof(vert->normal));
+		}
+	}
+	batch->vertex_c = obj->vc;
+	update_mesh_batch_colors(obj, batch);
+
+	memcpy(indices, tris->indices, sizeof(*indices) * index_c);
+	batch->index_c = index_c;
+	batch->version = obj->version;
+
+	return true;
+}
+
+/**
+ * Copy the colors of the vertices of an object into the batch,
+ * which has to be built from the object. Colors which are not
+ * set yet (-1) are taken as black.
+ *
+ * @param obj the object
+ * @param batch the batch [mod]
+ * @return true/false for success/failure
+ */
+bool update_mesh_batch_colors(HE_obj const * const obj,
+		mesh_batch *batch)
+{
+	if (!obj || !batch || batch->vertex_c != obj->vc)
+		return false;
+
+	for (uint32_t i = 0; i < obj->vc; i++) {
+		color const *col = obj->vertices[i].col;
+		float *c = batch->vertices[i].color;
+
+		c[0] = col && col->red >= 0 ? (float)col->red : 0;
+		c[1] = col && col->green >= 0 ? (float)col->green : 0;
+		c[2] = col && col->blue >= 0 ? (float)col->blue : 0;
+	}
+	batch->version = obj->version;
+
+	return true;
+}
+
+/**
+ * Free the arrays of a batch and zero it.
+ *
+ * @param batch the batch [mod]
+ */
+void delete_mesh_batch(mesh_batch *batch)
+{
+	if (!batch)
+		return;
+
+	free(batch->vertices);
+	free(batch->indices);
+	memset(batch, 0, sizeof(*batch));
+}
+
+/**
+ * Build the lines of the vertex normals of an object, each
+ * one from the vertex to its normal scaled by the given
+ * factor. The array of the lines is reused if it is big
+ * enough. The object needs one normal per vertex.
+ *
+ * @param obj the object
+ * @param scale the length of the lines
+ * @param lines the lines, zeroed or from an earlier call [mod]
+ * @return true/false for success/failure
+ */
+bool build_normal_lines(HE_obj const * const obj,
+		float scale,
+		normal_lines *lines)
+{
+	vector *points;
+
+	if (!obj || !lines || obj->vnc != obj->vc || (obj->vc && !obj->vn))
+		return false;
+
+	points = realloc(lines->points, sizeof(*points) * (2 * obj->vc + 1));
+	CHECK_PTR_VAL(points);
+	lines->points = points;
+
+	for (uint32_t i = 0; i < obj->vc; i++) {
+		vector const *pos = &(obj->positions[i]),
+			  *vn = &(obj->vn[i]);
+
+		points[2 * i] = *pos;
+		points[2 * i + 1].x = pos->x + vn->x * scale;
+		points[2 * i + 1].y = pos->y + vn->y * scale;
+		points[2 * i + 1].z = pos->z + vn->z * scale;
+	}
+	lines->point_c = 2 * obj->vc;
+	lines->scale = scale;
+	lines->version = obj->version;
+
+	return true;
+}
+
+/**
+ * Free the array of the normal lines and zero them.
+ *
+ * @param lines the lines [mod]
+ */
+void delete_normal_lines(normal_lines *lines)
+{
+	if (!lines)
+		return;
+
+	free(lines->points);
+	memset(lines, 0, sizeof(*lines));
+}
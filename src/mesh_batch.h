@@ -0,0 +1,136 @@
+/*
+ * Copyright 2011-2014 hasufell
+ *
+ * This file is part of a hasufell project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation version 2 of the License only.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file mesh_batch.h
+ * Header for the triangulated, interleaved vertex arrays of
+ * objects, as they are uploaded into vertex buffers.
+ * @brief header of mesh_batch.c
+ */
+
+#ifndef _DROW_ENGINE_MESH_BATCH_H
+#define _DROW_ENGINE_MESH_BATCH_H
+
+
+#include "half_edge.h"
+#include "vector.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+
+/**
+ * Fault intolerant macro. Will abort the program if the called
+ * function failed.
+ */
+#define BUILD_MESH_BATCH(...) \
+{ \
+	if (!build_mesh_batch(__VA_ARGS__)) { \
+		fprintf(stderr, "Failure in build_mesh_batch()!\n"); \
+		abort(); \
+	} \
+}
+
+
+typedef struct mesh_vertex mesh_vertex;
+typedef struct mesh_batch mesh_batch;
+typedef struct normal_lines normal_lines;
+
+
+/**
+ * One vertex with all its attributes, interleaved.
+ */
+struct mesh_vertex {
+	/**
+	 * Position.
+	 */
+	float pos[3];
+	/**
+	 * Normal, 0 if the object has no vertex normals.
+	 */
+	float normal[3];
+	/**
+	 * Color.
+	 */
+	float color[3];
+};
+
+/**
+ * The triangles of an object, one mesh_vertex per vertex
+ * of the object and three indices per triangle, from the
+ * triangulation of half_edge_tris.c.
+ */
+struct mesh_batch {
+	/**
+	 * The vertices, in the same order as in the object.
+	 */
+	mesh_vertex *vertices;
+	/**
+	 * Count of vertices.
+	 */
+	uint32_t vertex_c;
+	/**
+	 * Indices of the corners of all triangles.
+	 */
+	uint32_t *indices;
+	/**
+	 * Count of indices, three times the count of triangles.
+	 */
+	uint32_t index_c;
+	/**
+	 * The version of the object the batch was built from.
+	 */
+	uint32_t version;
+};
+
+/**
+ * The vertex normals of an object as lines, from every
+ * vertex to the tip of its scaled normal.
+ */
+struct normal_lines {
+	/**
+	 * End points of the lines, two per vertex.
+	 */
+	vector *points;
+	/**
+	 * Count of end points.
+	 */
+	uint32_t point_c;
+	/**
+	 * Length of the lines.
+	 */
+	float scale;
+	/**
+	 * The version of the object the lines were built from.
+	 */
+	uint32_t version;
+};
+
+
+bool build_mesh_batch(HE_obj * const obj,
+		mesh_batch *batch);
+bool update_mesh_batch_colors(HE_obj const * const obj,
+		mesh_batch *batch);
+void delete_mesh_batch(mesh_batch *batch);
+bool build_normal_lines(HE_obj const * const obj,
+		float scale,
+		normal_lines *lines);
+void delete_normal_lines(normal_lines *lines);
+
+
+#endif /* _DROW_ENGINE_MESH_BATCH_H */
@@ -0,0 +1,315 @@
+/*
+ * Copyright 2011-2014 hasufell
+ *
+ * This file is part of a hasufell project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation version 2 of the License only.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file mesh_bounds.c
+ * Computes the bounding box, centroid and scale factor of
+ * a set of positions in a single pass over them, and moves and
+ * scales them in a second one. Both passes are vectorized and
+ * split over threads for big meshes, so they are limited by
+ * the memory bandwidth rather than by the arithmetic.
+ * @brief bounds of meshes
+ */
+
+#include "err.h"
+#include "half_edge.h"
+#include "mesh_bounds.h"
+#include "vector.h"
+#include "vector_simd.h"
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+
+typedef struct bounds_part bounds_part;
+
+
+/**
+ * The part of the positions one thread works on.
+ */
+struct bounds_part {
+	/**
+	 * All positions.
+	 */
+	vector *positions;
+	/**
+	 * First position of the part.
+	 */
+	uint32_t start;
+	/**
+	 * End of the positions of the part (exclusive).
+	 */
+	uint32_t end;
+	/**
+	 * Smallest coordinates of the part.
+	 */
+	vector min;
+	/**
+	 * Largest coordinates of the part.
+	 */
+	vector max;
+	/**
+	 * Sums of the coordinates of the part.
+	 */
+	double sum[3];
+	/**
+	 * The offset of transform_positions().
+	 */
+	vector offset;
+	/**
+	 * The scale factor of transform_positions().
+	 */
+	float scale;
+};
+
+
+/*
+ * static function declaration
+ */
+static uint32_t count_bounds_parts(uint32_t n, unsigned threads);
+static void run_bounds_parts(void *(*fn)(void*),
+		bounds_part *parts,
+		uint32_t part_c);
+static void *bounds_of_part(void *arg);
+static void *transform_part(void *arg);
+
+
+/**
+ * Decide how many threads to use, so that each one gets at
+ * least MESH_BOUNDS_PART_MIN positions.
+ *
+ * @param n count of positions
+ * @param threads the maximum count of threads, 0 to use
+ * one per online CPU
+ * @return count of parts, at least 1
+ */
+static uint32_t count_bounds_parts(uint32_t n, unsigned threads)
+{
+	uint32_t const max_c = n / MESH_BOUNDS_PART_MIN;
+
+	if (!threads) {
+		long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+		threads = cpus > 0 ? (unsigned)cpus : 1;
+	}
+
+	if (max_c < threads)
+		threads = max_c;
+
+	return threads ? threads : 1;
+}
+
+/**
+ * Run a function on all parts, the first one in
+ * the calling thread.
+ *
+ * @param fn the function
+ * @param parts the parts
+ * @param part_c count of parts
+ */
+static void run_bounds_parts(void *(*fn)(void*),
+		bounds_part *parts,
+		uint32_t part_c)
+{
+	pthread_t *tids = malloc(sizeof(*tids) * part_c);
+
+	CHECK_PTR_VAL(tids);
+
+	for (uint32_t i = 1; i < part_c; i++)
+		if (pthread_create(&(tids[i]), NULL, fn, &(parts[i])))
+			ABORT("Failed to create bounds thread!\n");
+	fn(&(parts[0]));
+	for (uint32_t i = 1; i < part_c; i++)
+		if (pthread_join(tids[i], NULL))
+			ABORT("Failed to join bounds thread!\n");
+
+	free(tids);
+}
+
+/**
+ * Compute the bounding box and the sums of a part.
+ *
+ * @param arg the bounds_part, with the range set [mod]
+ * @return NULL
+ */
+static void *bounds_of_part(void *arg)
+{
+	bounds_part *part = arg;
+
+	vec_batch_bounds(part->positions + part->start,
+			part->end - part->start, &(part->min), &(part->max),
+			part->sum);
+
+	return NULL;
+}
+
+/**
+ * Move and scale the positions of a part.
+ *
+ * @param arg the bounds_part, with the range, offset and
+ * scale set [mod]
+ * @return NULL
+ */
+static void *transform_part(void *arg)
+{
+	bounds_part *part = arg;
+
+	vec_batch_translate_scale(part->positions + part->start,
+			part->positions + part->start, part->end - part->start,
+			part->offset, part->scale);
+
+	return NULL;
+}
+
+/**
+ * Compute the bounding box, the centroid and the scale factor
+ * of a set of positions in one pass. With no positions,
+ * all vectors are null vectors and the scale is 1.
+ *
+ * @param positions the positions
+ * @param n count of positions
+ * @param threads the maximum count of threads, 0 to use
+ * one per online CPU
+ * @param bounds the bounds [out]
+ * @return true/false for success/failure
+ */
+bool positions_bounds(vector const *positions,
+		uint32_t n,
+		unsigned threads,
+		mesh_bounds *bounds)
+{
+	uint32_t const part_c = count_bounds_parts(n, threads);
+	bounds_part *parts;
+	double sum[3] = { 0, 0, 0 };
+	float extent = 0;
+
+	if (!bounds || (n && !positions))
+		return false;
+
+	if (!n) {
+		SET_NULL_VECTOR(&(bounds->min));
+		SET_NULL_VECTOR(&(bounds->max));
+		SET_NULL_VECTOR(&(bounds->center));
+		bounds->scale = 1;
+		return true;
+	}
+
+	parts = calloc(part_c, sizeof(*parts));
+	CHECK_PTR_VAL(parts);
+	for (uint32_t i = 0; i < part_c; i++) {
+		/* the parts only read them */
+		parts[i].positions = (vector*)positions;
+		parts[i].start = (uint64_t)n * i / part_c;
+		parts[i].end = (uint64_t)n * (i + 1) / part_c;
+	}
+	run_bounds_parts(bounds_of_part, parts, part_c);
+
+	bounds->min = parts[0].min;
+	bounds->max = parts[0].max;
+	for (uint32_t i = 0; i < part_c; i++) {
+		vector const *lo = &(parts[i].min),
+			  *hi = &(parts[i].max);
+
+		bounds->min.x = lo->x < bounds->min.x ? lo->x : bounds->min.x;
+		bounds->min.y = lo->y < bounds->min.y ? lo->y : bounds->min.y;
+		bounds->min.z = lo->z < bounds->min.z ? lo->z : bounds->min.z;
+		bounds->max.x = hi->x > bounds->max.x ? hi->x : bounds->max.x;
+		bounds->max.y = hi->y > bounds->max.y ? hi->y : bounds->max.y;
+		bounds->max.z = hi->z > bounds->max.z ? hi->z : bounds->max.z;
+		sum[0] += parts[i].sum[0];
+		sum[1] += parts[i].sum[1];
+		sum[2] += parts[i].sum[2];
+	}
+	free(parts);
+
+	bounds->center.x = (float)(sum[0] / n);
+	bounds->center.y = (float)(sum[1] / n);
+	bounds->center.z = (float)(sum[2] / n);
+
+	if (bounds->max.x - bounds->min.x > extent)
+		extent = bounds->max.x - bounds->min.x;
+	if (bounds->max.y - bounds->min.y > extent)
+		extent = bounds->max.y - bounds->min.y;
+	if (bounds->max.z - bounds->min.z > extent)
+		extent = bounds->max.z - bounds->min.z;
+	bounds->scale = extent > 0 ? 1 / extent : 1;
+
+	return true;
+}
+
+/**
+ * Compute the bounding box, the centroid and the scale factor
+ * of the vertices of an object. See positions_bounds().
+ *
+ * @param obj the object
+ * @param threads the maximum count of threads, 0 to use
+ * one per online CPU
+ * @param bounds the bounds [out]
+ * @return true/false for success/failure
+ */
+bool get_mesh_bounds(HE_obj const * const obj,
+		unsigned threads,
+		mesh_bounds *bounds)
+{
+	if (!obj)
+		return false;
+
+	return positions_bounds(obj->positions, obj->vc, threads, bounds);
+}
+
+/**
+ * Move positions by an offset and then scale them, in place.
+ *
+ * @param positions the positions [mod]
+ * @param n count of positions
+ * @param offset the offset, NULL to only scale
+ * @param scale the scale factor
+ * @param threads the maximum count of threads, 0 to use
+ * one per online CPU
+ * @return true/false for success/failure
+ */
+bool transform_positions(vector *positions,
+		uint32_t n,
+		vector const *offset,
+		float scale,
+		unsigned threads)
+{
+	uint32_t const part_c = count_bounds_parts(n, threads);
+	bounds_part *parts;
+
+	if (n && !positions)
+		return false;
+
+	parts = calloc(part_c, sizeof(*parts));
+	CHECK_PTR_VAL(parts);
+	for (uint32_t i = 0; i < part_c; i++) {
+		parts[i].positions = positions;
+		parts[i].start = (uint64_t)n * i / part_c;
+		parts[i].end = (uint64_t)n * (i + 1) / part_c;
+		if (offset)
+			parts[i].offset = *offset;
+		parts[i].scale = scale;
+	}
+	run_bounds_parts(transform_part, parts, part_c);
+	free(parts);
+
+	return true;
+}
@@ -0,0 +1,99 @@
+/*
+ * Copyright 2011-2014 hasufell
+ *
+ * This file is part of a hasufell project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation version 2 of the License only.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file mesh_bounds.h
+ * Header for the bounding box, centroid and scale factor
+ * of meshes.
+ * @brief header of mesh_bounds.c
+ */
+
+#ifndef _DROW_ENGINE_MESH_BOUNDS_H
+#define _DROW_ENGINE_MESH_BOUNDS_H
+
+
+#include "half_edge.h"
+#include "vector.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+
+/**
+ * Fault intolerant macro. Will abort the program if the called
+ * function failed.
+ */
+#define GET_MESH_BOUNDS(...) \
+{ \
+	if (!get_mesh_bounds(__VA_ARGS__)) { \
+		fprintf(stderr, "Failure in get_mesh_bounds()!\n"); \
+		abort(); \
+	} \
+}
+
+/**
+ * Minimum count of positions every thread gets, below that
+ * starting a thread costs more than it saves.
+ */
+#define MESH_BOUNDS_PART_MIN (256 * 1024)
+
+
+typedef struct mesh_bounds mesh_bounds;
+
+
+/**
+ * The bounds of a set of positions.
+ */
+struct mesh_bounds {
+	/**
+	 * Smallest coordinates, the lower corner of the
+	 * axis-aligned bounding box.
+	 */
+	vector min;
+	/**
+	 * Largest coordinates, the upper corner of the
+	 * axis-aligned bounding box.
+	 */
+	vector max;
+	/**
+	 * Mean of all positions, summed up in double precision.
+	 */
+	vector center;
+	/**
+	 * Factor which scales the longest side of the bounding
+	 * box to 1, or 1 if the box is flat in all directions.
+	 */
+	float scale;
+};
+
+
+bool positions_bounds(vector const *positions,
+		uint32_t n,
+		unsigned threads,
+		mesh_bounds *bounds);
+bool get_mesh_bounds(HE_obj const * const obj,
+		unsigned threads,
+		mesh_bounds *bounds);
+bool transform_positions(vector *positions,
+		uint32_t n,
+		vector const *offset,
+		float scale,
+		unsigned threads);
+
+
+#endif /* _DROW_ENGINE_MESH_BOUNDS_H */
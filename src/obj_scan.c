@@ -0,0 +1,466 @@
+/*
+ * Copyright 2011-2014 hasufell
+ *
+ * This file is part of a hasufell project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation version 2 of the License only.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file obj_scan.c
+ * A small hand-written scanner for the .obj text format.
+ * It walks a buffer which is neither NULL-terminated nor
+ * writable by pointer, never allocates in the common case
+ * and does not depend on the locale, not even in the
+ * strtod_l() fallback.
+ * All functions take a position which is advanced and the
+ * end of the region they may look at, usually the end
+ * of the current line.
+ * @brief .obj text scanner
+ */
+
+#include "err.h"
+#include "obj_scan.h"
+
+#include <locale.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+/**
+ * Mantissas are accumulated as long as they stay below
+ * this value, so that another digit can never overflow.
+ */
+#define MANT_LIMIT UINT64_C(1000000000000000000)
+
+/**
+ * Largest integer which is exactly representable as a double.
+ */
+#define MANT_EXACT (UINT64_C(1) << 53)
+
+/**
+ * Size of the stack buffer used for the strtod_l() fallback.
+ */
+#define SLOW_BUF 128
+
+
+/*
+ * static function declaration
+ */
+static void init_c_locale(void);
+static bool scan_double_slow(char const *start,
+		char const *end,
+		double *out);
+
+
+/**
+ * All powers of ten which are exactly representable
+ * as a double.
+ */
+static double const pow10_exact[] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+	1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20,
+	1e21, 1e22
+};
+
+/**
+ * Makes sure c_locale is only created once, by whichever
+ * parser thread gets there first.
+ */
+static pthread_once_t c_locale_once = PTHREAD_ONCE_INIT;
+
+/**
+ * The C locale, for converting numbers in the fallback
+ * whatever LC_NUMERIC the host program set.
+ */
+static locale_t c_locale;
+
+
+/**
+ * Create the C locale used by scan_double_slow().
+ */
+static void init_c_locale(void)
+{
+	c_locale = newlocale(LC_ALL_MASK, "C", (locale_t)0);
+}
+
+/**
+ * Convert a number with strtod_l() in the C locale, which is
+ * correctly rounded for every input and reads a '.' as the
+ * decimal point, whatever the locale of the program is.
+ * Only used for numbers the fast path in scan_double()
+ * can't represent exactly.
+ *
+ * @param start start of the number
+ * @param end end of the number (exclusive)
+ * @param out the converted number [out]
+ * @return true/false for success/failure
+ */
+static bool scan_double_slow(char const *start,
+		char const *end,
+		double *out)
+{
+	char buf[SLOW_BUF],
+		 *str = buf;
+	size_t len = end - start;
+
+	if (pthread_once(&c_locale_once, init_c_locale) ||
+			c_locale == (locale_t)0)
+		ABORT("Failed to create the C locale!\n");
+
+	if (len >= SLOW_BUF) {
+		str = malloc(len + 1);
+		CHECK_PTR_VAL(str);
+	}
+
+	memcpy(str, start, len);
+	str[len] = '\0';
+	*out = strtod_l(str, NULL, c_locale);
+
+	if (str != buf)
+		free(str);
+
+	return true;
+}
+
+/**
+ * Find the end of the line which starts at pos.
+ *
+ * @param pos start of the line
+ * @param end end of the buffer
+ * @return pointer to the newline character or end if
+ * there is none
+ */
+char const *scan_line_end(char const *pos, char const *end)
+{
+	char const *line_end = memchr(pos, '\n', end - pos);
+
+	return line_end ? line_end : end;
+}
+
+/**
+ * Get the next word, skipping leading blanks.
+ *
+ * @param pos the current position, which is advanced behind
+ * the returned word [mod]
+ * @param end the end of the line
+ * @param len the length of the word [out]
+ * @return pointer to the start of the word or NULL if there
+ * are no words left
+ */
+char const *scan_word(char const **pos,
+		char const *end,
+		size_t *len)
+{
+	char const *p = *pos,
+		  *word;
+
+	while (p < end && SCAN_IS_BLANK(*p))
+		p++;
+
+	if (p == end) {
+		*pos = p;
+		return NULL;
+	}
+
+	word = p;
+	while (p < end && !SCAN_IS_BLANK(*p))
+		p++;
+
+	*len = p - word;
+	*pos = p;
+
+	return word;
+}
+
+/**
+ * Scan the keyword at the beginning of a line.
+ *
+ * @param pos start of the line, which is advanced behind the
+ * keyword [mod]
+ * @param end the end of the line
+ * @return the keyword, OBJ_KW_NONE for empty lines, comments
+ * and everything unsupported
+ */
+obj_keyword scan_keyword(char const **pos, char const *end)
+{
+	size_t len;
+	char const *word = scan_word(pos, end, &len);
+
+	if (!word)
+		return OBJ_KW_NONE;
+
+	switch (len) {
+	case 1:
+		if (word[0] == 'v')
+			return OBJ_KW_V;
+		else if (word[0] == 'f')
+			return OBJ_KW_F;
+		break;
+	case 2:
+		if (word[0] == 'v' && word[1] == 'n')
+			return OBJ_KW_VN;
+		else if (word[0] == 'v' && word[1] == 't')
+			return OBJ_KW_VT;
+		break;
+	case 4:
+		if (!memcmp(word, "curv", 4))
+			return OBJ_KW_CURV;
+		break;
+	}
+
+	return OBJ_KW_NONE;
+}
+
+/**
+ * Convert the decimal floating point number at pos.
+ * Mantissas up to 2^53 with decimal exponents up to +-22
+ * (which covers virtually every number in an .obj file)
+ * are converted with a single exactly rounded multiplication
+ * or division (Clinger's fast path), everything else falls
+ * back to strtod_l() in the C locale. The result is always
+ * identical to strtod() in the C locale, whatever locale the
+ * program runs in.
+ *
+ * @param pos the position of the number, which is advanced
+ * behind the number on success [mod]
+ * @param end the end of the line
+ * @param out the converted number [out]
+ * @return true if a number was found, false otherwise
+ */
+bool scan_double(char const **pos, char const *end, double *out)
+{
+	char const *p = *pos,
+		  *start = *pos;
+	bool neg = false,
+		 digits = false,
+		 inexact = false;
+	uint64_t mant = 0;
+	int32_t exp10 = 0;
+
+	if (p < end && (*p == '-' || *p == '+')) {
+		neg = (*p == '-');
+		p++;
+	}
+
+	/* integer part */
+	while (p < end && SCAN_IS_DIGIT(*p)) {
+		if (mant < MANT_LIMIT) {
+			mant = mant * 10 + (*p - '0');
+		} else {
+			exp10++;
+			if (*p != '0')
+				inexact = true;
+		}
+		digits = true;
+		p++;
+	}
+
+	/* fraction */
+	if (p < end && *p == '.') {
+		p++;
+		while (p < end && SCAN_IS_DIGIT(*p)) {
+			if (mant < MANT_LIMIT) {
+				mant = mant * 10 + (*p - '0');
+				exp10--;
+			} else if (*p != '0') {
+				inexact = true;
+			}
+			digits = true;
+			p++;
+		}
+	}
+
+	if (!digits)
+		return false;
+
+	/* exponent, only consumed if it has digits */
+	if (p < end && (*p == 'e' || *p == 'E')) {
+		char const *e = p + 1;
+		bool exp_neg = false;
+		int32_t exp_val = 0;
+
+		if (e < end && (*e == '-' || *e == '+')) {
+			exp_neg = (*e == '-');
+			e++;
+		}
+
+		if (e < end && SCAN_IS_DIGIT(*e)) {
+			while (e < end && SCAN_IS_DIGIT(*e)) {
+				if (exp_val < 100000)
+					exp_val = exp_val * 10 + (*e - '0');
+				e++;
+			}
+			exp10 += exp_neg ? -exp_val : exp_val;
+			p = e;
+		}
+	}
+
+	*pos = p;
+
+	if (!inexact && mant <= MANT_EXACT &&
+			exp10 >= -22 && exp10 <= 22) {
+		double val = (double)mant;
+
+		if (exp10 < 0)
+			val /= pow10_exact[-exp10];
+		else
+			val *= pow10_exact[exp10];
+
+		*out = neg ? -val : val;
+
+		return true;
+	}
+
+	return scan_double_slow(start, p, out);
+}
+
+/**
+ * Convert the unsigned decimal integer at pos.
+ * Values which don't fit into 32 bit saturate.
+ *
+ * @param pos the position of the number, which is advanced
+ * behind the number on success [mod]
+ * @param end the end of the line
+ * @param out the converted number [out]
+ * @return true if a number was found, false otherwise
+ */
+bool scan_uint(char const **pos, char const *end, uint32_t *out)
+{
+	char const *p = *pos;
+	uint64_t val = 0;
+
+	if (p == end || !SCAN_IS_DIGIT(*p))
+		return false;
+
+	while (p < end && SCAN_IS_DIGIT(*p)) {
+		val = val * 10 + (*p - '0');
+		if (val > UINT32_MAX)
+			val = UINT32_MAX;
+		p++;
+	}
+
+	*out = (uint32_t)val;
+	*pos = p;
+
+	return true;
+}
+
+/**
+ * Skip the remainder of the current word.
+ *
+ * @param pos the current position [mod]
+ * @param end the end of the line
+ */
+void scan_skip_word(char const **pos, char const *end)
+{
+	char const *p = *pos;
+
+	while (p < end && !SCAN_IS_BLANK(*p))
+		p++;
+
+	*pos = p;
+}
+
+/**
+ * Scan all remaining words of a line as floating point numbers,
+ * as in "v 0.3 0.2 -1.2". Words which are no numbers count
+ * as 0, trailing garbage of a word is ignored.
+ *
+ * @param pos the current position, which is advanced to the
+ * end of the line [mod]
+ * @param end the end of the line
+ * @param out the array to store the numbers in [out]
+ * @param max the size of out, further numbers are only counted
+ * @return the count of numbers found on the line
+ */
+uint8_t scan_doubles(char const **pos,
+		char const *end,
+		double *out,
+		uint8_t max)
+{
+	char const *p = *pos;
+	uint8_t i = 0;
+
+	while (1) {
+		double val;
+
+		while (p < end && SCAN_IS_BLANK(*p))
+			p++;
+
+		if (p == end)
+			break;
+
+		if (!scan_double(&p, end, &val))
+			val = 0;
+		scan_skip_word(&p, end);
+
+		if (i < max)
+			out[i] = val;
+		if (i < UINT8_MAX)
+			i++;
+	}
+
+	*pos = p;
+
+	return i;
+}
+
+/**
+ * Scan the next face element such as "3", "3/1", "3//2"
+ * or "3/1/2".
+ *
+ * @param pos the current position, which is advanced behind the
+ * element [mod]
+ * @param end the end of the line
+ * @param v the vertex index [out]
+ * @param vt the texture coordinate index, 0 if there is none [out]
+ * @return true if an element was found, false at the end of the line
+ */
+bool scan_face_index(char const **pos,
+		char const *end,
+		uint32_t *v,
+		uint32_t *vt)
+{
+	char const *p = *pos;
+
+	while (1) {
+		while (p < end && SCAN_IS_BLANK(*p))
+			p++;
+
+		if (p == end) {
+			*pos = p;
+			return false;
+		}
+
+		/* skip words without a leading vertex index */
+		if (scan_uint(&p, end, v))
+			break;
+
+		scan_skip_word(&p, end);
+	}
+
+	*vt = 0;
+	if (p < end && *p == '/') {
+		p++;
+		scan_uint(&p, end, vt);
+	}
+	scan_skip_word(&p, end);
+
+	*pos = p;
+
+	return true;
+}
@@ -0,0 +1,82 @@
+/*
+ * Copyright 2011-2014 hasufell
+ *
+ * This file is part of a hasufell project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation version 2 of the License only.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file obj_scan.h
+ * Header for the external API of obj_scan.c
+ * @brief header of obj_scan.c
+ */
+
+#ifndef _DROW_ENGINE_OBJ_SCAN_H
+#define _DROW_ENGINE_OBJ_SCAN_H
+
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+
+/**
+ * Whether the character separates words on a line.
+ * Carriage returns count as blanks, so dos line endings
+ * and trailing whitespace are harmless.
+ */
+#define SCAN_IS_BLANK(c) \
+	((c) == ' ' || (c) == '\t' || (c) == '\r' || \
+	 (c) == '\v' || (c) == '\f')
+
+/**
+ * Whether the character is a decimal digit.
+ */
+#define SCAN_IS_DIGIT(c) \
+	((unsigned char)((c) - '0') < 10)
+
+
+/**
+ * The keywords of an .obj line which are known
+ * to the scanner.
+ */
+typedef enum obj_keyword {
+	OBJ_KW_NONE, /**< comments, empty lines and unsupported items */
+	OBJ_KW_V, /**< "v", vertex */
+	OBJ_KW_VN, /**< "vn", vertex normal */
+	OBJ_KW_VT, /**< "vt", vertex texture coordinate */
+	OBJ_KW_F, /**< "f", face */
+	OBJ_KW_CURV, /**< "curv", bezier curve */
+} obj_keyword;
+
+
+char const *scan_line_end(char const *pos, char const *end);
+char const *scan_word(char const **pos,
+		char const *end,
+		size_t *len);
+obj_keyword scan_keyword(char const **pos, char const *end);
+bool scan_double(char const **pos, char const *end, double *out);
+bool scan_uint(char const **pos, char const *end, uint32_t *out);
+void scan_skip_word(char const **pos, char const *end);
+uint8_t scan_doubles(char const **pos,
+		char const *end,
+		double *out,
+		uint8_t max);
+bool scan_face_index(char const **pos,
+		char const *end,
+		uint32_t *v,
+		uint32_t *vt);
+
+
+#endif /* _DROW_ENGINE_OBJ_SCAN_H */
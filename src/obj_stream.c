@@ -0,0 +1,621 @@
+/*
+ * Copyright 2011-2014 hasufell
+ *
+ * This file is part of a hasufell project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation version 2 of the License only.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file obj_stream.c
+ * A parser for obj files which may be bigger than the memory.
+ * The file is read through a window of bounded size and the raw
+ * arrays are collected in growth buffers, which move into mappings
+ * of temporary files once the memory ceiling is reached. The same
+ * happens to the arrays of the assembled object.
+ *
+ * Only small per-vertex tables of the assembly in half_edge_AS.c
+ * are outside of the ceiling, everything else is accounted for.
+ * @brief streaming obj parser
+ */
+
+#include "arena.h"
+#include "err.h"
+#include "filereader.h"
+#include "half_edge.h"
+#include "obj_scan.h"
+#include "obj_stream.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+
+/**
+ * Initial capacity of a growth buffer, which is
+ * doubled whenever it runs full.
+ */
+#define STREAM_BUF_MIN (64 * 1024)
+
+/**
+ * Count of doubles stored per vertex, as
+ * scan_doubles() may need one more than used.
+ */
+#define STREAM_VEC_LEN 4
+
+
+typedef struct stream_buf stream_buf;
+typedef struct obj_stream obj_stream;
+
+
+/**
+ * A buffer which grows by doubling, either on the heap or,
+ * once that would exceed the memory ceiling, as a shared
+ * mapping of a temporary file.
+ */
+struct stream_buf {
+	/**
+	 * The content.
+	 */
+	char *data;
+	/**
+	 * Used bytes.
+	 */
+	size_t len;
+	/**
+	 * Allocated or mapped bytes.
+	 */
+	size_t cap;
+	/**
+	 * The temporary file, -1 while on the heap.
+	 */
+	int fd;
+};
+
+/**
+ * State of the streaming parser.
+ */
+struct obj_stream {
+	obj_stream_opts opts;
+	/**
+	 * Never NULL.
+	 */
+	obj_stream_stats *stats;
+	/**
+	 * Heap memory currently held by the parser.
+	 */
+	size_t mem;
+	/**
+	 * STREAM_VEC_LEN doubles per vertex.
+	 */
+	stream_buf v;
+	/**
+	 * STREAM_VEC_LEN doubles per vertex normal.
+	 */
+	stream_buf vn;
+	/**
+	 * The vertex indices of all faces as uint32_t,
+	 * every face terminated by 0.
+	 */
+	stream_buf f;
+	/**
+	 * The vertex indices of all bezier curves as int,
+	 * every curve terminated by 0.
+	 */
+	stream_buf bez;
+	uint32_t vc, vnc, vtc, fc, ec, bzc;
+};
+
+
+/*
+ * static function declaration
+ */
+static void stream_mem_add(obj_stream *s, size_t size);
+static void stream_buf_init(stream_buf *buf);
+static void *stream_buf_reserve(obj_stream *s,
+		stream_buf *buf,
+		size_t size);
+static void stream_buf_release(obj_stream *s, stream_buf *buf);
+static void scan_stream_vector(obj_stream *s,
+		stream_buf *buf,
+		char const **pos,
+		char const *end);
+static void parse_stream_lines(obj_stream *s,
+		char const *pos,
+		char const *end);
+static bool read_stream(obj_stream *s, int fd);
+static double **stream_vector_rows(obj_stream *s,
+		stream_buf *rows,
+		stream_buf const *buf,
+		uint32_t count);
+static uint32_t **stream_face_rows(obj_stream *s, stream_buf *rows);
+static int **stream_bez_rows(obj_stream *s, stream_buf *rows);
+
+
+/**
+ * Account for heap memory taken by the parser.
+ *
+ * @param s the parser [mod]
+ * @param size the size taken
+ */
+static void stream_mem_add(obj_stream *s, size_t size)
+{
+	s->mem += size;
+	if (s->mem > s->stats->mem_peak)
+		s->stats->mem_peak = s->mem;
+}
+
+/**
+ * Initialize an empty growth buffer.
+ *
+ * @param buf the buffer [out]
+ */
+static void stream_buf_init(stream_buf *buf)
+{
+	buf->data = NULL;
+	buf->len = 0;
+	buf->cap = 0;
+	buf->fd = -1;
+}
+
+/**
+ * Make room for more bytes at the end of a growth buffer.
+ * If growing it on the heap would exceed the memory ceiling,
+ * it is moved into a temporary file and grows there from
+ * then on. Aborts the program if that fails.
+ *
+ * @param s the parser [mod]
+ * @param buf the buffer [mod]
+ * @param size the count of bytes
+ * @return the end of the used bytes, which is followed by
+ * at least size free bytes; len is not changed
+ */
+static void *stream_buf_reserve(obj_stream *s,
+		stream_buf *buf,
+		size_t size)
+{
+	size_t cap = buf->cap ? buf->cap : STREAM_BUF_MIN;
+	char *data;
+
+	if (buf->len + size <= buf->cap)
+		return buf->data + buf->len;
+
+	while (cap < buf->len + size)
+		cap *= 2;
+
+	if (buf->fd == -1 && s->mem - buf->cap + cap <= s->opts.mem_limit) {
+		data = realloc(buf->data, cap);
+		CHECK_PTR_VAL(data);
+		stream_mem_add(s, cap - buf->cap);
+	} else if (buf->fd == -1) {
+		int fd = open_temp_file(s->opts.spill_dir);
+
+		if (fd == -1 || ftruncate(fd, cap))
+			ABORT("Failed to create a temporary file for the parser!\n");
+		data = mmap(NULL, cap, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		if (data == MAP_FAILED)
+			ABORT("Failed to map a temporary file of the parser!\n");
+
+		if (buf->len)
+			memcpy(data, buf->data, buf->len);
+		free(buf->data);
+		s->mem -= buf->cap;
+
+		buf->fd = fd;
+		s->stats->spilled += cap;
+	} else {
+		if (ftruncate(buf->fd, cap))
+			ABORT("Failed to grow a temporary file of the parser!\n");
+		data = mremap(buf->data, buf->cap, cap, MREMAP_MAYMOVE);
+		if (data == MAP_FAILED)
+			ABORT("Failed to map a temporary file of the parser!\n");
+
+		s->stats->spilled += cap - buf->cap;
+	}
+
+	buf->data = data;
+	buf->cap = cap;
+
+	return buf->data + buf->len;
+}
+
+/**
+ * Release a growth buffer, including its temporary file.
+ *
+ * @param s the parser [mod]
+ * @param buf the buffer [mod]
+ */
+static void stream_buf_release(obj_stream *s, stream_buf *buf)
+{
+	if (buf->fd != -1) {
+		munmap(buf->data, buf->cap);
+		close(buf->fd);
+	} else {
+		free(buf->data);
+		s->mem -= buf->cap;
+	}
+
+	stream_buf_init(buf);
+}
+
+/**
+ * Scan the coordinates of a "v" or "vn" line into
+ * a growth buffer. Missing coordinates are 0.
+ *
+ * @param s the parser [mod]
+ * @param buf the buffer [mod]
+ * @param pos the position behind the keyword [mod]
+ * @param end the end of the line
+ */
+static void scan_stream_vector(obj_stream *s,
+		stream_buf *buf,
+		char const **pos,
+		char const *end)
+{
+	double *row = stream_buf_reserve(s, buf, sizeof(*row) * STREAM_VEC_LEN);
+
+	for (uint32_t i = 0; i < STREAM_VEC_LEN; i++)
+		row[i] = 0;
+
+	if (scan_doubles(pos, end, row, STREAM_VEC_LEN) > 3)
+		ABORT("Malformed vertice exceeds 3 dimensions!\n");
+
+	buf->len += sizeof(*row) * STREAM_VEC_LEN;
+}
+
+/**
+ * Parse complete lines of the file into the raw arrays,
+ * the same way parse_obj_chunk() in half_edge_AS.c does.
+ * Texture coordinates are only counted, since the
+ * assembly doesn't use them.
+ *
+ * @param s the parser [mod]
+ * @param pos the start of the lines
+ * @param end the end of the lines
+ */
+static void parse_stream_lines(obj_stream *s,
+		char const *pos,
+		char const *end)
+{
+	while (pos < end) {
+		char const *line_end = scan_line_end(pos, end);
+		uint32_t v_id,
+				 vt_id;
+
+		switch (scan_keyword(&pos, line_end)) {
+		case OBJ_KW_V:
+			scan_stream_vector(s, &(s->v), &pos, line_end);
+			s->vc++;
+			break;
+
+		case OBJ_KW_VN:
+			scan_stream_vector(s, &(s->vn), &pos, line_end);
+			s->vnc++;
+			break;
+
+		case OBJ_KW_VT: {
+			double vt[STREAM_VEC_LEN];
+
+			if (scan_doubles(&pos, line_end, vt, STREAM_VEC_LEN) > 3)
+				ABORT("Malformed vertice texture exceeds 3 dimensions!\n");
+			s->vtc++;
+			break;
+		}
+
+		case OBJ_KW_F:
+			/* rows are terminated by 0, so we can iterate over them */
+			while (scan_face_index(&pos, line_end, &v_id, &vt_id)) {
+				uint32_t *id = stream_buf_reserve(s, &(s->f), sizeof(*id));
+
+				*id = v_id;
+				s->f.len += sizeof(*id);
+				s->ec++;
+			}
+			*(uint32_t*)stream_buf_reserve(s, &(s->f), sizeof(uint32_t)) = 0;
+			s->f.len += sizeof(uint32_t);
+			s->fc++;
+			break;
+
+		case OBJ_KW_CURV:
+			while (scan_face_index(&pos, line_end, &v_id, &vt_id)) {
+				int *id = stream_buf_reserve(s, &(s->bez), sizeof(*id));
+
+				*id = v_id;
+				s->bez.len += sizeof(*id);
+			}
+			*(int*)stream_buf_reserve(s, &(s->bez), sizeof(int)) = 0;
+			s->bez.len += sizeof(int);
+			s->bzc++;
+			break;
+
+		default:
+			break;
+		}
+
+		/* vertex indices go into the upper bits of the pairing keys */
+		if (s->vc > (UINT32_MAX >> 1) || s->ec > (UINT32_MAX >> 1))
+			ABORT("Object exceeds the maximum count of vertices or edges!\n");
+
+		pos = (line_end < end) ? line_end + 1 : end;
+	}
+}
+
+/**
+ * Read the whole file through the window and parse it.
+ * Only complete lines are parsed, the incomplete last line
+ * of a window is moved to its front and completed by the
+ * next read. The window only grows if a single line
+ * doesn't fit into it.
+ *
+ * @param s the parser [mod]
+ * @param fd the file
+ * @return true/false for success/failure
+ */
+static bool read_stream(obj_stream *s, int fd)
+{
+	size_t size = s->opts.window,
+		   have = 0;
+	char *window = malloc(size);
+	bool ret = true;
+
+	CHECK_PTR_VAL(window);
+	stream_mem_add(s, size);
+
+	while (1) {
+		ssize_t n = read(fd, window + have, size - have);
+		char *split;
+
+		if (n == -1 && errno == EINTR)
+			continue;
+		if (n == -1) {
+			ret = false;
+			break;
+		}
+		if (n == 0) { /* the last line may lack a newline */
+			parse_stream_lines(s, window, window + have);
+			break;
+		}
+
+		s->stats->windows++;
+		s->stats->bytes += (size_t)n;
+		have += (size_t)n;
+
+		split = window + have;
+		while (split > window && split[-1] != '\n')
+			split--;
+
+		if (split == window) {
+			if (have == size) {
+				window = realloc(window, size * 2);
+				CHECK_PTR_VAL(window);
+				stream_mem_add(s, size);
+				size *= 2;
+			}
+			continue;
+		}
+
+		parse_stream_lines(s, window, split);
+		have -= split - window;
+		memmove(window, split, have);
+	}
+
+	free(window);
+	s->mem -= size;
+
+	return ret;
+}
+
+/**
+ * Build the array of row pointers for the vectors in a
+ * growth buffer, as the assembly expects them.
+ *
+ * @param s the parser [mod]
+ * @param rows the growth buffer of the row pointers [mod]
+ * @param buf the buffer of the vectors, which must not grow
+ * anymore
+ * @param count count of vectors
+ * @return the NULL-terminated row pointers
+ */
+static double **stream_vector_rows(obj_stream *s,
+		stream_buf *rows,
+		stream_buf const *buf,
+		uint32_t count)
+{
+	double **ptrs = stream_buf_reserve(s, rows, sizeof(*ptrs) * (count + 1));
+	double *vec = (double*)buf->data;
+
+	for (uint32_t i = 0; i < count; i++)
+		ptrs[i] = vec + (size_t)i * STREAM_VEC_LEN;
+	ptrs[count] = NULL;
+	rows->len += sizeof(*ptrs) * (count + 1);
+
+	return ptrs;
+}
+
+/**
+ * Build the array of row pointers for the 0-terminated
+ * face rows, as the assembly expects them.
+ *
+ * @param s the parser [mod]
+ * @param rows the growth buffer of the row pointers [mod]
+ * @return the NULL-terminated row pointers
+ */
+static uint32_t **stream_face_rows(obj_stream *s, stream_buf *rows)
+{
+	uint32_t **ptrs = stream_buf_reserve(s, rows,
+			sizeof(*ptrs) * (s->fc + 1));
+	uint32_t *row = (uint32_t*)s->f.data;
+
+	for (uint32_t i = 0; i < s->fc; i++) {
+		ptrs[i] = row;
+		while (*row)
+			row++;
+		row++;
+	}
+	ptrs[s->fc] = NULL;
+	rows->len += sizeof(*ptrs) * (s->fc + 1);
+
+	return ptrs;
+}
+
+/**
+ * Build the array of row pointers for the 0-terminated
+ * bezier curve rows, as the assembly expects them.
+ * Empty rows get a NULL pointer, like in parse_obj_chunk().
+ *
+ * @param s the parser [mod]
+ * @param rows the growth buffer of the row pointers [mod]
+ * @return the NULL-terminated row pointers
+ */
+static int **stream_bez_rows(obj_stream *s, stream_buf *rows)
+{
+	int **ptrs = stream_buf_reserve(s, rows, sizeof(*ptrs) * (s->bzc + 1));
+	int *row = (int*)s->bez.data;
+
+	for (uint32_t i = 0; i < s->bzc; i++) {
+		ptrs[i] = *row ? row : NULL;
+		while (*row)
+			row++;
+		row++;
+	}
+	ptrs[s->bzc] = NULL;
+	rows->len += sizeof(*ptrs) * (s->bzc + 1);
+
+	return ptrs;
+}
+
+/**
+ * Parse an .obj file of any size and return a HE_obj
+ * that represents the whole object. The result is exactly
+ * the same as the one of read_obj_file() without a cache.
+ * The file is never mapped or read as a whole: it is read
+ * front to back through a window of bounded size, while the
+ * raw arrays and the arrays of the object are kept on the heap
+ * only as long as they fit below the memory ceiling. Beyond
+ * that they live in shared mappings of temporary files, which
+ * the kernel can write back and drop under memory pressure.
+ *
+ * @param filename the file
+ * @param opts the options, NULL for the defaults
+ * @param stats what the parser did, may be NULL [out]
+ * @return the HE_obj or NULL for failure, including empty files
+ */
+HE_obj *parse_obj_stream(char const * const filename,
+		obj_stream_opts const * const opts,
+		obj_stream_stats *stats)
+{
+	obj_stream s;
+	obj_stream_stats local_stats;
+	stream_buf v_rows,
+			   vn_rows,
+			   f_rows,
+			   bez_rows;
+	obj_items raw_obj;
+	FACES raw_f;
+	HE_obj *he_obj = NULL;
+	size_t size;
+	int fd;
+
+	if (!filename)
+		return NULL;
+
+	s.opts.window = OBJ_STREAM_WINDOW;
+	s.opts.mem_limit = OBJ_STREAM_MEM_LIMIT;
+	s.opts.spill_dir = NULL;
+	if (opts)
+		s.opts = *opts;
+	if (!s.opts.window)
+		s.opts.window = OBJ_STREAM_WINDOW;
+
+	s.stats = stats ? stats : &local_stats;
+	memset(s.stats, 0, sizeof(*s.stats));
+	s.mem = 0;
+	s.vc = s.vnc = s.vtc = s.fc = s.ec = s.bzc = 0;
+	stream_buf_init(&(s.v));
+	stream_buf_init(&(s.vn));
+	stream_buf_init(&(s.f));
+	stream_buf_init(&(s.bez));
+	stream_buf_init(&v_rows);
+	stream_buf_init(&vn_rows);
+	stream_buf_init(&f_rows);
+	stream_buf_init(&bez_rows);
+
+	if ((fd = open(filename, O_RDONLY)) == -1)
+		return NULL;
+
+	/* we walk the file strictly front to back */
+	posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+	if (!read_stream(&s, fd) || !s.stats->bytes)
+		goto cleanup;
+
+	/*
+	 * the raw arrays, as the assembly expects them
+	 */
+	raw_obj.v = stream_vector_rows(&s, &v_rows, &(s.v), s.vc);
+	raw_obj.vn = stream_vector_rows(&s, &vn_rows, &(s.vn), s.vnc);
+	raw_obj.vt = NULL;
+	raw_f.v = stream_face_rows(&s, &f_rows);
+	raw_f.vt = NULL;
+	raw_obj.f = &raw_f;
+	raw_obj.bez = s.bzc ? stream_bez_rows(&s, &bez_rows) : NULL;
+	arena_init(&(raw_obj.mem), 0);
+
+	he_obj = malloc(sizeof(*he_obj));
+	CHECK_PTR_VAL(he_obj);
+	he_obj->vc = s.vc;
+	he_obj->vnc = s.vnc;
+	he_obj->vtc = s.vtc;
+	he_obj->fc = s.fc;
+	he_obj->ec = s.ec;
+
+	/*
+	 * he_obj member allocation, all from one arena
+	 */
+	he_obj->mem = malloc(sizeof(*he_obj->mem));
+	CHECK_PTR_VAL(he_obj->mem);
+	size = obj_items_arena_size(&raw_obj, he_obj);
+	if (s.mem + size > s.opts.mem_limit) {
+		int obj_fd = open_temp_file(s.opts.spill_dir);
+
+		if (obj_fd == -1 || !arena_init_file(he_obj->mem, size, obj_fd))
+			ABORT("Failed to create a temporary file for the object!\n");
+		close(obj_fd);
+
+		s.stats->spilled += size;
+		s.stats->obj_spilled = true;
+	} else {
+		arena_init(he_obj->mem, size);
+		stream_mem_add(&s, size);
+	}
+
+	assemble_obj_items(&raw_obj, he_obj, 1);
+
+cleanup:
+	close(fd);
+	stream_buf_release(&s, &(s.v));
+	stream_buf_release(&s, &(s.vn));
+	stream_buf_release(&s, &(s.f));
+	stream_buf_release(&s, &(s.bez));
+	stream_buf_release(&s, &v_rows);
+	stream_buf_release(&s, &vn_rows);
+	stream_buf_release(&s, &f_rows);
+	stream_buf_release(&s, &bez_rows);
+
+	return he_obj;
+}
@@ -0,0 +1,110 @@
+/*
+ * Copyright 2011-2014 hasufell
+ *
+ * This file is part of a hasufell project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation version 2 of the License only.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file obj_stream.h
+ * Header for the streaming obj parser.
+ * @brief header of obj_stream.c
+ */
+
+#ifndef _DROW_ENGINE_OBJ_STREAM_H
+#define _DROW_ENGINE_OBJ_STREAM_H
+
+
+#include "half_edge.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+
+/**
+ * Default size of the window the file is read through.
+ */
+#define OBJ_STREAM_WINDOW (4 * 1024 * 1024)
+
+/**
+ * Default memory ceiling of the streaming parser.
+ */
+#define OBJ_STREAM_MEM_LIMIT ((size_t)1024 * 1024 * 1024)
+
+
+typedef struct obj_stream_opts obj_stream_opts;
+typedef struct obj_stream_stats obj_stream_stats;
+
+
+/**
+ * Options of the streaming parser.
+ */
+struct obj_stream_opts {
+	/**
+	 * Size of the window the file is read through. It only
+	 * grows if a single line doesn't fit into it.
+	 */
+	size_t window;
+	/**
+	 * Ceiling for the heap memory of the parser, which
+	 * includes the read window, the raw arrays and the final
+	 * object. Buffers which would exceed it are moved into
+	 * mappings of temporary files instead, so 0 moves
+	 * everything but the read window.
+	 */
+	size_t mem_limit;
+	/**
+	 * Directory of the temporary files, NULL for $TMPDIR
+	 * or /tmp.
+	 */
+	char const *spill_dir;
+};
+
+/**
+ * What the streaming parser did, to check it against
+ * the memory ceiling.
+ */
+struct obj_stream_stats {
+	/**
+	 * Count of reads into the window.
+	 */
+	size_t windows;
+	/**
+	 * Size of the file.
+	 */
+	size_t bytes;
+	/**
+	 * Highest amount of heap memory held by the parser at
+	 * once. It stays below the memory ceiling, unless the
+	 * read window exceeds it or has to grow for long lines.
+	 */
+	size_t mem_peak;
+	/**
+	 * Size of all temporary files.
+	 */
+	size_t spilled;
+	/**
+	 * Whether the arrays of the object live in
+	 * a temporary file.
+	 */
+	bool obj_spilled;
+};
+
+
+HE_obj *parse_obj_stream(char const * const filename,
+		obj_stream_opts const * const opts,
+		obj_stream_stats *stats);
+
+
+#endif /* _DROW_ENGINE_OBJ_STREAM_H */
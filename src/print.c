@@ -62,9 +62,9 @@ void print_vertices(HE_obj *obj)
 
 	printf("vertices: %d\n", obj->vc);
 	for (uint32_t i = 0; i < obj->vc; i++) {
-		printf("x[%d]: %f\n", i, obj->vertices[i].vec->x);
-		printf("y[%d]: %f\n", i, obj->vertices[i].vec->y);
-		printf("z[%d]: %f\n", i, obj->vertices[i].vec->z);
+		printf("x[%d]: %f\n", i, obj->positions[i].x);
+		printf("y[%d]: %f\n", i, obj->positions[i].y);
+		printf("z[%d]: %f\n", i, obj->positions[i].z);
 		printf("\n");
 	}
 }
@@ -0,0 +1,343 @@
+/*
+ * Copyright 2011-2014 hasufell
+ *
+ * This file is part of a hasufell project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation version 2 of the License only.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file profiler.c
+ * Times the zones of every frame, e.g. the draw_* calls of
+ * draw_scene(), into a ring buffer of the last frames. They can
+ * be averaged for an overlay or written as a Chrome trace, which
+ * chrome://tracing or https://ui.perfetto.dev show as a timeline.
+ * The times are wall times on the CPU, OpenGL may still be busy
+ * with the commands of a zone after it ended.
+ * @brief frame profiler
+ */
+
+#include "profiler.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+
+/**
+ * Marks a span on the stack which was dropped, since the
+ * frame had no room left.
+ */
+#define DROPPED_SPAN UINT32_MAX
+
+
+/*
+ * static function declaration
+ */
+static double profiler_now(void);
+static profile_frame *current_frame(profiler *prof);
+static profile_frame const *past_frame(profiler const *prof,
+		uint32_t age);
+
+
+/**
+ * Names of the zones, indexed by profile_zone.
+ */
+static char const * const zone_names[PROFILE_ZONE_C] = {
+	"draw_obj",
+	"draw_normals",
+	"draw_vertices",
+	"draw_bez",
+	"draw_bez_frame",
+	"draw_ship",
+	"draw_Planet_1",
+	"draw_Planet_2",
+	"overlay",
+};
+
+
+/**
+ * Get a monotonic timestamp.
+ *
+ * @return the time in seconds
+ */
+static double profiler_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ * Get the frame which is being recorded.
+ *
+ * @param prof the profiler
+ * @return the frame
+ */
+static profile_frame *current_frame(profiler *prof)
+{
+	return &(prof->frames[prof->frame_c % PROFILER_FRAMES]);
+}
+
+/**
+ * Get an ended frame.
+ *
+ * @param prof the profiler
+ * @param age 0 for the last ended frame, 1 for the one
+ * before and so on, less than the count of kept frames
+ * @return the frame
+ */
+static profile_frame const *past_frame(profiler const *prof,
+		uint32_t age)
+{
+	return &(prof->frames[(prof->frame_c - 1 - age) % PROFILER_FRAMES]);
+}
+
+/**
+ * Start a frame, ending the current one if there is any.
+ *
+ * @param prof the profiler [mod]
+ */
+void profiler_begin_frame(profiler *prof)
+{
+	profile_frame *frame;
+
+	if (!prof)
+		return;
+
+	if (prof->in_frame)
+		profiler_end_frame(prof);
+
+	frame = current_frame(prof);
+	frame->start = profiler_now();
+	frame->end = 0;
+	frame->span_c = 0;
+	prof->depth = 0;
+	prof->in_frame = true;
+}
+
+/**
+ * End the current frame, along with all zones which
+ * are still open.
+ *
+ * @param prof the profiler [mod]
+ */
+void profiler_end_frame(profiler *prof)
+{
+	if (!prof || !prof->in_frame)
+		return;
+
+	while (prof->depth)
+		profiler_pop(prof);
+	current_frame(prof)->end = profiler_now();
+
+	prof->frame_c++;
+	prof->in_frame = false;
+}
+
+/**
+ * Start a zone in the current frame, nested in the open ones.
+ * Outside of a frame, this does nothing.
+ *
+ * @param prof the profiler [mod]
+ * @param zone the zone
+ */
+void profiler_push(profiler *prof, profile_zone zone)
+{
+	profile_frame *frame;
+
+	if (!prof || !prof->in_frame)
+		return;
+
+	frame = current_frame(prof);
+	if (prof->depth < PROFILER_DEPTH) {
+		if (frame->span_c < PROFILER_SPANS) {
+			profile_span *span = &(frame->spans[frame->span_c]);
+
+			span->zone = (uint8_t)zone;
+			span->depth = (uint8_t)prof->depth;
+			span->end = 0;
+			prof->stack[prof->depth] = frame->span_c++;
+			span->start = profiler_now();
+		} else {
+			prof->stack[prof->depth] = DROPPED_SPAN;
+		}
+	}
+	prof->depth++;
+}
+
+/**
+ * End the innermost open zone.
+ *
+ * @param prof the profiler [mod]
+ */
+void profiler_pop(profiler *prof)
+{
+	double const now = profiler_now();
+
+	if (!prof || !prof->in_frame || !prof->depth)
+		return;
+
+	prof->depth--;
+	if (prof->depth < PROFILER_DEPTH &&
+			prof->stack[prof->depth] != DROPPED_SPAN)
+		current_frame(prof)->spans[prof->stack[prof->depth]].end = now;
+}
+
+/**
+ * Average the last ended frames.
+ *
+ * @param prof the profiler
+ * @param frames count of frames to average, at most
+ * PROFILER_FRAMES are kept
+ * @param sum the averages [out]
+ * @return false if there are no ended frames yet
+ */
+bool profiler_summary(profiler const *prof,
+		uint32_t frames,
+		profile_summary *sum)
+{
+	uint32_t n = frames;
+
+	if (!sum)
+		return false;
+	memset(sum, 0, sizeof(*sum));
+	if (!prof)
+		return false;
+
+	if (n > PROFILER_FRAMES)
+		n = PROFILER_FRAMES;
+	if (n > prof->frame_c)
+		n = (uint32_t)prof->frame_c;
+	if (!n)
+		return false;
+
+	for (uint32_t i = 0; i < n; i++) {
+		profile_frame const *frame = past_frame(prof, i);
+
+		sum->cpu_ms += (frame->end - frame->start) * 1e3;
+		for (uint32_t j = 0; j < frame->span_c; j++) {
+			profile_span const *span = &(frame->spans[j]);
+
+			sum->zone_ms[span->zone] += (span->end - span->start) * 1e3;
+			sum->zone_ran[span->zone] = true;
+		}
+	}
+
+	sum->frames = n;
+	sum->cpu_ms /= n;
+	for (uint32_t i = 0; i < PROFILE_ZONE_C; i++)
+		sum->zone_ms[i] /= n;
+
+	if (n > 1) {
+		sum->frame_ms = (past_frame(prof, 0)->start -
+				past_frame(prof, n - 1)->start) * 1e3 / (n - 1);
+		if (sum->frame_ms > 0)
+			sum->fps = 1e3 / sum->frame_ms;
+	}
+
+	return true;
+}
+
+/**
+ * Write the kept frames as a Chrome trace, with one complete
+ * event per frame and per zone. The times are in microseconds
+ * from the start of the oldest frame.
+ *
+ * @param prof the profiler
+ * @param out the stream
+ * @return true/false for success/failure
+ */
+bool write_profiler_trace(profiler const *prof, FILE *out)
+{
+	uint32_t n;
+	double origin;
+	bool first = true;
+
+	if (!prof || !out)
+		return false;
+
+	n = prof->frame_c < PROFILER_FRAMES ?
+		(uint32_t)prof->frame_c : PROFILER_FRAMES;
+	origin = n ? past_frame(prof, n - 1)->start : 0;
+
+	fprintf(out, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [");
+	for (uint32_t i = n; i-- > 0;) {
+		profile_frame const *frame = past_frame(prof, i);
+
+		fprintf(out, "%s\n{\"name\": \"frame\", \"cat\": \"frame\", "
+				"\"ph\": \"X\", \"pid\": 1, \"tid\": 1, "
+				"\"ts\": %.3f, \"dur\": %.3f, \"args\": {\"frame\": %llu}}",
+				first ? "" : ",",
+				(frame->start - origin) * 1e6,
+				(frame->end - frame->start) * 1e6,
+				(unsigned long long)(prof->frame_c - 1 - i));
+		first = false;
+
+		for (uint32_t j = 0; j < frame->span_c; j++) {
+			profile_span const *span = &(frame->spans[j]);
+
+			fprintf(out, ",\n{\"name\": \"%s\", \"cat\": \"draw\", "
+					"\"ph\": \"X\", \"pid\": 1, \"tid\": 1, "
+					"\"ts\": %.3f, \"dur\": %.3f}",
+					zone_names[span->zone],
+					(span->start - origin) * 1e6,
+					(span->end - span->start) * 1e6);
+		}
+	}
+	fprintf(out, "\n]}\n");
+
+	return !ferror(out);
+}
+
+/**
+ * Write the kept frames as a Chrome trace into a file,
+ * see write_profiler_trace().
+ *
+ * @param prof the profiler
+ * @param filename the file, which is overwritten
+ * @return true/false for success/failure
+ */
+bool save_profiler_trace(profiler const *prof,
+		char const * const filename)
+{
+	FILE *out;
+	bool ret;
+
+	if (!prof || !filename)
+		return false;
+
+	if (!(out = fopen(filename, "w")))
+		return false;
+	ret = write_profiler_trace(prof, out);
+
+	return !fclose(out) && ret;
+}
+
+/**
+ * Get the name of a zone.
+ *
+ * @param zone the zone
+ * @return the name, "unknown" for invalid zones
+ */
+char const *profile_zone_name(profile_zone zone)
+{
+	if (zone >= PROFILE_ZONE_C)
+		return "unknown";
+
+	return zone_names[zone];
+}
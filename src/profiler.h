@@ -0,0 +1,205 @@
+/*
+ * Copyright 2011-2014 hasufell
+ *
+ * This file is part of a hasufell project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation version 2 of the License only.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file profiler.h
+ * Header for the frame profiler.
+ * @brief header of profiler.c
+ */
+
+#ifndef _DROW_ENGINE_PROFILER_H
+#define _DROW_ENGINE_PROFILER_H
+
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+
+/**
+ * Count of frames the profiler keeps, the older ones
+ * are overwritten.
+ */
+#define PROFILER_FRAMES 256
+
+/**
+ * Maximum count of zones per frame, further ones are
+ * dropped.
+ */
+#define PROFILER_SPANS 64
+
+/**
+ * Maximum nesting of zones.
+ */
+#define PROFILER_DEPTH 8
+
+/**
+ * File the trace is written to when pressing P.
+ */
+#define PROFILER_TRACE_FILE "drow-engine-trace.json"
+
+
+typedef struct profile_span profile_span;
+typedef struct profile_frame profile_frame;
+typedef struct profiler profiler;
+typedef struct profile_summary profile_summary;
+
+
+/**
+ * The parts of a frame which are timed.
+ */
+enum profile_zone {
+	PROFILE_DRAW_OBJ,
+	PROFILE_DRAW_NORMALS,
+	PROFILE_DRAW_VERTICES,
+	PROFILE_DRAW_BEZ,
+	PROFILE_DRAW_BEZ_FRAME,
+	PROFILE_DRAW_SHIP,
+	PROFILE_DRAW_PLANET_1,
+	PROFILE_DRAW_PLANET_2,
+	PROFILE_DRAW_OVERLAY,
+	/**
+	 * Count of zones.
+	 */
+	PROFILE_ZONE_C,
+};
+
+typedef enum profile_zone profile_zone;
+
+
+/**
+ * One timed zone of a frame.
+ */
+struct profile_span {
+	/**
+	 * Start in seconds.
+	 */
+	double start;
+	/**
+	 * End in seconds, 0 while the zone is open.
+	 */
+	double end;
+	/**
+	 * The zone.
+	 */
+	uint8_t zone;
+	/**
+	 * Count of zones it is nested in.
+	 */
+	uint8_t depth;
+};
+
+/**
+ * One frame and its zones, in the order they started.
+ */
+struct profile_frame {
+	/**
+	 * Start in seconds.
+	 */
+	double start;
+	/**
+	 * End in seconds.
+	 */
+	double end;
+	/**
+	 * Count of spans.
+	 */
+	uint32_t span_c;
+	/**
+	 * The spans.
+	 */
+	profile_span spans[PROFILER_SPANS];
+};
+
+/**
+ * The last PROFILER_FRAMES frames. A zeroed one is empty
+ * and ready to use.
+ */
+struct profiler {
+	/**
+	 * Ring buffer of the frames.
+	 */
+	profile_frame frames[PROFILER_FRAMES];
+	/**
+	 * Count of frames ended so far, the next frame goes to
+	 * frames[frame_c % PROFILER_FRAMES].
+	 */
+	uint64_t frame_c;
+	/**
+	 * Whether a frame is open.
+	 */
+	bool in_frame;
+	/**
+	 * Indices of the open spans of the current frame.
+	 */
+	uint32_t stack[PROFILER_DEPTH];
+	/**
+	 * Count of open spans, including the ones which were
+	 * dropped.
+	 */
+	uint32_t depth;
+};
+
+/**
+ * Averages over the last frames.
+ */
+struct profile_summary {
+	/**
+	 * Count of frames averaged.
+	 */
+	uint32_t frames;
+	/**
+	 * Frames per second, from the starts of the frames, so
+	 * that the time between draw_scene() calls counts too.
+	 * 0 with less than two frames.
+	 */
+	double fps;
+	/**
+	 * Milliseconds between the starts of two frames.
+	 */
+	double frame_ms;
+	/**
+	 * Milliseconds from the start to the end of a frame.
+	 */
+	double cpu_ms;
+	/**
+	 * Milliseconds per zone and frame, nested zones
+	 * included.
+	 */
+	double zone_ms[PROFILE_ZONE_C];
+	/**
+	 * Whether a zone ran at all.
+	 */
+	bool zone_ran[PROFILE_ZONE_C];
+};
+
+
+void profiler_begin_frame(profiler *prof);
+void profiler_end_frame(profiler *prof);
+void profiler_push(profiler *prof, profile_zone zone);
+void profiler_pop(profiler *prof);
+bool profiler_summary(profiler const *prof,
+		uint32_t frames,
+		profile_summary *sum);
+bool write_profiler_trace(profiler const *prof, FILE *out);
+bool save_profiler_trace(profiler const *prof,
+		char const * const filename);
+char const *profile_zone_name(profile_zone zone);
+
+
+#endif /* _DROW_ENGINE_PROFILER_H */
@@ -0,0 +1,424 @@
+/*
+ * Copyright 2011-2014 hasufell
+ *
+ * This file is part of a hasufell project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation version 2 of the License only.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file render.c
+ * Draws objects from vertex buffer objects: the triangles of
+ * the faces are put together once by mesh_batch.c and
+ * uploaded, and every frame is a single glDrawElements()
+ * call. The buffers are only uploaded again when the version
+ * of the object changes. The vertex normals and the polylines
+ * of bezier curves are drawn as lines from a buffer the same way.
+ * @brief vertex buffer renderer
+ */
+
+/* glGenBuffers() and friends are OpenGL 1.5 */
+#define GL_GLEXT_PROTOTYPES
+
+#include "bezier.h"
+#include "bezier_arc.h"
+#include "err.h"
+#include "half_edge.h"
+#include "mesh_batch.h"
+#include "render.h"
+#include "vector.h"
+
+#include <GL/gl.h>
+#include <GL/glext.h>
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+
+/**
+ * Maximum count of errors clear_gl_errors() takes off the
+ * queue, without a context glGetError() may never run dry.
+ */
+#define GL_ERROR_MAX 32
+
+
+/*
+ * globals
+ */
+render_stats draw_stats;
+
+
+/*
+ * static function declaration
+ */
+static void clear_gl_errors(void);
+
+
+/**
+ * Take the errors earlier OpenGL calls left behind off the
+ * queue, so that glGetError() afterwards only reports the
+ * errors of the calls in between.
+ */
+static void clear_gl_errors(void)
+{
+	uint32_t i = 0;
+
+	while (glGetError() != GL_NO_ERROR && ++i < GL_ERROR_MAX)
+		continue;
+}
+
+
+/**
+ * Check whether the buffers hold the current version of
+ * an object.
+ *
+ * @param mesh the buffers
+ * @param obj the object
+ * @return true if they don't need to be uploaded again
+ */
+bool render_mesh_is_current(render_mesh const *mesh,
+		HE_obj const * const obj)
+{
+	return mesh->uploaded && mesh->batch.version == obj->version &&
+		mesh->batch.vertex_c == obj->vc;
+}
+
+/**
+ * Upload an object into the buffers, unless they hold its
+ * current version already. Needs a current OpenGL context.
+ *
+ * @param obj the object, its triangles are built if
+ * necessary [mod]
+ * @param mesh the buffers, zeroed or from an earlier call [mod]
+ * @return true/false for success/failure
+ */
+bool upload_render_mesh(HE_obj * const obj,
+		render_mesh *mesh)
+{
+	if (!obj || !mesh)
+		return false;
+
+	if (render_mesh_is_current(mesh, obj))
+		return true;
+
+	if (!build_mesh_batch(obj, &(mesh->batch)))
+		return false;
+
+	clear_gl_errors();
+	if (!mesh->vbo)
+		glGenBuffers(1, &(mesh->vbo));
+	if (!mesh->ibo)
+		glGenBuffers(1, &(mesh->ibo));
+
+	glBindBuffer(GL_ARRAY_BUFFER, mesh->vbo);
+	glBufferData(GL_ARRAY_BUFFER,
+			sizeof(mesh_vertex) * mesh->batch.vertex_c,
+			mesh->batch.vertices, GL_STATIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->ibo);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+			sizeof(uint32_t) * mesh->batch.index_c,
+			mesh->batch.indices, GL_STATIC_DRAW);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+	mesh->index_c = mesh->batch.index_c;
+	mesh->uploaded = glGetError() == GL_NO_ERROR;
+
+	return mesh->uploaded;
+}
+
+/**
+ * Upload only the colors of an object into buffers which hold
+ * it already, without triangulating it again. This is for
+ * objects whose colors change in every frame. Needs a current
+ * OpenGL context.
+ *
+ * @param obj the object
+ * @param mesh the buffers, uploaded from the object [mod]
+ * @return true/false for success/failure
+ */
+bool upload_render_mesh_colors(HE_obj const * const obj,
+		render_mesh *mesh)
+{
+	if (!obj || !mesh || !mesh->uploaded ||
+			!update_mesh_batch_colors(obj, &(mesh->batch)))
+		return false;
+
+	clear_gl_errors();
+	glBindBuffer(GL_ARRAY_BUFFER, mesh->vbo);
+	glBufferSubData(GL_ARRAY_BUFFER, 0,
+			sizeof(mesh_vertex) * mesh->batch.vertex_c,
+			mesh->batch.vertices);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	return glGetError() == GL_NO_ERROR;
+}
+
+/**
+ * Draw the triangles in the buffers with the current
+ * matrices. Needs a current OpenGL context.
+ *
+ * @param mesh the buffers
+ */
+void draw_render_mesh(render_mesh const *mesh)
+{
+	if (!mesh->uploaded || !mesh->index_c)
+		return;
+
+	glBindBuffer(GL_ARRAY_BUFFER, mesh->vbo);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->ibo);
+
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_NORMAL_ARRAY);
+	glEnableClientState(GL_COLOR_ARRAY);
+	glVertexPointer(3, GL_FLOAT, sizeof(mesh_vertex),
+			(void*)offsetof(mesh_vertex, pos));
+	glNormalPointer(GL_FLOAT, sizeof(mesh_vertex),
+			(void*)offsetof(mesh_vertex, normal));
+	glColorPointer(3, GL_FLOAT, sizeof(mesh_vertex),
+			(void*)offsetof(mesh_vertex, color));
+
+	glDrawElements(GL_TRIANGLES, (GLsizei)mesh->index_c,
+			GL_UNSIGNED_INT, NULL);
+	count_draw_call(mesh->index_c);
+
+	glDisableClientState(GL_COLOR_ARRAY);
+	glDisableClientState(GL_NORMAL_ARRAY);
+	glDisableClientState(GL_VERTEX_ARRAY);
+
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+/**
+ * Delete the buffers and zero them. Needs the OpenGL
+ * context they were created in.
+ *
+ * @param mesh the buffers [mod]
+ */
+void delete_render_mesh(render_mesh *mesh)
+{
+	if (!mesh)
+		return;
+
+	if (mesh->vbo)
+		glDeleteBuffers(1, &(mesh->vbo));
+	if (mesh->ibo)
+		glDeleteBuffers(1, &(mesh->ibo));
+	delete_mesh_batch(&(mesh->batch));
+	mesh->vbo = 0;
+	mesh->ibo = 0;
+	mesh->index_c = 0;
+	mesh->uploaded = false;
+}
+
+/**
+ * Check whether the buffer holds the normal lines of the
+ * current version of an object with the given length.
+ *
+ * @param lines the buffer
+ * @param obj the object
+ * @param scale the length of the lines
+ * @return true if it doesn't need to be uploaded again
+ */
+bool render_lines_is_current(render_lines const *lines,
+		HE_obj const * const obj,
+		float scale)
+{
+	return lines->uploaded && lines->lines.version == obj->version &&
+		lines->lines.point_c == 2 * obj->vc && lines->lines.scale == scale;
+}
+
+/**
+ * Upload the vertex normals of an object as lines into the
+ * buffer, unless it holds them with the same length already.
+ * The object needs one normal per vertex. Needs a current
+ * OpenGL context.
+ *
+ * @param obj the object
+ * @param scale the length of the lines
+ * @param lines the buffer, zeroed or from an earlier call [mod]
+ * @return true/false for success/failure
+ */
+bool upload_render_normals(HE_obj const * const obj,
+		float scale,
+		render_lines *lines)
+{
+	if (!obj || !lines)
+		return false;
+
+	if (render_lines_is_current(lines, obj, scale))
+		return true;
+
+	if (!build_normal_lines(obj, scale, &(lines->lines)))
+		return false;
+
+	clear_gl_errors();
+	if (!lines->vbo)
+		glGenBuffers(1, &(lines->vbo));
+
+	glBindBuffer(GL_ARRAY_BUFFER, lines->vbo);
+	glBufferData(GL_ARRAY_BUFFER,
+			sizeof(vector) * lines->lines.point_c,
+			lines->lines.points, GL_STATIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	lines->uploaded = glGetError() == GL_NO_ERROR;
+
+	return lines->uploaded;
+}
+
+/**
+ * Draw the lines in the buffer with the current matrices
+ * and color. Needs a current OpenGL context.
+ *
+ * @param lines the buffer
+ */
+void draw_render_lines(render_lines const *lines)
+{
+	if (!lines->uploaded || !lines->lines.point_c)
+		return;
+
+	glBindBuffer(GL_ARRAY_BUFFER, lines->vbo);
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glVertexPointer(3, GL_FLOAT, sizeof(vector), NULL);
+
+	glDrawArrays(GL_LINES, 0, (GLsizei)lines->lines.point_c);
+	count_draw_call(lines->lines.point_c);
+
+	glDisableClientState(GL_VERTEX_ARRAY);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+/**
+ * Delete the buffer of the lines and zero it. Needs the
+ * OpenGL context it was created in.
+ *
+ * @param lines the buffer [mod]
+ */
+void delete_render_lines(render_lines *lines)
+{
+	if (!lines)
+		return;
+
+	if (lines->vbo)
+		glDeleteBuffers(1, &(lines->vbo));
+	delete_normal_lines(&(lines->lines));
+	lines->vbo = 0;
+	lines->uploaded = false;
+}
+
+/**
+ * Tessellate a bezier curve with get_bez_poly() and upload the
+ * polyline into the buffer, unless it holds this version of it
+ * already. Needs a current OpenGL context.
+ *
+ * @param bez the curve
+ * @param tolerance the largest distance between the curve
+ * and the polyline
+ * @param curve the buffer, zeroed or from an earlier call
+ * for the same curve [mod]
+ * @return true/false for success/failure
+ */
+bool upload_render_curve(bez_curv const *bez,
+		float tolerance,
+		render_curve *curve)
+{
+	if (!bez || !curve)
+		return false;
+
+	if (!get_bez_poly(bez, tolerance, &(curve->poly)))
+		return false;
+
+	if (curve->uploaded && curve->version == curve->poly.version)
+		return true;
+
+	clear_gl_errors();
+	if (!curve->vbo)
+		glGenBuffers(1, &(curve->vbo));
+
+	glBindBuffer(GL_ARRAY_BUFFER, curve->vbo);
+	glBufferData(GL_ARRAY_BUFFER,
+			sizeof(vector) * curve->poly.point_c,
+			curve->poly.points, GL_STATIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	curve->version = curve->poly.version;
+	curve->uploaded = glGetError() == GL_NO_ERROR;
+
+	return curve->uploaded;
+}
+
+/**
+ * Draw the polyline in the buffer with the current matrices
+ * and color. Needs a current OpenGL context.
+ *
+ * @param curve the buffer
+ */
+void draw_render_curve(render_curve const *curve)
+{
+	if (!curve->uploaded || !curve->poly.point_c)
+		return;
+
+	glBindBuffer(GL_ARRAY_BUFFER, curve->vbo);
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glVertexPointer(3, GL_FLOAT, sizeof(vector), NULL);
+
+	glDrawArrays(GL_LINE_STRIP, 0, (GLsizei)curve->poly.point_c);
+	count_draw_call(curve->poly.point_c);
+
+	glDisableClientState(GL_VERTEX_ARRAY);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+/**
+ * Delete the buffer of the polyline and the arc length table
+ * and zero them. Needs the OpenGL context it was created in.
+ *
+ * @param curve the buffer [mod]
+ */
+void delete_render_curve(render_curve *curve)
+{
+	if (!curve)
+		return;
+
+	if (curve->vbo)
+		glDeleteBuffers(1, &(curve->vbo));
+	delete_bez_poly(&(curve->poly));
+	delete_bez_arc(&(curve->arc));
+	curve->vbo = 0;
+	curve->uploaded = false;
+	curve->version = 0;
+}
+
+/**
+ * Count a draw call in draw_stats.
+ *
+ * @param vertices count of vertices it submitted
+ */
+void count_draw_call(uint32_t vertices)
+{
+	draw_stats.draw_calls++;
+	draw_stats.vertices += vertices;
+}
+
+/**
+ * Reset draw_stats, e.g. at the start of a frame.
+ */
+void reset_render_stats(void)
+{
+	draw_stats.draw_calls = 0;
+	draw_stats.vertices = 0;
+}
@@ -0,0 +1,181 @@
+/*
+ * Copyright 2011-2014 hasufell
+ *
+ * This file is part of a hasufell project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation version 2 of the License only.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file render.h
+ * Header for drawing objects from vertex buffer objects.
+ * @brief header of render.c
+ */
+
+#ifndef _DROW_ENGINE_RENDER_H
+#define _DROW_ENGINE_RENDER_H
+
+
+#include "bezier.h"
+#include "bezier_arc.h"
+#include "half_edge.h"
+#include "mesh_batch.h"
+
+#include <GL/gl.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+
+
+/**
+ * Fault intolerant macro. Will abort the program if the called
+ * function failed.
+ */
+#define UPLOAD_RENDER_MESH(...) \
+{ \
+	if (!upload_render_mesh(__VA_ARGS__)) { \
+		fprintf(stderr, "Failure in upload_render_mesh()!\n"); \
+		abort(); \
+	} \
+}
+
+
+typedef struct render_mesh render_mesh;
+typedef struct render_lines render_lines;
+typedef struct render_curve render_curve;
+typedef struct render_stats render_stats;
+
+
+/**
+ * The vertex buffers of an object. A zeroed one has
+ * no buffers yet.
+ */
+struct render_mesh {
+	/**
+	 * Buffer of the interleaved vertices.
+	 */
+	GLuint vbo;
+	/**
+	 * Buffer of the indices of the triangles.
+	 */
+	GLuint ibo;
+	/**
+	 * Count of indices in the index buffer.
+	 */
+	uint32_t index_c;
+	/**
+	 * Whether the buffers hold an object yet.
+	 */
+	bool uploaded;
+	/**
+	 * The triangulated object, kept so that the colors
+	 * can be updated on their own.
+	 */
+	mesh_batch batch;
+};
+
+/**
+ * The vertex buffer of the normal lines of an object.
+ * A zeroed one has no buffer yet.
+ */
+struct render_lines {
+	/**
+	 * Buffer of the end points of the lines.
+	 */
+	GLuint vbo;
+	/**
+	 * Whether the buffer holds lines yet.
+	 */
+	bool uploaded;
+	/**
+	 * The lines, kept so that their array is reused.
+	 */
+	normal_lines lines;
+};
+
+/**
+ * The vertex buffer of the polyline of a bezier curve.
+ * A zeroed one has no buffer yet.
+ */
+struct render_curve {
+	/**
+	 * Buffer of the points of the polyline.
+	 */
+	GLuint vbo;
+	/**
+	 * Whether the buffer holds a polyline yet.
+	 */
+	bool uploaded;
+	/**
+	 * Version of the polyline in the buffer.
+	 */
+	uint32_t version;
+	/**
+	 * The polyline, tessellated again only when the curve
+	 * or the tolerance changes.
+	 */
+	bez_poly poly;
+	/**
+	 * Arc length table of the curve, for moving things
+	 * along it at a constant speed.
+	 */
+	bez_arc arc;
+};
+
+/**
+ * What the draw code submitted since the last
+ * reset_render_stats().
+ */
+struct render_stats {
+	/**
+	 * Count of draw calls, a glBegin()/glEnd() block or a
+	 * GLU quadric counts as one.
+	 */
+	uint32_t draw_calls;
+	/**
+	 * Count of vertices, without the ones of GLU quadrics,
+	 * which depend on the GLU implementation.
+	 */
+	uint64_t vertices;
+};
+
+
+extern render_stats draw_stats;
+
+
+bool render_mesh_is_current(render_mesh const *mesh,
+		HE_obj const * const obj);
+bool upload_render_mesh(HE_obj * const obj,
+		render_mesh *mesh);
+bool upload_render_mesh_colors(HE_obj const * const obj,
+		render_mesh *mesh);
+void draw_render_mesh(render_mesh const *mesh);
+void delete_render_mesh(render_mesh *mesh);
+bool render_lines_is_current(render_lines const *lines,
+		HE_obj const * const obj,
+		float scale);
+bool upload_render_normals(HE_obj const * const obj,
+		float scale,
+		render_lines *lines);
+void draw_render_lines(render_lines const *lines);
+void delete_render_lines(render_lines *lines);
+bool upload_render_curve(bez_curv const *bez,
+		float tolerance,
+		render_curve *curve);
+void draw_render_curve(render_curve const *curve);
+void delete_render_curve(render_curve *curve);
+void count_draw_call(uint32_t vertices);
+void reset_render_stats(void);
+
+
+#endif /* _DROW_ENGINE_RENDER_H */
@@ -0,0 +1,132 @@
+/*
+ * Copyright 2011-2014 hasufell
+ *
+ * This file is part of a hasufell project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation version 2 of the License only.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file sim.c
+ * Advances the animated parts of the scene in ticks of a fixed
+ * length, independent of the frame rate, and interpolates between
+ * two ticks for drawing. Nothing in here touches OpenGL or SDL,
+ * so the ticks can run in any thread.
+ * @brief fixed-timestep simulation
+ */
+
+#include "sim.h"
+
+#include <limits.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+
+/**
+ * Advance the state by one tick: a day passes and the ship
+ * moves along the bezier curve, turning at its ends.
+ *
+ * @param state the state [mod]
+ * @param params the settings of the tick
+ */
+void sim_tick(sim_state *state, sim_params const *params)
+{
+	state->tick++;
+
+	state->day++;
+	if (state->day >= params->yearabs) {
+		state->day = 0;
+		state->year++;
+	}
+	if (state->year >= (INT_MAX - 1000) || state->year < 0)
+		state->year = 0;
+	if (state->day < 0)
+		state->day = 0;
+
+	if (state->ball_pos > 0.98f)
+		state->ball_to_right = false;
+	else if (state->ball_pos < 0.02f)
+		state->ball_to_right = true;
+
+	if (state->ball_to_right)
+		state->ball_pos += 0.01f * params->ball_speed;
+	else
+		state->ball_pos -= 0.01f * params->ball_speed;
+}
+
+/**
+ * Interpolate between two consecutive ticks. The day is not
+ * interpolated over the end of a year, where it wraps around.
+ *
+ * @param prev the state of the earlier tick
+ * @param cur the state of the later tick
+ * @param alpha how far to go from prev to cur, from 0 to 1
+ * @param state the interpolated state [out]
+ */
+void sim_interpolate(sim_state const *prev,
+		sim_state const *cur,
+		float alpha,
+		sim_state *state)
+{
+	*state = *cur;
+
+	if (alpha >= 1)
+		return;
+	if (alpha < 0)
+		alpha = 0;
+
+	if (prev->year == cur->year && prev->day <= cur->day)
+		state->day = prev->day + (cur->day - prev->day) * alpha;
+	state->ball_pos = prev->ball_pos +
+		(cur->ball_pos - prev->ball_pos) * alpha;
+}
+
+/**
+ * Add the time since the last call to the clock and take
+ * as many whole ticks out of it as fit, at most SIM_MAX_TICKS.
+ *
+ * @param clock the clock [mod]
+ * @param elapsed_ms the time since the last call in milliseconds
+ * @return count of ticks to run
+ */
+uint32_t sim_clock_advance(sim_clock *clock, double elapsed_ms)
+{
+	uint32_t ticks = 0;
+
+	if (elapsed_ms > 0)
+		clock->lag_ms += elapsed_ms;
+
+	while (clock->lag_ms >= SIM_TICK_MS) {
+		clock->lag_ms -= SIM_TICK_MS;
+		if (++ticks == SIM_MAX_TICKS) {
+			/* drop the rest, we are too far behind */
+			if (clock->lag_ms >= SIM_TICK_MS)
+				clock->lag_ms = 0;
+			break;
+		}
+	}
+
+	return ticks;
+}
+
+/**
+ * Get how far the clock is into the next tick, to interpolate
+ * between the last two ticks with.
+ *
+ * @param clock the clock
+ * @return a value from 0 to 1
+ */
+float sim_clock_alpha(sim_clock const *clock)
+{
+	return (float)(clock->lag_ms / SIM_TICK_MS);
+}
@@ -0,0 +1,123 @@
+/*
+ * Copyright 2011-2014 hasufell
+ *
+ * This file is part of a hasufell project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation version 2 of the License only.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file sim.h
+ * Header for the fixed-timestep simulation of the scene.
+ * @brief header of sim.c
+ */
+
+#ifndef _DROW_ENGINE_SIM_H
+#define _DROW_ENGINE_SIM_H
+
+
+#include <stdbool.h>
+#include <stdint.h>
+
+
+/**
+ * Ticks of the simulation per second. The scene used to
+ * advance once per frame, this keeps its speed on a 60 Hz
+ * display.
+ */
+#define SIM_TICKS_PER_SEC 60
+
+/**
+ * Length of a tick in milliseconds.
+ */
+#define SIM_TICK_MS (1000.0 / SIM_TICKS_PER_SEC)
+
+/**
+ * Maximum count of ticks sim_clock_advance() catches up
+ * with at once. Time beyond that, e.g. when the window was
+ * dragged, is dropped instead of stalling the next frames.
+ */
+#define SIM_MAX_TICKS 8
+
+
+typedef struct sim_params sim_params;
+typedef struct sim_state sim_state;
+typedef struct sim_clock sim_clock;
+
+
+/**
+ * The settings a tick depends on, which may change
+ * between ticks.
+ */
+struct sim_params {
+	/**
+	 * Speed of the ship on the bezier curve.
+	 */
+	float ball_speed;
+	/**
+	 * Days of a year.
+	 */
+	int yearabs;
+};
+
+/**
+ * The animated state of the scene. A zeroed sim_state is
+ * the start of the simulation.
+ */
+struct sim_state {
+	/**
+	 * Count of ticks since the start.
+	 */
+	uint64_t tick;
+	/**
+	 * Count of years.
+	 */
+	int year;
+	/**
+	 * Day of the year, fractional when interpolated.
+	 */
+	float day;
+	/**
+	 * Position of the ship on the bezier curve, as a
+	 * part of its length.
+	 */
+	float ball_pos;
+	/**
+	 * Whether the ship moves towards the end of the curve.
+	 */
+	bool ball_to_right;
+};
+
+/**
+ * Accumulates the time between frames into whole ticks.
+ * A zeroed sim_clock is ready to use.
+ */
+struct sim_clock {
+	/**
+	 * Time in milliseconds which is not covered by
+	 * a tick yet, less than SIM_TICK_MS.
+	 */
+	double lag_ms;
+};
+
+
+void sim_tick(sim_state *state, sim_params const *params);
+void sim_interpolate(sim_state const *prev,
+		sim_state const *cur,
+		float alpha,
+		sim_state *state);
+uint32_t sim_clock_advance(sim_clock *clock, double elapsed_ms);
+float sim_clock_alpha(sim_clock const *clock);
+
+
+#endif /* _DROW_ENGINE_SIM_H */
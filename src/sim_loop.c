@@ -0,0 +1,209 @@
+/*
+ * Copyright 2011-2014 hasufell
+ *
+ * This file is part of a hasufell project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation version 2 of the License only.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file sim_loop.c
+ * Runs the ticks of sim.c at their fixed rate, in the rendering
+ * thread or in a worker thread. The worker keeps ticking while a
+ * frame is slow to draw and hands every tick over through a triple
+ * buffer of SDL atomics, so neither thread ever waits for the other.
+ * @brief running the simulation
+ */
+
+#include "sim.h"
+#include "sim_loop.h"
+
+#include <SDL.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+
+/**
+ * Flag of sim_loop.middle for a frame which was not
+ * taken yet.
+ */
+#define SIM_FRAME_NEW 4
+
+
+/*
+ * static function declaration
+ */
+static bool advance_sim_frame(sim_loop *loop, sim_frame *frame);
+static int run_sim_loop(void *data);
+
+
+/**
+ * Run the ticks which are due on a frame.
+ *
+ * @param loop the loop [mod]
+ * @param frame the frame [mod]
+ * @return true if there were any
+ */
+static bool advance_sim_frame(sim_loop *loop, sim_frame *frame)
+{
+	double const now = sim_time_ms();
+	uint32_t ticks = sim_clock_advance(&(loop->clock),
+			now - loop->last_ms);
+	sim_params params;
+
+	loop->last_ms = now;
+	if (!ticks)
+		return false;
+
+	SDL_AtomicLock(&(loop->params_lock));
+	params = loop->params;
+	SDL_AtomicUnlock(&(loop->params_lock));
+
+	while (ticks--) {
+		frame->prev = frame->cur;
+		sim_tick(&(frame->cur), &params);
+	}
+	frame->time_ms = now - loop->clock.lag_ms;
+
+	return true;
+}
+
+/**
+ * The worker thread. Runs the ticks as they are due and puts
+ * every new frame into the middle of the triple buffer.
+ *
+ * @param data the sim_loop
+ * @return 0
+ */
+static int run_sim_loop(void *data)
+{
+	sim_loop *loop = data;
+	sim_frame frame = loop->frames[loop->back];
+
+	while (SDL_AtomicGet(&(loop->running))) {
+		if (advance_sim_frame(loop, &frame)) {
+			loop->frames[loop->back] = frame;
+			SDL_MemoryBarrierRelease();
+			loop->back = SDL_AtomicSet(&(loop->middle),
+					loop->back | SIM_FRAME_NEW) & ~SIM_FRAME_NEW;
+		}
+
+		/* sleep until the next tick is due */
+		SDL_Delay((uint32_t)(SIM_TICK_MS - loop->clock.lag_ms) + 1);
+	}
+
+	return 0;
+}
+
+/**
+ * Get a monotonic timestamp.
+ *
+ * @return the time in milliseconds
+ */
+double sim_time_ms(void)
+{
+	return SDL_GetPerformanceCounter() /
+		(SDL_GetPerformanceFrequency() / 1000.0);
+}
+
+/**
+ * Start the simulation at its first tick.
+ *
+ * @param loop the loop [out]
+ * @param params the settings of the ticks
+ * @param threaded whether to run the ticks in a worker thread
+ * @return true/false for success/failure
+ */
+bool start_sim_loop(sim_loop *loop,
+		sim_params const *params,
+		bool threaded)
+{
+	if (!loop || !params)
+		return false;
+
+	memset(loop, 0, sizeof(*loop));
+	loop->params = *params;
+	loop->back = 0;
+	SDL_AtomicSet(&(loop->middle), 1);
+	loop->front = 2;
+	loop->last_ms = sim_time_ms();
+
+	if (threaded) {
+		SDL_AtomicSet(&(loop->running), 1);
+		if (!(loop->thread = SDL_CreateThread(run_sim_loop,
+						"drow-engine sim", loop))) {
+			fprintf(stderr, "Failed creating sim thread: %s\n",
+					SDL_GetError());
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * Stop the worker thread, if there is one.
+ *
+ * @param loop the loop [mod]
+ */
+void stop_sim_loop(sim_loop *loop)
+{
+	if (!loop || !loop->thread)
+		return;
+
+	SDL_AtomicSet(&(loop->running), 0);
+	SDL_WaitThread(loop->thread, NULL);
+	loop->thread = NULL;
+}
+
+/**
+ * Change the settings of the following ticks.
+ *
+ * @param loop the loop [mod]
+ * @param params the settings
+ */
+void set_sim_loop_params(sim_loop *loop, sim_params const *params)
+{
+	SDL_AtomicLock(&(loop->params_lock));
+	loop->params = *params;
+	SDL_AtomicUnlock(&(loop->params_lock));
+}
+
+/**
+ * Get the state to draw now, interpolated between the last
+ * two ticks. Runs the ticks which are due first, unless the
+ * worker thread does that.
+ *
+ * @param loop the loop [mod]
+ * @param state the state [out]
+ */
+void get_sim_loop_state(sim_loop *loop, sim_state *state)
+{
+	sim_frame const *frame;
+
+	if (!loop->thread) {
+		advance_sim_frame(loop, &(loop->frames[loop->front]));
+	} else if (SDL_AtomicGet(&(loop->middle)) & SIM_FRAME_NEW) {
+		loop->front = SDL_AtomicSet(&(loop->middle), loop->front) &
+			~SIM_FRAME_NEW;
+		SDL_MemoryBarrierAcquire();
+	}
+
+	frame = &(loop->frames[loop->front]);
+	sim_interpolate(&(frame->prev), &(frame->cur),
+			(float)((sim_time_ms() - frame->time_ms) / SIM_TICK_MS),
+			state);
+}
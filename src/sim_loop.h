@@ -0,0 +1,125 @@
+/*
+ * Copyright 2011-2014 hasufell
+ *
+ * This file is part of a hasufell project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation version 2 of the License only.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file sim_loop.h
+ * Header for running the simulation next to the rendering.
+ * @brief header of sim_loop.c
+ */
+
+#ifndef _DROW_ENGINE_SIM_LOOP_H
+#define _DROW_ENGINE_SIM_LOOP_H
+
+
+#include "sim.h"
+
+#include <SDL.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+
+
+typedef struct sim_frame sim_frame;
+typedef struct sim_loop sim_loop;
+
+
+/**
+ * What a tick hands to the rendering: the state of the last
+ * two ticks and when the later one was due.
+ */
+struct sim_frame {
+	/**
+	 * State of the tick before.
+	 */
+	sim_state prev;
+	/**
+	 * State of the last tick.
+	 */
+	sim_state cur;
+	/**
+	 * Time the last tick was due at, in milliseconds
+	 * of sim_time_ms().
+	 */
+	double time_ms;
+};
+
+/**
+ * Runs the ticks of the simulation, either in the rendering
+ * thread whenever it asks for a state, or in a thread of
+ * its own, which hands the frames over without locking.
+ */
+struct sim_loop {
+	/**
+	 * The worker thread, NULL if the ticks run in the
+	 * rendering thread.
+	 */
+	SDL_Thread *thread;
+	/**
+	 * Set to 0 to stop the worker thread.
+	 */
+	SDL_atomic_t running;
+	/**
+	 * Guards params.
+	 */
+	SDL_SpinLock params_lock;
+	/**
+	 * The settings of the next tick.
+	 */
+	sim_params params;
+	/**
+	 * The frames of a triple buffer: the worker writes the
+	 * back one, the rendering thread reads the front one and
+	 * they swap them with the middle one.
+	 */
+	sim_frame frames[3];
+	/**
+	 * Index of the middle frame, with SIM_FRAME_NEW set
+	 * while it holds a tick the rendering thread has not
+	 * taken yet.
+	 */
+	SDL_atomic_t middle;
+	/**
+	 * Index of the back frame, only used by the worker.
+	 */
+	int back;
+	/**
+	 * Index of the front frame, only used by the rendering
+	 * thread.
+	 */
+	int front;
+	/**
+	 * The clock of the ticks.
+	 */
+	sim_clock clock;
+	/**
+	 * Time of the last call to sim_clock_advance().
+	 */
+	double last_ms;
+};
+
+
+double sim_time_ms(void);
+bool start_sim_loop(sim_loop *loop,
+		sim_params const *params,
+		bool threaded);
+void stop_sim_loop(sim_loop *loop);
+void set_sim_loop_params(sim_loop *loop, sim_params const *params);
+void get_sim_loop_state(sim_loop *loop, sim_state *state);
+
+
+#endif /* _DROW_ENGINE_SIM_LOOP_H */
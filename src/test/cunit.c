@@ -23,15 +23,90 @@
  */
 
 #include "cunit.h"
+#include "filereader.h"
+#include "half_edge.h"
 
 #include <CUnit/Basic.h>
 #include <CUnit/Console.h>
 #include <CUnit/Automated.h>
+#include <dirent.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 
 
+/**
+ * Start walking over the .obj files in obj/, which the tests
+ * use as a corpus of real objects. Their caches are left out.
+ *
+ * @param objs the walk [out]
+ * @return true/false for success/failure
+ */
+bool open_obj_dir(obj_dir *objs)
+{
+	objs->dir = opendir("obj");
+	objs->path[0] = '\0';
+
+	CU_ASSERT_PTR_NOT_NULL(objs->dir);
+
+	return objs->dir != NULL;
+}
+
+/**
+ * Get the path of the next .obj file. The directory is
+ * closed after the last one.
+ *
+ * @param objs the walk [mod]
+ * @return the path, valid until the next call, NULL after
+ * the last file
+ */
+char const *next_obj_path(obj_dir *objs)
+{
+	struct dirent *entry;
+
+	if (!objs->dir)
+		return NULL;
+
+	while ((entry = readdir(objs->dir))) {
+		size_t const len = strlen(entry->d_name);
+
+		/* only .obj files, not their caches */
+		if (len < 4 || strcmp(entry->d_name + len - 4, ".obj"))
+			continue;
+
+		snprintf(objs->path, sizeof(objs->path), "obj/%s", entry->d_name);
+		return objs->path;
+	}
+
+	closedir(objs->dir);
+	objs->dir = NULL;
+
+	return NULL;
+}
+
+/**
+ * Read the next .obj file with read_obj_file(). Files which
+ * fail to read are asserted against and skipped.
+ *
+ * @param objs the walk [mod]
+ * @return the object, which the caller frees, its path is
+ * in objs->path; NULL after the last file
+ */
+HE_obj *next_obj(obj_dir *objs)
+{
+	while (next_obj_path(objs)) {
+		HE_obj *obj = read_obj_file(objs->path);
+
+		CU_ASSERT_PTR_NOT_NULL(obj);
+		if (obj)
+			return obj;
+	}
+
+	return NULL;
+}
+
 int init_suite(void)
 {
 	return 0;
@@ -51,6 +126,79 @@ int main(void)
 	if (CUE_SUCCESS != CU_initialize_registry())
 		return CU_get_error();
 
+	/* add a suite to the registry */
+	pSuite = CU_add_suite("arena tests",
+		init_suite,
+		clean_suite);
+	if (NULL == pSuite) {
+		CU_cleanup_registry();
+		return CU_get_error();
+	}
+
+	/* add the tests to the suite */
+	if (
+		(NULL == CU_add_test(pSuite, "test1 allocating from arena",
+							 test_arena1)) ||
+		(NULL == CU_add_test(pSuite, "test2 allocating from arena",
+							 test_arena2)) ||
+		(NULL == CU_add_test(pSuite, "test3 allocating from arena",
+							 test_arena3))
+		) {
+
+		CU_cleanup_registry();
+		return CU_get_error();
+	}
+
+	/* add a suite to the registry */
+	pSuite = CU_add_suite("bezier tests",
+		init_suite,
+		clean_suite);
+	if (NULL == pSuite) {
+		CU_cleanup_registry();
+		return CU_get_error();
+	}
+
+	/* add the tests to the suite */
+	if (
+		(NULL == CU_add_test(pSuite, "test1 evaluating bezier points",
+							 test_bezier1)) ||
+		(NULL == CU_add_test(pSuite, "test2 evaluating bezier points",
+							 test_bezier2)) ||
+		(NULL == CU_add_test(pSuite, "test3 evaluating bezier points",
+							 test_bezier3)) ||
+		(NULL == CU_add_test(pSuite, "test4 tessellating bezier curves",
+							 test_bezier4))
+		) {
+
+		CU_cleanup_registry();
+		return CU_get_error();
+	}
+
+	/* add a suite to the registry */
+	pSuite = CU_add_suite("bezier arc tests",
+		init_suite,
+		clean_suite);
+	if (NULL == pSuite) {
+		CU_cleanup_registry();
+		return CU_get_error();
+	}
+
+	/* add the tests to the suite */
+	if (
+		(NULL == CU_add_test(pSuite, "test1 arc length of bezier curves",
+							 test_bezier_arc1)) ||
+		(NULL == CU_add_test(pSuite, "test2 arc length of bezier curves",
+							 test_bezier_arc2)) ||
+		(NULL == CU_add_test(pSuite, "test3 arc length of bezier curves",
+							 test_bezier_arc3)) ||
+		(NULL == CU_add_test(pSuite, "test4 arc length of bezier curves",
+							 test_bezier_arc4))
+		) {
+
+		CU_cleanup_registry();
+		return CU_get_error();
+	}
+
 	/* add a suite to the registry */
 	pSuite = CU_add_suite("filereader tests",
 		init_suite,
@@ -106,6 +254,16 @@ int main(void)
 							 test_parse_obj5)) ||
 		(NULL == CU_add_test(pSuite, "test6 parsing .obj",
 							 test_parse_obj6)) ||
+		(NULL == CU_add_test(pSuite, "test7 parsing .obj",
+							 test_parse_obj7)) ||
+		(NULL == CU_add_test(pSuite, "test8 parsing .obj",
+							 test_parse_obj8)) ||
+		(NULL == CU_add_test(pSuite, "test1 parsing .obj in parallel",
+							 test_parse_obj_parallel1)) ||
+		(NULL == CU_add_test(pSuite, "test2 parsing .obj in parallel",
+							 test_parse_obj_parallel2)) ||
+		(NULL == CU_add_test(pSuite, "test1 contiguous vertex storage",
+							 test_parse_obj_positions1)) ||
 		(NULL == CU_add_test(pSuite, "test1 finding center ob obj",
 							 test_find_center1)) ||
 		(NULL == CU_add_test(pSuite, "test2 finding center ob obj",
@@ -122,6 +280,286 @@ int main(void)
 		return CU_get_error();
 	}
 
+	/* add a suite to the registry */
+	pSuite = CU_add_suite("half-edge cache tests",
+		init_suite,
+		clean_suite);
+	if (NULL == pSuite) {
+		CU_cleanup_registry();
+		return CU_get_error();
+	}
+
+	/* add the tests to the suite */
+	if (
+		(NULL == CU_add_test(pSuite, "test1 caching objects",
+							 test_obj_cache1)) ||
+		(NULL == CU_add_test(pSuite, "test2 caching objects",
+							 test_obj_cache2)) ||
+		(NULL == CU_add_test(pSuite, "test3 caching objects",
+							 test_obj_cache3))
+		) {
+
+		CU_cleanup_registry();
+		return CU_get_error();
+	}
+
+	/* add a suite to the registry */
+	pSuite = CU_add_suite("compact half-edge tests",
+		init_suite,
+		clean_suite);
+	if (NULL == pSuite) {
+		CU_cleanup_registry();
+		return CU_get_error();
+	}
+
+	/* add the tests to the suite */
+	if (
+		(NULL == CU_add_test(pSuite, "test1 compacting objects",
+							 test_compact_object1)) ||
+		(NULL == CU_add_test(pSuite, "test2 compacting objects",
+							 test_compact_object2)) ||
+		(NULL == CU_add_test(pSuite, "test3 compacting objects",
+							 test_compact_object3))
+		) {
+
+		CU_cleanup_registry();
+		return CU_get_error();
+	}
+
+	/* add a suite to the registry */
+	pSuite = CU_add_suite("half-edge normals tests",
+		init_suite,
+		clean_suite);
+	if (NULL == pSuite) {
+		CU_cleanup_registry();
+		return CU_get_error();
+	}
+
+	/* add the tests to the suite */
+	if (
+		(NULL == CU_add_test(pSuite, "test1 computing vertex normals",
+							 test_vertex_normals1)) ||
+		(NULL == CU_add_test(pSuite, "test2 computing vertex normals",
+							 test_vertex_normals2)) ||
+		(NULL == CU_add_test(pSuite, "test3 computing vertex normals",
+							 test_vertex_normals3))
+		) {
+
+		CU_cleanup_registry();
+		return CU_get_error();
+	}
+
+	/* add a suite to the registry */
+	pSuite = CU_add_suite("half-edge ring tests",
+		init_suite,
+		clean_suite);
+	if (NULL == pSuite) {
+		CU_cleanup_registry();
+		return CU_get_error();
+	}
+
+	/* add the tests to the suite */
+	if (
+		(NULL == CU_add_test(pSuite, "test1 building vertex rings",
+							 test_vertex_rings1)) ||
+		(NULL == CU_add_test(pSuite, "test2 building vertex rings",
+							 test_vertex_rings2)) ||
+		(NULL == CU_add_test(pSuite, "test3 building vertex rings",
+							 test_vertex_rings3))
+		) {
+
+		CU_cleanup_registry();
+		return CU_get_error();
+	}
+
+	/* add a suite to the registry */
+	pSuite = CU_add_suite("half-edge triangulation tests",
+		init_suite,
+		clean_suite);
+	if (NULL == pSuite) {
+		CU_cleanup_registry();
+		return CU_get_error();
+	}
+
+	/* add the tests to the suite */
+	if (
+		(NULL == CU_add_test(pSuite, "test1 triangulating faces",
+							 test_face_triangles1)) ||
+		(NULL == CU_add_test(pSuite, "test2 triangulating faces",
+							 test_face_triangles2)) ||
+		(NULL == CU_add_test(pSuite, "test3 triangulating faces",
+							 test_face_triangles3))
+		) {
+
+		CU_cleanup_registry();
+		return CU_get_error();
+	}
+
+	/* add a suite to the registry */
+	pSuite = CU_add_suite("load stats tests",
+		init_suite,
+		clean_suite);
+	if (NULL == pSuite) {
+		CU_cleanup_registry();
+		return CU_get_error();
+	}
+
+	/* add the tests to the suite */
+	if (
+		(NULL == CU_add_test(pSuite, "test1 adding up load stages",
+							 test_load_stats1)) ||
+		(NULL == CU_add_test(pSuite, "test2 load stats of the parser",
+							 test_load_stats2)) ||
+		(NULL == CU_add_test(pSuite, "test3 printing load stats",
+							 test_load_stats3))
+		) {
+
+		CU_cleanup_registry();
+		return CU_get_error();
+	}
+
+	/* add a suite to the registry */
+	pSuite = CU_add_suite("frame profiler tests",
+		init_suite,
+		clean_suite);
+	if (NULL == pSuite) {
+		CU_cleanup_registry();
+		return CU_get_error();
+	}
+
+	/* add the tests to the suite */
+	if (
+		(NULL == CU_add_test(pSuite, "test1 nesting profiler zones",
+							 test_profiler1)) ||
+		(NULL == CU_add_test(pSuite, "test2 profiler ring buffer",
+							 test_profiler2)) ||
+		(NULL == CU_add_test(pSuite, "test3 writing a trace",
+							 test_profiler3))
+		) {
+
+		CU_cleanup_registry();
+		return CU_get_error();
+	}
+
+	/* add a suite to the registry */
+	pSuite = CU_add_suite("mesh batch tests",
+		init_suite,
+		clean_suite);
+	if (NULL == pSuite) {
+		CU_cleanup_registry();
+		return CU_get_error();
+	}
+
+	/* add the tests to the suite */
+	if (
+		(NULL == CU_add_test(pSuite, "test1 triangulating objects",
+							 test_mesh_batch1)) ||
+		(NULL == CU_add_test(pSuite, "test2 triangulating objects",
+							 test_mesh_batch2)) ||
+		(NULL == CU_add_test(pSuite, "test3 triangulating objects",
+							 test_mesh_batch3)) ||
+		(NULL == CU_add_test(pSuite, "test4 normal lines",
+							 test_mesh_batch4))
+		) {
+
+		CU_cleanup_registry();
+		return CU_get_error();
+	}
+
+	/* add a suite to the registry */
+	pSuite = CU_add_suite("mesh bounds tests",
+		init_suite,
+		clean_suite);
+	if (NULL == pSuite) {
+		CU_cleanup_registry();
+		return CU_get_error();
+	}
+
+	/* add the tests to the suite */
+	if (
+		(NULL == CU_add_test(pSuite, "test1 computing mesh bounds",
+							 test_mesh_bounds1)) ||
+		(NULL == CU_add_test(pSuite, "test2 computing mesh bounds",
+							 test_mesh_bounds2)) ||
+		(NULL == CU_add_test(pSuite, "test3 computing mesh bounds",
+							 test_mesh_bounds3))
+		) {
+
+		CU_cleanup_registry();
+		return CU_get_error();
+	}
+
+	/* add a suite to the registry */
+	pSuite = CU_add_suite("obj scanner tests",
+		init_suite,
+		clean_suite);
+	if (NULL == pSuite) {
+		CU_cleanup_registry();
+		return CU_get_error();
+	}
+
+	/* add the tests to the suite */
+	if (
+		(NULL == CU_add_test(pSuite, "test1 scanning doubles",
+							 test_scan_double1)) ||
+		(NULL == CU_add_test(pSuite, "test2 scanning doubles",
+							 test_scan_double2)) ||
+		(NULL == CU_add_test(pSuite, "test3 scanning doubles",
+							 test_scan_double3)) ||
+		(NULL == CU_add_test(pSuite, "test1 scanning face indices",
+							 test_scan_face_index1))
+		) {
+
+		CU_cleanup_registry();
+		return CU_get_error();
+	}
+
+	/* add a suite to the registry */
+	pSuite = CU_add_suite("obj stream tests",
+		init_suite,
+		clean_suite);
+	if (NULL == pSuite) {
+		CU_cleanup_registry();
+		return CU_get_error();
+	}
+
+	/* add the tests to the suite */
+	if (
+		(NULL == CU_add_test(pSuite, "test1 parsing .obj as a stream",
+							 test_parse_obj_stream1)) ||
+		(NULL == CU_add_test(pSuite, "test2 parsing .obj as a stream",
+							 test_parse_obj_stream2)) ||
+		(NULL == CU_add_test(pSuite, "test3 parsing .obj as a stream",
+							 test_parse_obj_stream3))
+		) {
+
+		CU_cleanup_registry();
+		return CU_get_error();
+	}
+
+	/* add a suite to the registry */
+	pSuite = CU_add_suite("simulation tests",
+		init_suite,
+		clean_suite);
+	if (NULL == pSuite) {
+		CU_cleanup_registry();
+		return CU_get_error();
+	}
+
+	/* add the tests to the suite */
+	if (
+		(NULL == CU_add_test(pSuite, "test1 ticking the scene",
+							 test_sim1)) ||
+		(NULL == CU_add_test(pSuite, "test2 interpolating ticks",
+							 test_sim2)) ||
+		(NULL == CU_add_test(pSuite, "test3 fixed timestep clock",
+							 test_sim3))
+		) {
+
+		CU_cleanup_registry();
+		return CU_get_error();
+	}
+
 	/* add a suite to the registry */
 	pSuite = CU_add_suite("vector tests",
 		init_suite,
@@ -189,6 +627,29 @@ int main(void)
 		return CU_get_error();
 	}
 
+	/* add a suite to the registry */
+	pSuite = CU_add_suite("vector simd tests",
+		init_suite,
+		clean_suite);
+	if (NULL == pSuite) {
+		CU_cleanup_registry();
+		return CU_get_error();
+	}
+
+	/* add the tests to the suite */
+	if (
+		(NULL == CU_add_test(pSuite, "test1 batched vector kernels",
+							 test_vector_simd1)) ||
+		(NULL == CU_add_test(pSuite, "test2 batched vector kernels",
+							 test_vector_simd2)) ||
+		(NULL == CU_add_test(pSuite, "test3 batched vector kernels",
+							 test_vector_simd3))
+		) {
+
+		CU_cleanup_registry();
+		return CU_get_error();
+	}
+
 	/* save stderr stream and close it */
 	my_stderr = dup(STDERR_FILENO);
 	close(STDERR_FILENO);
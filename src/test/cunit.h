@@ -23,6 +23,62 @@
  * @brief test function declarations
  */
 
+#include "half_edge.h"
+
+#include <dirent.h>
+#include <stdbool.h>
+
+
+typedef struct obj_dir obj_dir;
+
+
+/**
+ * Walks over the .obj files in obj/, see open_obj_dir().
+ */
+struct obj_dir {
+	/**
+	 * The directory, NULL after the last file.
+	 */
+	DIR *dir;
+	/**
+	 * Path of the current file.
+	 */
+	char path[512];
+};
+
+
+/*
+ * test helpers
+ */
+bool open_obj_dir(obj_dir *objs);
+char const *next_obj_path(obj_dir *objs);
+HE_obj *next_obj(obj_dir *objs);
+bool objects_equal(HE_obj const * const a,
+		HE_obj const * const b);
+
+/*
+ * arena tests
+ */
+void test_arena1(void);
+void test_arena2(void);
+void test_arena3(void);
+
+/*
+ * bezier tests
+ */
+void test_bezier1(void);
+void test_bezier2(void);
+void test_bezier3(void);
+void test_bezier4(void);
+
+/*
+ * bezier_arc tests
+ */
+void test_bezier_arc1(void);
+void test_bezier_arc2(void);
+void test_bezier_arc3(void);
+void test_bezier_arc4(void);
+
 /*
  * filereader tests
  */
@@ -44,6 +100,12 @@ void test_parse_obj3(void);
 void test_parse_obj4(void);
 void test_parse_obj5(void);
 void test_parse_obj6(void);
+void test_parse_obj7(void);
+void test_parse_obj8(void);
+
+void test_parse_obj_parallel1(void);
+void test_parse_obj_parallel2(void);
+void test_parse_obj_positions1(void);
 
 void test_find_center1(void);
 void test_find_center2(void);
@@ -52,6 +114,93 @@ void test_find_center3(void);
 void test_get_normalized_scale_factor1(void);
 void test_get_normalized_scale_factor2(void);
 
+/*
+ * half_edge_cache tests
+ */
+void test_obj_cache1(void);
+void test_obj_cache2(void);
+void test_obj_cache3(void);
+
+/*
+ * half_edge_compact tests
+ */
+void test_compact_object1(void);
+void test_compact_object2(void);
+void test_compact_object3(void);
+
+/*
+ * half_edge_normals tests
+ */
+void test_vertex_normals1(void);
+void test_vertex_normals2(void);
+void test_vertex_normals3(void);
+
+/*
+ * half_edge_ring tests
+ */
+void test_vertex_rings1(void);
+void test_vertex_rings2(void);
+void test_vertex_rings3(void);
+
+/*
+ * half_edge_tris tests
+ */
+void test_face_triangles1(void);
+void test_face_triangles2(void);
+void test_face_triangles3(void);
+
+/*
+ * load_stats tests
+ */
+void test_load_stats1(void);
+void test_load_stats2(void);
+void test_load_stats3(void);
+
+/*
+ * profiler tests
+ */
+void test_profiler1(void);
+void test_profiler2(void);
+void test_profiler3(void);
+
+/*
+ * mesh_batch tests
+ */
+void test_mesh_batch1(void);
+void test_mesh_batch2(void);
+void test_mesh_batch3(void);
+void test_mesh_batch4(void);
+
+/*
+ * mesh_bounds tests
+ */
+void test_mesh_bounds1(void);
+void test_mesh_bounds2(void);
+void test_mesh_bounds3(void);
+
+/*
+ * obj_scan tests
+ */
+void test_scan_double1(void);
+void test_scan_double2(void);
+void test_scan_double3(void);
+
+void test_scan_face_index1(void);
+
+/*
+ * obj_stream tests
+ */
+void test_parse_obj_stream1(void);
+void test_parse_obj_stream2(void);
+void test_parse_obj_stream3(void);
+
+/*
+ * sim tests
+ */
+void test_sim1(void);
+void test_sim2(void);
+void test_sim3(void);
+
 /*
  * vector tests
  */
@@ -84,3 +233,10 @@ void test_normalize_vector4(void);
 void test_copy_vector1(void);
 void test_copy_vector2(void);
 void test_copy_vector3(void);
+
+/*
+ * vector_simd tests
+ */
+void test_vector_simd1(void);
+void test_vector_simd2(void);
+void test_vector_simd3(void);
@@ -0,0 +1,130 @@
+/*
+ * Copyright 2011-2014 hasufell
+ *
+ * This file is part of a hasufell project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation version 2 of the License only.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file cunit_arena.c
+ * Test functions for the arena allocator.
+ * @brief arena test functions
+ */
+
+#include "cunit.h"
+#include "arena.h"
+#include "filereader.h"
+#include "half_edge.h"
+
+#include <CUnit/Basic.h>
+#include <CUnit/Console.h>
+#include <CUnit/Automated.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+/**
+ * Test that small allocations are aligned, don't overlap
+ * and are served from a single block.
+ */
+void test_arena1(void)
+{
+	arena mem;
+	char *ptrs[100];
+
+	arena_init(&mem, ARENA_BLOCK_SIZE);
+	CU_ASSERT_EQUAL(mem.block_c, 0);
+
+	for (uint32_t i = 0; i < 100; i++) {
+		ptrs[i] = arena_alloc(&mem, i + 1);
+		CU_ASSERT_PTR_NOT_NULL(ptrs[i]);
+		CU_ASSERT_EQUAL((uintptr_t)ptrs[i] % ARENA_ALIGN, 0);
+		memset(ptrs[i], (int)i, i + 1);
+	}
+
+	for (uint32_t i = 0; i < 100; i++)
+		for (uint32_t j = 0; j <= i; j++)
+			CU_ASSERT_EQUAL(ptrs[i][j], (char)i);
+
+	CU_ASSERT_EQUAL(mem.alloc_c, 100);
+	CU_ASSERT_EQUAL(mem.block_c, 1);
+
+	arena_release(&mem);
+	CU_ASSERT_PTR_NULL(mem.block);
+	CU_ASSERT_EQUAL(mem.alloc_c, 0);
+	CU_ASSERT_EQUAL(mem.block_c, 0);
+}
+
+/**
+ * Test allocations bigger than the block size and
+ * merging two arenas.
+ */
+void test_arena2(void)
+{
+	arena mem,
+		  other;
+	char *small,
+		 *big,
+		 *next;
+
+	arena_init(&mem, 64);
+	arena_init(&other, 64);
+
+	small = arena_alloc(&mem, 16);
+	big = arena_alloc(&mem, 1000);
+	next = arena_alloc(&mem, 16);
+	memset(big, 1, 1000);
+
+	/* the current block is still used after the big allocation */
+	CU_ASSERT_EQUAL(mem.block_c, 2);
+	CU_ASSERT_PTR_EQUAL(next, small + 16);
+
+	arena_alloc(&other, 64);
+	arena_alloc(&other, 1);
+	CU_ASSERT_EQUAL(other.block_c, 2);
+
+	arena_merge(&mem, &other);
+	CU_ASSERT_EQUAL(mem.alloc_c, 5);
+	CU_ASSERT_EQUAL(mem.block_c, 4);
+	CU_ASSERT_PTR_NULL(other.block);
+	CU_ASSERT_EQUAL(other.alloc_c, 0);
+
+	arena_release(&mem);
+	arena_release(&other);
+	CU_ASSERT_PTR_NULL(mem.block);
+}
+
+/**
+ * Test that all arrays of every object in obj/ are
+ * served by a single block of its arena.
+ */
+void test_arena3(void)
+{
+	obj_dir objs;
+	HE_obj *obj;
+
+	if (!open_obj_dir(&objs))
+		return;
+
+	while ((obj = next_obj(&objs))) {
+		CU_ASSERT_PTR_NOT_NULL(obj->mem);
+		CU_ASSERT_EQUAL(obj->mem->block_c, 1);
+
+		delete_object(obj);
+		CU_ASSERT_PTR_NULL(obj->mem);
+		free(obj);
+	}
+}
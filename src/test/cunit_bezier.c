@@ -0,0 +1,302 @@
+/*
+ * Copyright 2011-2014 hasufell
+ *
+ * This file is part of a hasufell project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation version 2 of the License only.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file cunit_bezier.c
+ * Test functions for the evaluation of bezier curves.
+ * @brief bezier test functions
+ */
+
+#include "bezier.h"
+#include "vector.h"
+
+#include <CUnit/Basic.h>
+#include <CUnit/Console.h>
+#include <CUnit/Automated.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+/**
+ * Highest degree of the test curves, above BEZIER_STACK_DEG.
+ */
+#define TEST_BEZ_DEG 40
+
+
+/*
+ * static function declaration
+ */
+static void fill_curve(vector *vec, uint32_t deg);
+static vector reduced_point(const bez_curv *bez, float section);
+static float poly_distance(bez_poly const *poly, vector point);
+
+
+/**
+ * Fill the control points of a curve with pseudo-random
+ * vectors between -1 and 1.
+ *
+ * @param vec the control points [out]
+ * @param deg the degree of the curve
+ */
+static void fill_curve(vector *vec, uint32_t deg)
+{
+	srand(deg + 1);
+
+	for (uint32_t i = 0; i <= deg; i++) {
+		vec[i].x = (float)(rand() % 2000 - 1000) / 1000;
+		vec[i].y = (float)(rand() % 2000 - 1000) / 1000;
+		vec[i].z = (float)(rand() % 2000 - 1000) / 1000;
+	}
+}
+
+/**
+ * Calculate a point the long way, by reducing the curve
+ * with get_reduced_bez_curv() until one point is left.
+ *
+ * @param bez the bezier curve
+ * @param section the section
+ * @return the point
+ */
+static vector reduced_point(const bez_curv *bez, float section)
+{
+	bez_curv cur = *bez,
+			 next = { NULL, 0 };
+	vector point;
+
+	while (get_reduced_bez_curv(&cur, &next, section)) {
+		if (cur.vec != bez->vec)
+			free(cur.vec);
+		cur = next;
+	}
+	point = cur.vec[0];
+	if (cur.vec != bez->vec)
+		free(cur.vec);
+
+	return point;
+}
+
+/**
+ * Get the distance between a point and a polyline.
+ *
+ * @param poly the polyline
+ * @param point the point
+ * @return the distance
+ */
+static float poly_distance(bez_poly const *poly, vector point)
+{
+	float min = INFINITY;
+
+	for (uint32_t i = 0; i + 1 < poly->point_c; i++) {
+		vector const *a = &(poly->points[i]),
+			  *b = &(poly->points[i + 1]);
+		vector const ab = { b->x - a->x, b->y - a->y, b->z - a->z },
+			  ap = { point.x - a->x, point.y - a->y, point.z - a->z };
+		float const len2 = ab.x * ab.x + ab.y * ab.y + ab.z * ab.z;
+		float t = len2 > 0 ?
+			(ap.x * ab.x + ap.y * ab.y + ap.z * ab.z) / len2 : 0;
+		float dx, dy, dz;
+
+		t = t < 0 ? 0 : (t > 1 ? 1 : t);
+		dx = ap.x - ab.x * t;
+		dy = ap.y - ab.y * t;
+		dz = ap.z - ab.z * t;
+		if (sqrtf(dx * dx + dy * dy + dz * dz) < min)
+			min = sqrtf(dx * dx + dy * dy + dz * dz);
+	}
+
+	return min;
+}
+
+/**
+ * Test evaluating single points against the reduced curves,
+ * with and without a scratch buffer.
+ */
+void test_bezier1(void)
+{
+	vector vec[TEST_BEZ_DEG + 1],
+		   scratch[TEST_BEZ_DEG + 1];
+
+	for (uint32_t deg = 0; deg <= TEST_BEZ_DEG; deg += deg < 8 ? 1 : 16) {
+		bez_curv const bez = { vec, deg };
+
+		fill_curve(vec, deg);
+
+		for (float t = 0; t <= 1; t += 0.125f) {
+			vector const ref = reduced_point(&bez, t);
+			vector point,
+				   stack_point;
+
+			CU_ASSERT_TRUE(eval_bezier_point(&bez, t, scratch, &point));
+			CU_ASSERT_TRUE(eval_bezier_point(&bez, t, NULL, &stack_point));
+
+			CU_ASSERT_DOUBLE_EQUAL(point.x, ref.x, 0.0001);
+			CU_ASSERT_DOUBLE_EQUAL(point.y, ref.y, 0.0001);
+			CU_ASSERT_DOUBLE_EQUAL(point.z, ref.z, 0.0001);
+			CU_ASSERT_DOUBLE_EQUAL(stack_point.x, ref.x, 0.0001);
+			CU_ASSERT_DOUBLE_EQUAL(stack_point.y, ref.y, 0.0001);
+			CU_ASSERT_DOUBLE_EQUAL(stack_point.z, ref.z, 0.0001);
+		}
+
+		/* the control points stay as they are */
+		fill_curve(scratch, deg);
+		CU_ASSERT_FALSE(memcmp(vec, scratch, sizeof(vector) * (deg + 1)));
+	}
+}
+
+/**
+ * Test evaluating many points at once against single points,
+ * for counts around the block size.
+ */
+void test_bezier2(void)
+{
+	uint32_t const n = 131;
+	vector vec[TEST_BEZ_DEG + 1],
+		   points[131],
+		   samples[131];
+	float sections[131];
+
+	for (uint32_t i = 0; i < n; i++)
+		sections[i] = (float)i / (n - 1);
+
+	for (uint32_t deg = 0; deg <= TEST_BEZ_DEG; deg += deg < 8 ? 1 : 16) {
+		bez_curv const bez = { vec, deg };
+
+		fill_curve(vec, deg);
+
+		CU_ASSERT_TRUE(eval_bezier_points(&bez, sections, n, points));
+		CU_ASSERT_TRUE(sample_bezier_curve(&bez, n, samples));
+
+		for (uint32_t i = 0; i < n; i++) {
+			vector ref;
+
+			CU_ASSERT_TRUE(eval_bezier_point(&bez, sections[i], NULL, &ref));
+			CU_ASSERT_DOUBLE_EQUAL(points[i].x, ref.x, 0.0001);
+			CU_ASSERT_DOUBLE_EQUAL(points[i].y, ref.y, 0.0001);
+			CU_ASSERT_DOUBLE_EQUAL(points[i].z, ref.z, 0.0001);
+			CU_ASSERT_EQUAL(points[i].x, samples[i].x);
+			CU_ASSERT_EQUAL(points[i].y, samples[i].y);
+			CU_ASSERT_EQUAL(points[i].z, samples[i].z);
+		}
+
+		/* the ends of the curve are its end points */
+		CU_ASSERT_EQUAL(points[0].x, vec[0].x);
+		CU_ASSERT_EQUAL(points[0].z, vec[0].z);
+		CU_ASSERT_EQUAL(points[n - 1].x, vec[deg].x);
+		CU_ASSERT_EQUAL(points[n - 1].z, vec[deg].z);
+	}
+}
+
+/**
+ * Test the handling of invalid input.
+ */
+void test_bezier3(void)
+{
+	vector vec[2] = { { 1, 2, 3 }, { 3, 2, 1 } },
+		   points[2];
+	bez_curv const bez = { vec, 1 },
+		  point_bez = { vec, 0 },
+		  empty_bez = { NULL, 1 };
+	float const section = 0.5f;
+	vector *point;
+
+	CU_ASSERT_FALSE(eval_bezier_point(NULL, 0.5f, NULL, points));
+	CU_ASSERT_FALSE(eval_bezier_point(&empty_bez, 0.5f, NULL, points));
+	CU_ASSERT_FALSE(eval_bezier_point(&bez, 0.5f, NULL, NULL));
+	CU_ASSERT_FALSE(eval_bezier_points(&bez, NULL, 1, points));
+	CU_ASSERT_TRUE(eval_bezier_points(&bez, NULL, 0, NULL));
+	CU_ASSERT_FALSE(sample_bezier_curve(&bez, 1, points));
+	CU_ASSERT_PTR_NULL(calculate_bezier_point(&empty_bez, 0.5f));
+
+	/* a curve of degree 0 is a point */
+	CU_ASSERT_TRUE(eval_bezier_points(&point_bez, &section, 1, points));
+	CU_ASSERT_EQUAL(points[0].y, 2);
+	point = calculate_bezier_point(&point_bez, 0.5f);
+	CU_ASSERT_PTR_NOT_NULL(point);
+	if (point)
+		CU_ASSERT_EQUAL(point->z, 3);
+	free(point);
+
+	CU_ASSERT_TRUE(sample_bezier_curve(&bez, 2, points));
+	CU_ASSERT_EQUAL(points[1].x, 3);
+}
+
+/**
+ * Test the adaptive polylines, their tolerance and when they
+ * are tessellated again.
+ */
+void test_bezier4(void)
+{
+	vector vec[4] = { { 0, 0, 0 }, { 1, 2, 0 }, { 2, -2, 0 }, { 3, 0, 1 } },
+		   line[6];
+	bez_curv const bez = { vec, 3 },
+		  line_bez = { line, 5 };
+	bez_poly poly = { NULL, 0, 0, NULL, 0, 0, 0 },
+			 fine_poly = { NULL, 0, 0, NULL, 0, 0, 0 };
+	uint32_t version,
+			 point_c;
+
+	CU_ASSERT_TRUE(get_bez_poly(&bez, 0.01f, &poly));
+	CU_ASSERT_TRUE(poly.point_c > 2);
+	CU_ASSERT_EQUAL(poly.points[0].x, 0);
+	CU_ASSERT_EQUAL(poly.points[poly.point_c - 1].x, 3);
+	CU_ASSERT_EQUAL(poly.points[poly.point_c - 1].z, 1);
+	for (float t = 0; t <= 1; t += 0.01f) {
+		vector point;
+
+		eval_bezier_point(&bez, t, NULL, &point);
+		CU_ASSERT_TRUE(poly_distance(&poly, point) <= 0.01f);
+	}
+
+	/* same curve and tolerance, nothing to do */
+	version = poly.version;
+	point_c = poly.point_c;
+	CU_ASSERT_TRUE(get_bez_poly(&bez, 0.01f, &poly));
+	CU_ASSERT_EQUAL(poly.version, version);
+
+	/* a finer tolerance needs more segments */
+	CU_ASSERT_TRUE(get_bez_poly(&bez, 0.0001f, &fine_poly));
+	CU_ASSERT_TRUE(fine_poly.point_c > point_c);
+
+	/* a moved control point or another tolerance invalidate it */
+	vec[1].y = 3;
+	CU_ASSERT_TRUE(get_bez_poly(&bez, 0.01f, &poly));
+	CU_ASSERT_EQUAL(poly.version, version + 1);
+	CU_ASSERT_TRUE(get_bez_poly(&bez, 0.02f, &poly));
+	CU_ASSERT_EQUAL(poly.version, version + 2);
+
+	/* a straight curve is one segment, whatever its degree */
+	for (uint32_t i = 0; i <= 5; i++) {
+		line[i].x = (float)i;
+		line[i].y = 2 * (float)i;
+		line[i].z = 0;
+	}
+	CU_ASSERT_TRUE(get_bez_poly(&line_bez, 0.01f, &poly));
+	CU_ASSERT_EQUAL(poly.point_c, 2);
+	CU_ASSERT_EQUAL(poly.deg, 5);
+
+	CU_ASSERT_FALSE(get_bez_poly(&bez, 0, &poly));
+	CU_ASSERT_FALSE(get_bez_poly(NULL, 0.01f, &poly));
+	CU_ASSERT_FALSE(get_bez_poly(&bez, 0.01f, NULL));
+
+	delete_bez_poly(&poly);
+	delete_bez_poly(&fine_poly);
+	CU_ASSERT_PTR_NULL(poly.points);
+	CU_ASSERT_EQUAL(poly.point_c, 0);
+}
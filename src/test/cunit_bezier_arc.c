@@ -0,0 +1,232 @@
+/*
+ * Copyright 2011-2014 hasufell
+ *
+ * This file is part of a hasufell project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation version 2 of the License only.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file cunit_bezier_arc.c
+ * Test functions for the arc length tables of bezier curves.
+ * @brief bezier_arc test functions
+ */
+
+#include "bezier.h"
+#include "bezier_arc.h"
+#include "vector.h"
+
+#include <CUnit/Basic.h>
+#include <CUnit/Console.h>
+#include <CUnit/Automated.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+
+/**
+ * Test a straight curve whose control points are bunched up at
+ * the start, so its sections are far from its distances.
+ */
+void test_bezier_arc1(void)
+{
+	vector vec[4] = { { 0, 0, 0 }, { 0.1f, 0, 0 }, { 0.2f, 0, 0 },
+		{ 3, 0, 0 } };
+	bez_curv const bez = { vec, 3 };
+	bez_arc arc = { NULL, NULL, 0, NULL, 0, 0 };
+	float distances[31];
+	vector points[31];
+
+	CU_ASSERT_TRUE(get_bez_arc(&bez, 1024, &arc));
+	CU_ASSERT_DOUBLE_EQUAL(arc.length, 3, 0.0001);
+
+	/* the middle of the length is far from the middle section */
+	CU_ASSERT_TRUE(bez_arc_section(&arc, 1.5f) > 0.6f);
+
+	for (uint32_t i = 0; i < 31; i++) {
+		vector point,
+			   tangent;
+
+		distances[i] = (float)i / 10;
+		CU_ASSERT_TRUE(bez_arc_point(&arc, distances[i], &point, &tangent));
+		CU_ASSERT_DOUBLE_EQUAL(point.x, distances[i], 0.001);
+		CU_ASSERT_EQUAL(point.y, 0);
+		CU_ASSERT_DOUBLE_EQUAL(tangent.x, 1, 0.0001);
+		CU_ASSERT_DOUBLE_EQUAL(tangent.y, 0, 0.0001);
+	}
+
+	CU_ASSERT_TRUE(bez_arc_points(&arc, distances, 31, points));
+	for (uint32_t i = 0; i < 31; i++)
+		CU_ASSERT_DOUBLE_EQUAL(points[i].x, distances[i], 0.001);
+
+	/* distances beyond the ends are clamped */
+	CU_ASSERT_EQUAL(bez_arc_section(&arc, -1), 0);
+	CU_ASSERT_EQUAL(bez_arc_section(&arc, 4), 1);
+
+	delete_bez_arc(&arc);
+	CU_ASSERT_PTR_NULL(arc.lengths);
+}
+
+/**
+ * Test the length of a bent curve against a much finer
+ * polyline and rebuilding the table when the curve changes.
+ */
+void test_bezier_arc2(void)
+{
+	vector vec[4] = { { 0, 0, 0 }, { 0, 1, 0 }, { 1, 1, 1 },
+		{ 1, 0, 0 } };
+	bez_curv const bez = { vec, 3 };
+	bez_arc arc = { NULL, NULL, 0, NULL, 0, 0 };
+	uint32_t const fine_c = 100000;
+	vector *fine = malloc(sizeof(*fine) * fine_c);
+	double length = 0;
+	float last = 0;
+
+	CU_ASSERT_TRUE(sample_bezier_curve(&bez, fine_c, fine));
+	for (uint32_t i = 1; i < fine_c; i++)
+		length += sqrt(pow(fine[i].x - fine[i - 1].x, 2) +
+				pow(fine[i].y - fine[i - 1].y, 2) +
+				pow(fine[i].z - fine[i - 1].z, 2));
+	free(fine);
+
+	CU_ASSERT_TRUE(get_bez_arc(&bez, BEZ_ARC_SAMPLES, &arc));
+	CU_ASSERT_DOUBLE_EQUAL(arc.length, length, 0.0001 * length);
+
+	/* sections grow with the distance */
+	for (float d = 0; d <= arc.length; d += arc.length / 100) {
+		float const section = bez_arc_section(&arc, d);
+
+		CU_ASSERT_TRUE(section >= last);
+		last = section;
+	}
+
+	/* equal distances are equally far apart on the curve */
+	for (uint32_t i = 0; i < 50; i++) {
+		vector a,
+			   b;
+		float const step = arc.length / 50;
+
+		bez_arc_point(&arc, step * i, &a, NULL);
+		bez_arc_point(&arc, step * (i + 1), &b, NULL);
+		CU_ASSERT_DOUBLE_EQUAL(sqrt(pow(b.x - a.x, 2) + pow(b.y - a.y, 2) +
+					pow(b.z - a.z, 2)), step, 0.005 * step);
+	}
+
+	/* the same curve keeps its table, another one gets a new one */
+	CU_ASSERT_TRUE(get_bez_arc(&bez, BEZ_ARC_SAMPLES, &arc));
+	CU_ASSERT_DOUBLE_EQUAL(arc.length, length, 0.0001 * length);
+	vec[3].x = 3;
+	CU_ASSERT_TRUE(get_bez_arc(&bez, BEZ_ARC_SAMPLES, &arc));
+	CU_ASSERT_TRUE(arc.length > length + 1);
+
+	delete_bez_arc(&arc);
+}
+
+/**
+ * Test the frames along a curve and the handling of
+ * degenerate and invalid input.
+ */
+void test_bezier_arc3(void)
+{
+	vector vec[3] = { { 0, 0, 0 }, { 1, 0, 1 }, { 2, 0, 0 } },
+		   point;
+	bez_curv const bez = { vec, 2 },
+		  point_bez = { vec, 0 };
+	vector const up = { 0, 1, 0 },
+		  up_z = { 0, 0, 1 };
+	bez_arc arc = { NULL, NULL, 0, NULL, 0, 0 },
+			empty = { NULL, NULL, 0, NULL, 0, 0 };
+	float m[16];
+
+	CU_ASSERT_TRUE(get_bez_arc(&bez, BEZ_ARC_SAMPLES, &arc));
+
+	/* in the middle the curve runs along x, at the top of its arc */
+	CU_ASSERT_TRUE(bez_arc_frame(&arc, arc.length / 2, &up, m));
+	CU_ASSERT_DOUBLE_EQUAL(m[0], 1, 0.0001);
+	CU_ASSERT_DOUBLE_EQUAL(m[5], 1, 0.0001);
+	CU_ASSERT_DOUBLE_EQUAL(m[10], 1, 0.0001);
+	CU_ASSERT_DOUBLE_EQUAL(m[12], 1, 0.0001);
+	CU_ASSERT_DOUBLE_EQUAL(m[14], 0.5, 0.0001);
+	CU_ASSERT_EQUAL(m[15], 1);
+
+	/* the axes are orthonormal anywhere, whatever the up vector */
+	for (float d = 0; d <= arc.length; d += arc.length / 7) {
+		for (uint32_t k = 0; k < 2; k++) {
+			CU_ASSERT_TRUE(bez_arc_frame(&arc, d, k ? &up_z : &up, m));
+			for (uint32_t i = 0; i < 3; i++) {
+				for (uint32_t j = 0; j < 3; j++) {
+					float const dot = m[i * 4] * m[j * 4] +
+						m[i * 4 + 1] * m[j * 4 + 1] +
+						m[i * 4 + 2] * m[j * 4 + 2];
+
+					CU_ASSERT_DOUBLE_EQUAL(dot, i == j ? 1 : 0, 0.0001);
+				}
+			}
+		}
+	}
+
+	/* a curve of degree 0 is a point */
+	CU_ASSERT_TRUE(get_bez_arc(&point_bez, 16, &arc));
+	CU_ASSERT_EQUAL(arc.length, 0);
+	CU_ASSERT_TRUE(bez_arc_point(&arc, 1, &point, NULL));
+	CU_ASSERT_EQUAL(point.x, 0);
+	CU_ASSERT_TRUE(bez_arc_frame(&arc, 0, &up, m));
+
+	CU_ASSERT_FALSE(get_bez_arc(&bez, 1, &empty));
+	CU_ASSERT_FALSE(get_bez_arc(NULL, 16, &empty));
+	CU_ASSERT_PTR_NULL(empty.ctrl);
+	CU_ASSERT_FALSE(bez_arc_point(&empty, 0, &point, NULL));
+	CU_ASSERT_FALSE(bez_arc_points(&empty, m, 1, &point));
+	CU_ASSERT_FALSE(bez_arc_frame(&empty, 0, &up, m));
+	CU_ASSERT_FALSE(bez_arc_frame(&arc, 0, NULL, m));
+
+	delete_bez_arc(&arc);
+}
+
+/**
+ * Test that the reduced curves of the frame meet in the point
+ * at the section of a distance, where the ship is drawn.
+ */
+void test_bezier_arc4(void)
+{
+	vector vec[4] = { { 0, 0, 0 }, { 0.1f, 1, 0 }, { 0.2f, 1, 1 },
+		{ 3, 0, 0 } };
+	bez_curv const bez = { vec, 3 };
+	bez_arc arc = { NULL, NULL, 0, NULL, 0, 0 };
+
+	CU_ASSERT_TRUE(get_bez_arc(&bez, BEZ_ARC_SAMPLES, &arc));
+
+	for (uint32_t i = 0; i <= 20; i++) {
+		float const section = bez_arc_section(&arc, arc.length * i / 20);
+		bez_curv cur_bez = bez,
+				 next_bez = { NULL, 0 };
+		vector point;
+
+		CU_ASSERT_TRUE(eval_bezier_point(&bez, section, NULL, &point));
+
+		/* reduce the curve down to a point, as draw_bez_frame() does */
+		while (get_reduced_bez_curv(&cur_bez, &next_bez, section)) {
+			if (cur_bez.deg < bez.deg)
+				free(cur_bez.vec);
+			cur_bez = next_bez;
+		}
+
+		CU_ASSERT_EQUAL(cur_bez.deg, 0);
+		CU_ASSERT_DOUBLE_EQUAL(cur_bez.vec[0].x, point.x, 0.00001);
+		CU_ASSERT_DOUBLE_EQUAL(cur_bez.vec[0].y, point.y, 0.00001);
+		CU_ASSERT_DOUBLE_EQUAL(cur_bez.vec[0].z, point.z, 0.00001);
+		free(cur_bez.vec);
+	}
+
+	delete_bez_arc(&arc);
+}
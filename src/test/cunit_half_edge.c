@@ -23,12 +23,17 @@
  * @brief half-edge test functions
  */
 
+#include "cunit.h"
+#include "filereader.h"
 #include "half_edge.h"
 
 #include <CUnit/Basic.h>
 #include <CUnit/Console.h>
 #include <CUnit/Automated.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+
 
 /**
  * Use a valid string representing an .obj file
@@ -535,6 +540,186 @@ void test_parse_obj6(void)
 	}
 }
 
+/**
+ * Test if the parser copes with dos line endings, tabs,
+ * trailing whitespace and face elements with texture and
+ * normal references.
+ */
+void test_parse_obj7(void)
+{
+	char const * const string = ""
+		"v 9.0 10.0 11.0 \r\n"
+		"v\t11.0 10.0 11.0\r\n"
+		"v 9.0 11.0 11.0\t\r\n"
+		"v 11.0 11.0 11.0\r\n"
+		"vt 0.5 1e-1\r\n"
+		"\r\n"
+		"f 1/1/1 2/1/1 4//1 3 \r\n";
+
+	HE_obj *obj = parse_obj(string);
+
+	CU_ASSERT_PTR_NOT_NULL(obj);
+
+	CU_ASSERT_EQUAL(obj->vc, 4);
+	CU_ASSERT_EQUAL(obj->vtc, 1);
+	CU_ASSERT_EQUAL(obj->fc, 1);
+	CU_ASSERT_EQUAL(obj->ec, 4);
+
+	CU_ASSERT_EQUAL(obj->vertices[1].vec->x, 11.0);
+	CU_ASSERT_EQUAL(obj->vertices[1].vec->y, 10.0);
+	CU_ASSERT_EQUAL(obj->vertices[1].vec->z, 11.0);
+
+	CU_ASSERT_EQUAL(obj->vertices[2].vec->z, 11.0);
+
+	CU_ASSERT_EQUAL(obj->faces[0].edge->vert->vec->x, 9.0);
+	CU_ASSERT_EQUAL(obj->faces[0].edge->vert->vec->y, 11.0);
+	CU_ASSERT_EQUAL(obj->faces[0].edge->vert->vec->z, 11.0);
+
+	CU_ASSERT_EQUAL(obj->faces[0].edge->next->vert->vec->x, 9.0);
+	CU_ASSERT_EQUAL(obj->faces[0].edge->next->vert->vec->y, 10.0);
+	CU_ASSERT_EQUAL(obj->faces[0].edge->next->vert->vec->z, 11.0);
+}
+
+/**
+ * Test the pairs of a triangle fan around a vertex with
+ * a high valence, which has a border all around.
+ */
+void test_parse_obj8(void)
+{
+	uint32_t const valence = 2000;
+	char *string = malloc(valence * 64);
+	size_t pos = 0;
+	HE_obj *obj;
+
+	pos += sprintf(string + pos, "v 0 0 1\n");
+	for (uint32_t i = 0; i < valence; i++)
+		pos += sprintf(string + pos, "v %u 0 0\n", i);
+	for (uint32_t i = 0; i < valence; i++)
+		pos += sprintf(string + pos, "f 1 %u %u\n", i + 2,
+				(i + 1) % valence + 2);
+
+	obj = parse_obj(string);
+
+	CU_ASSERT_PTR_NOT_NULL(obj);
+	CU_ASSERT_EQUAL(obj->ec, valence * 3);
+	CU_ASSERT_EQUAL(obj->dec, valence);
+
+	for (uint32_t i = 0; i < obj->ec + obj->dec; i++) {
+		HE_edge const *edge = &(obj->edges[i]);
+
+		CU_ASSERT_PTR_EQUAL(edge->pair->pair, edge);
+		CU_ASSERT_PTR_NOT_EQUAL(edge->pair, edge);
+		CU_ASSERT_PTR_NOT_NULL(edge->next);
+		CU_ASSERT_PTR_EQUAL(edge->next->vert, edge->pair->vert);
+	}
+
+	/* spokes pair with the spokes of the neighbouring faces */
+	for (uint32_t i = 0; i < valence; i++) {
+		HE_edge const *spoke = &(obj->edges[i * 3]);
+
+		CU_ASSERT_PTR_EQUAL(spoke->pair->face,
+				&(obj->faces[(i + valence - 1) % valence]));
+	}
+
+	/* the border edges form one loop around the fan */
+	for (uint32_t i = 0; i < obj->dec; i++) {
+		HE_edge const *dummy = &(obj->edges[obj->ec + i]);
+
+		CU_ASSERT_PTR_NULL(dummy->face);
+		CU_ASSERT_PTR_NULL(dummy->next->face);
+		CU_ASSERT_PTR_NOT_EQUAL(dummy->next, dummy);
+	}
+
+	delete_object(obj);
+	free(obj);
+	free(string);
+}
+
+/**
+ * Parse and assemble every file in obj/ with multiple threads
+ * and compare the result with the serial parser.
+ */
+void test_parse_obj_parallel1(void)
+{
+	obj_dir objs;
+	char const *path;
+
+	if (!open_obj_dir(&objs))
+		return;
+
+	while ((path = next_obj_path(&objs))) {
+		char const *map;
+		size_t len;
+		HE_obj *serial;
+
+		map = map_file(path, &len);
+		CU_ASSERT_PTR_NOT_NULL(map);
+		if (!map)
+			continue;
+
+		serial = parse_obj_buf(map, len);
+		CU_ASSERT_PTR_NOT_NULL(serial);
+
+		for (unsigned threads = 2; threads <= 8; threads *= 2) {
+			HE_obj *parallel = parse_obj_parallel(map, len, threads);
+
+			CU_ASSERT_PTR_NOT_NULL(parallel);
+			CU_ASSERT_TRUE(objects_equal(serial, parallel));
+
+			delete_object(parallel);
+			free(parallel);
+		}
+
+		delete_object(serial);
+		free(serial);
+		unmap_file(map, len);
+	}
+}
+
+/**
+ * Test if the parallel parser correctly aborts when passed
+ * a NULL pointer.
+ */
+void test_parse_obj_parallel2(void)
+{
+	HE_obj *obj = parse_obj_parallel(NULL, 0, 4);
+
+	CU_ASSERT_PTR_NULL(obj);
+}
+
+/**
+ * Test that the vertex coordinates and colors are stored in
+ * contiguous arrays which the vertices point into.
+ */
+void test_parse_obj_positions1(void)
+{
+	char const * const string = ""
+		"v 9.0 10.0 11.0\n"
+		"v 11.0 10.0 11.0\n"
+		"v 9.0 11.0 11.0\n"
+		"v 11.0 11.0 11.0\n"
+		"f 1 2 4 3\n";
+
+	HE_obj *obj = parse_obj(string);
+
+	CU_ASSERT_PTR_NOT_NULL(obj);
+	CU_ASSERT_PTR_NOT_NULL(obj->positions);
+	CU_ASSERT_PTR_NOT_NULL(obj->colors);
+
+	for (uint32_t i = 0; i < obj->vc; i++) {
+		CU_ASSERT_PTR_EQUAL(obj->vertices[i].vec, &(obj->positions[i]));
+		CU_ASSERT_PTR_EQUAL(obj->vertices[i].col, &(obj->colors[i]));
+	}
+
+	CU_ASSERT_EQUAL(obj->positions[1].x, 11.0);
+	CU_ASSERT_EQUAL(obj->positions[2].y, 11.0);
+	CU_ASSERT_EQUAL(obj->positions[3].z, 11.0);
+	CU_ASSERT_EQUAL(obj->colors[3].red, -1);
+
+	delete_object(obj);
+	free(obj);
+}
+
 /**
  * Test finding the center of an object.
  */
@@ -631,8 +816,9 @@ void test_get_normalized_scale_factor1(void)
 	HE_obj *obj = parse_obj(string);
 	float factor = get_normalized_scale_factor(obj);
 
+	/* the longest side of the bounding box is 2 */
 	CU_ASSERT_PTR_NOT_NULL(obj);
-	CU_ASSERT_EQUAL(factor, 0.2f);
+	CU_ASSERT_EQUAL(factor, 0.5f);
 }
 
 /**
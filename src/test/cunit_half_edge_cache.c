@@ -0,0 +1,306 @@
+/*
+ * Copyright 2011-2014 hasufell
+ *
+ * This file is part of a hasufell project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation version 2 of the License only.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file cunit_half_edge_cache.c
+ * Test functions for the binary half-edge cache.
+ * @brief half-edge cache test functions
+ */
+
+#include "cunit.h"
+#include "filereader.h"
+#include "half_edge.h"
+#include "half_edge_cache.h"
+
+#include <CUnit/Basic.h>
+#include <CUnit/Console.h>
+#include <CUnit/Automated.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+/**
+ * Index of a pointer into an array, -1 for NULL.
+ */
+#define PTR_ID(ptr, arr) ((ptr) ? (long)((ptr) - (arr)) : -1L)
+
+
+/*
+ * static function declaration
+ */
+static bool write_string(char const * const filename,
+		char const * const string);
+
+
+/**
+ * Check if two objects have the same coordinates and
+ * exactly the same topology, down to the order of the edges.
+ * References are compared as indices into their arrays.
+ * Shared by the tests of all ways to build objects.
+ *
+ * @param a the first object
+ * @param b the second object
+ * @return true if they are the same, false otherwise
+ */
+bool objects_equal(HE_obj const * const a,
+		HE_obj const * const b)
+{
+	if (a->ec != b->ec || a->dec != b->dec || a->vc != b->vc ||
+			a->fc != b->fc || a->vnc != b->vnc || a->vtc != b->vtc ||
+			a->bzc != b->bzc)
+		return false;
+
+	if (memcmp(a->positions, b->positions, sizeof(vector) * a->vc) ||
+			(a->vnc && memcmp(a->vn, b->vn, sizeof(vector) * a->vnc)))
+		return false;
+
+	for (uint32_t i = 0; i < a->ec + a->dec; i++) {
+		HE_edge const *ea = &(a->edges[i]),
+			  *eb = &(b->edges[i]);
+
+		if (PTR_ID(ea->vert, a->vertices) != PTR_ID(eb->vert, b->vertices) ||
+				PTR_ID(ea->pair, a->edges) != PTR_ID(eb->pair, b->edges) ||
+				PTR_ID(ea->face, a->faces) != PTR_ID(eb->face, b->faces) ||
+				PTR_ID(ea->next, a->edges) != PTR_ID(eb->next, b->edges))
+			return false;
+	}
+
+	for (uint32_t i = 0; i < a->vc; i++)
+		if (PTR_ID(a->vertices[i].edge, a->edges) !=
+				PTR_ID(b->vertices[i].edge, b->edges) ||
+				b->vertices[i].vec != &(b->positions[i]))
+			return false;
+
+	for (uint32_t i = 0; i < a->fc; i++)
+		if (PTR_ID(a->faces[i].edge, a->edges) !=
+				PTR_ID(b->faces[i].edge, b->edges))
+			return false;
+
+	for (uint32_t i = 0; i < a->bzc; i++)
+		if (a->bez_curves[i].deg != b->bez_curves[i].deg ||
+				memcmp(a->bez_curves[i].vec, b->bez_curves[i].vec,
+					sizeof(vector) * (a->bez_curves[i].deg + 1)))
+			return false;
+
+	return true;
+}
+
+/**
+ * Write a string into a file.
+ *
+ * @param filename the file
+ * @param string the content
+ * @return true/false for success/failure
+ */
+static bool write_string(char const * const filename,
+		char const * const string)
+{
+	FILE *file = fopen(filename, "w");
+	bool ret;
+
+	if (!file)
+		return false;
+
+	ret = fputs(string, file) >= 0;
+
+	return !fclose(file) && ret;
+}
+
+/**
+ * Write every file in obj/ into a cache and load
+ * it again, which must give exactly the same object.
+ */
+void test_obj_cache1(void)
+{
+	char const * const cache = "cunit_test_cache" HE_CACHE_SUFFIX;
+	obj_dir objs;
+	char const *path;
+
+	if (!open_obj_dir(&objs))
+		return;
+
+	while ((path = next_obj_path(&objs))) {
+		char const *map;
+		size_t len;
+		HE_obj *obj,
+			   *cached;
+
+		map = map_file(path, &len);
+		CU_ASSERT_PTR_NOT_NULL(map);
+		if (!map)
+			continue;
+		obj = parse_obj_buf(map, len);
+		unmap_file(map, len);
+
+		CU_ASSERT_TRUE(write_obj_cache(obj, cache));
+		cached = load_obj_cache(cache);
+		CU_ASSERT_PTR_NOT_NULL(cached);
+		if (cached) {
+			CU_ASSERT_TRUE(objects_equal(obj, cached));
+			CU_ASSERT_EQUAL(cached->mem->block_c, 1);
+			delete_object(cached);
+			free(cached);
+		}
+
+		delete_object(obj);
+		free(obj);
+	}
+	unlink(cache);
+}
+
+/**
+ * Test that damaged caches and caches of another
+ * version or byte order are rejected.
+ */
+void test_obj_cache2(void)
+{
+	char const * const cache = "cunit_test_cache" HE_CACHE_SUFFIX;
+	char const * const string = ""
+		"v 9.0 10.0 11.0\n"
+		"v 11.0 10.0 11.0\n"
+		"v 9.0 11.0 11.0\n"
+		"v 11.0 11.0 11.0\n"
+		"f 1 2 4 3\n";
+	HE_obj *obj = parse_obj(string);
+	HE_obj *cached;
+	HE_cache_header header;
+	char const *map;
+	char *buf;
+	size_t len = 0;
+
+	CU_ASSERT_TRUE(write_obj_cache(obj, cache));
+	map = map_file(cache, &len);
+	CU_ASSERT_PTR_NOT_NULL(map);
+	if (!map)
+		return;
+
+	buf = malloc(len);
+	memcpy(buf, map, len);
+	unmap_file(map, len);
+	unlink(cache);
+
+	cached = load_obj_cache_buf(buf, len);
+	CU_ASSERT_PTR_NOT_NULL(cached);
+	CU_ASSERT_TRUE(cached && objects_equal(obj, cached));
+	delete_object(cached);
+	free(cached);
+
+	CU_ASSERT_PTR_NULL(load_obj_cache_buf(buf, len - 1));
+	CU_ASSERT_PTR_NULL(load_obj_cache_buf(buf, sizeof(header) - 1));
+
+	/* flipped bit in the coordinates */
+	buf[sizeof(header) + 5] ^= 0x10;
+	CU_ASSERT_PTR_NULL(load_obj_cache_buf(buf, len));
+	buf[sizeof(header) + 5] ^= 0x10;
+
+	memcpy(&header, buf, sizeof(header));
+	header.version++;
+	memcpy(buf, &header, sizeof(header));
+	CU_ASSERT_PTR_NULL(load_obj_cache_buf(buf, len));
+
+	header.version--;
+	header.byte_order = 0x04030201;
+	memcpy(buf, &header, sizeof(header));
+	CU_ASSERT_PTR_NULL(load_obj_cache_buf(buf, len));
+
+	header.byte_order = HE_CACHE_BYTE_ORDER;
+	memcpy(buf, &header, sizeof(header));
+	cached = load_obj_cache_buf(buf, len);
+	CU_ASSERT_PTR_NOT_NULL(cached);
+	delete_object(cached);
+	free(cached);
+
+	CU_ASSERT_PTR_NULL(load_obj_cache_buf(NULL, len));
+	CU_ASSERT_PTR_NULL(load_obj_cache("nonexistent" HE_CACHE_SUFFIX));
+	CU_ASSERT_FALSE(write_obj_cache(NULL, cache));
+
+	free(buf);
+	delete_object(obj);
+	free(obj);
+}
+
+/**
+ * Test that read_obj_file() writes a cache next to the
+ * obj file and uses it as long as it is newer.
+ */
+void test_obj_cache3(void)
+{
+	char const * const filename = "cunit_test_sidecar.obj";
+	char const * const cache = "cunit_test_sidecar.obj" HE_CACHE_SUFFIX;
+	char const * const quad = ""
+		"v 9.0 10.0 11.0\n"
+		"v 11.0 10.0 11.0\n"
+		"v 9.0 11.0 11.0\n"
+		"v 11.0 11.0 11.0\n"
+		"f 1 2 4 3\n";
+	char const * const triangle = ""
+		"v 9.0 10.0 11.0\n"
+		"v 11.0 10.0 11.0\n"
+		"v 9.0 11.0 11.0\n"
+		"f 1 2 3\n";
+	/* file times are too coarse to tell apart files written right now */
+	struct timespec const obj_times[2] = { { 1000, 0 }, { 1000, 0 } };
+	struct timespec const old_times[2] = { { 1, 0 }, { 1, 0 } };
+	struct stat st;
+	HE_obj *obj,
+		   *tri;
+
+	unlink(cache);
+	CU_ASSERT_TRUE(write_string(filename, quad));
+	CU_ASSERT_EQUAL(utimensat(AT_FDCWD, filename, obj_times, 0), 0);
+
+	/* the first read writes the cache */
+	obj = read_obj_file(filename);
+	CU_ASSERT_PTR_NOT_NULL(obj);
+	CU_ASSERT_EQUAL(stat(cache, &st), 0);
+
+	/* a newer cache is used instead of the obj file */
+	tri = parse_obj(triangle);
+	CU_ASSERT_TRUE(write_obj_cache(tri, cache));
+	delete_object(obj);
+	free(obj);
+	obj = read_obj_file(filename);
+	CU_ASSERT_PTR_NOT_NULL(obj);
+	CU_ASSERT_TRUE(obj && objects_equal(obj, tri));
+	delete_object(obj);
+	free(obj);
+
+	/* an outdated cache is ignored and rewritten */
+	CU_ASSERT_EQUAL(utimensat(AT_FDCWD, cache, old_times, 0), 0);
+	obj = read_obj_file(filename);
+	CU_ASSERT_PTR_NOT_NULL(obj);
+	CU_ASSERT_EQUAL(obj->vc, 4);
+	CU_ASSERT_EQUAL(obj->fc, 1);
+	delete_object(obj);
+	free(obj);
+	obj = load_obj_cache(cache);
+	CU_ASSERT_PTR_NOT_NULL(obj);
+	CU_ASSERT_TRUE(obj && obj->vc == 4);
+	delete_object(obj);
+	free(obj);
+
+	delete_object(tri);
+	free(tri);
+	unlink(filename);
+	unlink(cache);
+}
@@ -0,0 +1,215 @@
+/*
+ * Copyright 2011-2014 hasufell
+ *
+ * This file is part of a hasufell project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation version 2 of the License only.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file cunit_half_edge_compact.c
+ * Test functions for the compact half-edge representation.
+ * @brief compact half-edge test functions
+ */
+
+#include "cunit.h"
+#include "filereader.h"
+#include "half_edge.h"
+#include "half_edge_compact.h"
+
+#include <CUnit/Basic.h>
+#include <CUnit/Console.h>
+#include <CUnit/Automated.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+/*
+ * static function declaration
+ */
+static bool cobj_valid(HE_cobj const * const cobj);
+static bool faces_equal(HE_obj const * const a,
+		HE_cobj const * const b);
+
+
+/**
+ * Check the invariants of a compact object: every face loop
+ * is closed and only consists of half-edges bordering that face,
+ * and every half-edge ends where its pair starts.
+ *
+ * @param cobj the compact object
+ * @return true if all invariants hold, false otherwise
+ */
+static bool cobj_valid(HE_cobj const * const cobj)
+{
+	if (cobj->ec % 2)
+		return false;
+
+	for (uint32_t i = 0; i < cobj->ec; i++) {
+		HE_cedge const *edge = &(cobj->edges[i]);
+
+		if (edge->vert >= cobj->vc)
+			return false;
+		if (edge->next != HE_C_NONE &&
+				cobj->edges[edge->next].vert !=
+				cobj->edges[HE_C_PAIR(i)].vert)
+			return false;
+	}
+
+	for (uint32_t i = 0; i < cobj->fc; i++) {
+		uint32_t edge = cobj->face_edges[i];
+		uint32_t steps = 0;
+
+		do {
+			if (cobj->edges[edge].face != i || steps++ > cobj->ec)
+				return false;
+			edge = cobj->edges[edge].next;
+		} while (edge != cobj->face_edges[i]);
+	}
+
+	return true;
+}
+
+/**
+ * Check if all faces of an object and of a compact object
+ * consist of the same vertices in the same order.
+ *
+ * @param a the object
+ * @param b the compact object
+ * @return true if they are the same, false otherwise
+ */
+static bool faces_equal(HE_obj const * const a,
+		HE_cobj const * const b)
+{
+	if (a->fc != b->fc || a->vc != b->vc)
+		return false;
+
+	for (uint32_t i = 0; i < a->fc; i++) {
+		HE_edge const *edge = a->faces[i].edge;
+		uint32_t cedge = b->face_edges[i];
+
+		do {
+			if ((uint32_t)(edge->vert - a->vertices) !=
+					b->edges[cedge].vert)
+				return false;
+			edge = edge->next;
+			cedge = b->edges[cedge].next;
+		} while (edge != a->faces[i].edge);
+
+		if (cedge != b->face_edges[i])
+			return false;
+	}
+
+	return !memcmp(a->positions, b->positions, sizeof(vector) * a->vc);
+}
+
+/**
+ * Convert every file in obj/ into the compact representation
+ * and back, checking that the topology is preserved and
+ * that converting again gives exactly the same compact object.
+ */
+void test_compact_object1(void)
+{
+	obj_dir objs;
+	HE_obj *obj;
+
+	CU_ASSERT_EQUAL(sizeof(HE_cedge), 12);
+
+	if (!open_obj_dir(&objs))
+		return;
+
+	while ((obj = next_obj(&objs))) {
+		HE_obj *expanded;
+		HE_cobj *cobj,
+				*cobj2;
+
+		cobj = compact_object(obj);
+		CU_ASSERT_PTR_NOT_NULL(cobj);
+		CU_ASSERT_TRUE(cobj_valid(cobj));
+		CU_ASSERT_TRUE(faces_equal(obj, cobj));
+
+		expanded = expand_object(cobj);
+		CU_ASSERT_PTR_NOT_NULL(expanded);
+		CU_ASSERT_EQUAL(expanded->ec + expanded->dec, cobj->ec);
+		CU_ASSERT_TRUE(faces_equal(expanded, cobj));
+
+		cobj2 = compact_object(expanded);
+		CU_ASSERT_EQUAL(cobj->ec, cobj2->ec);
+		CU_ASSERT_TRUE(!memcmp(cobj->edges, cobj2->edges,
+					sizeof(HE_cedge) * cobj->ec));
+		CU_ASSERT_TRUE(!memcmp(cobj->vert_edges, cobj2->vert_edges,
+					sizeof(uint32_t) * cobj->vc));
+		CU_ASSERT_TRUE(!memcmp(cobj->face_edges, cobj2->face_edges,
+					sizeof(uint32_t) * cobj->fc));
+
+		delete_compact_object(cobj2);
+		free(cobj2);
+		delete_object(expanded);
+		free(expanded);
+		delete_compact_object(cobj);
+		free(cobj);
+		delete_object(obj);
+		free(obj);
+	}
+}
+
+/**
+ * Test the conversion of a simple quad with four border edges.
+ */
+void test_compact_object2(void)
+{
+	char const * const string = ""
+		"v 9.0 10.0 11.0\n"
+		"v 11.0 10.0 11.0\n"
+		"v 9.0 11.0 11.0\n"
+		"v 11.0 11.0 11.0\n"
+		"f 1 2 4 3\n";
+
+	HE_obj *obj = parse_obj(string);
+	HE_cobj *cobj = compact_object(obj);
+
+	CU_ASSERT_PTR_NOT_NULL(cobj);
+	CU_ASSERT_EQUAL(cobj->ec, 8);
+	CU_ASSERT_EQUAL(cobj->vc, 4);
+	CU_ASSERT_EQUAL(cobj->fc, 1);
+
+	for (uint32_t i = 0; i < cobj->ec; i += 2) {
+		CU_ASSERT_EQUAL(cobj->edges[i].face, 0);
+		CU_ASSERT_EQUAL(cobj->edges[i + 1].face, HE_C_NONE);
+	}
+
+	CU_ASSERT_EQUAL(cobj->edges[0].vert, 0);
+	CU_ASSERT_EQUAL(cobj->edges[1].vert, 1);
+	CU_ASSERT_EQUAL(cobj->edges[2].vert, 1);
+	CU_ASSERT_EQUAL(cobj->edges[4].vert, 3);
+	CU_ASSERT_EQUAL(cobj->edges[6].vert, 2);
+	CU_ASSERT_EQUAL(cobj->edges[0].next, 2);
+	CU_ASSERT_EQUAL(cobj->edges[6].next, 0);
+	CU_ASSERT_EQUAL(cobj->positions[3].z, 11.0);
+
+	delete_compact_object(cobj);
+	free(cobj);
+	delete_object(obj);
+	free(obj);
+}
+
+/**
+ * Test error handling by passing NULL pointers.
+ */
+void test_compact_object3(void)
+{
+	CU_ASSERT_PTR_NULL(compact_object(NULL));
+	CU_ASSERT_PTR_NULL(expand_object(NULL));
+}
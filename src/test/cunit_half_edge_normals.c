@@ -0,0 +1,188 @@
+/*
+ * Copyright 2011-2014 hasufell
+ *
+ * This file is part of a hasufell project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation version 2 of the License only.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file cunit_half_edge_normals.c
+ * Test functions for the batch computation of vertex normals.
+ * @brief vertex normals test functions
+ */
+
+#include "cunit.h"
+#include "filereader.h"
+#include "half_edge.h"
+#include "half_edge_normals.h"
+
+#include <CUnit/Basic.h>
+#include <CUnit/Console.h>
+#include <CUnit/Automated.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+/**
+ * Test that the normals of every object in obj/ are
+ * the same for any count of threads, have length 1 and match
+ * vec_normal() on the regular icosahedron.
+ */
+void test_vertex_normals1(void)
+{
+	obj_dir objs;
+	HE_obj *obj;
+
+	if (!open_obj_dir(&objs))
+		return;
+
+	while ((obj = next_obj(&objs))) {
+		vector *serial;
+
+		for (int w = NORMAL_WEIGHT_AREA; w <= NORMAL_WEIGHT_ANGLE; w++) {
+			CU_ASSERT_TRUE(compute_vertex_normals(obj, w));
+			CU_ASSERT_EQUAL(obj->vnc, obj->vc);
+
+			serial = malloc(sizeof(*serial) * (obj->vc + 1));
+			memcpy(serial, obj->vn, sizeof(*serial) * obj->vc);
+
+			for (unsigned threads = 2; threads <= 7; threads += 5) {
+				CU_ASSERT_TRUE(compute_vertex_normals_parallel(obj, w,
+							threads));
+				CU_ASSERT_FALSE(memcmp(serial, obj->vn,
+							sizeof(*serial) * obj->vc));
+			}
+
+			for (uint32_t i = 0; i < obj->vc; i++) {
+				float const len = obj->vn[i].x * obj->vn[i].x +
+					obj->vn[i].y * obj->vn[i].y +
+					obj->vn[i].z * obj->vn[i].z;
+
+				CU_ASSERT_TRUE(len == 0 || fabs(len - 1) < 0.0001);
+			}
+
+			free(serial);
+		}
+
+		if (!strcmp(objs.path, "obj/icosahedron.obj")) {
+			for (uint32_t i = 0; i < obj->vc; i++) {
+				vector vec;
+
+				CU_ASSERT_TRUE(vec_normal(obj, i, &vec));
+				CU_ASSERT_DOUBLE_EQUAL(vec.x, obj->vn[i].x, 0.0001);
+				CU_ASSERT_DOUBLE_EQUAL(vec.y, obj->vn[i].y, 0.0001);
+				CU_ASSERT_DOUBLE_EQUAL(vec.z, obj->vn[i].z, 0.0001);
+			}
+		}
+
+		delete_object(obj);
+		free(obj);
+	}
+}
+
+/**
+ * Test the weighting on a big and a small face, which
+ * are at a right angle and both have a right angle at the
+ * common vertex.
+ */
+void test_vertex_normals2(void)
+{
+	char const * const string = ""
+		"v 0.0 0.0 0.0\n"
+		"v 10.0 0.0 0.0\n"
+		"v 0.0 10.0 0.0\n"
+		"v 0.0 0.0 -0.1\n"
+		"f 1 2 3\n"
+		"f 2 1 4\n";
+	HE_obj *obj = parse_obj(string);
+	vector vec;
+
+	CU_ASSERT_PTR_NOT_NULL(obj);
+	if (!obj)
+		return;
+
+	/* the big face dominates by its area */
+	CU_ASSERT_TRUE(compute_vertex_normals(obj, NORMAL_WEIGHT_AREA));
+	CU_ASSERT_DOUBLE_EQUAL(obj->vn[0].x, 0, 0.0001);
+	CU_ASSERT_DOUBLE_EQUAL(obj->vn[0].y, -0.01, 0.0001);
+	CU_ASSERT_DOUBLE_EQUAL(obj->vn[0].z, 1, 0.0001);
+
+	/* equal angles weigh both faces the same */
+	CU_ASSERT_TRUE(compute_vertex_normals(obj, NORMAL_WEIGHT_ANGLE));
+	CU_ASSERT_DOUBLE_EQUAL(obj->vn[0].x, 0, 0.0001);
+	CU_ASSERT_DOUBLE_EQUAL(obj->vn[0].y, -M_SQRT1_2, 0.0001);
+	CU_ASSERT_DOUBLE_EQUAL(obj->vn[0].z, M_SQRT1_2, 0.0001);
+
+	CU_ASSERT_TRUE(vec_normal(obj, 0, &vec));
+	CU_ASSERT_DOUBLE_EQUAL(vec.y, obj->vn[0].y, 0.0001);
+	CU_ASSERT_DOUBLE_EQUAL(vec.z, obj->vn[0].z, 0.0001);
+
+	/* vertices of a single face get its normal */
+	CU_ASSERT_DOUBLE_EQUAL(obj->vn[2].z, 1, 0.0001);
+	CU_ASSERT_DOUBLE_EQUAL(obj->vn[3].y, -1, 0.0001);
+
+	delete_object(obj);
+	free(obj);
+}
+
+/**
+ * Test that normals from the file are replaced, that the
+ * array is reused and that isolated vertices and invalid
+ * objects are handled.
+ */
+void test_vertex_normals3(void)
+{
+	char const * const string = ""
+		"v 0.0 0.0 0.0\n"
+		"v 1.0 0.0 0.0\n"
+		"v 1.0 1.0 0.0\n"
+		"v 5.0 5.0 5.0\n"
+		"vn 1.0 0.0 0.0\n"
+		"f 1 2 3\n";
+	HE_obj *obj = parse_obj(string);
+	HE_obj empty;
+	vector *vn;
+
+	CU_ASSERT_PTR_NOT_NULL(obj);
+	if (!obj)
+		return;
+	CU_ASSERT_EQUAL(obj->vnc, 1);
+
+	CU_ASSERT_TRUE(compute_vertex_normals_parallel(obj,
+				NORMAL_WEIGHT_AREA, 0));
+	CU_ASSERT_EQUAL(obj->vnc, 4);
+	CU_ASSERT_DOUBLE_EQUAL(obj->vn[0].z, 1, 0.0001);
+	CU_ASSERT_DOUBLE_EQUAL(obj->vn[1].z, 1, 0.0001);
+	CU_ASSERT_DOUBLE_EQUAL(obj->vn[2].z, 1, 0.0001);
+
+	/* the isolated vertex has no normal */
+	CU_ASSERT_EQUAL(obj->vn[3].x, 0);
+	CU_ASSERT_EQUAL(obj->vn[3].y, 0);
+	CU_ASSERT_EQUAL(obj->vn[3].z, 0);
+
+	vn = obj->vn;
+	CU_ASSERT_TRUE(compute_vertex_normals(obj, NORMAL_WEIGHT_ANGLE));
+	CU_ASSERT_PTR_EQUAL(obj->vn, vn);
+
+	delete_object(obj);
+	free(obj);
+
+	memset(&empty, 0, sizeof(empty));
+	CU_ASSERT_TRUE(compute_vertex_normals(&empty, NORMAL_WEIGHT_AREA));
+	CU_ASSERT_PTR_NULL(empty.vn);
+	CU_ASSERT_FALSE(compute_vertex_normals(NULL, NORMAL_WEIGHT_AREA));
+}
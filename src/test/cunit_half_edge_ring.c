@@ -0,0 +1,182 @@
+/*
+ * Copyright 2011-2014 hasufell
+ *
+ * This file is part of a hasufell project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation version 2 of the License only.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file cunit_half_edge_ring.c
+ * Test functions for the one-ring index.
+ * @brief one-ring index test functions
+ */
+
+#include "cunit.h"
+#include "filereader.h"
+#include "half_edge.h"
+#include "half_edge_ring.h"
+
+#include <CUnit/Basic.h>
+#include <CUnit/Console.h>
+#include <CUnit/Automated.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+/**
+ * Test that the one-ring index of every object in obj/
+ * holds every edge exactly once, in the slice of its
+ * start-vertex.
+ */
+void test_vertex_rings1(void)
+{
+	obj_dir objs;
+	HE_obj *obj;
+
+	if (!open_obj_dir(&objs))
+		return;
+
+	while ((obj = next_obj(&objs))) {
+		HE_ring const *ring;
+		bool *seen;
+
+		ring = get_vertex_rings(obj);
+		CU_ASSERT_PTR_NOT_NULL(ring);
+		CU_ASSERT_PTR_EQUAL(get_vertex_rings(obj), ring);
+		CU_ASSERT_EQUAL(ring->offsets[obj->vc], obj->ec + obj->dec);
+
+		seen = calloc(obj->ec + obj->dec + 1, sizeof(*seen));
+		for (uint32_t v = 0; v < obj->vc; v++) {
+			uint32_t count;
+			uint32_t const *edges = vertex_ring(obj, v, &count);
+
+			for (uint32_t i = 0; i < count; i++) {
+				CU_ASSERT_PTR_EQUAL(obj->edges[edges[i]].vert,
+						&(obj->vertices[v]));
+				CU_ASSERT_FALSE(seen[edges[i]]);
+				seen[edges[i]] = true;
+			}
+		}
+		free(seen);
+
+		delete_object(obj);
+		CU_ASSERT_PTR_NULL(obj->ring);
+		free(obj);
+	}
+}
+
+/**
+ * Test the iterators on two triangles sharing an edge,
+ * including the dummy edges at the border.
+ */
+void test_vertex_rings2(void)
+{
+	char const * const string = ""
+		"v 0.0 0.0 0.0\n"
+		"v 1.0 0.0 0.0\n"
+		"v 1.0 1.0 0.0\n"
+		"v 0.0 1.0 0.0\n"
+		"v 5.0 5.0 5.0\n"
+		"f 1 2 3\n"
+		"f 1 3 4\n";
+	HE_obj *obj = parse_obj(string);
+	HE_ring_iter it;
+	HE_edge *edge;
+	uint32_t edge_c = 0,
+			 dummy_c = 0;
+
+	/* vertex 1 has one edge in every face and a dummy edge */
+	CU_ASSERT_TRUE(ring_iter_init(&it, obj, 0));
+	while ((edge = ring_next_edge(&it))) {
+		CU_ASSERT_PTR_EQUAL(edge->vert, &(obj->vertices[0]));
+		edge_c++;
+		if (!edge->face)
+			dummy_c++;
+	}
+	CU_ASSERT_EQUAL(edge_c, 3);
+	CU_ASSERT_EQUAL(dummy_c, 1);
+
+	CU_ASSERT_TRUE(ring_iter_init(&it, obj, 0));
+	CU_ASSERT_PTR_NOT_NULL(ring_next_face(&it));
+	CU_ASSERT_PTR_NOT_NULL(ring_next_face(&it));
+	CU_ASSERT_PTR_NULL(ring_next_face(&it));
+	CU_ASSERT_PTR_NULL(ring_next_edge(&it));
+
+	/* vertex 2 has one face */
+	CU_ASSERT_TRUE(ring_iter_init(&it, obj, 1));
+	CU_ASSERT_PTR_EQUAL(ring_next_face(&it), &(obj->faces[0]));
+	CU_ASSERT_PTR_NULL(ring_next_face(&it));
+
+	/* isolated and out of range vertices */
+	CU_ASSERT_FALSE(ring_iter_init(&it, obj, 4));
+	CU_ASSERT_PTR_NULL(ring_next_edge(&it));
+	CU_ASSERT_FALSE(ring_iter_init(&it, obj, 5));
+	CU_ASSERT_PTR_NULL(ring_next_edge(&it));
+	CU_ASSERT_FALSE(ring_iter_init(&it, NULL, 0));
+
+	delete_object(obj);
+	free(obj);
+}
+
+/**
+ * Test vertex normals around a pole with a valence
+ * far beyond the old limit of 500.
+ */
+void test_vertex_rings3(void)
+{
+	uint32_t const valence = 2000;
+	char *buf = malloc(64 + (size_t)valence * 96);
+	size_t pos = 0;
+	uint32_t count;
+	HE_obj *obj;
+	vector vec;
+
+	pos += sprintf(buf + pos, "v 0 0 1\n");
+	for (uint32_t i = 0; i < valence; i++) {
+		double const angle = 2 * M_PI * i / valence;
+
+		pos += sprintf(buf + pos, "v %f %f 0\n", cos(angle), sin(angle));
+	}
+	for (uint32_t i = 0; i < valence; i++)
+		pos += sprintf(buf + pos, "f 1 %u %u\n", i + 2,
+				(i + 1) % valence + 2);
+
+	obj = parse_obj_buf(buf, pos);
+	free(buf);
+	CU_ASSERT_PTR_NOT_NULL(obj);
+	if (!obj)
+		return;
+
+	CU_ASSERT_PTR_NOT_NULL(vertex_ring(obj, 0, &count));
+	CU_ASSERT_EQUAL(count, valence);
+
+	/* the faces around the pole cancel out to the z axis */
+	CU_ASSERT_TRUE(vec_normal(obj, 0, &vec));
+	CU_ASSERT_DOUBLE_EQUAL(vec.x, 0, 0.0001);
+	CU_ASSERT_DOUBLE_EQUAL(vec.y, 0, 0.0001);
+	CU_ASSERT_DOUBLE_EQUAL(fabs(vec.z), 1, 0.0001);
+
+	/* the index can be dropped and is rebuilt on demand */
+	delete_vertex_rings(obj);
+	CU_ASSERT_PTR_NULL(obj->ring);
+	CU_ASSERT_TRUE(vec_normal(obj, 1, &vec));
+	CU_ASSERT_PTR_NOT_NULL(obj->ring);
+	CU_ASSERT_FALSE(vec_normal(obj, valence + 1, &vec));
+
+	delete_object(obj);
+	free(obj);
+}
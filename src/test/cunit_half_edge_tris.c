@@ -0,0 +1,297 @@
+/*
+ * Copyright 2011-2014 hasufell
+ *
+ * This file is part of a hasufell project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation version 2 of the License only.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file cunit_half_edge_tris.c
+ * Test functions for the triangulation of faces.
+ * @brief half_edge_tris test functions
+ */
+
+#include "cunit.h"
+#include "filereader.h"
+#include "half_edge.h"
+#include "half_edge_tris.h"
+
+#include <CUnit/Basic.h>
+#include <CUnit/Console.h>
+#include <CUnit/Automated.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+/*
+ * static function declaration
+ */
+static double triangle_area_z(HE_obj const * const obj,
+		uint32_t const * const tri);
+
+
+/**
+ * Calculate the signed area of a triangle in the xy plane.
+ *
+ * @param obj the object
+ * @param tri the three vertex indices of the triangle
+ * @return the area, positive if counter-clockwise
+ */
+static double triangle_area_z(HE_obj const * const obj,
+		uint32_t const * const tri)
+{
+	vector const *a = &(obj->positions[tri[0]]),
+		  *b = &(obj->positions[tri[1]]),
+		  *c = &(obj->positions[tri[2]]);
+
+	return ((double)(b->x - a->x) * (c->y - a->y) -
+			(double)(b->y - a->y) * (c->x - a->x)) / 2;
+}
+
+/**
+ * Test the triangles of every object in obj/: every face has
+ * corners - 2 triangles of its own corners, which add up to the
+ * Newell vector of the face, however it was split.
+ */
+void test_face_triangles1(void)
+{
+	obj_dir objs;
+	HE_obj *obj;
+
+	if (!open_obj_dir(&objs))
+		return;
+
+	while ((obj = next_obj(&objs))) {
+		HE_tris const *tris;
+		bool corners_ok = true,
+			 area_ok = true;
+
+		tris = get_face_triangles(obj);
+		CU_ASSERT_PTR_NOT_NULL(tris);
+		CU_ASSERT_PTR_EQUAL(get_face_triangles(obj), tris);
+		CU_ASSERT_EQUAL(tris->offsets[obj->fc], tris->index_c);
+
+		for (uint32_t i = 0; i < obj->fc; i++) {
+			HE_edge const * const start = obj->faces[i].edge;
+			HE_edge const *edge = start;
+			uint32_t corner_c = 0;
+			double newell[3] = { 0, 0, 0 },
+				   sum[3] = { 0, 0, 0 },
+				   size = 0;
+
+			do {
+				vector const *cur = edge->vert->vec,
+					  *next = edge->next->vert->vec;
+
+				newell[0] += (double)(cur->y - next->y) * (cur->z + next->z);
+				newell[1] += (double)(cur->z - next->z) * (cur->x + next->x);
+				newell[2] += (double)(cur->x - next->x) * (cur->y + next->y);
+				size += fabs(cur->x) + fabs(cur->y) + fabs(cur->z);
+				corner_c++;
+			} while ((edge = edge->next) != start);
+
+			corners_ok = corners_ok && tris->offsets[i + 1] -
+				tris->offsets[i] == 3 * (corner_c - 2);
+
+			for (uint32_t j = tris->offsets[i]; j < tris->offsets[i + 1];
+					j += 3) {
+				vector const *a = &(obj->positions[tris->indices[j]]),
+					  *b = &(obj->positions[tris->indices[j + 1]]),
+					  *c = &(obj->positions[tris->indices[j + 2]]);
+				double const u[3] = { b->x - a->x, b->y - a->y, b->z - a->z },
+					  v[3] = { c->x - a->x, c->y - a->y, c->z - a->z };
+
+				sum[0] += u[1] * v[2] - u[2] * v[1];
+				sum[1] += u[2] * v[0] - u[0] * v[2];
+				sum[2] += u[0] * v[1] - u[1] * v[0];
+
+				for (uint32_t k = j; k < j + 3; k++) {
+					bool found = false;
+
+					edge = start;
+					do {
+						found = found || tris->indices[k] ==
+							(uint32_t)(edge->vert - obj->vertices);
+					} while ((edge = edge->next) != start);
+					corners_ok = corners_ok && found;
+				}
+			}
+
+			size = size * size / corner_c / corner_c;
+			for (uint32_t k = 0; k < 3; k++)
+				area_ok = area_ok &&
+					fabs(sum[k] - newell[k]) <= 0.0001 * (size + 1);
+		}
+		CU_ASSERT_TRUE(corners_ok);
+		CU_ASSERT_TRUE(area_ok);
+
+		delete_object(obj);
+		free(obj);
+	}
+}
+
+/**
+ * Test concave faces, which a fan around their first corner
+ * would draw outside of the face: a dart whose first corner
+ * is next to the reflex one, and a star with more corners
+ * than fit on the stack.
+ */
+void test_face_triangles2(void)
+{
+	char const * const dart = ""
+		"v 0.0 0.0 0.0\n"
+		"v 2.0 1.0 0.0\n"
+		"v 4.0 0.0 0.0\n"
+		"v 2.0 3.0 0.0\n"
+		"f 2 3 4 1\n";
+	uint32_t const spikes = HE_TRIS_STACK_CORNERS;
+	char *star = malloc(64 * (2 * spikes + 1) + 64);
+	size_t len = 0;
+	HE_obj *obj = parse_obj(dart);
+	HE_tris const *tris;
+	double area = 0,
+		   star_area = 0;
+	bool positive = true;
+
+	CU_ASSERT_PTR_NOT_NULL(obj);
+	if (!obj)
+		return;
+
+	/* the face starts at the corner of vertex 1 */
+	CU_ASSERT_EQUAL(obj->faces[0].edge->vert - obj->vertices, 0);
+	tris = get_face_triangles(obj);
+	CU_ASSERT_EQUAL(tris->index_c, 6);
+	for (uint32_t i = 0; i < tris->index_c; i += 3) {
+		positive = positive && triangle_area_z(obj, tris->indices + i) > 0;
+		area += triangle_area_z(obj, tris->indices + i);
+	}
+	CU_ASSERT_TRUE(positive);
+	CU_ASSERT_DOUBLE_EQUAL(area, 4, 0.00001);
+	delete_object(obj);
+	free(obj);
+
+	/* clockwise, seen from +z */
+	for (uint32_t i = 0; i < 2 * spikes; i++) {
+		double const angle = -M_PI * i / spikes,
+			  radius = i % 2 ? 0.5 : 1;
+
+		len += sprintf(star + len, "v %f %f 0.0\n",
+				radius * cos(angle), radius * sin(angle));
+	}
+	len += sprintf(star + len, "f");
+	for (uint32_t i = 0; i < 2 * spikes; i++)
+		len += sprintf(star + len, " %u", (unsigned)(i + 1));
+	sprintf(star + len, "\n");
+
+	obj = parse_obj(star);
+	free(star);
+	CU_ASSERT_PTR_NOT_NULL(obj);
+	if (!obj)
+		return;
+
+	for (uint32_t i = 0; i < obj->vc; i++) {
+		vector const *a = &(obj->positions[i]),
+			  *b = &(obj->positions[(i + 1) % obj->vc]);
+
+		star_area += ((double)a->x * b->y - (double)b->x * a->y) / 2;
+	}
+	CU_ASSERT_TRUE(star_area < 0);
+
+	tris = get_face_triangles(obj);
+	CU_ASSERT_EQUAL(tris->index_c, 3 * (2 * spikes - 2));
+	area = 0;
+	positive = true;
+	for (uint32_t i = 0; i < tris->index_c; i += 3) {
+		positive = positive && triangle_area_z(obj, tris->indices + i) < 0;
+		area += triangle_area_z(obj, tris->indices + i);
+	}
+	CU_ASSERT_TRUE(positive);
+	CU_ASSERT_DOUBLE_EQUAL(area, star_area, 0.0001);
+
+	delete_object(obj);
+	free(obj);
+}
+
+/**
+ * Test triangulating single faces again after their
+ * vertices moved, and invalid input.
+ */
+void test_face_triangles3(void)
+{
+	char const * const string = ""
+		"v 0.0 0.0 0.0\n"
+		"v 2.0 1.0 0.0\n"
+		"v 4.0 0.0 0.0\n"
+		"v 2.0 3.0 0.0\n"
+		"v 5.0 5.0 0.0\n"
+		"f 2 3 4 1\n"
+		"f 3 5 4\n";
+	HE_obj *obj = parse_obj(string);
+	HE_tris const *tris;
+	uint32_t const face = 0,
+		  bad_face = 2,
+		  faces[2] = { 0, 2 };
+	uint32_t first[6],
+			 second[3],
+			 version;
+	bool positive = true;
+
+	CU_ASSERT_PTR_NOT_NULL(obj);
+	if (!obj)
+		return;
+
+	/* builds all of them */
+	CU_ASSERT_TRUE(update_face_triangles(obj, NULL, 0));
+	tris = obj->tris;
+	CU_ASSERT_PTR_NOT_NULL(tris);
+	CU_ASSERT_EQUAL(tris->index_c, 9);
+	memcpy(second, tris->indices + 6, sizeof(second));
+
+	/* move the reflex corner of the dart to the other side */
+	obj->positions[1].y = -1;
+	obj->positions[0].y = 0.5f;
+	version = obj->version;
+	CU_ASSERT_TRUE(update_face_triangles(obj, &face, 1));
+	CU_ASSERT_PTR_EQUAL(obj->tris, tris);
+	CU_ASSERT_EQUAL(obj->version, version + 1);
+	for (uint32_t i = 0; i < 6; i += 3)
+		positive = positive && triangle_area_z(obj, tris->indices + i) > 0;
+	CU_ASSERT_TRUE(positive);
+	CU_ASSERT_FALSE(memcmp(second, tris->indices + 6, sizeof(second)));
+
+	CU_ASSERT_FALSE(update_face_triangles(obj, &bad_face, 1));
+
+	/* a bad face after a good one changes nothing */
+	memcpy(first, tris->indices, sizeof(first));
+	obj->positions[1].y = 1;
+	obj->positions[0].y = 0;
+	version = obj->version;
+	CU_ASSERT_FALSE(update_face_triangles(obj, faces, 2));
+	CU_ASSERT_FALSE(memcmp(first, tris->indices, sizeof(first)));
+	CU_ASSERT_EQUAL(obj->version, version);
+
+	CU_ASSERT_FALSE(update_face_triangles(obj, NULL, 1));
+	CU_ASSERT_FALSE(update_face_triangles(NULL, &face, 1));
+	CU_ASSERT_PTR_NULL(get_face_triangles(NULL));
+
+	delete_face_triangles(obj);
+	CU_ASSERT_PTR_NULL(obj->tris);
+	delete_face_triangles(obj);
+
+	delete_object(obj);
+	free(obj);
+}
@@ -0,0 +1,165 @@
+/*
+ * Copyright 2011-2014 hasufell
+ *
+ * This file is part of a hasufell project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation version 2 of the License only.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file cunit_load_stats.c
+ * Test functions for the statistics of loading objects.
+ * @brief load_stats test functions
+ */
+
+#include "half_edge.h"
+#include "load_stats.h"
+
+#include <CUnit/Basic.h>
+#include <CUnit/Console.h>
+#include <CUnit/Automated.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+/**
+ * Test adding up stages.
+ */
+void test_load_stats1(void)
+{
+	load_stats stats;
+	load_sample sample;
+
+	init_load_stats(&stats);
+	for (uint32_t i = 0; i < LOAD_STAGE_C; i++)
+		CU_ASSERT_FALSE(stats.stages[i].ran);
+
+	take_load_sample(&sample);
+	CU_ASSERT_TRUE(sample.time > 0);
+	CU_ASSERT_TRUE(sample.peak_rss > 0);
+
+	add_load_stage(&stats, LOAD_STAGE_PARSE, &sample, 10);
+	add_load_stage(&stats, LOAD_STAGE_PARSE, &sample, 5);
+	CU_ASSERT_TRUE(stats.stages[LOAD_STAGE_PARSE].ran);
+	CU_ASSERT_EQUAL(stats.stages[LOAD_STAGE_PARSE].items, 15);
+	CU_ASSERT_TRUE(stats.stages[LOAD_STAGE_PARSE].seconds >= 0);
+	CU_ASSERT_TRUE(stats.stages[LOAD_STAGE_PARSE].peak_rss >= 0);
+	CU_ASSERT_FALSE(stats.stages[LOAD_STAGE_READ].ran);
+
+	/* invalid stages are ignored */
+	add_load_stage(&stats, LOAD_STAGE_C, &sample, 1);
+	add_load_stage(NULL, LOAD_STAGE_READ, &sample, 1);
+	add_load_stage(&stats, LOAD_STAGE_READ, NULL, 1);
+	CU_ASSERT_FALSE(stats.stages[LOAD_STAGE_READ].ran);
+
+	CU_ASSERT_STRING_EQUAL(load_stage_name(LOAD_STAGE_STAGE2), "stage2");
+	CU_ASSERT_STRING_EQUAL(load_stage_name(LOAD_STAGE_C), "unknown");
+}
+
+/**
+ * Test the stats of parsing a cube with one and with
+ * several threads, which are only recorded with -DLOAD_STATS.
+ */
+void test_load_stats2(void)
+{
+	char const * const string = ""
+		"v 0.0 0.0 0.0\n"
+		"v 1.0 0.0 0.0\n"
+		"v 1.0 1.0 0.0\n"
+		"v 0.0 1.0 0.0\n"
+		"v 0.0 0.0 1.0\n"
+		"v 1.0 0.0 1.0\n"
+		"v 1.0 1.0 1.0\n"
+		"v 0.0 1.0 1.0\n"
+		"f 1 4 3 2\n"
+		"f 5 6 7 8\n"
+		"f 1 2 6 5\n"
+		"f 2 3 7 6\n"
+		"f 3 4 8 7\n";
+
+	for (unsigned threads = 1; threads <= 4; threads += 3) {
+		load_stats stats;
+		HE_obj *obj;
+
+		init_load_stats(&stats);
+		obj = parse_obj_stats(string, strlen(string), threads, &stats);
+		CU_ASSERT_PTR_NOT_NULL(obj);
+		if (!obj)
+			return;
+
+		CU_ASSERT_EQUAL(obj->vc, 8);
+		CU_ASSERT_EQUAL(obj->fc, 5);
+		/* the open side */
+		CU_ASSERT_EQUAL(obj->dec, 4);
+
+		if (LOAD_STATS_ENABLED) {
+			CU_ASSERT_EQUAL(stats.stages[LOAD_STAGE_PARSE].items, 13);
+			CU_ASSERT_EQUAL(stats.stages[LOAD_STAGE_STAGE1].items, 8);
+			CU_ASSERT_EQUAL(stats.stages[LOAD_STAGE_STAGE2].items, 20);
+			CU_ASSERT_EQUAL(stats.stages[LOAD_STAGE_STAGE3].items, 4);
+			CU_ASSERT_EQUAL(stats.stages[LOAD_STAGE_CLEANUP].items, 5);
+			CU_ASSERT_FALSE(stats.stages[LOAD_STAGE_READ].ran);
+			CU_ASSERT_FALSE(stats.stages[LOAD_STAGE_CACHE].ran);
+			/* the raw arrays are gone again, the heap is unknown
+			 * with a replaced malloc() such as the one of ASan */
+			CU_ASSERT_TRUE(stats.stages[LOAD_STAGE_CLEANUP].bytes <= 0);
+		} else {
+			for (uint32_t i = 0; i < LOAD_STAGE_C; i++)
+				CU_ASSERT_FALSE(stats.stages[i].ran);
+		}
+
+		delete_object(obj);
+		free(obj);
+	}
+
+	CU_ASSERT_PTR_NULL(parse_obj_stats(NULL, 0, 1, NULL));
+}
+
+/**
+ * Test printing only the stages which ran.
+ */
+void test_load_stats3(void)
+{
+	load_stats stats;
+	FILE *out = tmpfile();
+	char text[1024];
+	size_t len;
+
+	CU_ASSERT_PTR_NOT_NULL(out);
+	if (!out)
+		return;
+
+	init_load_stats(&stats);
+	stats.stages[LOAD_STAGE_STAGE3].ran = true;
+	stats.stages[LOAD_STAGE_STAGE3].seconds = 0.0125;
+	stats.stages[LOAD_STAGE_STAGE3].bytes = 2048;
+	stats.stages[LOAD_STAGE_STAGE3].items = 42;
+
+	print_load_stats(out, "cube.obj", &stats);
+	print_load_stats(out, NULL, NULL);
+	print_load_stats(NULL, "cube.obj", &stats);
+
+	rewind(out);
+	len = fread(text, 1, sizeof(text) - 1, out);
+	text[len] = '\0';
+	fclose(out);
+
+	CU_ASSERT_PTR_NOT_NULL(strstr(text, "cube.obj:\n"));
+	CU_ASSERT_PTR_NOT_NULL(strstr(text, "stage3"));
+	CU_ASSERT_PTR_NOT_NULL(strstr(text, "12.500"));
+	CU_ASSERT_PTR_NOT_NULL(strstr(text, "42\n"));
+	CU_ASSERT_PTR_NOT_NULL(strstr(text, "total"));
+	CU_ASSERT_PTR_NULL(strstr(text, "parse"));
+}
@@ -0,0 +1,263 @@
+/*
+ * Copyright 2011-2014 hasufell
+ *
+ * This file is part of a hasufell project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation version 2 of the License only.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file cunit_mesh_batch.c
+ * Test functions for the triangulated vertex arrays of objects.
+ * @brief mesh_batch test functions
+ */
+
+#include "cunit.h"
+#include "filereader.h"
+#include "half_edge.h"
+#include "half_edge_normals.h"
+#include "mesh_batch.h"
+
+#include <CUnit/Basic.h>
+#include <CUnit/Console.h>
+#include <CUnit/Automated.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+/**
+ * Test the batches of every object in obj/: every face
+ * becomes corners - 2 triangles of its own vertices.
+ */
+void test_mesh_batch1(void)
+{
+	obj_dir objs;
+	HE_obj *obj;
+
+	if (!open_obj_dir(&objs))
+		return;
+
+	while ((obj = next_obj(&objs))) {
+		mesh_batch batch = { NULL, 0, NULL, 0, 0 };
+		uint32_t index_c = 0,
+				 pos = 0;
+		bool in_range = true;
+
+		CU_ASSERT_TRUE(build_mesh_batch(obj, &batch));
+		CU_ASSERT_EQUAL(batch.vertex_c, obj->vc);
+		CU_ASSERT_EQUAL(batch.version, obj->version);
+
+		for (uint32_t i = 0; i < obj->fc; i++) {
+			HE_edge const *edge = obj->faces[i].edge;
+			uint32_t corner_c = 0;
+
+			do {
+				corner_c++;
+			} while ((edge = edge->next) != obj->faces[i].edge);
+
+			/* the triangles only use corners of their face */
+			for (uint32_t j = 0; j + 2 < corner_c; j++) {
+				for (uint32_t k = 0; k < 3; k++, pos++) {
+					bool found = false;
+
+					edge = obj->faces[i].edge;
+					do {
+						found = found || (pos < batch.index_c &&
+								batch.indices[pos] == (uint32_t)
+								(edge->vert - obj->vertices));
+					} while ((edge = edge->next) != obj->faces[i].edge);
+					in_range = in_range && found;
+				}
+			}
+			index_c += corner_c >= 3 ? 3 * (corner_c - 2) : 0;
+		}
+		CU_ASSERT_EQUAL(batch.index_c, index_c);
+		CU_ASSERT_TRUE(in_range);
+
+		for (uint32_t i = 0; i < batch.index_c; i++)
+			in_range = in_range && batch.indices[i] < obj->vc;
+		CU_ASSERT_TRUE(in_range);
+
+		for (uint32_t i = 0; i < obj->vc; i++)
+			in_range = in_range &&
+				batch.vertices[i].pos[0] == obj->positions[i].x &&
+				batch.vertices[i].pos[1] == obj->positions[i].y &&
+				batch.vertices[i].pos[2] == obj->positions[i].z;
+		CU_ASSERT_TRUE(in_range);
+
+		delete_mesh_batch(&batch);
+		delete_object(obj);
+		free(obj);
+	}
+}
+
+/**
+ * Test the triangles, colors and normals of a quad
+ * and a triangle.
+ */
+void test_mesh_batch2(void)
+{
+	char const * const string = ""
+		"v 0.0 0.0 0.0\n"
+		"v 1.0 0.0 0.0\n"
+		"v 1.0 1.0 0.0\n"
+		"v 0.0 1.0 0.0\n"
+		"v 2.0 0.0 0.0\n"
+		"f 1 2 3 4\n"
+		"f 2 5 3\n";
+	/* the edge of a face starts at its last corner, the
+	 * winding stays the same */
+	uint32_t const indices[9] = { 3, 0, 1, 3, 1, 2, 2, 1, 4 };
+	HE_obj *obj = parse_obj(string);
+	mesh_batch batch = { NULL, 0, NULL, 0, 0 };
+
+	CU_ASSERT_PTR_NOT_NULL(obj);
+	if (!obj)
+		return;
+
+	CU_ASSERT_TRUE(build_mesh_batch(obj, &batch));
+	CU_ASSERT_EQUAL(batch.index_c, 9);
+	CU_ASSERT_FALSE(memcmp(batch.indices, indices, sizeof(indices)));
+
+	/* no normals and no colors yet */
+	CU_ASSERT_EQUAL(batch.vertices[2].normal[2], 0);
+	CU_ASSERT_EQUAL(batch.vertices[2].color[0], 0);
+
+	obj->colors[2].red = 0.5;
+	obj->colors[2].green = 0.25;
+	obj->colors[2].blue = 1;
+	obj->version++;
+	CU_ASSERT_TRUE(update_mesh_batch_colors(obj, &batch));
+	CU_ASSERT_EQUAL(batch.vertices[2].color[0], 0.5f);
+	CU_ASSERT_EQUAL(batch.vertices[2].color[1], 0.25f);
+	CU_ASSERT_EQUAL(batch.vertices[2].color[2], 1);
+	CU_ASSERT_EQUAL(batch.version, obj->version);
+
+	/* computing normals makes the batch outdated */
+	CU_ASSERT_TRUE(compute_vertex_normals(obj, NORMAL_WEIGHT_AREA));
+	CU_ASSERT_NOT_EQUAL(batch.version, obj->version);
+	CU_ASSERT_TRUE(build_mesh_batch(obj, &batch));
+	CU_ASSERT_EQUAL(batch.version, obj->version);
+	CU_ASSERT_DOUBLE_EQUAL(batch.vertices[2].normal[2], 1, 0.0001);
+	CU_ASSERT_EQUAL(batch.vertices[2].color[1], 0.25f);
+
+	delete_mesh_batch(&batch);
+	delete_object(obj);
+	free(obj);
+}
+
+/**
+ * Test rebuilding a batch from another object and the
+ * handling of invalid input.
+ */
+void test_mesh_batch3(void)
+{
+	char const * const quad = ""
+		"v 0.0 0.0 0.0\n"
+		"v 1.0 0.0 0.0\n"
+		"v 1.0 1.0 0.0\n"
+		"v 0.0 1.0 0.0\n"
+		"f 1 2 3 4\n";
+	char const * const tri = ""
+		"v 0.0 0.0 0.0\n"
+		"v 1.0 0.0 0.0\n"
+		"v 1.0 1.0 0.0\n"
+		"f 1 2 3\n";
+	HE_obj *quad_obj = parse_obj(quad),
+		   *tri_obj = parse_obj(tri);
+	mesh_batch batch = { NULL, 0, NULL, 0, 0 };
+
+	CU_ASSERT_PTR_NOT_NULL(quad_obj);
+	CU_ASSERT_PTR_NOT_NULL(tri_obj);
+	if (!quad_obj || !tri_obj)
+		return;
+
+	CU_ASSERT_TRUE(build_mesh_batch(quad_obj, &batch));
+	CU_ASSERT_EQUAL(batch.index_c, 6);
+	CU_ASSERT_TRUE(build_mesh_batch(tri_obj, &batch));
+	CU_ASSERT_EQUAL(batch.index_c, 3);
+	CU_ASSERT_EQUAL(batch.vertex_c, 3);
+
+	/* the colors of another object don't fit */
+	CU_ASSERT_FALSE(update_mesh_batch_colors(quad_obj, &batch));
+	CU_ASSERT_FALSE(build_mesh_batch(NULL, &batch));
+	CU_ASSERT_FALSE(build_mesh_batch(tri_obj, NULL));
+
+	delete_mesh_batch(&batch);
+	CU_ASSERT_PTR_NULL(batch.vertices);
+	CU_ASSERT_EQUAL(batch.index_c, 0);
+	delete_mesh_batch(NULL);
+
+	delete_object(quad_obj);
+	free(quad_obj);
+	delete_object(tri_obj);
+	free(tri_obj);
+}
+
+/**
+ * Test the lines of the vertex normals of a flat quad
+ * and that they need normals for all vertices.
+ */
+void test_mesh_batch4(void)
+{
+	char const * const quad = ""
+		"v 0.0 0.0 0.0\n"
+		"v 1.0 0.0 0.0\n"
+		"v 1.0 1.0 0.0\n"
+		"v 0.0 1.0 0.0\n"
+		"f 1 2 3 4\n";
+	HE_obj *obj = parse_obj(quad);
+	normal_lines lines = { NULL, 0, 0, 0 };
+
+	CU_ASSERT_PTR_NOT_NULL(obj);
+	if (!obj)
+		return;
+
+	/* the string has no vertex normals */
+	CU_ASSERT_FALSE(build_normal_lines(obj, 0.5f, &lines));
+	CU_ASSERT_TRUE(compute_vertex_normals(obj, NORMAL_WEIGHT_AREA));
+
+	CU_ASSERT_TRUE(build_normal_lines(obj, 0.5f, &lines));
+	CU_ASSERT_EQUAL(lines.point_c, 8);
+	CU_ASSERT_EQUAL(lines.scale, 0.5f);
+	CU_ASSERT_EQUAL(lines.version, obj->version);
+	for (uint32_t i = 0; i < obj->vc; i++) {
+		vector const *from = &(lines.points[2 * i]),
+			  *to = &(lines.points[2 * i + 1]);
+
+		CU_ASSERT_EQUAL(from->x, obj->positions[i].x);
+		CU_ASSERT_EQUAL(from->y, obj->positions[i].y);
+		CU_ASSERT_EQUAL(to->x, from->x);
+		CU_ASSERT_EQUAL(to->y, from->y);
+		CU_ASSERT_DOUBLE_EQUAL(to->z - from->z, 0.5, 0.00001);
+	}
+
+	/* a new length moves the tips only */
+	CU_ASSERT_TRUE(build_normal_lines(obj, 0.25f, &lines));
+	CU_ASSERT_EQUAL(lines.point_c, 8);
+	CU_ASSERT_DOUBLE_EQUAL(lines.points[3].z - lines.points[2].z,
+			0.25, 0.00001);
+
+	CU_ASSERT_FALSE(build_normal_lines(NULL, 1, &lines));
+	CU_ASSERT_FALSE(build_normal_lines(obj, 1, NULL));
+
+	delete_normal_lines(&lines);
+	CU_ASSERT_PTR_NULL(lines.points);
+	CU_ASSERT_EQUAL(lines.point_c, 0);
+	delete_normal_lines(NULL);
+
+	delete_object(obj);
+	free(obj);
+}
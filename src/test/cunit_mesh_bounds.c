@@ -0,0 +1,200 @@
+/*
+ * Copyright 2011-2014 hasufell
+ *
+ * This file is part of a hasufell project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation version 2 of the License only.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file cunit_mesh_bounds.c
+ * Test functions for the bounds of meshes.
+ * @brief mesh_bounds test functions
+ */
+
+#include "cunit.h"
+#include "filereader.h"
+#include "half_edge.h"
+#include "mesh_bounds.h"
+
+#include <CUnit/Basic.h>
+#include <CUnit/Console.h>
+#include <CUnit/Automated.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+/**
+ * Test the bounds of every object in obj/ against plain
+ * loops, with one and with several threads.
+ */
+void test_mesh_bounds1(void)
+{
+	obj_dir objs;
+	HE_obj *obj;
+
+	if (!open_obj_dir(&objs))
+		return;
+
+	while ((obj = next_obj(&objs))) {
+		mesh_bounds bounds,
+					mt_bounds;
+		vector lo,
+			   hi;
+		double x = 0,
+			   y = 0,
+			   z = 0;
+
+		CU_ASSERT_TRUE(get_mesh_bounds(obj, 1, &bounds));
+		CU_ASSERT_TRUE(get_mesh_bounds(obj, 0, &mt_bounds));
+		CU_ASSERT_FALSE(memcmp(&bounds, &mt_bounds, sizeof(bounds)));
+
+		if (!obj->vc) {
+			delete_object(obj);
+			free(obj);
+			continue;
+		}
+
+		lo = hi = obj->positions[0];
+		for (uint32_t i = 0; i < obj->vc; i++) {
+			vector const *pos = &(obj->positions[i]);
+
+			lo.x = fminf(lo.x, pos->x);
+			lo.y = fminf(lo.y, pos->y);
+			lo.z = fminf(lo.z, pos->z);
+			hi.x = fmaxf(hi.x, pos->x);
+			hi.y = fmaxf(hi.y, pos->y);
+			hi.z = fmaxf(hi.z, pos->z);
+			x += pos->x;
+			y += pos->y;
+			z += pos->z;
+		}
+
+		/* compared by value, as -0 and 0 are the same */
+		CU_ASSERT_EQUAL(lo.x, bounds.min.x);
+		CU_ASSERT_EQUAL(lo.y, bounds.min.y);
+		CU_ASSERT_EQUAL(lo.z, bounds.min.z);
+		CU_ASSERT_EQUAL(hi.x, bounds.max.x);
+		CU_ASSERT_EQUAL(hi.y, bounds.max.y);
+		CU_ASSERT_EQUAL(hi.z, bounds.max.z);
+		CU_ASSERT_DOUBLE_EQUAL(bounds.center.x, x / obj->vc,
+				0.00001 * (1 + fabs(x / obj->vc)));
+		CU_ASSERT_DOUBLE_EQUAL(bounds.center.y, y / obj->vc,
+				0.00001 * (1 + fabs(y / obj->vc)));
+		CU_ASSERT_DOUBLE_EQUAL(bounds.center.z, z / obj->vc,
+				0.00001 * (1 + fabs(z / obj->vc)));
+		CU_ASSERT_TRUE(bounds.scale > 0);
+
+		delete_object(obj);
+		free(obj);
+	}
+}
+
+/**
+ * Test a set of positions big enough for several threads,
+ * whose centroid is lost when it is summed up in float.
+ */
+void test_mesh_bounds2(void)
+{
+	uint32_t const n = 4 * MESH_BOUNDS_PART_MIN + 7;
+	vector *positions = malloc(sizeof(*positions) * n);
+	vector const offset = { -10000.5f, 0, 0 };
+	mesh_bounds bounds,
+				mt_bounds;
+
+	for (uint32_t i = 0; i < n; i++) {
+		positions[i].x = 10000.5f;
+		positions[i].y = i % 2 ? -3.0f : 1.0f;
+		positions[i].z = (float)(i % 1000);
+	}
+	positions[n / 2].x = 10001.5f;
+	positions[n / 3].x = 9999.5f;
+
+	CU_ASSERT_TRUE(positions_bounds(positions, n, 1, &bounds));
+	CU_ASSERT_TRUE(positions_bounds(positions, n, 4, &mt_bounds));
+
+	CU_ASSERT_EQUAL(bounds.center.x, 10000.5f);
+	CU_ASSERT_EQUAL(mt_bounds.center.x, 10000.5f);
+	CU_ASSERT_DOUBLE_EQUAL(bounds.center.y, -1, 0.00001);
+	CU_ASSERT_EQUAL(bounds.min.x, 9999.5f);
+	CU_ASSERT_EQUAL(bounds.max.x, 10001.5f);
+	CU_ASSERT_EQUAL(bounds.min.y, -3);
+	CU_ASSERT_EQUAL(bounds.max.y, 1);
+	CU_ASSERT_EQUAL(bounds.max.z, 999);
+	CU_ASSERT_FALSE(memcmp(&(bounds.min), &(mt_bounds.min),
+				sizeof(vector) * 2));
+	CU_ASSERT_EQUAL(bounds.scale, 1 / 999.0f);
+
+	/* move to the origin and scale to a size of 1 */
+	CU_ASSERT_TRUE(transform_positions(positions, n, &offset,
+				bounds.scale, 4));
+	CU_ASSERT_TRUE(positions_bounds(positions, n, 4, &bounds));
+	CU_ASSERT_DOUBLE_EQUAL(bounds.min.x, -1 / 999.0, 0.000001);
+	CU_ASSERT_DOUBLE_EQUAL(bounds.max.z, 1, 0.000001);
+	CU_ASSERT_DOUBLE_EQUAL(bounds.center.x, 0, 0.000001);
+
+	free(positions);
+}
+
+/**
+ * Test normalizing an object with several bezier curves
+ * and the handling of empty and invalid input.
+ */
+void test_mesh_bounds3(void)
+{
+	char const * const string = ""
+		"v 0.0 0.0 0.0\n"
+		"v 4.0 0.0 0.0\n"
+		"v 4.0 2.0 0.0\n"
+		"f 1 2 3\n";
+	vector curve1[2] = { { 4, 0, 0 }, { 0, 2, 0 } },
+		   curve2[2] = { { 8, 0, 0 }, { 0, 8, 0 } },
+		   curve3[2] = { { 0, 0, 4 }, { 2, 2, 2 } };
+	bez_curv curves[3] = { { curve1, 1 }, { curve2, 1 }, { curve3, 1 } };
+	HE_obj *obj = parse_obj(string);
+	bez_curv *parsed_curves;
+	uint32_t parsed_bzc;
+	mesh_bounds bounds;
+
+	CU_ASSERT_PTR_NOT_NULL(obj);
+	if (!obj)
+		return;
+
+	/* every curve is scaled, not just every second one */
+	parsed_curves = obj->bez_curves;
+	parsed_bzc = obj->bzc;
+	obj->bez_curves = curves;
+	obj->bzc = 3;
+	CU_ASSERT_TRUE(normalize_object(obj));
+	CU_ASSERT_EQUAL(obj->positions[1].x, 1);
+	CU_ASSERT_EQUAL(obj->positions[2].y, 0.5f);
+	CU_ASSERT_EQUAL(curve1[0].x, 1);
+	CU_ASSERT_EQUAL(curve2[1].y, 2);
+	CU_ASSERT_EQUAL(curve3[0].z, 1);
+	obj->bez_curves = parsed_curves;
+	obj->bzc = parsed_bzc;
+
+	delete_object(obj);
+	free(obj);
+
+	CU_ASSERT_TRUE(positions_bounds(NULL, 0, 0, &bounds));
+	CU_ASSERT_TRUE(is_null_vector(&(bounds.center)));
+	CU_ASSERT_EQUAL(bounds.scale, 1);
+	CU_ASSERT_FALSE(positions_bounds(NULL, 1, 0, &bounds));
+	CU_ASSERT_FALSE(get_mesh_bounds(NULL, 0, &bounds));
+	CU_ASSERT_TRUE(transform_positions(NULL, 0, NULL, 2, 0));
+	CU_ASSERT_FALSE(transform_positions(NULL, 1, NULL, 2, 0));
+}
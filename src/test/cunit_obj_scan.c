@@ -0,0 +1,140 @@
+/*
+ * Copyright 2011-2014 hasufell
+ *
+ * This file is part of a hasufell project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation version 2 of the License only.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file cunit_obj_scan.c
+ * Test functions for the .obj text scanner.
+ * @brief obj scanner test functions
+ */
+
+#include "obj_scan.h"
+
+#include <CUnit/Basic.h>
+#include <CUnit/Console.h>
+#include <CUnit/Automated.h>
+#include <locale.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+/**
+ * Compare the converted numbers bit by bit with strtod(),
+ * covering both the fast path and the fallback.
+ */
+void test_scan_double1(void)
+{
+	char const * const numbers[] = {
+		"0", "-0.0", "1", "6.892648", "-1.586767", "0.000001",
+		"123456789.123456789", "1e-5", "2.5E+3", "-7.e2",
+		".5", "9007199254740993", "1.7976931348623157e308",
+		"4.9e-324", "0.1234567890123456789012345", "3.14159abc",
+		NULL
+	};
+
+	for (uint32_t i = 0; numbers[i]; i++) {
+		char const *pos = numbers[i],
+			  *end = numbers[i] + strlen(numbers[i]);
+		double actual,
+			   expected = strtod(numbers[i], NULL);
+
+		CU_ASSERT_TRUE(scan_double(&pos, end, &actual));
+		CU_ASSERT_EQUAL(memcmp(&actual, &expected, sizeof(double)), 0);
+	}
+}
+
+/**
+ * Pass words which are no numbers.
+ */
+void test_scan_double2(void)
+{
+	char const * const string = "abc";
+	char const *pos = string;
+	double actual;
+
+	CU_ASSERT_FALSE(scan_double(&pos, string + 3, &actual));
+	CU_ASSERT_PTR_EQUAL(pos, string);
+}
+
+/**
+ * Convert numbers with more than 19 digits or exponents
+ * beyond +-22, which take the fallback, in the C locale and
+ * in any locale with a decimal comma which is installed.
+ */
+void test_scan_double3(void)
+{
+	char const * const numbers[] = {
+		"0.1234567890123456789", "12345678901234567890123",
+		"1e23", "-2.5e-23", "6.02214076e+100", "1.5e-300",
+		NULL
+	};
+	double const expected[] = {
+		0.1234567890123456789, 12345678901234567890123.0,
+		1e23, -2.5e-23, 6.02214076e+100, 1.5e-300
+	};
+	char const * const locales[] = {
+		"C", "de_DE.UTF-8", "de_DE", "fr_FR.UTF-8", "fr_FR", NULL
+	};
+
+	for (uint32_t j = 0; locales[j]; j++) {
+		if (!setlocale(LC_NUMERIC, locales[j]))
+			continue;
+
+		for (uint32_t i = 0; numbers[i]; i++) {
+			char const *pos = numbers[i],
+				  *end = numbers[i] + strlen(numbers[i]);
+			double actual;
+
+			CU_ASSERT_TRUE(scan_double(&pos, end, &actual));
+			CU_ASSERT_PTR_EQUAL(pos, end);
+			CU_ASSERT_EQUAL(memcmp(&actual, &expected[i],
+						sizeof(double)), 0);
+		}
+	}
+
+	setlocale(LC_NUMERIC, "C");
+}
+
+/**
+ * Scan all supported face element notations on one line.
+ */
+void test_scan_face_index1(void)
+{
+	char const * const string = "3 4/1 5//2 6/3/4 \r";
+	char const *pos = string,
+		  *end = string + strlen(string);
+	uint32_t v,
+			 vt;
+
+	CU_ASSERT_TRUE(scan_face_index(&pos, end, &v, &vt));
+	CU_ASSERT_EQUAL(v, 3);
+	CU_ASSERT_EQUAL(vt, 0);
+
+	CU_ASSERT_TRUE(scan_face_index(&pos, end, &v, &vt));
+	CU_ASSERT_EQUAL(v, 4);
+	CU_ASSERT_EQUAL(vt, 1);
+
+	CU_ASSERT_TRUE(scan_face_index(&pos, end, &v, &vt));
+	CU_ASSERT_EQUAL(v, 5);
+	CU_ASSERT_EQUAL(vt, 0);
+
+	CU_ASSERT_TRUE(scan_face_index(&pos, end, &v, &vt));
+	CU_ASSERT_EQUAL(v, 6);
+	CU_ASSERT_EQUAL(vt, 3);
+
+	CU_ASSERT_FALSE(scan_face_index(&pos, end, &v, &vt));
+}
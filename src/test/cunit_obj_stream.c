@@ -0,0 +1,187 @@
+/*
+ * Copyright 2011-2014 hasufell
+ *
+ * This file is part of a hasufell project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation version 2 of the License only.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file cunit_obj_stream.c
+ * Test functions for the streaming obj parser.
+ * @brief obj stream test functions
+ */
+
+#include "cunit.h"
+#include "filereader.h"
+#include "half_edge.h"
+#include "obj_stream.h"
+
+#include <CUnit/Basic.h>
+#include <CUnit/Console.h>
+#include <CUnit/Automated.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+
+/*
+ * static function declaration
+ */
+static void check_obj_dir(obj_stream_opts const * const opts,
+		bool spilled);
+
+
+/**
+ * Stream every file in obj/ and compare the result with
+ * the one of parse_obj_buf().
+ *
+ * @param opts the options of the streaming parser
+ * @param spilled whether the object must live in a temporary file
+ */
+static void check_obj_dir(obj_stream_opts const * const opts,
+		bool spilled)
+{
+	obj_dir objs;
+	char const *path;
+
+	if (!open_obj_dir(&objs))
+		return;
+
+	while ((path = next_obj_path(&objs))) {
+		char const *map;
+		size_t len;
+		obj_stream_stats stats;
+		HE_obj *obj,
+			   *streamed;
+
+		map = map_file(path, &len);
+		CU_ASSERT_PTR_NOT_NULL(map);
+		if (!map)
+			continue;
+		obj = parse_obj_buf(map, len);
+		unmap_file(map, len);
+
+		streamed = parse_obj_stream(path, opts, &stats);
+		CU_ASSERT_PTR_NOT_NULL(streamed);
+		if (streamed) {
+			CU_ASSERT_TRUE(objects_equal(obj, streamed));
+			CU_ASSERT_EQUAL(stats.bytes, len);
+			CU_ASSERT_EQUAL(stats.obj_spilled, spilled);
+			CU_ASSERT_EQUAL(streamed->mem->block_c, 1);
+			if (opts && len > opts->window)
+				CU_ASSERT_TRUE(stats.windows > 1);
+			delete_object(streamed);
+			free(streamed);
+		}
+
+		delete_object(obj);
+		free(obj);
+	}
+}
+
+/**
+ * Test that streaming every file in obj/ with the
+ * default options gives the same objects as parsing them,
+ * without any temporary files.
+ */
+void test_parse_obj_stream1(void)
+{
+	obj_stream_stats stats;
+	HE_obj *obj;
+
+	check_obj_dir(NULL, false);
+
+	obj = parse_obj_stream("obj/testcube_trans.obj", NULL, &stats);
+	CU_ASSERT_PTR_NOT_NULL(obj);
+	CU_ASSERT_EQUAL(stats.windows, 1);
+	CU_ASSERT_EQUAL(stats.spilled, 0);
+	delete_object(obj);
+	free(obj);
+}
+
+/**
+ * Test tiny windows and a memory ceiling of 0, which moves
+ * all buffers and the object into temporary files.
+ */
+void test_parse_obj_stream2(void)
+{
+	char const * const filename = "cunit_test_stream.obj";
+	/* dos line endings, a line longer than the window and no final newline */
+	char const * const string = ""
+		"v 9.0 10.0 11.0\r\n"
+		"v 11.0 10.0 11.0\r\n"
+		"v 9.0 11.0 11.0      \t          \t            \t     \r\n"
+		"v 11.0 11.0 11.0\r\n"
+		"f 1 2 4 3";
+	obj_stream_opts const opts = { 16, 0, NULL };
+	obj_stream_stats stats;
+	HE_obj *obj,
+		   *streamed;
+	FILE *file;
+
+	check_obj_dir(&opts, true);
+
+	file = fopen(filename, "w");
+	CU_ASSERT_PTR_NOT_NULL(file);
+	if (!file)
+		return;
+	fputs(string, file);
+	fclose(file);
+
+	obj = parse_obj(string);
+	streamed = parse_obj_stream(filename, &opts, &stats);
+	CU_ASSERT_PTR_NOT_NULL(streamed);
+	CU_ASSERT_TRUE(streamed && objects_equal(obj, streamed));
+	CU_ASSERT_TRUE(streamed && streamed->vc == 4 && streamed->fc == 1);
+	CU_ASSERT_TRUE(stats.windows > 1);
+	CU_ASSERT_TRUE(stats.spilled > 0);
+
+	delete_object(streamed);
+	free(streamed);
+	delete_object(obj);
+	free(obj);
+	unlink(filename);
+}
+
+/**
+ * Test that the heap memory of the parser stays below the
+ * memory ceiling and that missing or empty files fail.
+ */
+void test_parse_obj_stream3(void)
+{
+	char const * const filename = "cunit_test_stream.obj";
+	obj_stream_opts const opts = { 64 * 1024, 1024 * 1024, NULL };
+	obj_stream_stats stats;
+	HE_obj *obj;
+	FILE *file;
+
+	obj = parse_obj_stream("obj/bod_starter1-6.obj", &opts, &stats);
+	CU_ASSERT_PTR_NOT_NULL(obj);
+	CU_ASSERT_TRUE(stats.mem_peak <= opts.mem_limit);
+	CU_ASSERT_TRUE(stats.spilled > 0);
+	delete_object(obj);
+	free(obj);
+
+	CU_ASSERT_PTR_NULL(parse_obj_stream("nonexistent.obj", &opts, &stats));
+	CU_ASSERT_PTR_NULL(parse_obj_stream(NULL, &opts, &stats));
+
+	file = fopen(filename, "w");
+	CU_ASSERT_PTR_NOT_NULL(file);
+	if (file)
+		fclose(file);
+	CU_ASSERT_PTR_NULL(parse_obj_stream(filename, &opts, &stats));
+	unlink(filename);
+}
@@ -0,0 +1,189 @@
+/*
+ * Copyright 2011-2014 hasufell
+ *
+ * This file is part of a hasufell project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation version 2 of the License only.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file cunit_profiler.c
+ * Test functions for the frame profiler.
+ * @brief profiler test functions
+ */
+
+#include "profiler.h"
+
+#include <CUnit/Basic.h>
+#include <CUnit/Console.h>
+#include <CUnit/Automated.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+/**
+ * Test nesting zones and closing the open ones at the
+ * end of a frame.
+ */
+void test_profiler1(void)
+{
+	profiler *prof = calloc(1, sizeof(*prof));
+	profile_frame const *frame = &(prof->frames[0]);
+
+	/* outside of a frame, nothing is recorded */
+	profiler_push(prof, PROFILE_DRAW_OBJ);
+	profiler_pop(prof);
+	CU_ASSERT_EQUAL(prof->depth, 0);
+
+	profiler_begin_frame(prof);
+	profiler_push(prof, PROFILE_DRAW_OBJ);
+	profiler_push(prof, PROFILE_DRAW_VERTICES);
+	profiler_pop(prof);
+	profiler_pop(prof);
+	profiler_push(prof, PROFILE_DRAW_PLANET_1);
+	profiler_end_frame(prof);
+
+	CU_ASSERT_EQUAL(prof->frame_c, 1);
+	CU_ASSERT_FALSE(prof->in_frame);
+	CU_ASSERT_EQUAL(prof->depth, 0);
+	CU_ASSERT_EQUAL(frame->span_c, 3);
+	CU_ASSERT_EQUAL(frame->spans[0].zone, PROFILE_DRAW_OBJ);
+	CU_ASSERT_EQUAL(frame->spans[0].depth, 0);
+	CU_ASSERT_EQUAL(frame->spans[1].zone, PROFILE_DRAW_VERTICES);
+	CU_ASSERT_EQUAL(frame->spans[1].depth, 1);
+	CU_ASSERT_EQUAL(frame->spans[2].depth, 0);
+
+	/* nested in their parents and in the frame */
+	CU_ASSERT_TRUE(frame->spans[1].start >= frame->spans[0].start);
+	CU_ASSERT_TRUE(frame->spans[1].end <= frame->spans[0].end);
+	CU_ASSERT_TRUE(frame->spans[2].start >= frame->spans[0].end);
+	CU_ASSERT_TRUE(frame->spans[2].end > 0);
+	CU_ASSERT_TRUE(frame->spans[2].end <= frame->end);
+	CU_ASSERT_TRUE(frame->start <= frame->spans[0].start);
+
+	CU_ASSERT_STRING_EQUAL(profile_zone_name(PROFILE_DRAW_SHIP),
+			"draw_ship");
+	CU_ASSERT_STRING_EQUAL(profile_zone_name(PROFILE_ZONE_C), "unknown");
+
+	free(prof);
+}
+
+/**
+ * Test the ring buffer, the limits of a frame and
+ * the averages.
+ */
+void test_profiler2(void)
+{
+	profiler *prof = calloc(1, sizeof(*prof));
+	profile_summary sum;
+
+	CU_ASSERT_FALSE(profiler_summary(prof, 10, &sum));
+	CU_ASSERT_EQUAL(sum.frames, 0);
+
+	for (uint32_t i = 0; i < PROFILER_FRAMES + 10; i++) {
+		profiler_begin_frame(prof);
+
+		/* too many zones in a row and too deeply nested */
+		for (uint32_t j = 0; j < PROFILER_SPANS + 5; j++) {
+			profiler_push(prof, PROFILE_DRAW_BEZ);
+			profiler_pop(prof);
+		}
+		for (uint32_t j = 0; j < PROFILER_DEPTH + 3; j++)
+			profiler_push(prof, PROFILE_DRAW_SHIP);
+		for (uint32_t j = 0; j < PROFILER_DEPTH + 3; j++)
+			profiler_pop(prof);
+		CU_ASSERT_EQUAL(prof->depth, 0);
+
+		/* a frame without an end is ended by the next one */
+		if (i % 2)
+			profiler_end_frame(prof);
+	}
+	profiler_end_frame(prof);
+
+	CU_ASSERT_EQUAL(prof->frame_c, PROFILER_FRAMES + 10);
+	CU_ASSERT_EQUAL(prof->frames[0].span_c, PROFILER_SPANS);
+
+	CU_ASSERT_TRUE(profiler_summary(prof, 1000, &sum));
+	CU_ASSERT_EQUAL(sum.frames, PROFILER_FRAMES);
+	CU_ASSERT_TRUE(sum.fps > 0);
+	CU_ASSERT_DOUBLE_EQUAL(sum.fps * sum.frame_ms, 1000, 0.001);
+	CU_ASSERT_TRUE(sum.cpu_ms >= 0);
+	CU_ASSERT_TRUE(sum.zone_ran[PROFILE_DRAW_BEZ]);
+	CU_ASSERT_FALSE(sum.zone_ran[PROFILE_DRAW_SHIP]);
+	CU_ASSERT_FALSE(sum.zone_ran[PROFILE_DRAW_OBJ]);
+	CU_ASSERT_TRUE(sum.zone_ms[PROFILE_DRAW_BEZ] <= sum.cpu_ms);
+
+	/* a single frame has no rate */
+	CU_ASSERT_TRUE(profiler_summary(prof, 1, &sum));
+	CU_ASSERT_EQUAL(sum.frames, 1);
+	CU_ASSERT_EQUAL(sum.fps, 0);
+
+	CU_ASSERT_FALSE(profiler_summary(NULL, 1, &sum));
+
+	free(prof);
+}
+
+/**
+ * Test writing a trace.
+ */
+void test_profiler3(void)
+{
+	char const * const empty = "{\"displayTimeUnit\": \"ms\", "
+		"\"traceEvents\": [\n]}\n";
+	profiler *prof = calloc(1, sizeof(*prof));
+	FILE *out = tmpfile();
+	char text[4096];
+	char const *pos;
+	size_t len;
+	uint32_t events = 0;
+
+	CU_ASSERT_PTR_NOT_NULL(out);
+	if (!out) {
+		free(prof);
+		return;
+	}
+
+	/* an empty trace is valid as well */
+	CU_ASSERT_TRUE(write_profiler_trace(prof, out));
+
+	for (uint32_t i = 0; i < 2; i++) {
+		profiler_begin_frame(prof);
+		profiler_push(prof, PROFILE_DRAW_OBJ);
+		profiler_push(prof, PROFILE_DRAW_NORMALS);
+		profiler_pop(prof);
+		profiler_pop(prof);
+		profiler_end_frame(prof);
+	}
+	CU_ASSERT_TRUE(write_profiler_trace(prof, out));
+
+	rewind(out);
+	len = fread(text, 1, sizeof(text) - 1, out);
+	text[len] = '\0';
+	fclose(out);
+
+	CU_ASSERT_EQUAL(strncmp(text, empty, strlen(empty)), 0);
+	CU_ASSERT_EQUAL(strcmp(text + len - 5, "}\n]}\n"), 0);
+	CU_ASSERT_PTR_NOT_NULL(strstr(text, "\"name\": \"draw_normals\""));
+	CU_ASSERT_PTR_NOT_NULL(strstr(text, "\"ts\": 0.000, "));
+	CU_ASSERT_PTR_NOT_NULL(strstr(text, "\"args\": {\"frame\": 1}"));
+	for (pos = text; (pos = strstr(pos, "\"ph\": \"X\"")); pos++)
+		events++;
+	CU_ASSERT_EQUAL(events, 6);
+
+	CU_ASSERT_FALSE(save_profiler_trace(prof, "/nonexistent/trace.json"));
+	CU_ASSERT_FALSE(write_profiler_trace(NULL, stdout));
+
+	free(prof);
+}
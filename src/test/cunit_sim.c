@@ -0,0 +1,161 @@
+/*
+ * Copyright 2011-2014 hasufell
+ *
+ * This file is part of a hasufell project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation version 2 of the License only.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file cunit_sim.c
+ * Test functions for the fixed-timestep simulation.
+ * @brief sim test functions
+ */
+
+#include "sim.h"
+
+#include <CUnit/Basic.h>
+#include <CUnit/Console.h>
+#include <CUnit/Automated.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+/**
+ * Test the days, the years and the ship moving back
+ * and forth, starting from a zeroed state.
+ */
+void test_sim1(void)
+{
+	sim_params params = { 0.2f, 365 };
+	sim_state state;
+
+	memset(&state, 0, sizeof(state));
+
+	sim_tick(&state, &params);
+	CU_ASSERT_EQUAL(state.tick, 1);
+	CU_ASSERT_EQUAL(state.day, 1);
+	CU_ASSERT_EQUAL(state.year, 0);
+	CU_ASSERT_TRUE(state.ball_to_right);
+	CU_ASSERT_DOUBLE_EQUAL(state.ball_pos, 0.002, 0.000001);
+
+	for (uint32_t i = 1; i < 365; i++)
+		sim_tick(&state, &params);
+	CU_ASSERT_EQUAL(state.day, 0);
+	CU_ASSERT_EQUAL(state.year, 1);
+
+	/* a shorter year ends with the next tick */
+	for (uint32_t i = 0; i < 100; i++)
+		sim_tick(&state, &params);
+	params.yearabs = 50;
+	sim_tick(&state, &params);
+	CU_ASSERT_EQUAL(state.day, 0);
+	CU_ASSERT_EQUAL(state.year, 2);
+
+	/* the ship turns at both ends of the curve */
+	params.ball_speed = 10;
+	memset(&state, 0, sizeof(state));
+	for (uint32_t i = 0; i < 10; i++)
+		sim_tick(&state, &params);
+	CU_ASSERT_TRUE(state.ball_to_right);
+	sim_tick(&state, &params);
+	CU_ASSERT_FALSE(state.ball_to_right);
+	for (uint32_t i = 0; i < 1000; i++) {
+		sim_tick(&state, &params);
+		CU_ASSERT_TRUE(state.ball_pos > -0.1f && state.ball_pos < 1.1f);
+	}
+	CU_ASSERT_EQUAL(state.tick, 1011);
+}
+
+/**
+ * Test interpolating between two ticks.
+ */
+void test_sim2(void)
+{
+	sim_params const params = { 1, 10 };
+	sim_state prev,
+			  cur,
+			  state;
+
+	memset(&prev, 0, sizeof(prev));
+	for (uint32_t i = 0; i < 5; i++)
+		sim_tick(&prev, &params);
+	cur = prev;
+	sim_tick(&cur, &params);
+
+	sim_interpolate(&prev, &cur, 0, &state);
+	CU_ASSERT_EQUAL(state.day, prev.day);
+	CU_ASSERT_EQUAL(state.ball_pos, prev.ball_pos);
+	CU_ASSERT_EQUAL(state.tick, cur.tick);
+
+	sim_interpolate(&prev, &cur, 0.25f, &state);
+	CU_ASSERT_DOUBLE_EQUAL(state.day, 5.25, 0.000001);
+	CU_ASSERT_DOUBLE_EQUAL(state.ball_pos,
+			prev.ball_pos + (cur.ball_pos - prev.ball_pos) / 4, 0.000001);
+
+	/* out of range */
+	sim_interpolate(&prev, &cur, 3, &state);
+	CU_ASSERT_FALSE(memcmp(&state, &cur, sizeof(state)));
+	sim_interpolate(&prev, &cur, -1, &state);
+	CU_ASSERT_EQUAL(state.day, prev.day);
+
+	/* no days going backwards at the end of a year */
+	for (uint32_t i = 0; i < 4; i++) {
+		prev = cur;
+		sim_tick(&cur, &params);
+	}
+	CU_ASSERT_EQUAL(prev.day, 9);
+	CU_ASSERT_EQUAL(cur.day, 0);
+	sim_interpolate(&prev, &cur, 0.5f, &state);
+	CU_ASSERT_EQUAL(state.day, 0);
+	CU_ASSERT_EQUAL(state.year, 1);
+}
+
+/**
+ * Test that the count of ticks only depends on the time,
+ * not on the frame rate, and that the catching up is limited.
+ */
+void test_sim3(void)
+{
+	sim_clock clock = { 0 };
+	uint32_t slow = 0,
+			 fast = 0;
+
+	CU_ASSERT_EQUAL(sim_clock_advance(&clock, 10), 0);
+	CU_ASSERT_DOUBLE_EQUAL(sim_clock_alpha(&clock), 10 / SIM_TICK_MS,
+			0.000001);
+	CU_ASSERT_EQUAL(sim_clock_advance(&clock, 10), 1);
+	CU_ASSERT_DOUBLE_EQUAL(sim_clock_alpha(&clock), 20 / SIM_TICK_MS - 1,
+			0.000001);
+	CU_ASSERT_EQUAL(sim_clock_advance(&clock, -5), 0);
+
+	/* two seconds at 25 and at 125 frames per second */
+	memset(&clock, 0, sizeof(clock));
+	for (uint32_t i = 0; i < 50; i++)
+		slow += sim_clock_advance(&clock, 40);
+	memset(&clock, 0, sizeof(clock));
+	for (uint32_t i = 0; i < 250; i++)
+		fast += sim_clock_advance(&clock, 8);
+	CU_ASSERT_TRUE(slow >= 2 * SIM_TICKS_PER_SEC - 1 &&
+			slow <= 2 * SIM_TICKS_PER_SEC);
+	CU_ASSERT_TRUE(fast >= 2 * SIM_TICKS_PER_SEC - 1 &&
+			fast <= 2 * SIM_TICKS_PER_SEC);
+
+	/* a stall of a second is not caught up with */
+	memset(&clock, 0, sizeof(clock));
+	CU_ASSERT_EQUAL(sim_clock_advance(&clock, 1000), SIM_MAX_TICKS);
+	CU_ASSERT_TRUE(sim_clock_alpha(&clock) < 1);
+	CU_ASSERT_EQUAL(sim_clock_advance(&clock, 0), 0);
+}
@@ -0,0 +1,244 @@
+/*
+ * Copyright 2011-2014 hasufell
+ *
+ * This file is part of a hasufell project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation version 2 of the License only.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file cunit_vector_simd.c
+ * Test functions for the inline and batched vector maths.
+ * @brief vector_simd test functions
+ */
+
+#include "bezier.h"
+#include "vector.h"
+#include "vector_simd.h"
+
+#include <CUnit/Basic.h>
+#include <CUnit/Console.h>
+#include <CUnit/Automated.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+
+/**
+ * Count of vectors the kernels are tested with, so that
+ * every kernel runs with and without a remainder.
+ */
+#define TEST_VECTOR_C 37
+
+
+/*
+ * static function declaration
+ */
+static void fill_vectors(vector *vecs, uint32_t n, unsigned seed);
+static void assert_vectors_equal(vector const *a,
+		vector const *b,
+		uint32_t n);
+
+
+/**
+ * Fill an array with pseudo-random vectors between -100
+ * and 100, with a null vector in the middle.
+ *
+ * @param vecs the array [out]
+ * @param n count of vectors
+ * @param seed the seed
+ */
+static void fill_vectors(vector *vecs, uint32_t n, unsigned seed)
+{
+	srand(seed);
+
+	for (uint32_t i = 0; i < n; i++) {
+		vecs[i].x = (float)(rand() % 20000 - 10000) / 100;
+		vecs[i].y = (float)(rand() % 20000 - 10000) / 100;
+		vecs[i].z = (float)(rand() % 20000 - 10000) / 100;
+	}
+
+	if (n > 5)
+		SET_NULL_VECTOR(&(vecs[5]));
+}
+
+/**
+ * Assert that two arrays of vectors are equal up to rounding.
+ *
+ * @param a the first vectors
+ * @param b the second vectors
+ * @param n count of vectors
+ */
+static void assert_vectors_equal(vector const *a,
+		vector const *b,
+		uint32_t n)
+{
+	for (uint32_t i = 0; i < n; i++) {
+		CU_ASSERT_DOUBLE_EQUAL(a[i].x, b[i].x, 0.0001 * (1 + fabs(a[i].x)));
+		CU_ASSERT_DOUBLE_EQUAL(a[i].y, b[i].y, 0.0001 * (1 + fabs(a[i].y)));
+		CU_ASSERT_DOUBLE_EQUAL(a[i].z, b[i].z, 0.0001 * (1 + fabs(a[i].z)));
+	}
+}
+
+/**
+ * Test the element-wise kernels against the single vector
+ * functions for all counts up to TEST_VECTOR_C.
+ */
+void test_vector_simd1(void)
+{
+	vector a[TEST_VECTOR_C],
+		   b[TEST_VECTOR_C],
+		   out[TEST_VECTOR_C] = { { 0, 0, 0 } },
+		   ref[TEST_VECTOR_C];
+
+	fill_vectors(a, TEST_VECTOR_C, 1);
+	fill_vectors(b, TEST_VECTOR_C, 2);
+
+	for (uint32_t n = 0; n <= TEST_VECTOR_C; n++) {
+		vec_batch_scale(a, out, n, 0.3f);
+		for (uint32_t i = 0; i < n; i++)
+			ref[i] = vec_scale(a[i], 0.3f);
+		assert_vectors_equal(ref, out, n);
+
+		vec_batch_lerp(a, b, out, n, 0.7f);
+		for (uint32_t i = 0; i < n; i++)
+			ref[i] = vec_lerp(a[i], b[i], 0.7f);
+		assert_vectors_equal(ref, out, n);
+
+		vec_batch_cross(a, b, out, n);
+		for (uint32_t i = 0; i < n; i++)
+			VECTOR_PRODUCT(&(a[i]), &(b[i]), &(ref[i]));
+		assert_vectors_equal(ref, out, n);
+
+		vec_batch_normalize(a, out, n);
+		for (uint32_t i = 0; i < n; i++)
+			ref[i] = vec_normalize(a[i]);
+		assert_vectors_equal(ref, out, n);
+	}
+
+	/* null vectors stay null */
+	CU_ASSERT_EQUAL(out[5].x, 0);
+	CU_ASSERT_EQUAL(out[5].y, 0);
+	CU_ASSERT_EQUAL(out[5].z, 0);
+	CU_ASSERT_DOUBLE_EQUAL(vec_dot(out[6], out[6]), 1, 0.0001);
+
+	/* in place */
+	for (uint32_t i = 0; i < TEST_VECTOR_C; i++)
+		ref[i] = vec_cross(a[i], b[i]);
+	vec_batch_cross(a, b, a, TEST_VECTOR_C);
+	assert_vectors_equal(ref, a, TEST_VECTOR_C);
+}
+
+/**
+ * Test the reductions against plain loops.
+ */
+void test_vector_simd2(void)
+{
+	uint32_t const big = 100003;
+	vector *vecs = malloc(sizeof(*vecs) * big);
+	vector min,
+		   max,
+		   sum;
+
+	fill_vectors(vecs, big, 3);
+
+	for (uint32_t n = 1; n <= big; n = n < TEST_VECTOR_C ? n + 1 : big) {
+		double x = 0,
+			   y = 0,
+			   z = 0;
+		vector lo = vecs[0],
+			   hi = vecs[0];
+
+		for (uint32_t i = 0; i < n; i++) {
+			x += vecs[i].x;
+			y += vecs[i].y;
+			z += vecs[i].z;
+			lo.x = fminf(lo.x, vecs[i].x);
+			lo.y = fminf(lo.y, vecs[i].y);
+			lo.z = fminf(lo.z, vecs[i].z);
+			hi.x = fmaxf(hi.x, vecs[i].x);
+			hi.y = fmaxf(hi.y, vecs[i].y);
+			hi.z = fmaxf(hi.z, vecs[i].z);
+		}
+
+		sum = vec_batch_sum(vecs, n);
+		CU_ASSERT_DOUBLE_EQUAL(sum.x, x, 0.0001 * (n + fabs(x)));
+		CU_ASSERT_DOUBLE_EQUAL(sum.y, y, 0.0001 * (n + fabs(y)));
+		CU_ASSERT_DOUBLE_EQUAL(sum.z, z, 0.0001 * (n + fabs(z)));
+
+		CU_ASSERT_TRUE(vec_batch_min_max(vecs, n, &min, &max));
+		CU_ASSERT_EQUAL(min.x, lo.x);
+		CU_ASSERT_EQUAL(min.y, lo.y);
+		CU_ASSERT_EQUAL(min.z, lo.z);
+		CU_ASSERT_EQUAL(max.x, hi.x);
+		CU_ASSERT_EQUAL(max.y, hi.y);
+		CU_ASSERT_EQUAL(max.z, hi.z);
+
+		if (n == big)
+			break;
+	}
+
+	sum = vec_batch_sum(vecs, 0);
+	CU_ASSERT_TRUE(is_null_vector(&sum));
+	CU_ASSERT_FALSE(vec_batch_min_max(vecs, 0, &min, &max));
+
+	free(vecs);
+}
+
+/**
+ * Test the transformation by a matrix and the
+ * bezier code on top of the kernels.
+ */
+void test_vector_simd3(void)
+{
+	/* rotate by 90 degrees around z, then move by (1, 2, 3) */
+	float const m[16] = {
+		0, 1, 0, 0,
+		-1, 0, 0, 0,
+		0, 0, 1, 0,
+		1, 2, 3, 1,
+	};
+	vector vecs[TEST_VECTOR_C],
+		   out[TEST_VECTOR_C];
+	vector ctrl[3] = { { 0, 0, 0 }, { 1, 2, 0 }, { 2, 0, 0 } };
+	bez_curv const bez = { ctrl, 2 };
+	vector *point;
+
+	fill_vectors(vecs, TEST_VECTOR_C, 4);
+	vec_batch_transform(m, vecs, out, TEST_VECTOR_C);
+	for (uint32_t i = 0; i < TEST_VECTOR_C; i++) {
+		CU_ASSERT_DOUBLE_EQUAL(out[i].x, 1 - vecs[i].y, 0.0001);
+		CU_ASSERT_DOUBLE_EQUAL(out[i].y, 2 + vecs[i].x, 0.0001);
+		CU_ASSERT_DOUBLE_EQUAL(out[i].z, 3 + vecs[i].z, 0.0001);
+	}
+
+	/* in place */
+	vec_batch_transform(m, vecs, vecs, TEST_VECTOR_C);
+	assert_vectors_equal(out, vecs, TEST_VECTOR_C);
+
+	point = calculate_bezier_point(&bez, 0.5f);
+	CU_ASSERT_DOUBLE_EQUAL(point->x, 1, 0.0001);
+	CU_ASSERT_DOUBLE_EQUAL(point->y, 1, 0.0001);
+	CU_ASSERT_DOUBLE_EQUAL(point->z, 0, 0.0001);
+	free(point);
+
+	/* the ends of the curve are its end points */
+	point = calculate_bezier_point(&bez, 0);
+	CU_ASSERT_EQUAL(point->x, 0);
+	CU_ASSERT_EQUAL(point->y, 0);
+	free(point);
+	point = calculate_bezier_point(&bez, 1);
+	CU_ASSERT_EQUAL(point->x, 2);
+	CU_ASSERT_EQUAL(point->y, 0);
+	free(point);
+}
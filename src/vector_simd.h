@@ -0,0 +1,749 @@
+/*
+ * Copyright 2011-2014 hasufell
+ *
+ * This file is part of a hasufell project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation version 2 of the License only.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file vector_simd.h
+ * Inline vector maths for the hot paths, next to the checked
+ * functions in vector.c. Single vectors are passed by value
+ * and nothing is checked for NULL. Arrays of vectors are
+ * processed by batched kernels, which use AVX2 or SSE2 if
+ * the compiler targets them (e.g. by -march=native) and plain
+ * C otherwise. Defining VECTOR_SIMD_SCALAR forces plain C.
+ *
+ * The element-wise kernels do the same operations in the same
+ * order as the plain C code, only vec_batch_sum() and
+ * vec_batch_bounds() add up in a different order.
+ * @brief inline and batched vector maths
+ */
+
+#ifndef _DROW_ENGINE_VECTOR_SIMD_H
+#define _DROW_ENGINE_VECTOR_SIMD_H
+
+
+#include "vector.h"
+
+#include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#if !defined(VECTOR_SIMD_SCALAR) && defined(__AVX2__)
+#define VECTOR_SIMD_AVX2
+#define VECTOR_SIMD_SSE
+#include <immintrin.h>
+#elif !defined(VECTOR_SIMD_SCALAR) && defined(__SSE2__)
+#define VECTOR_SIMD_SSE
+#include <emmintrin.h>
+#endif
+
+
+/**
+ * Name of the instruction set the kernels were built for.
+ */
+#if defined(VECTOR_SIMD_AVX2)
+#define VECTOR_SIMD_NAME "avx2"
+#elif defined(VECTOR_SIMD_SSE)
+#define VECTOR_SIMD_NAME "sse2"
+#else
+#define VECTOR_SIMD_NAME "scalar"
+#endif
+
+/*
+ * The register the flat kernels work on, VSIMD_W floats wide,
+ * and the one with doubles of half the count.
+ */
+#if defined(VECTOR_SIMD_AVX2)
+#define VSIMD_W 8
+#define VSIMD_REG __m256
+#define VSIMD_LOAD(p) _mm256_loadu_ps(p)
+#define VSIMD_STORE(p, a) _mm256_storeu_ps(p, a)
+#define VSIMD_SET1(f) _mm256_set1_ps(f)
+#define VSIMD_ADD(a, b) _mm256_add_ps(a, b)
+#define VSIMD_SUB(a, b) _mm256_sub_ps(a, b)
+#define VSIMD_MUL(a, b) _mm256_mul_ps(a, b)
+#define VSIMD_MIN(a, b) _mm256_min_ps(a, b)
+#define VSIMD_MAX(a, b) _mm256_max_ps(a, b)
+#define VSIMD_DREG __m256d
+#define VSIMD_DZERO() _mm256_setzero_pd()
+#define VSIMD_DLO(a) _mm256_cvtps_pd(_mm256_castps256_ps128(a))
+#define VSIMD_DHI(a) _mm256_cvtps_pd(_mm256_extractf128_ps(a, 1))
+#define VSIMD_DADD(a, b) _mm256_add_pd(a, b)
+#define VSIMD_DSTORE(p, a) _mm256_storeu_pd(p, a)
+#elif defined(VECTOR_SIMD_SSE)
+#define VSIMD_W 4
+#define VSIMD_REG __m128
+#define VSIMD_LOAD(p) _mm_loadu_ps(p)
+#define VSIMD_STORE(p, a) _mm_storeu_ps(p, a)
+#define VSIMD_SET1(f) _mm_set1_ps(f)
+#define VSIMD_ADD(a, b) _mm_add_ps(a, b)
+#define VSIMD_SUB(a, b) _mm_sub_ps(a, b)
+#define VSIMD_MUL(a, b) _mm_mul_ps(a, b)
+#define VSIMD_MIN(a, b) _mm_min_ps(a, b)
+#define VSIMD_MAX(a, b) _mm_max_ps(a, b)
+#define VSIMD_DREG __m128d
+#define VSIMD_DZERO() _mm_setzero_pd()
+#define VSIMD_DLO(a) _mm_cvtps_pd(a)
+#define VSIMD_DHI(a) _mm_cvtps_pd(_mm_movehl_ps(a, a))
+#define VSIMD_DADD(a, b) _mm_add_pd(a, b)
+#define VSIMD_DSTORE(p, a) _mm_storeu_pd(p, a)
+#endif
+
+
+/**
+ * The kernels treat arrays of vectors as arrays of floats.
+ */
+typedef char vector_simd_packed[sizeof(vector) == 3 * sizeof(float) ? 1 : -1];
+
+
+/**
+ * Add two vectors.
+ *
+ * @param a vector
+ * @param b vector
+ * @return a + b
+ */
+static inline vector vec_add(vector a, vector b)
+{
+	vector c;
+
+	c.x = a.x + b.x;
+	c.y = a.y + b.y;
+	c.z = a.z + b.z;
+
+	return c;
+}
+
+/**
+ * Subtract two vectors.
+ *
+ * @param a vector
+ * @param b vector
+ * @return a - b
+ */
+static inline vector vec_sub(vector a, vector b)
+{
+	vector c;
+
+	c.x = a.x - b.x;
+	c.y = a.y - b.y;
+	c.z = a.z - b.z;
+
+	return c;
+}
+
+/**
+ * Multiply a vector with a scalar.
+ *
+ * @param a vector
+ * @param scal the scalar
+ * @return a * scal
+ */
+static inline vector vec_scale(vector a, float scal)
+{
+	vector c;
+
+	c.x = a.x * scal;
+	c.y = a.y * scal;
+	c.z = a.z * scal;
+
+	return c;
+}
+
+/**
+ * Calculate the dot product of two vectors.
+ *
+ * @param a vector
+ * @param b vector
+ * @return a . b
+ */
+static inline float vec_dot(vector a, vector b)
+{
+	return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+/**
+ * Calculate the vector product of two vectors, like
+ * vector_product().
+ *
+ * @param a vector
+ * @param b vector
+ * @return a x b
+ */
+static inline vector vec_cross(vector a, vector b)
+{
+	vector c;
+
+	c.x = a.y * b.z - a.z * b.y;
+	c.y = a.z * b.x - a.x * b.z;
+	c.z = a.x * b.y - a.y * b.x;
+
+	return c;
+}
+
+/**
+ * Interpolate linearly between two vectors.
+ *
+ * @param a vector at t = 0
+ * @param b vector at t = 1
+ * @param t the section between 0 and 1
+ * @return a + (b - a) * t
+ */
+static inline vector vec_lerp(vector a, vector b, float t)
+{
+	return vec_add(a, vec_scale(vec_sub(b, a), t));
+}
+
+/**
+ * Normalize a vector, like normalize_vector(). A vector
+ * of length 0 stays as it is, instead of turning into NaNs.
+ *
+ * @param a vector
+ * @return a / |a|
+ */
+static inline vector vec_normalize(vector a)
+{
+	float const len = sqrtf(a.x * a.x + a.y * a.y + a.z * a.z);
+
+	if (len == 0)
+		return a;
+
+	a.x /= len;
+	a.y /= len;
+	a.z /= len;
+
+	return a;
+}
+
+#ifdef VECTOR_SIMD_SSE
+/**
+ * Load 4 vectors and transpose them into one register
+ * per coordinate.
+ *
+ * @param in the vectors
+ * @param x the x coordinates [out]
+ * @param y the y coordinates [out]
+ * @param z the z coordinates [out]
+ */
+static inline void vsimd_load4(vector const *in,
+		__m128 *x,
+		__m128 *y,
+		__m128 *z)
+{
+	float const *f = (float const*)in;
+	/* x0 y0 z0 x1 | y1 z1 x2 y2 | z2 x3 y3 z3 */
+	__m128 const a = _mm_loadu_ps(f),
+		  b = _mm_loadu_ps(f + 4),
+		  c = _mm_loadu_ps(f + 8);
+
+	*x = _mm_shuffle_ps(a, _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 2, 2)),
+			_MM_SHUFFLE(2, 0, 3, 0));
+	*y = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1)),
+			_mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3)),
+			_MM_SHUFFLE(2, 0, 2, 0));
+	*z = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2)),
+			_mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 0, 0)),
+			_MM_SHUFFLE(2, 0, 2, 0));
+}
+
+/**
+ * Transpose one register per coordinate back into 4 vectors
+ * and store them.
+ *
+ * @param out the vectors [out]
+ * @param x the x coordinates
+ * @param y the y coordinates
+ * @param z the z coordinates
+ */
+static inline void vsimd_store4(vector *out,
+		__m128 x,
+		__m128 y,
+		__m128 z)
+{
+	float *f = (float*)out;
+
+	_mm_storeu_ps(f, _mm_shuffle_ps(
+				_mm_shuffle_ps(x, y, _MM_SHUFFLE(0, 0, 0, 0)),
+				_mm_shuffle_ps(z, x, _MM_SHUFFLE(1, 1, 0, 0)),
+				_MM_SHUFFLE(2, 0, 2, 0)));
+	_mm_storeu_ps(f + 4, _mm_shuffle_ps(
+				_mm_shuffle_ps(y, z, _MM_SHUFFLE(1, 1, 1, 1)),
+				_mm_shuffle_ps(x, y, _MM_SHUFFLE(2, 2, 2, 2)),
+				_MM_SHUFFLE(2, 0, 2, 0)));
+	_mm_storeu_ps(f + 8, _mm_shuffle_ps(
+				_mm_shuffle_ps(z, x, _MM_SHUFFLE(3, 3, 2, 2)),
+				_mm_shuffle_ps(y, z, _MM_SHUFFLE(3, 3, 3, 3)),
+				_MM_SHUFFLE(2, 0, 2, 0)));
+}
+#endif
+
+/**
+ * Multiply n vectors with a scalar. in and out may
+ * be the same array.
+ *
+ * @param in the vectors
+ * @param out the results [out]
+ * @param n count of vectors
+ * @param scal the scalar
+ */
+static inline void vec_batch_scale(vector const *in,
+		vector *out,
+		uint32_t n,
+		float scal)
+{
+	float const *a = (float const*)in;
+	float *c = (float*)out;
+	size_t const len = (size_t)n * 3;
+	size_t i = 0;
+
+#ifdef VSIMD_W
+	VSIMD_REG const s = VSIMD_SET1(scal);
+
+	for (; i + VSIMD_W <= len; i += VSIMD_W)
+		VSIMD_STORE(c + i, VSIMD_MUL(VSIMD_LOAD(a + i), s));
+#endif
+	for (; i < len; i++)
+		c[i] = a[i] * scal;
+}
+
+/**
+ * Interpolate linearly between n pairs of vectors, like
+ * vec_lerp(). out may be the same array as a or b.
+ *
+ * @param a the vectors at t = 0
+ * @param b the vectors at t = 1
+ * @param out the results [out]
+ * @param n count of vectors
+ * @param t the section between 0 and 1
+ */
+static inline void vec_batch_lerp(vector const *a,
+		vector const *b,
+		vector *out,
+		uint32_t n,
+		float t)
+{
+	float const *fa = (float const*)a,
+		  *fb = (float const*)b;
+	float *c = (float*)out;
+	size_t const len = (size_t)n * 3;
+	size_t i = 0;
+
+#ifdef VSIMD_W
+	VSIMD_REG const s = VSIMD_SET1(t);
+
+	for (; i + VSIMD_W <= len; i += VSIMD_W) {
+		VSIMD_REG const va = VSIMD_LOAD(fa + i);
+
+		VSIMD_STORE(c + i, VSIMD_ADD(va,
+					VSIMD_MUL(VSIMD_SUB(VSIMD_LOAD(fb + i), va), s)));
+	}
+#endif
+	for (; i < len; i++)
+		c[i] = fa[i] + (fb[i] - fa[i]) * t;
+}
+
+/**
+ * Sum up n vectors. The SIMD builds keep one partial sum per
+ * lane, so the result may differ in the last bits from
+ * adding them up one after another.
+ *
+ * @param in the vectors
+ * @param n count of vectors
+ * @return the sum, a null vector if n is 0
+ */
+static inline vector vec_batch_sum(vector const *in, uint32_t n)
+{
+	float const *a = (float const*)in;
+	size_t const len = (size_t)n * 3;
+	float sum[3] = { 0, 0, 0 };
+	size_t i = 0;
+	vector c;
+
+#ifdef VSIMD_W
+	/* three registers hold whole vectors, lane j is coordinate j % 3 */
+	VSIMD_REG acc0 = VSIMD_SET1(0),
+			  acc1 = VSIMD_SET1(0),
+			  acc2 = VSIMD_SET1(0);
+	float lanes[3 * VSIMD_W];
+
+	for (; i + 3 * VSIMD_W <= len; i += 3 * VSIMD_W) {
+		acc0 = VSIMD_ADD(acc0, VSIMD_LOAD(a + i));
+		acc1 = VSIMD_ADD(acc1, VSIMD_LOAD(a + i + VSIMD_W));
+		acc2 = VSIMD_ADD(acc2, VSIMD_LOAD(a + i + 2 * VSIMD_W));
+	}
+	VSIMD_STORE(lanes, acc0);
+	VSIMD_STORE(lanes + VSIMD_W, acc1);
+	VSIMD_STORE(lanes + 2 * VSIMD_W, acc2);
+	for (size_t j = 0; j < 3 * VSIMD_W; j++)
+		sum[j % 3] += lanes[j];
+#endif
+	for (; i < len; i++)
+		sum[i % 3] += a[i];
+
+	c.x = sum[0];
+	c.y = sum[1];
+	c.z = sum[2];
+
+	return c;
+}
+
+/**
+ * Find the smallest and largest coordinates of n vectors,
+ * which are the corners of their bounding box.
+ *
+ * @param in the vectors
+ * @param n count of vectors
+ * @param min the smallest coordinates [out]
+ * @param max the largest coordinates [out]
+ * @return false if n is 0, true otherwise
+ */
+static inline bool vec_batch_min_max(vector const *in,
+		uint32_t n,
+		vector *min,
+		vector *max)
+{
+	float const *a = (float const*)in;
+	size_t const len = (size_t)n * 3;
+	float lo[3] = { INFINITY, INFINITY, INFINITY },
+		  hi[3] = { -INFINITY, -INFINITY, -INFINITY };
+	size_t i = 0;
+
+	if (!n)
+		return false;
+
+#ifdef VSIMD_W
+	{
+		/* the same lane layout as in vec_batch_sum() */
+		VSIMD_REG lo0 = VSIMD_SET1(INFINITY),
+				  lo1 = VSIMD_SET1(INFINITY),
+				  lo2 = VSIMD_SET1(INFINITY),
+				  hi0 = VSIMD_SET1(-INFINITY),
+				  hi1 = VSIMD_SET1(-INFINITY),
+				  hi2 = VSIMD_SET1(-INFINITY);
+		float lanes_lo[3 * VSIMD_W],
+			  lanes_hi[3 * VSIMD_W];
+
+		for (; i + 3 * VSIMD_W <= len; i += 3 * VSIMD_W) {
+			VSIMD_REG const v0 = VSIMD_LOAD(a + i),
+					  v1 = VSIMD_LOAD(a + i + VSIMD_W),
+					  v2 = VSIMD_LOAD(a + i + 2 * VSIMD_W);
+
+			lo0 = VSIMD_MIN(lo0, v0);
+			lo1 = VSIMD_MIN(lo1, v1);
+			lo2 = VSIMD_MIN(lo2, v2);
+			hi0 = VSIMD_MAX(hi0, v0);
+			hi1 = VSIMD_MAX(hi1, v1);
+			hi2 = VSIMD_MAX(hi2, v2);
+		}
+		VSIMD_STORE(lanes_lo, lo0);
+		VSIMD_STORE(lanes_lo + VSIMD_W, lo1);
+		VSIMD_STORE(lanes_lo + 2 * VSIMD_W, lo2);
+		VSIMD_STORE(lanes_hi, hi0);
+		VSIMD_STORE(lanes_hi + VSIMD_W, hi1);
+		VSIMD_STORE(lanes_hi + 2 * VSIMD_W, hi2);
+		for (size_t j = 0; j < 3 * VSIMD_W; j++) {
+			if (lanes_lo[j] < lo[j % 3])
+				lo[j % 3] = lanes_lo[j];
+			if (lanes_hi[j] > hi[j % 3])
+				hi[j % 3] = lanes_hi[j];
+		}
+	}
+#endif
+	for (; i < len; i++) {
+		if (a[i] < lo[i % 3])
+			lo[i % 3] = a[i];
+		if (a[i] > hi[i % 3])
+			hi[i % 3] = a[i];
+	}
+
+	min->x = lo[0];
+	min->y = lo[1];
+	min->z = lo[2];
+	max->x = hi[0];
+	max->y = hi[1];
+	max->z = hi[2];
+
+	return true;
+}
+
+/**
+ * Find the bounding box and the sum of n vectors in one pass.
+ * The sum is added up in double precision, so it stays exact
+ * for millions of float coordinates of similar magnitude.
+ *
+ * @param in the vectors
+ * @param n count of vectors
+ * @param min the smallest coordinates [out]
+ * @param max the largest coordinates [out]
+ * @param sum the sums of the x, y and z coordinates [out]
+ * @return false if n is 0, true otherwise
+ */
+static inline bool vec_batch_bounds(vector const *in,
+		uint32_t n,
+		vector *min,
+		vector *max,
+		double sum[3])
+{
+	float const *a = (float const*)in;
+	size_t const len = (size_t)n * 3;
+	float lo[3] = { INFINITY, INFINITY, INFINITY },
+		  hi[3] = { -INFINITY, -INFINITY, -INFINITY };
+	size_t i = 0;
+
+	sum[0] = sum[1] = sum[2] = 0;
+
+	if (!n)
+		return false;
+
+#ifdef VSIMD_W
+	{
+		/* the same lane layout as in vec_batch_sum() */
+		VSIMD_REG lo0 = VSIMD_SET1(INFINITY),
+				  lo1 = VSIMD_SET1(INFINITY),
+				  lo2 = VSIMD_SET1(INFINITY),
+				  hi0 = VSIMD_SET1(-INFINITY),
+				  hi1 = VSIMD_SET1(-INFINITY),
+				  hi2 = VSIMD_SET1(-INFINITY);
+		/* the low and high halves of the three registers */
+		VSIMD_DREG s0 = VSIMD_DZERO(),
+				   s1 = VSIMD_DZERO(),
+				   s2 = VSIMD_DZERO(),
+				   s3 = VSIMD_DZERO(),
+				   s4 = VSIMD_DZERO(),
+				   s5 = VSIMD_DZERO();
+		float lanes_lo[3 * VSIMD_W],
+			  lanes_hi[3 * VSIMD_W];
+		double lanes_sum[3 * VSIMD_W];
+
+		for (; i + 3 * VSIMD_W <= len; i += 3 * VSIMD_W) {
+			VSIMD_REG const v0 = VSIMD_LOAD(a + i),
+					  v1 = VSIMD_LOAD(a + i + VSIMD_W),
+					  v2 = VSIMD_LOAD(a + i + 2 * VSIMD_W);
+
+			lo0 = VSIMD_MIN(lo0, v0);
+			lo1 = VSIMD_MIN(lo1, v1);
+			lo2 = VSIMD_MIN(lo2, v2);
+			hi0 = VSIMD_MAX(hi0, v0);
+			hi1 = VSIMD_MAX(hi1, v1);
+			hi2 = VSIMD_MAX(hi2, v2);
+			s0 = VSIMD_DADD(s0, VSIMD_DLO(v0));
+			s1 = VSIMD_DADD(s1, VSIMD_DHI(v0));
+			s2 = VSIMD_DADD(s2, VSIMD_DLO(v1));
+			s3 = VSIMD_DADD(s3, VSIMD_DHI(v1));
+			s4 = VSIMD_DADD(s4, VSIMD_DLO(v2));
+			s5 = VSIMD_DADD(s5, VSIMD_DHI(v2));
+		}
+		VSIMD_STORE(lanes_lo, lo0);
+		VSIMD_STORE(lanes_lo + VSIMD_W, lo1);
+		VSIMD_STORE(lanes_lo + 2 * VSIMD_W, lo2);
+		VSIMD_STORE(lanes_hi, hi0);
+		VSIMD_STORE(lanes_hi + VSIMD_W, hi1);
+		VSIMD_STORE(lanes_hi + 2 * VSIMD_W, hi2);
+		VSIMD_DSTORE(lanes_sum, s0);
+		VSIMD_DSTORE(lanes_sum + VSIMD_W / 2, s1);
+		VSIMD_DSTORE(lanes_sum + VSIMD_W, s2);
+		VSIMD_DSTORE(lanes_sum + 3 * VSIMD_W / 2, s3);
+		VSIMD_DSTORE(lanes_sum + 2 * VSIMD_W, s4);
+		VSIMD_DSTORE(lanes_sum + 5 * VSIMD_W / 2, s5);
+		for (size_t j = 0; j < 3 * VSIMD_W; j++) {
+			if (lanes_lo[j] < lo[j % 3])
+				lo[j % 3] = lanes_lo[j];
+			if (lanes_hi[j] > hi[j % 3])
+				hi[j % 3] = lanes_hi[j];
+			sum[j % 3] += lanes_sum[j];
+		}
+	}
+#endif
+	for (; i < len; i++) {
+		if (a[i] < lo[i % 3])
+			lo[i % 3] = a[i];
+		if (a[i] > hi[i % 3])
+			hi[i % 3] = a[i];
+		sum[i % 3] += a[i];
+	}
+
+	min->x = lo[0];
+	min->y = lo[1];
+	min->z = lo[2];
+	max->x = hi[0];
+	max->y = hi[1];
+	max->z = hi[2];
+
+	return true;
+}
+
+/**
+ * Move n positions by an offset and then scale them, like
+ * vec_scale(vec_add(in[i], offset), scal). in and out may be
+ * the same array.
+ *
+ * @param in the positions
+ * @param out the results [out]
+ * @param n count of positions
+ * @param offset the offset
+ * @param scal the scalar
+ */
+static inline void vec_batch_translate_scale(vector const *in,
+		vector *out,
+		uint32_t n,
+		vector offset,
+		float scal)
+{
+	float const *a = (float const*)in;
+	float const off[3] = { offset.x, offset.y, offset.z };
+	float *c = (float*)out;
+	size_t const len = (size_t)n * 3;
+	size_t i = 0;
+
+#ifdef VSIMD_W
+	{
+		/* three registers hold whole vectors, lane j is coordinate j % 3 */
+		float pattern[3 * VSIMD_W];
+		VSIMD_REG const s = VSIMD_SET1(scal);
+		VSIMD_REG o0, o1, o2;
+
+		for (size_t j = 0; j < 3 * VSIMD_W; j++)
+			pattern[j] = off[j % 3];
+		o0 = VSIMD_LOAD(pattern);
+		o1 = VSIMD_LOAD(pattern + VSIMD_W);
+		o2 = VSIMD_LOAD(pattern + 2 * VSIMD_W);
+
+		for (; i + 3 * VSIMD_W <= len; i += 3 * VSIMD_W) {
+			VSIMD_STORE(c + i,
+					VSIMD_MUL(VSIMD_ADD(VSIMD_LOAD(a + i), o0), s));
+			VSIMD_STORE(c + i + VSIMD_W,
+					VSIMD_MUL(VSIMD_ADD(VSIMD_LOAD(a + i + VSIMD_W), o1), s));
+			VSIMD_STORE(c + i + 2 * VSIMD_W,
+					VSIMD_MUL(VSIMD_ADD(VSIMD_LOAD(a + i + 2 * VSIMD_W), o2),
+						s));
+		}
+	}
+#endif
+	for (; i < len; i++)
+		c[i] = (a[i] + off[i % 3]) * scal;
+}
+
+/**
+ * Calculate the vector products of n pairs of vectors, like
+ * vec_cross(). out may be the same array as a or b.
+ *
+ * @param a the first vectors
+ * @param b the second vectors
+ * @param out the results [out]
+ * @param n count of vectors
+ */
+static inline void vec_batch_cross(vector const *a,
+		vector const *b,
+		vector *out,
+		uint32_t n)
+{
+	uint32_t i = 0;
+
+#ifdef VECTOR_SIMD_SSE
+	for (; i + 4 <= n; i += 4) {
+		__m128 ax, ay, az, bx, by, bz;
+
+		vsimd_load4(a + i, &ax, &ay, &az);
+		vsimd_load4(b + i, &bx, &by, &bz);
+		vsimd_store4(out + i,
+				_mm_sub_ps(_mm_mul_ps(ay, bz), _mm_mul_ps(az, by)),
+				_mm_sub_ps(_mm_mul_ps(az, bx), _mm_mul_ps(ax, bz)),
+				_mm_sub_ps(_mm_mul_ps(ax, by), _mm_mul_ps(ay, bx)));
+	}
+#endif
+	for (; i < n; i++)
+		out[i] = vec_cross(a[i], b[i]);
+}
+
+/**
+ * Normalize n vectors, like vec_normalize(). in and out may
+ * be the same array.
+ *
+ * @param in the vectors
+ * @param out the results [out]
+ * @param n count of vectors
+ */
+static inline void vec_batch_normalize(vector const *in,
+		vector *out,
+		uint32_t n)
+{
+	uint32_t i = 0;
+
+#ifdef VECTOR_SIMD_SSE
+	for (; i + 4 <= n; i += 4) {
+		__m128 x, y, z, len, keep;
+
+		vsimd_load4(in + i, &x, &y, &z);
+		len = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x),
+						_mm_mul_ps(y, y)), _mm_mul_ps(z, z)));
+		/* lanes of length 0 keep their input */
+		keep = _mm_cmpeq_ps(len, _mm_setzero_ps());
+		len = _mm_or_ps(_mm_andnot_ps(keep, len),
+				_mm_and_ps(keep, _mm_set1_ps(1)));
+		vsimd_store4(out + i, _mm_div_ps(x, len), _mm_div_ps(y, len),
+				_mm_div_ps(z, len));
+	}
+#endif
+	for (; i < n; i++)
+		out[i] = vec_normalize(in[i]);
+}
+
+/**
+ * Transform n positions by a 4x4 matrix in the column-major
+ * order of OpenGL, with w = 1. The w of the result is
+ * dropped, so this is only meant for affine transformations.
+ * in and out may be the same array.
+ *
+ * @param m the matrix
+ * @param in the positions
+ * @param out the results [out]
+ * @param n count of positions
+ */
+static inline void vec_batch_transform(float const m[16],
+		vector const *in,
+		vector *out,
+		uint32_t n)
+{
+#ifdef VECTOR_SIMD_SSE
+	__m128 const c0 = _mm_loadu_ps(m),
+		  c1 = _mm_loadu_ps(m + 4),
+		  c2 = _mm_loadu_ps(m + 8),
+		  c3 = _mm_loadu_ps(m + 12);
+
+	for (uint32_t i = 0; i < n; i++) {
+		__m128 const r = _mm_add_ps(_mm_add_ps(_mm_add_ps(
+						_mm_mul_ps(c0, _mm_set1_ps(in[i].x)),
+						_mm_mul_ps(c1, _mm_set1_ps(in[i].y))),
+					_mm_mul_ps(c2, _mm_set1_ps(in[i].z))), c3);
+
+		/* only 3 floats, the next vector may still be unread */
+		_mm_storel_pi((__m64*)&(out[i].x), r);
+		_mm_store_ss(&(out[i].z), _mm_movehl_ps(r, r));
+	}
+#else
+	for (uint32_t i = 0; i < n; i++) {
+		vector const v = in[i];
+
+		out[i].x = m[0] * v.x + m[4] * v.y + m[8] * v.z + m[12];
+		out[i].y = m[1] * v.x + m[5] * v.y + m[9] * v.z + m[13];
+		out[i].z = m[2] * v.x + m[6] * v.y + m[10] * v.z + m[14];
+	}
+#endif
+}
+
+
+#endif /* _DROW_ENGINE_VECTOR_SIMD_H */